@@ -81,6 +81,7 @@ void print_array(char *print_buf, uint64_t *array, int count);
 
 #define ARRAY_SIZE(a) (sizeof(a) / sizeof((a)[0]))
 #define min(x, y) (((x) < (y)) ? (x) : (y))
+#define max(x, y) (((x) > (y)) ? (x) : (y))
 
 
 #define DEFINE_PACK_UNPACK_ACCESSORS(device, table)                                \
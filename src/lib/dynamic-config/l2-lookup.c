@@ -33,6 +33,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <time.h>
 /* These are our own include files */
 #include <lib/include/dynamic-config.h>
 #include <lib/include/static-config.h>
@@ -46,26 +47,49 @@
  */
 
 /* Buffer is segregated into 2 parts:
- *   * ENTRY: a portion of SIZE_L2_LOOKUP_ENTRY (12) bytes,
- *            corresponding to addresses 0x20, 0x21 and 0x22
- *   * CMD: a portion of 4 bytes, corresponding to address 0x23
+ *   * ENTRY: a portion of SIZE_L2_LOOKUP_ENTRY_ET (12) bytes on E/T,
+ *            corresponding to addresses 0x20, 0x21 and 0x22, or of
+ *            SIZE_L2_LOOKUP_ENTRY_PQRS (20) bytes on P/Q/R/S,
+ *            corresponding to addresses 0x24 to 0x28
+ *   * CMD: a portion of 4 bytes, corresponding to address 0x23 on E/T
+ *          and to 0x29 on P/Q/R/S
  */
+#define SJA1105ET_L2_LOOKUP_ENTRY_ADDR   0x20
+#define SJA1105PQRS_L2_LOOKUP_ENTRY_ADDR 0x24
+#define SIZE_L2_LOOKUP_CMD               4
+#define SIZE_L2_LOOKUP_RECONF_MAX  (SIZE_L2_LOOKUP_ENTRY_PQRS + SIZE_L2_LOOKUP_CMD)
+
+#define NSEC_PER_SEC 1000000000ull
+
+static int sja1105_dyn_l2_lookup_entry_size(uint64_t device_id)
+{
+	return IS_ET(device_id) ? SIZE_L2_LOOKUP_ENTRY_ET :
+	                          SIZE_L2_LOOKUP_ENTRY_PQRS;
+}
+
+static int sja1105_dyn_l2_lookup_addr(uint64_t device_id)
+{
+	return IS_ET(device_id) ? SJA1105ET_L2_LOOKUP_ENTRY_ADDR :
+	                          SJA1105PQRS_L2_LOOKUP_ENTRY_ADDR;
+}
+
 static void
 sja1105_dyn_l2_lookup_cmd_access(void *buf,
                                  struct sja1105_dyn_l2_lookup_cmd *cmd,
-                                 int write)
+                                 int write,
+                                 uint64_t device_id)
 {
 	int  (*pack_or_unpack)(void*, uint64_t*, int, int, int);
-	int    size = 4 + SIZE_L2_LOOKUP_ENTRY_ET;
+	int    entry_size = sja1105_dyn_l2_lookup_entry_size(device_id);
 	uint8_t *entry_ptr = (uint8_t*) buf;
-	uint8_t *cmd_ptr   = (uint8_t*) buf + SIZE_L2_LOOKUP_ENTRY_ET;
+	uint8_t *cmd_ptr   = (uint8_t*) buf + entry_size;
 
 	if (write == 0) {
 		pack_or_unpack = gtable_unpack;
 		memset(cmd, 0, sizeof(*cmd));
 	} else {
 		pack_or_unpack = gtable_pack;
-		memset(buf, 0, size);
+		memset(buf, 0, entry_size + SIZE_L2_LOOKUP_CMD);
 	}
 	pack_or_unpack(cmd_ptr, &cmd->valid,     31, 31, 4);
 	pack_or_unpack(cmd_ptr, &cmd->rdwrset,   30, 30, 4);
@@ -73,6 +97,9 @@ sja1105_dyn_l2_lookup_cmd_access(void *buf,
 	pack_or_unpack(cmd_ptr, &cmd->lockeds,   28, 28, 4);
 	pack_or_unpack(cmd_ptr, &cmd->valident,  27, 27, 4);
 	pack_or_unpack(cmd_ptr, &cmd->mgmtroute, 26, 26, 4);
+	if (IS_PQRS(device_id)) {
+		pack_or_unpack(cmd_ptr, &cmd->hostcmd, 25, 23, 4);
+	}
 	if (cmd->mgmtroute) {
 		/* Management route */
 		pack_or_unpack(entry_ptr, &cmd->entry.mgmt.ts_regid,  85, 85, SIZE_L2_LOOKUP_ENTRY_ET);
@@ -81,27 +108,38 @@ sja1105_dyn_l2_lookup_cmd_access(void *buf,
 		pack_or_unpack(entry_ptr, &cmd->entry.mgmt.destports, 35, 31, SIZE_L2_LOOKUP_ENTRY_ET);
 		pack_or_unpack(entry_ptr, &cmd->entry.mgmt.enfport,   30, 30, SIZE_L2_LOOKUP_ENTRY_ET);
 		pack_or_unpack(entry_ptr, &cmd->entry.mgmt.index,     29, 20, SIZE_L2_LOOKUP_ENTRY_ET);
+	} else if (IS_ET(device_id)) {
+		/* Regular L2 lookup entry, same layout as in the
+		 * static config. The entry pack functions clear
+		 * only their own portion of the buffer. */
+		if (write == 0) {
+			sja1105et_l2_lookup_entry_unpack(entry_ptr, &cmd->entry.l2);
+		} else {
+			sja1105et_l2_lookup_entry_pack(entry_ptr, &cmd->entry.l2);
+		}
 	} else {
-		/* Regular L2 lookup entry.
-		 * Code duplicated from src/lib/static-config/tables/l2-lookup.c */
-		pack_or_unpack(entry_ptr, &cmd->entry.l2.vlanid,    95, 84, SIZE_L2_LOOKUP_ENTRY_ET);
-		pack_or_unpack(entry_ptr, &cmd->entry.l2.macaddr,   83, 36, SIZE_L2_LOOKUP_ENTRY_ET);
-		pack_or_unpack(entry_ptr, &cmd->entry.l2.destports, 35, 31, SIZE_L2_LOOKUP_ENTRY_ET);
-		pack_or_unpack(entry_ptr, &cmd->entry.l2.enfport,   30, 30, SIZE_L2_LOOKUP_ENTRY_ET);
-		pack_or_unpack(entry_ptr, &cmd->entry.l2.index,     29, 20, SIZE_L2_LOOKUP_ENTRY_ET);
+		/* For learned entries (LOCKEDS=0) only the key,
+		 * DESTPORTS and INDEX are meaningful. */
+		if (write == 0) {
+			sja1105pqrs_l2_lookup_entry_unpack(entry_ptr, &cmd->entry.l2);
+		} else {
+			sja1105pqrs_l2_lookup_entry_pack(entry_ptr, &cmd->entry.l2);
+		}
 	}
 }
 
-void sja1105_dyn_l2_lookup_cmd_pack(void *buf, struct
-                                    sja1105_dyn_l2_lookup_cmd *cmd)
+void sja1105_dyn_l2_lookup_cmd_pack(void *buf,
+                                    struct sja1105_dyn_l2_lookup_cmd *cmd,
+                                    uint64_t device_id)
 {
-	sja1105_dyn_l2_lookup_cmd_access(buf, cmd, 1);
+	sja1105_dyn_l2_lookup_cmd_access(buf, cmd, 1, device_id);
 }
 
-void sja1105_dyn_l2_lookup_cmd_unpack(void *buf, struct
-                                      sja1105_dyn_l2_lookup_cmd *cmd)
+void sja1105_dyn_l2_lookup_cmd_unpack(void *buf,
+                                      struct sja1105_dyn_l2_lookup_cmd *cmd,
+                                      uint64_t device_id)
 {
-	sja1105_dyn_l2_lookup_cmd_access(buf, cmd, 0);
+	sja1105_dyn_l2_lookup_cmd_access(buf, cmd, 0, device_id);
 }
 
 void sja1105_mgmt_entry_show(struct sja1105_mgmt_entry *entry)
@@ -122,6 +160,7 @@ void sja1105_dyn_l2_lookup_cmd_show(struct sja1105_dyn_l2_lookup_cmd *cmd)
 	printf("LOCKEDS   %" PRIX64 "\n", cmd->lockeds);
 	printf("VALIDENT  %" PRIX64 "\n", cmd->valident);
 	printf("MGMTROUTE %" PRIX64 "\n", cmd->mgmtroute);
+	printf("HOSTCMD   %" PRIX64 "\n", cmd->hostcmd);
 	if (cmd->mgmtroute) {
 		sja1105_mgmt_entry_show(&cmd->entry.mgmt);
 	} else {
@@ -129,25 +168,70 @@ void sja1105_dyn_l2_lookup_cmd_show(struct sja1105_dyn_l2_lookup_cmd *cmd)
 	}
 }
 
+/* Sends @cmd with VALID set, in a single SPI transaction together with
+ * its entry, then polls the command register until the switch clears
+ * VALID. The entry is read back by the same transactions, so on return
+ * @cmd holds the switch's answer (for reads and searches).
+ *
+ * Returns -ETIMEDOUT if the switch never completes the command,
+ * and -EIO if it completes it with ERRORS set.
+ */
+int sja1105_dyn_l2_lookup_cmd_commit(struct sja1105_spi_setup *spi_setup,
+                                     struct sja1105_dyn_l2_lookup_cmd *cmd)
+{
+	uint64_t device_id = spi_setup->device_id;
+	int entry_addr = sja1105_dyn_l2_lookup_addr(device_id);
+	int buf_len = sja1105_dyn_l2_lookup_entry_size(device_id) +
+	              SIZE_L2_LOOKUP_CMD;
+	uint8_t packed_buf[SIZE_L2_LOOKUP_RECONF_MAX];
+	int i, rc;
+
+	cmd->valid = 1;
+	sja1105_dyn_l2_lookup_cmd_pack(packed_buf, cmd, device_id);
+
+	rc = sja1105_spi_send_packed_buf(spi_setup, SPI_WRITE, entry_addr,
+	                                 packed_buf, buf_len);
+	if (rc < 0) {
+		loge("failed to write l2 lookup command");
+		goto out;
+	}
+	for (i = 0; i < SJA1105_DYN_CMD_POLL_COUNT; i++) {
+		memset(packed_buf, 0, buf_len);
+		rc = sja1105_spi_send_packed_buf(spi_setup, SPI_READ,
+		                                 entry_addr, packed_buf,
+		                                 buf_len);
+		if (rc < 0) {
+			loge("failed to read l2 lookup command");
+			goto out;
+		}
+		sja1105_dyn_l2_lookup_cmd_unpack(packed_buf, cmd, device_id);
+		if (!cmd->valid) {
+			break;
+		}
+	}
+	if (cmd->valid) {
+		loge("switch did not complete the l2 lookup command");
+		rc = -ETIMEDOUT;
+	} else if (cmd->errors) {
+		loge("switch flagged the l2 lookup command with errors");
+		rc = -EIO;
+	}
+out:
+	return rc;
+}
+
 static inline int
 sja1105_mgmt_route_commit(struct sja1105_spi_setup *spi_setup,
                           struct sja1105_mgmt_entry *entry,
                           int read_or_write,
                           int index)
 {
-	/* Access to CMD_ADDR = 0x23 is implicit and done
-	 * through the same SPI transaction */
-	const int ENTRY_ADDR = 0x20;
-	const int BUF_LEN = 4 + SIZE_L2_LOOKUP_ENTRY_ET;
-	/* SPI payload buffer */
-	uint8_t packed_buf[BUF_LEN];
 	/* Structure to hold command we are constructing,
 	 * and mgmt entry we are reading/writing */
 	struct sja1105_dyn_l2_lookup_cmd cmd;
 	int rc;
 
 	memset(&cmd, 0, sizeof(cmd));
-	cmd.valid     = 1;
 	cmd.rdwrset   = (read_or_write == SPI_WRITE);
 	cmd.valident  = 1;
 	cmd.mgmtroute = 1;
@@ -158,33 +242,16 @@ sja1105_mgmt_route_commit(struct sja1105_spi_setup *spi_setup,
 	}
 	cmd.entry.mgmt.index = index;
 	cmd.entry.mgmt.enfport = 1;
-	sja1105_dyn_l2_lookup_cmd_pack(packed_buf, &cmd);
-
-	/* Send SPI write operation: "read/write mgmt table entry" */
-	rc = sja1105_spi_send_packed_buf(spi_setup,
-	                                 SPI_WRITE,
-	                                 ENTRY_ADDR,
-	                                 packed_buf,
-	                                 BUF_LEN);
+
+	rc = sja1105_dyn_l2_lookup_cmd_commit(spi_setup, &cmd);
 	if (rc < 0) {
-		loge("failed to read from spi");
+		loge("failed to %s management route %d",
+		     (read_or_write == SPI_WRITE) ? "write" : "read", index);
 		goto out;
 	}
-
 	if (read_or_write == SPI_READ) {
-		/* If previous operation was a read, retrieve its result:
+		/* Retrieve the result of the read:
 		 * the mgmt table entry requested for */
-		memset(packed_buf, 0, BUF_LEN);
-		rc = sja1105_spi_send_packed_buf(spi_setup,
-		                                 SPI_READ,
-		                                 ENTRY_ADDR,
-		                                 packed_buf,
-		                                 BUF_LEN);
-		if (rc < 0) {
-			loge("failed to read from spi");
-			goto out;
-		}
-		sja1105_dyn_l2_lookup_cmd_unpack(packed_buf, &cmd);
 		memcpy(entry, &cmd.entry, sizeof(*entry));
 	}
 out:
@@ -204,3 +271,464 @@ int sja1105_mgmt_route_set(struct sja1105_spi_setup *spi_setup,
 {
 	return sja1105_mgmt_route_commit(spi_setup, entry, SPI_WRITE, index);
 }
+
+static int sja1105et_fdb_hash(const struct sja1105_l2_lookup_params_entry *params,
+                              uint64_t macaddr, uint64_t vlanid)
+{
+	struct sja1105et_l2_hash hash;
+
+	sja1105et_l2_hash_init(&hash, params);
+	return sja1105et_l2_hash(&hash, macaddr, vlanid);
+}
+
+int sja1105_fdb_get(struct sja1105_spi_setup *spi_setup,
+                    int index, struct sja1105_fdb_entry *entry)
+{
+	struct sja1105_dyn_l2_lookup_cmd cmd;
+	int rc;
+
+	if (index < 0 || index >= MAX_L2_LOOKUP_COUNT) {
+		return -ERANGE;
+	}
+	memset(&cmd, 0, sizeof(cmd));
+	cmd.rdwrset = SPI_READ;
+	cmd.hostcmd = SJA1105_HOSTCMD_READ;
+	cmd.entry.l2.index = index;
+
+	rc = sja1105_dyn_l2_lookup_cmd_commit(spi_setup, &cmd);
+	if (rc < 0) {
+		return rc;
+	}
+	if (!cmd.valident) {
+		return -ENOENT;
+	}
+	entry->l2 = cmd.entry.l2;
+	entry->l2.index = index;
+	entry->lockeds = cmd.lockeds;
+	return 0;
+}
+
+static int sja1105_fdb_key_matches(const struct sja1105_l2_lookup_params_entry *params,
+                                   struct sja1105_fdb_entry *entry,
+                                   uint64_t macaddr, uint64_t vlanid)
+{
+	return (entry->l2.macaddr == macaddr) &&
+	       (params->shared_learn || entry->l2.vlanid == vlanid);
+}
+
+/* Exact-match masks for a P/Q/R/S key that the caller left unmasked */
+static void sja1105pqrs_fdb_masks_set(struct sja1105_l2_lookup_entry *l2)
+{
+	if (l2->mask_macaddr || l2->mask_vlanid || l2->mask_iotag) {
+		return;
+	}
+	l2->mask_macaddr = 0xffffffffffffull;
+	l2->mask_vlanid  = 0xfff;
+	l2->mask_iotag   = 1;
+}
+
+int sja1105_fdb_search(struct sja1105_spi_setup *spi_setup,
+                       const struct sja1105_l2_lookup_params_entry *params,
+                       uint64_t macaddr, uint64_t vlanid,
+                       struct sja1105_fdb_entry *entry)
+{
+	struct sja1105_dyn_l2_lookup_cmd cmd;
+	int bin, way;
+	int rc;
+
+	if (IS_ET(spi_setup->device_id)) {
+		if (!params) {
+			loge("L2 Lookup Parameters are needed on E/T");
+			return -EINVAL;
+		}
+		/* No search command: look through the ways of the bin */
+		bin = sja1105et_fdb_hash(params, macaddr, vlanid);
+		for (way = 0; way < SJA1105ET_L2_LOOKUP_BIN_SIZE; way++) {
+			rc = sja1105_fdb_get(spi_setup,
+			                     bin * SJA1105ET_L2_LOOKUP_BIN_SIZE + way,
+			                     entry);
+			if (rc == -ENOENT) {
+				continue;
+			}
+			if (rc < 0) {
+				return rc;
+			}
+			if (sja1105_fdb_key_matches(params, entry,
+			                            macaddr, vlanid)) {
+				return 0;
+			}
+		}
+		return -ENOENT;
+	}
+	memset(&cmd, 0, sizeof(cmd));
+	cmd.rdwrset = SPI_READ;
+	cmd.hostcmd = SJA1105_HOSTCMD_SEARCH;
+	cmd.entry.l2.macaddr = macaddr;
+	cmd.entry.l2.vlanid  = vlanid;
+	sja1105pqrs_fdb_masks_set(&cmd.entry.l2);
+
+	rc = sja1105_dyn_l2_lookup_cmd_commit(spi_setup, &cmd);
+	if (rc < 0) {
+		return rc;
+	}
+	if (!cmd.valident) {
+		return -ENOENT;
+	}
+	entry->l2 = cmd.entry.l2;
+	entry->lockeds = cmd.lockeds;
+	return 0;
+}
+
+/* Picks the index where an entry with the key of @entry is to be
+ * written: the index of the entry with the same key if there is one,
+ * otherwise a free index, otherwise (E/T only) one of a learned entry
+ * in the same bin. */
+static int sja1105_fdb_index_find(struct sja1105_spi_setup *spi_setup,
+                                  const struct sja1105_l2_lookup_params_entry *params,
+                                  struct sja1105_fdb_entry *entry)
+{
+	struct sja1105_fdb_entry tmp;
+	int free_index = -1;
+	int learned_index = -1;
+	int bin, i;
+	int rc;
+
+	rc = sja1105_fdb_search(spi_setup, params, entry->l2.macaddr,
+	                        entry->l2.vlanid, &tmp);
+	if (rc == 0) {
+		return tmp.l2.index;
+	}
+	if (rc != -ENOENT) {
+		return rc;
+	}
+	if (IS_ET(spi_setup->device_id)) {
+		bin = sja1105et_fdb_hash(params, entry->l2.macaddr,
+		                         entry->l2.vlanid);
+		for (i = bin * SJA1105ET_L2_LOOKUP_BIN_SIZE;
+		     i < (bin + 1) * SJA1105ET_L2_LOOKUP_BIN_SIZE; i++) {
+			rc = sja1105_fdb_get(spi_setup, i, &tmp);
+			if (rc == -ENOENT) {
+				free_index = i;
+				break;
+			}
+			if (rc < 0) {
+				return rc;
+			}
+			if (!tmp.lockeds && learned_index < 0) {
+				learned_index = i;
+			}
+		}
+		if (free_index < 0 && learned_index >= 0) {
+			logv("bin %d is full, replacing learned entry %d",
+			     bin, learned_index);
+			free_index = learned_index;
+		}
+	} else {
+		/* The P/Q/R/S table has no fixed placement,
+		 * so any unused index will do. */
+		for (i = 0; i < MAX_L2_LOOKUP_COUNT; i++) {
+			rc = sja1105_fdb_get(spi_setup, i, &tmp);
+			if (rc == -ENOENT) {
+				free_index = i;
+				break;
+			}
+			if (rc < 0) {
+				return rc;
+			}
+		}
+	}
+	if (free_index < 0) {
+		loge("no room left in the FDB for this entry");
+		return -ENOSPC;
+	}
+	return free_index;
+}
+
+int sja1105_fdb_add(struct sja1105_spi_setup *spi_setup,
+                    const struct sja1105_l2_lookup_params_entry *params,
+                    struct sja1105_fdb_entry *entry)
+{
+	struct sja1105_dyn_l2_lookup_cmd cmd;
+	int index;
+
+	index = sja1105_fdb_index_find(spi_setup, params, entry);
+	if (index < 0) {
+		return index;
+	}
+	memset(&cmd, 0, sizeof(cmd));
+	cmd.rdwrset  = SPI_WRITE;
+	cmd.valident = 1;
+	cmd.lockeds  = entry->lockeds;
+	cmd.hostcmd  = SJA1105_HOSTCMD_WRITE;
+	cmd.entry.l2 = entry->l2;
+	cmd.entry.l2.index = index;
+	if (IS_PQRS(spi_setup->device_id)) {
+		sja1105pqrs_fdb_masks_set(&cmd.entry.l2);
+	}
+	entry->l2.index = index;
+
+	return sja1105_dyn_l2_lookup_cmd_commit(spi_setup, &cmd);
+}
+
+int sja1105_fdb_del(struct sja1105_spi_setup *spi_setup,
+                    const struct sja1105_l2_lookup_params_entry *params,
+                    uint64_t macaddr, uint64_t vlanid)
+{
+	struct sja1105_dyn_l2_lookup_cmd cmd;
+	struct sja1105_fdb_entry entry;
+	int rc;
+
+	rc = sja1105_fdb_search(spi_setup, params, macaddr, vlanid, &entry);
+	if (rc < 0) {
+		return rc;
+	}
+	memset(&cmd, 0, sizeof(cmd));
+	cmd.rdwrset  = SPI_WRITE;
+	cmd.valident = 0;
+	cmd.hostcmd  = SJA1105_HOSTCMD_INVALIDATE;
+	cmd.entry.l2.index = entry.l2.index;
+
+	return sja1105_dyn_l2_lookup_cmd_commit(spi_setup, &cmd);
+}
+
+void sja1105_fdb_brief_from_entry(struct sja1105_fdb_brief *brief,
+                                  const struct sja1105_fdb_entry *entry)
+{
+	brief->macaddr   = entry->l2.macaddr;
+	brief->vlanid    = entry->l2.vlanid;
+	brief->index     = entry->l2.index;
+	brief->destports = entry->l2.destports;
+	brief->lockeds   = entry->lockeds;
+}
+
+/* Reads all valid entries of the FDB into @entries, which must have
+ * room for MAX_L2_LOOKUP_COUNT of them, in index order. Returns the
+ * number of entries read.
+ *
+ * All read commands and the reads of their results are queued up
+ * front and submitted together, as a read command is normally
+ * completed by the time its result is clocked out. If one is not
+ * (VALID still set), the command after it may have been dropped and
+ * its result may hold another entry, so everything from that index
+ * on is read again one by one.
+ */
+int sja1105_fdb_dump(struct sja1105_spi_setup *spi_setup,
+                     struct sja1105_fdb_brief *entries)
+{
+	uint64_t device_id = spi_setup->device_id;
+	int entry_addr = sja1105_dyn_l2_lookup_addr(device_id);
+	int buf_len = sja1105_dyn_l2_lookup_entry_size(device_id) +
+	              SIZE_L2_LOOKUP_CMD;
+	struct sja1105_dyn_l2_lookup_cmd cmd;
+	struct sja1105_spi_queue queue;
+	struct sja1105_fdb_entry entry;
+	uint8_t *tx_buf, *rx_buf;
+	int count = 0;
+	int i, rc;
+
+	tx_buf = malloc(2 * MAX_L2_LOOKUP_COUNT * buf_len);
+	if (!tx_buf) {
+		return -ENOMEM;
+	}
+	rx_buf = tx_buf + MAX_L2_LOOKUP_COUNT * buf_len;
+	memset(rx_buf, 0, MAX_L2_LOOKUP_COUNT * buf_len);
+	sja1105_spi_queue_init(&queue);
+
+	for (i = 0; i < MAX_L2_LOOKUP_COUNT; i++) {
+		memset(&cmd, 0, sizeof(cmd));
+		cmd.valid   = 1;
+		cmd.rdwrset = SPI_READ;
+		cmd.hostcmd = SJA1105_HOSTCMD_READ;
+		cmd.entry.l2.index = i;
+		sja1105_dyn_l2_lookup_cmd_pack(tx_buf + i * buf_len, &cmd,
+		                               device_id);
+		rc = sja1105_spi_queue_add(&queue, SPI_WRITE, entry_addr,
+		                           tx_buf + i * buf_len, buf_len);
+		if (rc < 0) {
+			goto out;
+		}
+		rc = sja1105_spi_queue_add(&queue, SPI_READ, entry_addr,
+		                           rx_buf + i * buf_len, buf_len);
+		if (rc < 0) {
+			goto out;
+		}
+	}
+	rc = sja1105_spi_queue_submit(spi_setup, &queue);
+	if (rc < 0) {
+		loge("failed to read the l2 lookup table");
+		goto out;
+	}
+	for (i = 0; i < MAX_L2_LOOKUP_COUNT; i++) {
+		sja1105_dyn_l2_lookup_cmd_unpack(rx_buf + i * buf_len, &cmd,
+		                                 device_id);
+		if (cmd.valid) {
+			break;
+		}
+		if (cmd.errors) {
+			loge("switch flagged the read of l2 lookup entry %d "
+			     "with errors", i);
+			rc = -EIO;
+			goto out;
+		}
+		if (!cmd.valident) {
+			continue;
+		}
+		entries[count].macaddr   = cmd.entry.l2.macaddr;
+		entries[count].vlanid    = cmd.entry.l2.vlanid;
+		entries[count].index     = i;
+		entries[count].destports = cmd.entry.l2.destports;
+		entries[count].lockeds   = cmd.lockeds;
+		count++;
+	}
+	if (i < MAX_L2_LOOKUP_COUNT) {
+		logv("%d l2 lookup entries had to be read again",
+		     MAX_L2_LOOKUP_COUNT - i);
+	}
+	for (; i < MAX_L2_LOOKUP_COUNT; i++) {
+		rc = sja1105_fdb_get(spi_setup, i, &entry);
+		if (rc == -ENOENT) {
+			continue;
+		}
+		if (rc < 0) {
+			goto out;
+		}
+		sja1105_fdb_brief_from_entry(&entries[count++], &entry);
+	}
+	rc = count;
+out:
+	sja1105_spi_queue_free(&queue);
+	free(tx_buf);
+	return rc;
+}
+
+static int sja1105_fdb_brief_cmp(const void *a, const void *b)
+{
+	const struct sja1105_fdb_brief *x = a;
+	const struct sja1105_fdb_brief *y = b;
+
+	if (x->macaddr != y->macaddr) {
+		return (x->macaddr < y->macaddr) ? -1 : 1;
+	}
+	return (int) x->vlanid - (int) y->vlanid;
+}
+
+/* Calls @cb for every difference between two dumps of the FDB: keys
+ * only in @new_entries were added, keys only in @old_entries were
+ * removed, and keys in both with other DESTPORTS have moved. Both
+ * arrays are sorted by key in place. Stops early if @cb returns
+ * non-zero, and returns that value.
+ */
+int sja1105_fdb_diff(struct sja1105_fdb_brief *old_entries, int old_count,
+                     struct sja1105_fdb_brief *new_entries, int new_count,
+                     int (*cb)(enum sja1105_fdb_change,
+                               const struct sja1105_fdb_brief *old_entry,
+                               const struct sja1105_fdb_brief *new_entry,
+                               void *priv),
+                     void *priv)
+{
+	struct sja1105_fdb_brief *o, *n;
+	int i = 0, j = 0;
+	int cmp, rc = 0;
+
+	qsort(old_entries, old_count, sizeof(*old_entries),
+	      sja1105_fdb_brief_cmp);
+	qsort(new_entries, new_count, sizeof(*new_entries),
+	      sja1105_fdb_brief_cmp);
+
+	while (i < old_count || j < new_count) {
+		o = (i < old_count) ? &old_entries[i] : NULL;
+		n = (j < new_count) ? &new_entries[j] : NULL;
+		if (o && n) {
+			cmp = sja1105_fdb_brief_cmp(o, n);
+		} else {
+			cmp = o ? -1 : 1;
+		}
+		if (cmp < 0) {
+			rc = cb(SJA1105_FDB_REMOVED, o, NULL, priv);
+			i++;
+		} else if (cmp > 0) {
+			rc = cb(SJA1105_FDB_ADDED, NULL, n, priv);
+			j++;
+		} else if (o->destports != n->destports) {
+			rc = cb(SJA1105_FDB_MOVED, o, n, priv);
+			i++; j++;
+		} else {
+			i++; j++;
+		}
+		if (rc) {
+			break;
+		}
+	}
+	return rc;
+}
+
+/* Dumps the FDB every @interval_ns, on absolute deadlines, and reports
+ * the differences from the previous dump through @cb. Everything in
+ * the first dump is reported as added. Stops after @count dumps (0
+ * means never), when @cb returns non-zero, when a signal interrupts
+ * the wait between dumps, or once *@stop (if not NULL) is set.
+ */
+int sja1105_fdb_watch(struct sja1105_spi_setup *spi_setup,
+                      uint64_t interval_ns, uint64_t count,
+                      int (*cb)(enum sja1105_fdb_change,
+                                const struct sja1105_fdb_brief *old_entry,
+                                const struct sja1105_fdb_brief *new_entry,
+                                void *priv),
+                      void *priv, volatile sig_atomic_t *stop)
+{
+	struct sja1105_fdb_brief *buf, *old_entries, *new_entries, *tmp;
+	int old_count = 0, new_count;
+	struct timespec deadline;
+	uint64_t deadline_ns;
+	uint64_t i;
+	int rc;
+
+	if (interval_ns == 0) {
+		return -EINVAL;
+	}
+	buf = malloc(2 * MAX_L2_LOOKUP_COUNT * sizeof(*buf));
+	if (!buf) {
+		return -ENOMEM;
+	}
+	old_entries = buf;
+	new_entries = buf + MAX_L2_LOOKUP_COUNT;
+
+	clock_gettime(CLOCK_MONOTONIC, &deadline);
+	deadline_ns = deadline.tv_sec * NSEC_PER_SEC + deadline.tv_nsec;
+	for (i = 0; count == 0 || i < count; i++) {
+		if (stop && *stop) {
+			break;
+		}
+		if (i) {
+			deadline_ns += interval_ns;
+			deadline.tv_sec  = deadline_ns / NSEC_PER_SEC;
+			deadline.tv_nsec = deadline_ns % NSEC_PER_SEC;
+			if (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME,
+			                    &deadline, NULL) == EINTR) {
+				break;
+			}
+			if (stop && *stop) {
+				break;
+			}
+		}
+		rc = sja1105_fdb_dump(spi_setup, new_entries);
+		if (rc < 0) {
+			goto out;
+		}
+		new_count = rc;
+		rc = sja1105_fdb_diff(old_entries, old_count,
+		                      new_entries, new_count, cb, priv);
+		if (rc) {
+			rc = (rc < 0) ? rc : 0;
+			goto out;
+		}
+		old_count = new_count;
+		tmp = old_entries;
+		old_entries = new_entries;
+		new_entries = tmp;
+	}
+	rc = 0;
+out:
+	free(buf);
+	return rc;
+}
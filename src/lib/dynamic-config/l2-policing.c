@@ -0,0 +1,288 @@
+/******************************************************************************
+ * Copyright (c) 2018, NXP Semiconductors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+/* These are our own include files */
+#include <lib/include/dynamic-config.h>
+#include <lib/include/static-config.h>
+#include <lib/include/gtable.h>
+#include <lib/include/spi.h>
+#include <common.h>
+
+/* Only E/T have these registers (UM10944). On P/Q/R/S, 0x2D to 0x30
+ * is the VLAN Lookup block (UM11040), and the L2 Policing table can
+ * only be changed with a new static config.
+ * Buffer is segregated into 2 parts:
+ *   * ENTRY: a portion of SIZE_L2_POLICING_ENTRY (8) bytes, corresponding
+ *            to addresses 0x2B and 0x2C. Same layout as in the static
+ *            config.
+ *   * CMD: a portion of 4 bytes, corresponding to address 0x2D
+ */
+#define SJA1105_L2_POLICING_ENTRY_ADDR 0x2B
+#define SIZE_L2_POLICING_CMD           4
+#define SIZE_L2_POLICING_RECONF        (SIZE_L2_POLICING_ENTRY + \
+                                        SIZE_L2_POLICING_CMD)
+
+/* RATE counts in steps of 1/64 Mbps (15.625 kbps), in 16 bits */
+#define SJA1105_POLICING_RATE_PER_MBPS 64
+#define SJA1105_POLICING_RATE_MAX      0xffff
+#define SJA1105_POLICING_SMAX_MAX      0xffff
+
+static void
+sja1105_dyn_l2_policing_cmd_access(void *buf,
+                                   struct sja1105_dyn_l2_policing_cmd *cmd,
+                                   int write)
+{
+	int  (*pack_or_unpack)(void*, uint64_t*, int, int, int);
+	uint8_t *cmd_ptr = (uint8_t*) buf + SIZE_L2_POLICING_ENTRY;
+
+	if (write == 0) {
+		pack_or_unpack = gtable_unpack;
+		memset(cmd, 0, sizeof(*cmd));
+		sja1105_l2_policing_entry_unpack(buf, &cmd->entry);
+	} else {
+		pack_or_unpack = gtable_pack;
+		memset(buf, 0, SIZE_L2_POLICING_RECONF);
+		sja1105_l2_policing_entry_pack(buf, &cmd->entry);
+	}
+	pack_or_unpack(cmd_ptr, &cmd->valid,   31, 31, 4);
+	pack_or_unpack(cmd_ptr, &cmd->rdwrset, 30, 30, 4);
+	pack_or_unpack(cmd_ptr, &cmd->errors,  29, 29, 4);
+	pack_or_unpack(cmd_ptr, &cmd->index,   26, 21, 4);
+}
+
+void sja1105_dyn_l2_policing_cmd_pack(void *buf,
+                                      struct sja1105_dyn_l2_policing_cmd *cmd)
+{
+	sja1105_dyn_l2_policing_cmd_access(buf, cmd, 1);
+}
+
+void sja1105_dyn_l2_policing_cmd_unpack(void *buf,
+                                        struct sja1105_dyn_l2_policing_cmd *cmd)
+{
+	sja1105_dyn_l2_policing_cmd_access(buf, cmd, 0);
+}
+
+/* Same protocol as sja1105_dyn_l2_lookup_cmd_commit */
+int sja1105_dyn_l2_policing_cmd_commit(struct sja1105_spi_setup *spi_setup,
+                                       struct sja1105_dyn_l2_policing_cmd *cmd)
+{
+	uint8_t packed_buf[SIZE_L2_POLICING_RECONF];
+	int i, rc;
+
+	cmd->valid = 1;
+	sja1105_dyn_l2_policing_cmd_pack(packed_buf, cmd);
+
+	rc = sja1105_spi_send_packed_buf(spi_setup, SPI_WRITE,
+	                                 SJA1105_L2_POLICING_ENTRY_ADDR,
+	                                 packed_buf, SIZE_L2_POLICING_RECONF);
+	if (rc < 0) {
+		loge("failed to write l2 policing command");
+		goto out;
+	}
+	for (i = 0; i < SJA1105_DYN_CMD_POLL_COUNT; i++) {
+		memset(packed_buf, 0, SIZE_L2_POLICING_RECONF);
+		rc = sja1105_spi_send_packed_buf(spi_setup, SPI_READ,
+		                                 SJA1105_L2_POLICING_ENTRY_ADDR,
+		                                 packed_buf,
+		                                 SIZE_L2_POLICING_RECONF);
+		if (rc < 0) {
+			loge("failed to read l2 policing command");
+			goto out;
+		}
+		sja1105_dyn_l2_policing_cmd_unpack(packed_buf, cmd);
+		if (!cmd->valid) {
+			break;
+		}
+	}
+	if (cmd->valid) {
+		loge("switch did not complete the l2 policing command");
+		rc = -ETIMEDOUT;
+	} else if (cmd->errors) {
+		loge("switch flagged the l2 policing command with errors");
+		rc = -EIO;
+	}
+out:
+	return rc;
+}
+
+/* Converts @rate_mbps to the fixed-point RATE of @entry, rounding to
+ * the nearest step. Returns -ERANGE if it does not fit. */
+int sja1105_l2_policing_rate_set(struct sja1105_l2_policing_entry *entry,
+                                 double rate_mbps)
+{
+	double rate = rate_mbps * SJA1105_POLICING_RATE_PER_MBPS + 0.5;
+
+	if (!(rate >= 0 && rate <= SJA1105_POLICING_RATE_MAX + 0.5)) {
+		loge("Policing rate %.3f Mbps out of range (0 to %.3f)",
+		     rate_mbps, (double) SJA1105_POLICING_RATE_MAX /
+		                SJA1105_POLICING_RATE_PER_MBPS);
+		return -ERANGE;
+	}
+	entry->rate = (uint64_t) rate;
+	return 0;
+}
+
+double sja1105_l2_policing_rate_get(const struct sja1105_l2_policing_entry *entry)
+{
+	return (double) entry->rate / SJA1105_POLICING_RATE_PER_MBPS;
+}
+
+/* SMAX is the size of the token bucket, in bytes */
+int sja1105_l2_policing_burst_set(struct sja1105_l2_policing_entry *entry,
+                                  uint64_t burst_bytes)
+{
+	if (burst_bytes > SJA1105_POLICING_SMAX_MAX) {
+		loge("Policing burst %" PRIu64 " bytes out of range (max %d)",
+		     burst_bytes, SJA1105_POLICING_SMAX_MAX);
+		return -ERANGE;
+	}
+	entry->smax = burst_bytes;
+	return 0;
+}
+
+int sja1105_l2_policing_set(struct sja1105_spi_setup *spi_setup, int index,
+                            const struct sja1105_l2_policing_entry *entry)
+{
+	struct sja1105_dyn_l2_policing_cmd cmd;
+
+	if (!IS_ET(spi_setup->device_id)) {
+		return -EOPNOTSUPP;
+	}
+	if (index < 0 || index >= MAX_L2_POLICING_COUNT) {
+		return -ERANGE;
+	}
+	memset(&cmd, 0, sizeof(cmd));
+	cmd.rdwrset = SPI_WRITE;
+	cmd.index   = index;
+	cmd.entry   = *entry;
+	return sja1105_dyn_l2_policing_cmd_commit(spi_setup, &cmd);
+}
+
+/* Writes @count policing entries in a single SPI transaction: each
+ * command is followed by a read of the command register, which by the
+ * time it is clocked out tells whether the switch is done with it.
+ * Should the switch have been slower than the SPI bus, the command it
+ * was still busy with, and all those after it (which may have been
+ * written over it), are sent again one by one.
+ */
+int sja1105_l2_policing_set_batch(struct sja1105_spi_setup *spi_setup,
+                                  const struct sja1105_l2_policing_update *updates,
+                                  int count)
+{
+	struct sja1105_dyn_l2_policing_cmd cmd;
+	struct sja1105_spi_queue queue;
+	uint8_t *tx_buf, *rx_buf;
+	int i, rc;
+
+	if (!IS_ET(spi_setup->device_id)) {
+		return -EOPNOTSUPP;
+	}
+	for (i = 0; i < count; i++) {
+		if (updates[i].index < 0 ||
+		    updates[i].index >= MAX_L2_POLICING_COUNT) {
+			return -ERANGE;
+		}
+	}
+	if (count == 0) {
+		return 0;
+	}
+	tx_buf = malloc(2 * count * SIZE_L2_POLICING_RECONF);
+	if (!tx_buf) {
+		return -ENOMEM;
+	}
+	rx_buf = tx_buf + count * SIZE_L2_POLICING_RECONF;
+	/* Left as is in dry run mode */
+	memset(rx_buf, 0, count * SIZE_L2_POLICING_RECONF);
+	sja1105_spi_queue_init(&queue);
+
+	for (i = 0; i < count; i++) {
+		memset(&cmd, 0, sizeof(cmd));
+		cmd.valid   = 1;
+		cmd.rdwrset = SPI_WRITE;
+		cmd.index   = updates[i].index;
+		cmd.entry   = updates[i].entry;
+		sja1105_dyn_l2_policing_cmd_pack(tx_buf + i * SIZE_L2_POLICING_RECONF,
+		                                 &cmd);
+		rc = sja1105_spi_queue_add(&queue, SPI_WRITE,
+		                           SJA1105_L2_POLICING_ENTRY_ADDR,
+		                           tx_buf + i * SIZE_L2_POLICING_RECONF,
+		                           SIZE_L2_POLICING_RECONF);
+		if (rc < 0) {
+			goto out;
+		}
+		rc = sja1105_spi_queue_add(&queue, SPI_READ,
+		                           SJA1105_L2_POLICING_ENTRY_ADDR +
+		                           SIZE_L2_POLICING_ENTRY / 4,
+		                           rx_buf + i * SIZE_L2_POLICING_RECONF +
+		                           SIZE_L2_POLICING_ENTRY,
+		                           SIZE_L2_POLICING_CMD);
+		if (rc < 0) {
+			goto out;
+		}
+	}
+	rc = sja1105_spi_queue_submit(spi_setup, &queue);
+	if (rc < 0) {
+		loge("failed to write the l2 policing entries");
+		goto out;
+	}
+	for (i = 0; i < count; i++) {
+		sja1105_dyn_l2_policing_cmd_unpack(rx_buf + i * SIZE_L2_POLICING_RECONF,
+		                                   &cmd);
+		if (cmd.valid) {
+			break;
+		}
+		if (cmd.errors) {
+			loge("switch flagged the write of l2 policing entry %d "
+			     "with errors", updates[i].index);
+			rc = -EIO;
+			goto out;
+		}
+	}
+	if (i < count) {
+		logv("%d l2 policing entries had to be written again",
+		     count - i);
+	}
+	for (; i < count; i++) {
+		rc = sja1105_l2_policing_set(spi_setup, updates[i].index,
+		                             &updates[i].entry);
+		if (rc < 0) {
+			goto out;
+		}
+	}
+	rc = 0;
+out:
+	sja1105_spi_queue_free(&queue);
+	free(tx_buf);
+	return rc;
+}
@@ -0,0 +1,234 @@
+/******************************************************************************
+ * Copyright (c) 2018, NXP Semiconductors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+/* These are our own include files */
+#include <lib/include/dynamic-config.h>
+#include <lib/include/static-config.h>
+#include <lib/include/port-control.h>
+#include <lib/include/gtable.h>
+#include <lib/include/spi.h>
+#include <common.h>
+
+/* E/T: UM10944 Table 52 and 53. Two 32-bit registers, with the command
+ * and most of the entry in the second one (0x37), and TP_DELIN and
+ * TP_DELOUT in the first one (0x36). Only these fields can be changed
+ * at runtime; TOP, BASE, ENABLED, IFG, MAXAGE and DRPNONA664 cannot.
+ * The registers are write-only.
+ *
+ * P/Q/R/S: UM11040 Table 78 and 79. The whole entry, in the static
+ * config layout, at 0x4B to 0x52, followed by the command at 0x53.
+ */
+#define SJA1105ET_MAC_CONFIG_ENTRY_ADDR   0x36
+#define SJA1105PQRS_MAC_CONFIG_ENTRY_ADDR 0x4B
+#define SIZE_MAC_CONFIG_CMD               4
+#define SIZE_MAC_CONFIG_RECONF_ET         8
+#define SIZE_MAC_CONFIG_RECONF_PQRS       (SIZE_MAC_CONFIG_ENTRY_PQRS + \
+                                           SIZE_MAC_CONFIG_CMD)
+
+static void
+sja1105et_dyn_mac_config_cmd_access(void *buf,
+                                    struct sja1105_dyn_mac_config_cmd *cmd,
+                                    int write)
+{
+	int  (*pack_or_unpack)(void*, uint64_t*, int, int, int);
+	struct sja1105_mac_config_entry *entry = &cmd->entry;
+	uint8_t *reg1 = (uint8_t*) buf + 4;
+	uint8_t *reg2 = (uint8_t*) buf;
+
+	if (write == 0) {
+		pack_or_unpack = gtable_unpack;
+		memset(cmd, 0, sizeof(*cmd));
+	} else {
+		pack_or_unpack = gtable_pack;
+		memset(buf, 0, SIZE_MAC_CONFIG_RECONF_ET);
+	}
+	pack_or_unpack(reg1, &cmd->valid,       31, 31, 4);
+	pack_or_unpack(reg1, &entry->speed,     30, 29, 4);
+	pack_or_unpack(reg1, &cmd->index,       26, 24, 4);
+	pack_or_unpack(reg1, &entry->drpdtag,   23, 23, 4);
+	pack_or_unpack(reg1, &entry->drpuntag,  22, 22, 4);
+	pack_or_unpack(reg1, &entry->retag,     21, 21, 4);
+	pack_or_unpack(reg1, &entry->dyn_learn, 20, 20, 4);
+	pack_or_unpack(reg1, &entry->egress,    19, 19, 4);
+	pack_or_unpack(reg1, &entry->ingress,   18, 18, 4);
+	pack_or_unpack(reg1, &entry->ing_mirr,  17, 17, 4);
+	pack_or_unpack(reg1, &entry->egr_mirr,  16, 16, 4);
+	pack_or_unpack(reg1, &entry->vlanprio,  14, 12, 4);
+	pack_or_unpack(reg1, &entry->vlanid,    11,  0, 4);
+	pack_or_unpack(reg2, &entry->tp_delin,  31, 16, 4);
+	pack_or_unpack(reg2, &entry->tp_delout, 15,  0, 4);
+}
+
+static void
+sja1105pqrs_dyn_mac_config_cmd_access(void *buf,
+                                      struct sja1105_dyn_mac_config_cmd *cmd,
+                                      int write)
+{
+	int  (*pack_or_unpack)(void*, uint64_t*, int, int, int);
+	uint8_t *cmd_ptr = (uint8_t*) buf + SIZE_MAC_CONFIG_ENTRY_PQRS;
+
+	if (write == 0) {
+		pack_or_unpack = gtable_unpack;
+		memset(cmd, 0, sizeof(*cmd));
+		sja1105pqrs_mac_config_entry_unpack(buf, &cmd->entry);
+	} else {
+		pack_or_unpack = gtable_pack;
+		memset(buf, 0, SIZE_MAC_CONFIG_RECONF_PQRS);
+		sja1105pqrs_mac_config_entry_pack(buf, &cmd->entry);
+	}
+	pack_or_unpack(cmd_ptr, &cmd->valid,   31, 31, 4);
+	pack_or_unpack(cmd_ptr, &cmd->errors,  30, 30, 4);
+	pack_or_unpack(cmd_ptr, &cmd->rdwrset, 29, 29, 4);
+	pack_or_unpack(cmd_ptr, &cmd->index,    2,  0, 4);
+}
+
+void sja1105_dyn_mac_config_cmd_pack(void *buf,
+                                     struct sja1105_dyn_mac_config_cmd *cmd,
+                                     uint64_t device_id)
+{
+	if (IS_ET(device_id)) {
+		sja1105et_dyn_mac_config_cmd_access(buf, cmd, 1);
+	} else {
+		sja1105pqrs_dyn_mac_config_cmd_access(buf, cmd, 1);
+	}
+}
+
+void sja1105_dyn_mac_config_cmd_unpack(void *buf,
+                                       struct sja1105_dyn_mac_config_cmd *cmd,
+                                       uint64_t device_id)
+{
+	if (IS_ET(device_id)) {
+		sja1105et_dyn_mac_config_cmd_access(buf, cmd, 0);
+	} else {
+		sja1105pqrs_dyn_mac_config_cmd_access(buf, cmd, 0);
+	}
+}
+
+/* The entry and the command go out in one SPI transaction. On P/Q/R/S,
+ * the command register is then polled until the switch clears VALID,
+ * and @cmd holds what was read back. The E/T registers cannot be read,
+ * so the write is all there is to it.
+ */
+int sja1105_dyn_mac_config_cmd_commit(struct sja1105_spi_setup *spi_setup,
+                                      struct sja1105_dyn_mac_config_cmd *cmd)
+{
+	uint8_t packed_buf[SIZE_MAC_CONFIG_RECONF_PQRS];
+	int entry_addr;
+	int size;
+	int i, rc;
+
+	if (IS_ET(spi_setup->device_id)) {
+		entry_addr = SJA1105ET_MAC_CONFIG_ENTRY_ADDR;
+		size = SIZE_MAC_CONFIG_RECONF_ET;
+	} else {
+		entry_addr = SJA1105PQRS_MAC_CONFIG_ENTRY_ADDR;
+		size = SIZE_MAC_CONFIG_RECONF_PQRS;
+	}
+	cmd->valid = 1;
+	sja1105_dyn_mac_config_cmd_pack(packed_buf, cmd, spi_setup->device_id);
+
+	rc = sja1105_spi_send_packed_buf(spi_setup, SPI_WRITE, entry_addr,
+	                                 packed_buf, size);
+	if (rc < 0) {
+		loge("failed to write mac config command");
+		goto out;
+	}
+	if (IS_ET(spi_setup->device_id)) {
+		goto out;
+	}
+	for (i = 0; i < SJA1105_DYN_CMD_POLL_COUNT; i++) {
+		memset(packed_buf, 0, size);
+		rc = sja1105_spi_send_packed_buf(spi_setup, SPI_READ,
+		                                 entry_addr, packed_buf, size);
+		if (rc < 0) {
+			loge("failed to read mac config command");
+			goto out;
+		}
+		sja1105_dyn_mac_config_cmd_unpack(packed_buf, cmd,
+		                                  spi_setup->device_id);
+		if (!cmd->valid) {
+			break;
+		}
+	}
+	if (cmd->valid) {
+		loge("switch did not complete the mac config command");
+		rc = -ETIMEDOUT;
+	} else if (cmd->errors) {
+		loge("switch flagged the mac config command with errors");
+		rc = -EIO;
+	}
+out:
+	return rc;
+}
+
+int sja1105_mac_config_get(struct sja1105_spi_setup *spi_setup, int port,
+                           struct sja1105_mac_config_entry *entry)
+{
+	struct sja1105_dyn_mac_config_cmd cmd;
+	int rc;
+
+	if (IS_ET(spi_setup->device_id)) {
+		return -EOPNOTSUPP;
+	}
+	if (port < 0 || port >= SJA1105T_NUM_PORTS) {
+		return -ERANGE;
+	}
+	memset(&cmd, 0, sizeof(cmd));
+	cmd.rdwrset = SPI_READ;
+	cmd.index = port;
+	rc = sja1105_dyn_mac_config_cmd_commit(spi_setup, &cmd);
+	if (rc < 0) {
+		return rc;
+	}
+	*entry = cmd.entry;
+	return 0;
+}
+
+/* Writes the MAC Configuration of @port on the running switch. The
+ * other ports keep forwarding meanwhile. On E/T, the fields that cannot
+ * be reconfigured (see above) are left as they are in the switch. */
+int sja1105_mac_config_set(struct sja1105_spi_setup *spi_setup, int port,
+                           const struct sja1105_mac_config_entry *entry)
+{
+	struct sja1105_dyn_mac_config_cmd cmd;
+
+	if (port < 0 || port >= SJA1105T_NUM_PORTS) {
+		return -ERANGE;
+	}
+	memset(&cmd, 0, sizeof(cmd));
+	cmd.rdwrset = SPI_WRITE;
+	cmd.index = port;
+	cmd.entry = *entry;
+	return sja1105_dyn_mac_config_cmd_commit(spi_setup, &cmd);
+}
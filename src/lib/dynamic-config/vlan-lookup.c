@@ -0,0 +1,262 @@
+/******************************************************************************
+ * Copyright (c) 2018, NXP Semiconductors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+/* These are our own include files */
+#include <lib/include/dynamic-config.h>
+#include <lib/include/static-config.h>
+#include <lib/include/gtable.h>
+#include <lib/include/spi.h>
+#include <common.h>
+
+/* Buffer is segregated into 3 parts:
+ *   * ENTRY: a portion of SIZE_VLAN_LOOKUP_ENTRY (8) bytes, at addresses
+ *            0x27 and 0x28 on E/T (UM10944) and 0x2D and 0x2E on
+ *            P/Q/R/S (UM11040)
+ *   * a 4 byte gap, at 0x29 on E/T and 0x2F on P/Q/R/S
+ *   * CMD: a portion of 4 bytes, at 0x2A on E/T and 0x30 on P/Q/R/S
+ * The entry has the same layout as in the static config, and its
+ * VLANID is the index of the entry that is read or written.
+ * On E/T, 0x2B to 0x2D is the L2 Policing block instead, which P/Q/R/S
+ * do not have (see l2-policing.c).
+ */
+#define SJA1105ET_VLAN_LOOKUP_ENTRY_ADDR   0x27
+#define SJA1105PQRS_VLAN_LOOKUP_ENTRY_ADDR 0x2D
+#define SIZE_VLAN_LOOKUP_CMD               4
+#define SIZE_VLAN_LOOKUP_RECONF            (SIZE_VLAN_LOOKUP_ENTRY + 4 + \
+                                            SIZE_VLAN_LOOKUP_CMD)
+
+static void
+sja1105_dyn_vlan_lookup_cmd_access(void *buf,
+                                   struct sja1105_dyn_vlan_lookup_cmd *cmd,
+                                   int write)
+{
+	int  (*pack_or_unpack)(void*, uint64_t*, int, int, int);
+	uint8_t *cmd_ptr = (uint8_t*) buf + SIZE_VLAN_LOOKUP_ENTRY + 4;
+
+	if (write == 0) {
+		pack_or_unpack = gtable_unpack;
+		memset(cmd, 0, sizeof(*cmd));
+		sja1105_vlan_lookup_entry_unpack(buf, &cmd->entry);
+	} else {
+		pack_or_unpack = gtable_pack;
+		memset(buf, 0, SIZE_VLAN_LOOKUP_RECONF);
+		sja1105_vlan_lookup_entry_pack(buf, &cmd->entry);
+	}
+	pack_or_unpack(cmd_ptr, &cmd->valid,    31, 31, 4);
+	pack_or_unpack(cmd_ptr, &cmd->rdwrset,  30, 30, 4);
+	pack_or_unpack(cmd_ptr, &cmd->valident, 27, 27, 4);
+}
+
+void sja1105_dyn_vlan_lookup_cmd_pack(void *buf,
+                                      struct sja1105_dyn_vlan_lookup_cmd *cmd)
+{
+	sja1105_dyn_vlan_lookup_cmd_access(buf, cmd, 1);
+}
+
+void sja1105_dyn_vlan_lookup_cmd_unpack(void *buf,
+                                        struct sja1105_dyn_vlan_lookup_cmd *cmd)
+{
+	sja1105_dyn_vlan_lookup_cmd_access(buf, cmd, 0);
+}
+
+/* Same protocol as sja1105_dyn_l2_lookup_cmd_commit: the entry and the
+ * command go out in one SPI transaction, then the command register is
+ * polled until the switch clears VALID. On return, @cmd holds what was
+ * read back. Returns -ETIMEDOUT if the switch never completes it.
+ */
+int sja1105_dyn_vlan_lookup_cmd_commit(struct sja1105_spi_setup *spi_setup,
+                                       struct sja1105_dyn_vlan_lookup_cmd *cmd)
+{
+	uint8_t packed_buf[SIZE_VLAN_LOOKUP_RECONF];
+	int entry_addr;
+	int i, rc;
+
+	entry_addr = IS_ET(spi_setup->device_id) ?
+	             SJA1105ET_VLAN_LOOKUP_ENTRY_ADDR :
+	             SJA1105PQRS_VLAN_LOOKUP_ENTRY_ADDR;
+	cmd->valid = 1;
+	sja1105_dyn_vlan_lookup_cmd_pack(packed_buf, cmd);
+
+	rc = sja1105_spi_send_packed_buf(spi_setup, SPI_WRITE, entry_addr,
+	                                 packed_buf, SIZE_VLAN_LOOKUP_RECONF);
+	if (rc < 0) {
+		loge("failed to write vlan lookup command");
+		goto out;
+	}
+	for (i = 0; i < SJA1105_DYN_CMD_POLL_COUNT; i++) {
+		memset(packed_buf, 0, SIZE_VLAN_LOOKUP_RECONF);
+		rc = sja1105_spi_send_packed_buf(spi_setup, SPI_READ,
+		                                 entry_addr, packed_buf,
+		                                 SIZE_VLAN_LOOKUP_RECONF);
+		if (rc < 0) {
+			loge("failed to read vlan lookup command");
+			goto out;
+		}
+		sja1105_dyn_vlan_lookup_cmd_unpack(packed_buf, cmd);
+		if (!cmd->valid) {
+			break;
+		}
+	}
+	if (cmd->valid) {
+		loge("switch did not complete the vlan lookup command");
+		rc = -ETIMEDOUT;
+	}
+out:
+	return rc;
+}
+
+int sja1105_vlan_get(struct sja1105_spi_setup *spi_setup, uint16_t vid,
+                     struct sja1105_vlan_lookup_entry *entry)
+{
+	struct sja1105_dyn_vlan_lookup_cmd cmd;
+	int rc;
+
+	if (IS_ET(spi_setup->device_id)) {
+		return -EOPNOTSUPP;
+	}
+	if (vid >= MAX_VLAN_LOOKUP_COUNT) {
+		return -ERANGE;
+	}
+	memset(&cmd, 0, sizeof(cmd));
+	cmd.rdwrset = SPI_READ;
+	cmd.entry.vlanid = vid;
+	rc = sja1105_dyn_vlan_lookup_cmd_commit(spi_setup, &cmd);
+	if (rc < 0) {
+		return rc;
+	}
+	if (!cmd.valident) {
+		return -ENOENT;
+	}
+	*entry = cmd.entry;
+	entry->vlanid = vid;
+	return 0;
+}
+
+int sja1105_vlan_set(struct sja1105_spi_setup *spi_setup,
+                     struct sja1105_vlan_lookup_entry *entry)
+{
+	struct sja1105_dyn_vlan_lookup_cmd cmd;
+
+	if (entry->vlanid >= MAX_VLAN_LOOKUP_COUNT) {
+		return -ERANGE;
+	}
+	memset(&cmd, 0, sizeof(cmd));
+	cmd.rdwrset  = SPI_WRITE;
+	cmd.valident = 1;
+	cmd.entry    = *entry;
+	return sja1105_dyn_vlan_lookup_cmd_commit(spi_setup, &cmd);
+}
+
+/* Invalidates the entry of @vid: frames of that VLAN are dropped */
+int sja1105_vlan_del(struct sja1105_spi_setup *spi_setup, uint16_t vid)
+{
+	struct sja1105_dyn_vlan_lookup_cmd cmd;
+
+	if (vid >= MAX_VLAN_LOOKUP_COUNT) {
+		return -ERANGE;
+	}
+	memset(&cmd, 0, sizeof(cmd));
+	cmd.rdwrset  = SPI_WRITE;
+	cmd.valident = 0;
+	cmd.entry.vlanid = vid;
+	return sja1105_dyn_vlan_lookup_cmd_commit(spi_setup, &cmd);
+}
+
+/* Brings the VLAN Lookup table of a running switch from @old_entries
+ * to @new_entries, writing only the VIDs whose entry changed and
+ * invalidating those that are gone. Returns the number of entries
+ * written, or a negative error code (the switch is then left
+ * somewhere in between).
+ */
+int sja1105_vlan_sync(struct sja1105_spi_setup *spi_setup,
+                      const struct sja1105_vlan_lookup_entry *old_entries,
+                      int old_count,
+                      const struct sja1105_vlan_lookup_entry *new_entries,
+                      int new_count)
+{
+	struct sja1105_vlan_lookup_index *old_index;
+	struct sja1105_vlan_lookup_index *new_index;
+	struct sja1105_vlan_lookup_entry entry;
+	uint64_t bits;
+	int old_pos, new_pos;
+	int count = 0;
+	int w, b, vid;
+	int rc;
+
+	old_index = malloc(sizeof(*old_index));
+	new_index = malloc(sizeof(*new_index));
+	if (!old_index || !new_index) {
+		rc = -ENOMEM;
+		goto out;
+	}
+	rc = sja1105_vlan_lookup_index_build(old_index, old_entries, old_count);
+	if (rc < 0) {
+		goto out;
+	}
+	rc = sja1105_vlan_lookup_index_build(new_index, new_entries, new_count);
+	if (rc < 0) {
+		goto out;
+	}
+	for (w = 0; w < SJA1105_VLAN_INDEX_WORDS; w++) {
+		bits = old_index->present[w] | new_index->present[w];
+		while (bits) {
+			b = __builtin_ctzll(bits);
+			bits &= bits - 1;
+			vid = w * 64 + b;
+			old_pos = sja1105_vlan_lookup_index_find(old_index, vid);
+			new_pos = sja1105_vlan_lookup_index_find(new_index, vid);
+			if (new_pos < 0) {
+				rc = sja1105_vlan_del(spi_setup, vid);
+			} else if (old_pos < 0 ||
+			           memcmp(&old_entries[old_pos],
+			                  &new_entries[new_pos],
+			                  sizeof(entry)) != 0) {
+				entry = new_entries[new_pos];
+				rc = sja1105_vlan_set(spi_setup, &entry);
+			} else {
+				continue;
+			}
+			if (rc < 0) {
+				loge("failed to update VLAN %d", vid);
+				goto out;
+			}
+			count++;
+		}
+	}
+	rc = count;
+out:
+	free(new_index);
+	free(old_index);
+	return rc;
+}
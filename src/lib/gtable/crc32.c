@@ -0,0 +1,362 @@
+/******************************************************************************
+ * Copyright (c) 2018, NXP Semiconductors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+#include <inttypes.h>
+#include <stdint.h>
+#include <string.h>
+#include <lib/include/gtable.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CRC32_HAVE_PCLMUL
+#elif defined(__aarch64__) && defined(__linux__)
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#include <arm_acle.h>
+#define CRC32_HAVE_ARMV8
+#endif
+
+/* Ethernet CRC polynomial 0x04C11DB7, bit-reversed */
+#define ETHER_CRC32_POLY_LE 0xEDB88320
+
+extern int g_quirks;
+
+/* The switch does not checksum the buffer in memory order.
+ * The buffer is treated as a sequence of 32-bit words, each read the way
+ * gtable_unpack reads a 4-byte field (so subject to the quirks), and the
+ * bytes of every word are fed to the CRC least significant first.
+ * QUIRK_LSW32_IS_FIRST has no effect on a single 32-bit word.
+ * Other than this, it is the usual reflected Ethernet CRC32, so the
+ * per-word processing below is the textbook one.
+ */
+static inline uint32_t crc32_word_load(const uint8_t *p, int quirks)
+{
+	uint32_t w;
+
+	if (quirks & QUIRK_LITTLE_ENDIAN) {
+		w =  (uint32_t) p[0] | ((uint32_t) p[1] << 8) |
+		    ((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24);
+	} else {
+		w = ((uint32_t) p[0] << 24) | ((uint32_t) p[1] << 16) |
+		    ((uint32_t) p[2] << 8) | (uint32_t) p[3];
+	}
+	if (quirks & QUIRK_MSB_ON_THE_RIGHT) {
+		/* Reverse the bits within each byte */
+		w = ((w >> 1) & 0x55555555) | ((w & 0x55555555) << 1);
+		w = ((w >> 2) & 0x33333333) | ((w & 0x33333333) << 2);
+		w = ((w >> 4) & 0x0F0F0F0F) | ((w & 0x0F0F0F0F) << 4);
+	}
+	return w;
+}
+
+/* Slicing-by-8 lookup tables, built on first use */
+static uint32_t crc32_table[8][256];
+static int      crc32_table_ready;
+
+static void crc32_table_init(void)
+{
+	uint32_t crc;
+	int i, j;
+
+	if (__atomic_load_n(&crc32_table_ready, __ATOMIC_ACQUIRE)) {
+		return;
+	}
+	for (i = 0; i < 256; i++) {
+		crc = i;
+		for (j = 0; j < 8; j++) {
+			crc = (crc >> 1) ^ ((crc & 1) ? ETHER_CRC32_POLY_LE : 0);
+		}
+		crc32_table[0][i] = crc;
+	}
+	for (i = 0; i < 256; i++) {
+		crc = crc32_table[0][i];
+		for (j = 1; j < 8; j++) {
+			crc = (crc >> 8) ^ crc32_table[0][crc & 0xFF];
+			crc32_table[j][i] = crc;
+		}
+	}
+	__atomic_store_n(&crc32_table_ready, 1, __ATOMIC_RELEASE);
+}
+
+/* @len must be a multiple of 4 */
+static uint32_t
+crc32_slice8(uint32_t crc, const uint8_t *p, unsigned int len, int quirks)
+{
+	uint32_t (*t)[256] = crc32_table;
+	uint32_t one, two;
+
+	crc32_table_init();
+
+	while (len >= 8) {
+		one = crc32_word_load(p, quirks) ^ crc;
+		two = crc32_word_load(p + 4, quirks);
+		crc = t[7][one & 0xFF] ^ t[6][(one >> 8) & 0xFF] ^
+		      t[5][(one >> 16) & 0xFF] ^ t[4][one >> 24] ^
+		      t[3][two & 0xFF] ^ t[2][(two >> 8) & 0xFF] ^
+		      t[1][(two >> 16) & 0xFF] ^ t[0][two >> 24];
+		p   += 8;
+		len -= 8;
+	}
+	if (len >= 4) {
+		one = crc32_word_load(p, quirks) ^ crc;
+		crc = t[3][one & 0xFF] ^ t[2][(one >> 8) & 0xFF] ^
+		      t[1][(one >> 16) & 0xFF] ^ t[0][one >> 24];
+	}
+	return crc;
+}
+
+#ifdef CRC32_HAVE_PCLMUL
+
+/* Folding with carry-less multiplication, as described in Intel's
+ * "Fast CRC Computation for Generic Polynomials Using PCLMULQDQ
+ * Instruction". Constants are for the bit-reflected Ethernet polynomial.
+ * Only whole 16-byte blocks are consumed, the rest is left to the caller.
+ * @len must be at least 64.
+ */
+__attribute__((target("pclmul,ssse3,sse4.1")))
+static uint32_t
+crc32_pclmul(uint32_t crc, const uint8_t *p, unsigned int len, int quirks)
+{
+	const __m128i k1k2 = _mm_set_epi64x(0x01c6e41596, 0x0154442bd4);
+	const __m128i k3k4 = _mm_set_epi64x(0x00ccaa009e, 0x01751997d0);
+	const __m128i k5k0 = _mm_set_epi64x(0x0000000000, 0x0163cd6124);
+	const __m128i poly = _mm_set_epi64x(0x01f7011641, 0x01db710641);
+	const __m128i mask32 = _mm_setr_epi32(~0, 0, ~0, 0);
+	/* Byte swap within each 32-bit word, unless the buffer
+	 * is already little endian */
+	const __m128i bswap = (quirks & QUIRK_LITTLE_ENDIAN) ?
+	                      _mm_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9,
+	                                    10, 11, 12, 13, 14, 15) :
+	                      _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10,
+	                                    9, 8, 15, 14, 13, 12);
+	__m128i x0, x1, x2, x3, x4, x5, x6, x7, x8;
+
+#define CRC32_LOAD(ptr) \
+	_mm_shuffle_epi8(_mm_loadu_si128((const __m128i*) (ptr)), bswap)
+
+	x1 = CRC32_LOAD(p + 0x00);
+	x2 = CRC32_LOAD(p + 0x10);
+	x3 = CRC32_LOAD(p + 0x20);
+	x4 = CRC32_LOAD(p + 0x30);
+	x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128(crc));
+	p   += 64;
+	len -= 64;
+
+	/* Fold 4 blocks of 16 bytes in parallel */
+	x0 = k1k2;
+	while (len >= 64) {
+		x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+		x6 = _mm_clmulepi64_si128(x2, x0, 0x00);
+		x7 = _mm_clmulepi64_si128(x3, x0, 0x00);
+		x8 = _mm_clmulepi64_si128(x4, x0, 0x00);
+		x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+		x2 = _mm_clmulepi64_si128(x2, x0, 0x11);
+		x3 = _mm_clmulepi64_si128(x3, x0, 0x11);
+		x4 = _mm_clmulepi64_si128(x4, x0, 0x11);
+		x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), CRC32_LOAD(p + 0x00));
+		x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), CRC32_LOAD(p + 0x10));
+		x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), CRC32_LOAD(p + 0x20));
+		x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), CRC32_LOAD(p + 0x30));
+		p   += 64;
+		len -= 64;
+	}
+	/* Fold into 128 bits */
+	x0 = k3k4;
+	x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+	x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+	x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+	x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+	x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+	x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), x5);
+	x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+	x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+	x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), x5);
+	/* Remaining blocks of 16 bytes */
+	while (len >= 16) {
+		x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+		x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+		x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), CRC32_LOAD(p));
+		p   += 16;
+		len -= 16;
+	}
+#undef CRC32_LOAD
+	/* Fold 128 bits to 64 bits */
+	x2 = _mm_clmulepi64_si128(x1, x0, 0x10);
+	x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+	x0 = k5k0;
+	x2 = _mm_srli_si128(x1, 4);
+	x1 = _mm_and_si128(x1, mask32);
+	x1 = _mm_clmulepi64_si128(x1, x0, 0x00);
+	x1 = _mm_xor_si128(x1, x2);
+	/* Barrett reduction to 32 bits */
+	x0 = poly;
+	x2 = _mm_and_si128(x1, mask32);
+	x2 = _mm_clmulepi64_si128(x2, x0, 0x10);
+	x2 = _mm_and_si128(x2, mask32);
+	x2 = _mm_clmulepi64_si128(x2, x0, 0x00);
+	x1 = _mm_xor_si128(x1, x2);
+
+	return _mm_extract_epi32(x1, 1);
+}
+
+static uint32_t
+crc32_x86(uint32_t crc, const uint8_t *p, unsigned int len, int quirks)
+{
+	unsigned int folded;
+
+	if (len < 64 || (quirks & QUIRK_MSB_ON_THE_RIGHT)) {
+		return crc32_slice8(crc, p, len, quirks);
+	}
+	folded = len & ~15u;
+	crc = crc32_pclmul(crc, p, folded, quirks);
+	return crc32_slice8(crc, p + folded, len - folded, quirks);
+}
+
+#endif
+
+#ifdef CRC32_HAVE_ARMV8
+
+/* The CRC32X/CRC32W instructions use the Ethernet polynomial
+ * and consume their operand least significant byte first. */
+__attribute__((target("+crc")))
+static uint32_t
+crc32_armv8(uint32_t crc, const uint8_t *p, unsigned int len, int quirks)
+{
+	uint64_t dword;
+
+	while (len >= 8) {
+		dword = ((uint64_t) crc32_word_load(p + 4, quirks) << 32) |
+		         crc32_word_load(p, quirks);
+		crc = __crc32d(crc, dword);
+		p   += 8;
+		len -= 8;
+	}
+	if (len >= 4) {
+		crc = __crc32w(crc, crc32_word_load(p, quirks));
+	}
+	return crc;
+}
+
+#endif
+
+typedef uint32_t (*crc32_fn)(uint32_t, const uint8_t*, unsigned int, int);
+
+static crc32_fn crc32_impl;
+
+static crc32_fn crc32_select(void)
+{
+	crc32_fn fn = __atomic_load_n(&crc32_impl, __ATOMIC_ACQUIRE);
+
+	if (fn != NULL) {
+		return fn;
+	}
+	fn = crc32_slice8;
+#if defined(CRC32_HAVE_PCLMUL)
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("pclmul") &&
+	    __builtin_cpu_supports("ssse3") &&
+	    __builtin_cpu_supports("sse4.1")) {
+		fn = crc32_x86;
+	}
+#elif defined(CRC32_HAVE_ARMV8)
+	if (getauxval(AT_HWCAP) & HWCAP_CRC32) {
+		fn = crc32_armv8;
+	}
+#endif
+	__atomic_store_n(&crc32_impl, fn, __ATOMIC_RELEASE);
+	return fn;
+}
+
+/* Continue a CRC over @buf. Same convention as zlib's crc32():
+ * ether_crc32_le_update(ether_crc32_le(a, len_a), b, len_b) is the CRC
+ * of a followed by b, and ether_crc32_le(buf, len) is the same as
+ * ether_crc32_le_update(0, buf, len).
+ */
+uint32_t ether_crc32_le_update(uint32_t crc, void *buf, unsigned int len)
+{
+	unsigned int aligned = len & ~3u;
+	uint8_t tail[4] = {0};
+
+	crc = ~crc;
+	crc = crc32_select()(crc, buf, aligned, g_quirks);
+	if (aligned != len) {
+		/* Not expected from a static config buffer.
+		 * Pad the last word with zeroes. */
+		memcpy(tail, (uint8_t*) buf + aligned, len - aligned);
+		crc = crc32_slice8(crc, tail, 4, g_quirks);
+	}
+	return ~crc;
+}
+
+uint32_t ether_crc32_le(void *buf, unsigned int len)
+{
+	return ether_crc32_le_update(0, buf, len);
+}
+
+/* Polynomial multiplication modulo the (bit-reflected) CRC polynomial */
+static uint32_t crc32_multmodp(uint32_t a, uint32_t b)
+{
+	uint32_t m = (uint32_t) 1 << 31;
+	uint32_t p = 0;
+
+	while (m) {
+		if (a & m) {
+			p ^= b;
+		}
+		m >>= 1;
+		b = (b & 1) ? (b >> 1) ^ ETHER_CRC32_POLY_LE : b >> 1;
+	}
+	return p;
+}
+
+/* x^(8 * len) modulo the CRC polynomial, by repeated squaring */
+static uint32_t crc32_x8nmodp(unsigned int len)
+{
+	uint32_t x2k = (uint32_t) 1 << 23; /* x^8 */
+	uint32_t p   = (uint32_t) 1 << 31; /* x^0 */
+
+	while (len) {
+		if (len & 1) {
+			p = crc32_multmodp(x2k, p);
+		}
+		x2k = crc32_multmodp(x2k, x2k);
+		len >>= 1;
+	}
+	return p;
+}
+
+/* Given crc1 = CRC(a) and crc2 = CRC(b), return CRC(a followed by b),
+ * in O(log(len2)) time. Both buffers must have a length which is a
+ * multiple of 4, since the switch checksums 32-bit words.
+ */
+uint32_t ether_crc32_combine(uint32_t crc1, uint32_t crc2, unsigned int len2)
+{
+	return crc32_multmodp(crc32_x8nmodp(len2), crc1) ^ crc2;
+}
@@ -30,6 +30,7 @@
  *****************************************************************************/
 #include <inttypes.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include <stdio.h>
 #include <errno.h>
 #include <lib/include/gtable.h>
@@ -247,6 +248,246 @@ gtable_pack(void *buf, uint64_t *value, int start, int end,
 	                           len_bytes, GTABLE_PACK, g_quirks);
 }
 
+/* A compiled field plan is a flat list of operations, one for each
+ * piece of a field that lies within a single logical 32-bit word of the
+ * packed entry. Logical word k holds bits 32*k+31 to 32*k of the entry.
+ */
+struct gtable_op {
+	/* Right-aligned mask of the bits moved by this operation */
+	uint32_t mask;
+	/* Byte offset of the uint64_t inside the unpacked entry */
+	uint16_t entry_offset;
+	/* Logical word of the packed entry */
+	uint8_t  word;
+	/* Position of the piece inside the word, and inside the value */
+	uint8_t  word_shift;
+	uint8_t  value_shift;
+	/* Field width on the first piece of a field, 0 on the others */
+	uint8_t  width;
+};
+
+struct gtable_plan_ops {
+	int count;
+	struct gtable_op op[];
+};
+
+/* Marks a plan that failed to compile. Such a plan is still usable,
+ * but goes through gtable_field_access for every field. */
+static struct gtable_plan_ops gtable_plan_invalid;
+
+#define GTABLE_PLAN_MAX_WORDS 255
+
+int gtable_plan_compile(struct gtable_plan *plan)
+{
+	struct gtable_plan_ops *ops;
+	struct gtable_plan_ops *expected = NULL;
+	const struct gtable_field *field;
+	int start, end, lo, hi;
+	int count = 0;
+	int i, j;
+
+	if (__atomic_load_n(&plan->ops, __ATOMIC_ACQUIRE) != NULL) {
+		return (plan->ops == &gtable_plan_invalid) ? -EINVAL : 0;
+	}
+	if ((plan->len_bytes % 4) != 0 ||
+	    (plan->len_bytes / 4) > GTABLE_PLAN_MAX_WORDS) {
+		loge("gtable_plan_compile: unsupported entry length %d",
+		     plan->len_bytes);
+		goto invalid;
+	}
+	/* First pass: validate fields and count the operations */
+	for (i = 0; i < plan->field_count; i++) {
+		field = &plan->fields[i];
+		for (j = 0; j < field->count; j++) {
+			start = field->start + j * field->stride;
+			end   = field->end + j * field->stride;
+			if (start < end || start - end + 1 > 64 || end < 0 ||
+			    start >= plan->len_bytes * 8) {
+				loge("gtable_plan_compile: invalid field %d-%d",
+				     start, end);
+				goto invalid;
+			}
+			count += start / 32 - end / 32 + 1;
+		}
+	}
+	ops = malloc(sizeof(*ops) + count * sizeof(struct gtable_op));
+	if (ops == NULL) {
+		loge("gtable_plan_compile: out of memory");
+		goto invalid;
+	}
+	/* Second pass: split every field on 32-bit word boundaries */
+	ops->count = 0;
+	for (i = 0; i < plan->field_count; i++) {
+		field = &plan->fields[i];
+		for (j = 0; j < field->count; j++) {
+			start = field->start + j * field->stride;
+			end   = field->end + j * field->stride;
+			for (lo = end; lo <= start; lo = hi + 1) {
+				struct gtable_op *op = &ops->op[ops->count++];
+
+				hi = (lo / 32) * 32 + 31;
+				if (hi > start) {
+					hi = start;
+				}
+				op->mask = (hi - lo == 31) ? 0xFFFFFFFF :
+				           ((1u << (hi - lo + 1)) - 1);
+				op->entry_offset = field->offset +
+				                   j * sizeof(uint64_t);
+				op->word = lo / 32;
+				op->word_shift = lo % 32;
+				op->value_shift = lo - end;
+				op->width = (lo == end) ? (start - end + 1) : 0;
+			}
+		}
+	}
+	if (!__atomic_compare_exchange_n(&plan->ops, &expected, ops, 0,
+	                                 __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+		/* Somebody else compiled it in the meantime */
+		free(ops);
+	}
+	return 0;
+invalid:
+	__atomic_compare_exchange_n(&plan->ops, &expected,
+	                            &gtable_plan_invalid, 0,
+	                            __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+	return -EINVAL;
+}
+
+static struct gtable_plan_ops *gtable_plan_get_ops(struct gtable_plan *plan)
+{
+	struct gtable_plan_ops *ops;
+
+	ops = __atomic_load_n(&plan->ops, __ATOMIC_ACQUIRE);
+	if (ops == NULL) {
+		gtable_plan_compile(plan);
+		ops = __atomic_load_n(&plan->ops, __ATOMIC_ACQUIRE);
+	}
+	/* The bit-reversal quirk is only supported field by field */
+	if (ops == &gtable_plan_invalid || (g_quirks & QUIRK_MSB_ON_THE_RIGHT)) {
+		return NULL;
+	}
+	return ops;
+}
+
+static void
+gtable_plan_slow_access(struct gtable_plan *plan, void *buf, void *entry,
+                        enum gtable_operation op)
+{
+	const struct gtable_field *field;
+	uint64_t *value;
+	int i, j;
+
+	for (i = 0; i < plan->field_count; i++) {
+		field = &plan->fields[i];
+		for (j = 0; j < field->count; j++) {
+			value = (uint64_t*) ((uint8_t*) entry + field->offset) + j;
+			gtable_field_access(buf, value,
+			                    field->start + j * field->stride,
+			                    field->end + j * field->stride,
+			                    plan->len_bytes, op, g_quirks);
+		}
+	}
+}
+
+/* Physical location of logical word @word. Without quirks,
+ * the most significant word comes first in memory. */
+static inline uint8_t*
+gtable_word_addr(uint8_t *buf, int word, int len_bytes, int quirks)
+{
+	if (quirks & QUIRK_LSW32_IS_FIRST) {
+		return buf + 4 * word;
+	}
+	return buf + len_bytes - 4 * (word + 1);
+}
+
+static inline uint32_t gtable_word_load(const uint8_t *p, int quirks)
+{
+	if (quirks & QUIRK_LITTLE_ENDIAN) {
+		return  (uint32_t) p[0] | ((uint32_t) p[1] << 8) |
+		       ((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24);
+	}
+	return ((uint32_t) p[0] << 24) | ((uint32_t) p[1] << 16) |
+	       ((uint32_t) p[2] << 8) | (uint32_t) p[3];
+}
+
+static inline void gtable_word_store(uint8_t *p, uint32_t w, int quirks)
+{
+	if (quirks & QUIRK_LITTLE_ENDIAN) {
+		p[0] = w; p[1] = w >> 8; p[2] = w >> 16; p[3] = w >> 24;
+	} else {
+		p[0] = w >> 24; p[1] = w >> 16; p[2] = w >> 8; p[3] = w;
+	}
+}
+
+void gtable_plan_unpack(struct gtable_plan *plan, void *buf, void *entry)
+{
+	struct gtable_plan_ops *ops = gtable_plan_get_ops(plan);
+	uint32_t words[GTABLE_PLAN_MAX_WORDS];
+	int num_words = plan->len_bytes / 4;
+	const struct gtable_op *op;
+	uint64_t *value;
+	int quirks = g_quirks;
+	int i;
+
+	if (ops == NULL) {
+		gtable_plan_slow_access(plan, buf, entry, GTABLE_UNPACK);
+		return;
+	}
+	for (i = 0; i < num_words; i++) {
+		words[i] = gtable_word_load(gtable_word_addr(buf, i,
+		                            plan->len_bytes, quirks), quirks);
+	}
+	for (i = 0; i < ops->count; i++) {
+		op = &ops->op[i];
+		value = (uint64_t*) ((uint8_t*) entry + op->entry_offset);
+		if (op->width) {
+			*value = 0;
+		}
+		*value |= (uint64_t) ((words[op->word] >> op->word_shift) &
+		                      op->mask) << op->value_shift;
+	}
+}
+
+void gtable_plan_pack(struct gtable_plan *plan, void *buf, void *entry)
+{
+	struct gtable_plan_ops *ops = gtable_plan_get_ops(plan);
+	uint32_t words[GTABLE_PLAN_MAX_WORDS];
+	int num_words = plan->len_bytes / 4;
+	const struct gtable_op *op;
+	uint64_t *value;
+	uint32_t chunk;
+	int quirks = g_quirks;
+	int i;
+
+	if (ops == NULL) {
+		gtable_plan_slow_access(plan, buf, entry, GTABLE_PACK);
+		return;
+	}
+	for (i = 0; i < num_words; i++) {
+		words[i] = gtable_word_load(gtable_word_addr(buf, i,
+		                            plan->len_bytes, quirks), quirks);
+	}
+	for (i = 0; i < ops->count; i++) {
+		op = &ops->op[i];
+		value = (uint64_t*) ((uint8_t*) entry + op->entry_offset);
+		if (op->width && op->width < 64 &&
+		   (*value >= (1ull << op->width))) {
+			loge("gtable_access: Warning, cannot store %" PRIX64
+			     " inside %d bits!", *value, op->width);
+			*value &= (1ull << op->width) - 1;
+			loge("Truncated value to %" PRIX64 ", this may not be "
+			     "what you want.", *value);
+		}
+		chunk = (*value >> op->value_shift) & op->mask;
+		words[op->word] &= ~(op->mask << op->word_shift);
+		words[op->word] |= chunk << op->word_shift;
+	}
+	for (i = 0; i < num_words; i++) {
+		gtable_word_store(gtable_word_addr(buf, i, plan->len_bytes,
+		                  quirks), words[i], quirks);
+	}
+}
+
 void gtable_hexdump(void *table, int len)
 {
 	uint8_t *p = (uint8_t*) table;
@@ -299,40 +540,3 @@ int gtable_configure(int quirks)
 	quirks &= ~(1 << QUIRK_MSB_ON_THE_RIGHT);
 	return (quirks == 0) ? 0 : -EINVAL;
 }
-
-static uint32_t crc32_add(uint32_t crc, uint8_t byte)
-{
-	const uint32_t ether_crc32_poly = 0x04C11DB7;
-	uint32_t byte32 = bit_reverse(byte, 32);
-	int i;
-
-	for (i = 0; i < 8; i++) {
-		if ((crc ^ byte32) & (1 << 31)) {
-			crc <<= 1;
-			crc ^= ether_crc32_poly;
-		} else {
-			crc <<= 1;
-		}
-		byte32 <<= 1;
-	}
-	return crc;
-}
-
-uint32_t ether_crc32_le(void *buf, unsigned int len)
-{
-	unsigned int i;
-	uint64_t chunk;
-	uint32_t crc;
-
-	/* seed */
-	crc = 0xFFFFFFFF;
-	for (i = 0; i < len; i += 4) {
-		gtable_unpack(buf + i, &chunk, 31, 0, 4);
-		crc = crc32_add(crc, chunk & 0xFF);
-		crc = crc32_add(crc, (chunk >> 8) & 0xFF);
-		crc = crc32_add(crc, (chunk >> 16) & 0xFF);
-		crc = crc32_add(crc, (chunk >> 24) & 0xFF);
-	}
-	return bit_reverse(~crc, 32);
-}
-
@@ -31,11 +31,16 @@
 #ifndef _DYN_CFG_H
 #define _DYN_CFG_H
 
+#include <signal.h>
 #include "spi.h"
 #include "static-config.h"
 
 #define SJA1105_MGMT_ROUTE_COUNT 4
 
+/* The switch normally clears VALID before the host is able to read
+ * the command register back, so a few reads are more than enough */
+#define SJA1105_DYN_CMD_POLL_COUNT 10
+
 struct sja1105_mgmt_entry {
 	uint64_t ts_regid;
 	uint64_t egr_ts;
@@ -50,6 +55,14 @@ union sja1105_dyn_l2_lookup_entry {
 	struct sja1105_mgmt_entry mgmt;
 };
 
+/* P/Q/R/S only: operation requested through HOSTCMD */
+enum sja1105_hostcmd {
+	SJA1105_HOSTCMD_SEARCH     = 1,
+	SJA1105_HOSTCMD_READ       = 2,
+	SJA1105_HOSTCMD_WRITE      = 3,
+	SJA1105_HOSTCMD_INVALIDATE = 4,
+};
+
 struct sja1105_dyn_l2_lookup_cmd {
 	uint64_t valid;
 	uint64_t rdwrset;
@@ -57,15 +70,163 @@ struct sja1105_dyn_l2_lookup_cmd {
 	uint64_t lockeds;
 	uint64_t valident;
 	uint64_t mgmtroute;
+	uint64_t hostcmd;    /* P/Q/R/S only */
 	union sja1105_dyn_l2_lookup_entry entry;
 };
 
-void sja1105_dyn_l2_lookup_cmd_pack(void *buf, struct
-                                    sja1105_dyn_l2_lookup_cmd *cmd);
-void sja1105_dyn_l2_lookup_cmd_unpack(void *buf, struct
-                                      sja1105_dyn_l2_lookup_cmd *cmd);
+/* An entry of the forwarding database, as seen at runtime through the
+ * L2 Address Lookup table reconfiguration registers */
+struct sja1105_fdb_entry {
+	struct sja1105_l2_lookup_entry l2;
+	uint64_t lockeds;    /* Static entry, not subject to ageing */
+};
+
+void sja1105_dyn_l2_lookup_cmd_pack(void *buf,
+                                    struct sja1105_dyn_l2_lookup_cmd *cmd,
+                                    uint64_t device_id);
+void sja1105_dyn_l2_lookup_cmd_unpack(void *buf,
+                                      struct sja1105_dyn_l2_lookup_cmd *cmd,
+                                      uint64_t device_id);
+void sja1105_dyn_l2_lookup_cmd_show(struct sja1105_dyn_l2_lookup_cmd *cmd);
+int sja1105_dyn_l2_lookup_cmd_commit(struct sja1105_spi_setup*,
+                                     struct sja1105_dyn_l2_lookup_cmd*);
 int sja1105_mgmt_route_get(struct sja1105_spi_setup*, struct sja1105_mgmt_entry*, int index);
 int sja1105_mgmt_route_set(struct sja1105_spi_setup*, struct sja1105_mgmt_entry*, int index);
 void sja1105_mgmt_entry_show(struct sja1105_mgmt_entry *entry);
 
+/* FDB access. The L2 Lookup Parameters are only needed on E/T, where
+ * the hash (POLY) and SHARED_LEARN determine the placement of entries;
+ * they may be NULL on P/Q/R/S. The functions return -ENOENT when no
+ * (valid) entry is found. */
+int sja1105_fdb_get(struct sja1105_spi_setup*, int index,
+                    struct sja1105_fdb_entry*);
+int sja1105_fdb_search(struct sja1105_spi_setup*,
+                       const struct sja1105_l2_lookup_params_entry*,
+                       uint64_t macaddr, uint64_t vlanid,
+                       struct sja1105_fdb_entry*);
+int sja1105_fdb_add(struct sja1105_spi_setup*,
+                    const struct sja1105_l2_lookup_params_entry*,
+                    struct sja1105_fdb_entry*);
+int sja1105_fdb_del(struct sja1105_spi_setup*,
+                    const struct sja1105_l2_lookup_params_entry*,
+                    uint64_t macaddr, uint64_t vlanid);
+
+/* FDB entry as returned by a bulk dump */
+struct sja1105_fdb_brief {
+	uint64_t macaddr;
+	uint16_t vlanid;
+	uint16_t index;
+	uint8_t  destports;
+	uint8_t  lockeds;
+};
+
+enum sja1105_fdb_change {
+	SJA1105_FDB_ADDED,    /* only new_entry is set */
+	SJA1105_FDB_REMOVED,  /* only old_entry is set */
+	SJA1105_FDB_MOVED,    /* DESTPORTS changed */
+};
+
+void sja1105_fdb_brief_from_entry(struct sja1105_fdb_brief*,
+                                  const struct sja1105_fdb_entry*);
+int sja1105_fdb_dump(struct sja1105_spi_setup*, struct sja1105_fdb_brief*);
+int sja1105_fdb_diff(struct sja1105_fdb_brief *old_entries, int old_count,
+                     struct sja1105_fdb_brief *new_entries, int new_count,
+                     int (*cb)(enum sja1105_fdb_change,
+                               const struct sja1105_fdb_brief *old_entry,
+                               const struct sja1105_fdb_brief *new_entry,
+                               void *priv),
+                     void *priv);
+int sja1105_fdb_watch(struct sja1105_spi_setup*, uint64_t interval_ns,
+                      uint64_t count,
+                      int (*cb)(enum sja1105_fdb_change,
+                                const struct sja1105_fdb_brief *old_entry,
+                                const struct sja1105_fdb_brief *new_entry,
+                                void *priv),
+                      void *priv, volatile sig_atomic_t *stop);
+
+/* From vlan-lookup.c */
+struct sja1105_dyn_vlan_lookup_cmd {
+	uint64_t valid;
+	uint64_t rdwrset;
+	uint64_t valident;
+	/* VLANID selects the entry that is read or written */
+	struct sja1105_vlan_lookup_entry entry;
+};
+
+void sja1105_dyn_vlan_lookup_cmd_pack(void *buf,
+                                      struct sja1105_dyn_vlan_lookup_cmd*);
+void sja1105_dyn_vlan_lookup_cmd_unpack(void *buf,
+                                        struct sja1105_dyn_vlan_lookup_cmd*);
+int sja1105_dyn_vlan_lookup_cmd_commit(struct sja1105_spi_setup*,
+                                       struct sja1105_dyn_vlan_lookup_cmd*);
+/* Runtime access to the VLAN Lookup table, by VID. Reading back is not
+ * possible on E/T (-EOPNOTSUPP); -ENOENT means the VID has no entry. */
+int sja1105_vlan_get(struct sja1105_spi_setup*, uint16_t vid,
+                     struct sja1105_vlan_lookup_entry*);
+int sja1105_vlan_set(struct sja1105_spi_setup*,
+                     struct sja1105_vlan_lookup_entry*);
+int sja1105_vlan_del(struct sja1105_spi_setup*, uint16_t vid);
+int sja1105_vlan_sync(struct sja1105_spi_setup*,
+                      const struct sja1105_vlan_lookup_entry *old_entries,
+                      int old_count,
+                      const struct sja1105_vlan_lookup_entry *new_entries,
+                      int new_count);
+
+/* From l2-policing.c */
+struct sja1105_dyn_l2_policing_cmd {
+	uint64_t valid;
+	uint64_t rdwrset;
+	uint64_t errors;
+	uint64_t index;
+	struct sja1105_l2_policing_entry entry;
+};
+
+/* New contents for entry @index of the L2 Policing table: port * 8 + prio
+ * for the policers of each port and priority, 40 + port for broadcast */
+struct sja1105_l2_policing_update {
+	int index;
+	struct sja1105_l2_policing_entry entry;
+};
+
+void sja1105_dyn_l2_policing_cmd_pack(void *buf,
+                                      struct sja1105_dyn_l2_policing_cmd*);
+void sja1105_dyn_l2_policing_cmd_unpack(void *buf,
+                                        struct sja1105_dyn_l2_policing_cmd*);
+int sja1105_dyn_l2_policing_cmd_commit(struct sja1105_spi_setup*,
+                                       struct sja1105_dyn_l2_policing_cmd*);
+int sja1105_l2_policing_rate_set(struct sja1105_l2_policing_entry*,
+                                 double rate_mbps);
+double sja1105_l2_policing_rate_get(const struct sja1105_l2_policing_entry*);
+int sja1105_l2_policing_burst_set(struct sja1105_l2_policing_entry*,
+                                  uint64_t burst_bytes);
+int sja1105_l2_policing_set(struct sja1105_spi_setup*, int index,
+                            const struct sja1105_l2_policing_entry*);
+int sja1105_l2_policing_set_batch(struct sja1105_spi_setup*,
+                                  const struct sja1105_l2_policing_update*,
+                                  int count);
+
+/* From mac-config.c */
+struct sja1105_dyn_mac_config_cmd {
+	uint64_t valid;
+	uint64_t rdwrset;    /* P/Q/R/S only */
+	uint64_t errors;     /* P/Q/R/S only */
+	uint64_t index;      /* Port */
+	struct sja1105_mac_config_entry entry;
+};
+
+void sja1105_dyn_mac_config_cmd_pack(void *buf,
+                                     struct sja1105_dyn_mac_config_cmd*,
+                                     uint64_t device_id);
+void sja1105_dyn_mac_config_cmd_unpack(void *buf,
+                                       struct sja1105_dyn_mac_config_cmd*,
+                                       uint64_t device_id);
+int sja1105_dyn_mac_config_cmd_commit(struct sja1105_spi_setup*,
+                                      struct sja1105_dyn_mac_config_cmd*);
+/* Runtime access to the MAC Configuration table, by port. Reading back
+ * is not possible on E/T (-EOPNOTSUPP). */
+int sja1105_mac_config_get(struct sja1105_spi_setup*, int port,
+                           struct sja1105_mac_config_entry*);
+int sja1105_mac_config_set(struct sja1105_spi_setup*, int port,
+                           const struct sja1105_mac_config_entry*);
+
 #endif
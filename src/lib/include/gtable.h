@@ -31,6 +31,9 @@
 #ifndef _GTABLE_H
 #define _GTABLE_H
 
+#include <stddef.h>
+#include <stdint.h>
+
 #define QUIRK_MSB_ON_THE_RIGHT (1 << 0ull)
 #define QUIRK_LITTLE_ENDIAN    (1 << 1ull)
 #define QUIRK_LSW32_IS_FIRST   (1 << 2ull)
@@ -41,5 +44,50 @@ int  gtable_pack(void*, uint64_t*, int, int, int);
 void gtable_hexdump(void*, int);
 void gtable_bitdump(void*, int);
 uint32_t ether_crc32_le(void*, unsigned int);
+uint32_t ether_crc32_le_update(uint32_t, void*, unsigned int);
+uint32_t ether_crc32_combine(uint32_t, uint32_t, unsigned int);
+
+/* Field plans.
+ *
+ * A field plan describes the layout of a packed table entry as an array
+ * of (start, end, struct offset) tuples, instead of a sequence of
+ * gtable_pack/gtable_unpack calls. On first use, the plan is compiled
+ * into a list of word-sized shift-and-mask operations, so that packing
+ * or unpacking an entry costs a single pass over its 32-bit words.
+ *
+ * All members referenced by a plan must be of type uint64_t.
+ * Array members are described once, with a count of elements and the
+ * bit distance (stride) between two consecutive elements.
+ */
+struct gtable_field {
+	int start;
+	int end;
+	int offset;
+	int count;
+	int stride;
+};
+
+#define GTABLE_FIELD(type, member, start, end) \
+	{ (start), (end), offsetof(type, member), 1, 0 }
+
+#define GTABLE_ARRAY_FIELD(type, member, start, end, count, stride) \
+	{ (start), (end), offsetof(type, member), (count), (stride) }
+
+struct gtable_plan_ops;
+
+struct gtable_plan {
+	const struct gtable_field *fields;
+	int field_count;
+	int len_bytes;
+	/* Populated by gtable_plan_compile */
+	struct gtable_plan_ops *ops;
+};
+
+#define GTABLE_PLAN(fields, len_bytes) \
+	{ (fields), sizeof(fields) / sizeof((fields)[0]), (len_bytes), NULL }
+
+int  gtable_plan_compile(struct gtable_plan*);
+void gtable_plan_unpack(struct gtable_plan*, void *buf, void *entry);
+void gtable_plan_pack(struct gtable_plan*, void *buf, void *entry);
 
 #endif
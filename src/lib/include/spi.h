@@ -32,6 +32,7 @@
 #define _SPI_EXTERNAL_H
 
 #include <linux/spi/spidev.h>
+#include <stddef.h>
 #include <stdint.h>
 
 struct sja1105_spi_setup {
@@ -46,6 +47,8 @@ struct sja1105_spi_setup {
 	int         dry_run;
 	const char *staging_area;
 	int         flush;
+	int         force;   /* Upload even if the switch runs that config */
+	const char *upload_state; /* Record of the last upload, or NULL */
 	int         fd;
 };
 
@@ -60,6 +63,26 @@ enum sja1105_spi_access_mode {
 	SPI_WRITE = 1,
 };
 
+/* One SPI message held in a struct sja1105_spi_queue. Only the header
+ * is stored in the queue, the payload stays in the caller's buffer. */
+struct sja1105_spi_queue_msg {
+	enum sja1105_spi_access_mode read_or_write;
+	void    *packed_buf; /* Payload, sent from or received into in place */
+	uint64_t size_bytes; /* Payload length, without the message header */
+};
+
+/* Collects SPI messages so that they can be submitted to spidev in as
+ * few SPI_IOC_MESSAGE(N) ioctls as possible, under a single lock.
+ * Initialize with sja1105_spi_queue_init, release with
+ * sja1105_spi_queue_free.
+ */
+struct sja1105_spi_queue {
+	struct sja1105_spi_queue_msg *msgs;
+	uint8_t *headers;    /* SIZE_SPI_MSG_HEADER bytes for each message */
+	int      count;
+	int      capacity;
+};
+
 const char *sja1105_device_id_string_get(uint64_t device_id, uint64_t part_nr);
 int sja1105_device_id_get(struct sja1105_spi_setup *spi_setup,
                           uint64_t *device_id, uint64_t *part_nr);
@@ -74,6 +97,11 @@ int sja1105_spi_send_packed_buf(struct sja1105_spi_setup *spi_setup,
                                 uint64_t reg_addr,
                                 void    *packed_buf,
                                 uint64_t size_bytes);
+int sja1105_spi_send_msg_buf(struct sja1105_spi_setup *spi_setup,
+                             enum sja1105_spi_access_mode read_or_write,
+                             uint64_t reg_addr,
+                             void    *msg_buf,
+                             uint64_t size_bytes);
 int sja1105_spi_send_int(struct sja1105_spi_setup *spi_setup,
                          enum sja1105_spi_access_mode read_or_write,
                          uint64_t reg_offset,
@@ -84,9 +112,27 @@ int sja1105_spi_send_long_packed_buf(struct sja1105_spi_setup *spi_setup,
                                      uint64_t base_addr,
                                      char    *packed_buf,
                                      uint64_t size_bytes);
+void sja1105_spi_queue_init(struct sja1105_spi_queue*);
+void sja1105_spi_queue_reset(struct sja1105_spi_queue*);
+void sja1105_spi_queue_free(struct sja1105_spi_queue*);
+int sja1105_spi_queue_add(struct sja1105_spi_queue*,
+                          enum sja1105_spi_access_mode read_or_write,
+                          uint64_t reg_addr,
+                          void    *packed_buf,
+                          uint64_t size_bytes);
+int sja1105_spi_queue_add_long(struct sja1105_spi_queue*,
+                               enum sja1105_spi_access_mode read_or_write,
+                               uint64_t base_addr,
+                               char    *packed_buf,
+                               uint64_t size_bytes);
+int sja1105_spi_queue_submit(const struct sja1105_spi_setup*,
+                             struct sja1105_spi_queue*);
 
 #define SIZE_SJA1105_DEVICE_ID 4
 #define SIZE_SPI_MSG_HEADER    4
 #define SIZE_SPI_MSG_MAXLEN    64 * 4
 
+/* Payload of a buffer laid out for sja1105_spi_send_msg_buf */
+#define SPI_MSG_PAYLOAD(msg_buf) ((uint8_t*) (msg_buf) + SIZE_SPI_MSG_HEADER)
+
 #endif
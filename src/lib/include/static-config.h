@@ -423,12 +423,56 @@ struct sja1105_retagging_entry {
 	uint64_t destports;
 };
 
-#define STATIC_CONFIG_MEMBER(table, size)           \
-	struct sja1105_##table##_entry table[size]; \
+/* Checksum of a table, as it was last packed or unpacked.
+ * Whoever changes the entries of an unpacked table in place must call
+ * sja1105_static_config_mark_dirty, so that its CRC is computed again.
+ */
+struct sja1105_table_cache {
+	int      valid;
+	int      len;
+	uint32_t crc;
+};
+
+/* Where a table lives inside a packed static config buffer.
+ * Offsets are in bytes, relative to the start of the buffer.
+ * Filled in by sja1105_static_config_locate.
+ */
+struct sja1105_table_location {
+	int block_id;
+	int data;        /* First entry */
+	int len;         /* Bytes of entry data. The data CRC follows. */
+	int entry_size;
+	int entry_count;
+};
+
+/* The table blocks of a packed static config, see
+ * sja1105_static_config_index. @unpacked has a bit set for each block id
+ * that sja1105_static_config_unpack_table has already decoded.
+ */
+struct sja1105_static_config_index {
+	uint64_t device_id;
+	struct sja1105_table_location *blocks;
+	int block_count;
+	uint32_t unpacked[256 / 32];
+};
+
+/* Tables live on the heap and only take as much memory as the entries
+ * they hold. @table##_capacity is the number of entries allocated,
+ * @table##_count the number of valid ones. Use sja1105_static_config_resize
+ * or sja1105_static_config_append to change the count.
+ * @max_count is the most entries the hardware accepts for the table.
+ */
+#define STATIC_CONFIG_MEMBER(table, max_count)      \
+	struct sja1105_##table##_entry *table;      \
 	int table##_count;                          \
+	int table##_capacity;                       \
+	struct sja1105_table_cache table##_cache;   \
 
 struct sja1105_static_config {
 	uint64_t device_id;
+	/* CRC of the last packed buffer, up to the CRC field
+	 * of the final table header. Set by sja1105_static_config_pack. */
+	uint32_t packed_crc;
 	STATIC_CONFIG_MEMBER(l2_forwarding_params, MAX_L2_FORWARDING_PARAMS_COUNT);
 	STATIC_CONFIG_MEMBER(l2_forwarding, MAX_L2_FORWARDING_COUNT);
 	STATIC_CONFIG_MEMBER(l2_lookup, MAX_L2_LOOKUP_COUNT);
@@ -503,8 +547,194 @@ int  sja1105_static_config_hexdump(void*);
 int  sja1105_static_config_check_valid(struct sja1105_static_config*);
 int  sja1105_static_config_pack(void*, struct sja1105_static_config*);
 int  sja1105_static_config_unpack(void*, struct sja1105_static_config*);
+void sja1105_static_config_mark_dirty(struct sja1105_static_config*, int blk_id);
+void sja1105_static_config_init(struct sja1105_static_config*);
+void sja1105_static_config_free(struct sja1105_static_config*);
+int  sja1105_static_config_resize(struct sja1105_static_config*, int blk_id,
+                                  int count);
+int  sja1105_static_config_append(struct sja1105_static_config*, int blk_id,
+                                  const void *entry);
+int  sja1105_static_config_entry_size(uint64_t device_id, int blk_id);
+int  sja1105_static_config_locate(void *buf, unsigned int buf_len, int blk_id,
+                                  struct sja1105_table_location*);
+int  sja1105_static_config_index(void *buf, unsigned int buf_len,
+                                 struct sja1105_static_config_index*);
+void sja1105_static_config_index_free(struct sja1105_static_config_index*);
+int  sja1105_static_config_unpack_table(void *buf,
+                                        struct sja1105_static_config_index*,
+                                        int blk_id,
+                                        struct sja1105_static_config*);
+int  sja1105_static_config_unpack_tables(void *buf,
+                                         struct sja1105_static_config_index*,
+                                         struct sja1105_static_config*);
+int  sja1105_static_config_entry_unpack(void *buf,
+                                        struct sja1105_table_location*,
+                                        int index,
+                                        struct sja1105_static_config*);
+int  sja1105_static_config_entry_pack(void *buf,
+                                      struct sja1105_table_location*,
+                                      int index,
+                                      struct sja1105_static_config*);
 
 void sja1105_lib_get_build_date(char *buf);
 void sja1105_lib_get_version(char *buf);
 
+/* From l2-lookup-hash.c */
+#define SJA1105ET_L2_LOOKUP_BIN_COUNT 256
+#define SJA1105ET_L2_LOOKUP_BIN_SIZE  4
+
+/* Hash of the E/T L2 Address Lookup table, for one POLY and SHARED_LEARN.
+ * Bit j of the bin is the parity of the key bits set in mask[j]. */
+struct sja1105et_l2_hash {
+	uint64_t mask[8];
+	uint64_t key_mask; /* Key bits that take part in lookups */
+};
+
+/* How the static entries of the L2 Address Lookup table fill it */
+struct sja1105_l2_lookup_usage {
+	int placed;       /* Entries in a way of their bin */
+	int bins_used;    /* Bins with at least one static entry */
+	int bins_full;    /* Bins with no way left for learning */
+	int bins_short;   /* Bins with fewer than DYN_TBSZ ways left */
+	int max_per_bin;
+	int misplaced;    /* Entries whose INDEX is not in their bin */
+	int overflows;    /* Entries that did not fit in their bin */
+	int duplicates;   /* Entries that repeat the key of another one */
+};
+
+void sja1105et_l2_hash_init(struct sja1105et_l2_hash*,
+                            const struct sja1105_l2_lookup_params_entry*);
+int  sja1105et_l2_hash(const struct sja1105et_l2_hash*,
+                       uint64_t macaddr, uint64_t vlanid);
+void sja1105et_l2_hash_batch(const struct sja1105et_l2_hash*,
+                             const uint64_t *keys, int count, uint8_t *bins);
+int  sja1105et_l2_lookup_place(struct sja1105_static_config*, int place,
+                               struct sja1105_l2_lookup_usage*);
+
+/* From vlan-lookup-index.c */
+#define SJA1105_VLAN_INDEX_WORDS (MAX_VLAN_LOOKUP_COUNT / 64)
+
+/* Sparse index of the VLAN Lookup table by VID */
+struct sja1105_vlan_lookup_index {
+	uint64_t present[SJA1105_VLAN_INDEX_WORDS]; /* Bit per VID */
+	uint16_t rank[SJA1105_VLAN_INDEX_WORDS];    /* VIDs below each word */
+	uint16_t entry[MAX_VLAN_LOOKUP_COUNT];      /* Positions, by VID */
+	int count;
+};
+
+int  sja1105_vlan_lookup_index_build(struct sja1105_vlan_lookup_index*,
+                                     const struct sja1105_vlan_lookup_entry*,
+                                     int count);
+int  sja1105_vlan_lookup_index_find(const struct sja1105_vlan_lookup_index*,
+                                    uint16_t vid);
+int  sja1105_vlan_lookup_sort(struct sja1105_static_config*);
+int  sja1105_vlan_lookup_range_add(struct sja1105_static_config*,
+                                   uint16_t first, uint16_t last,
+                                   uint64_t ports, uint64_t tagged);
+int  sja1105_vlan_lookup_range_del(struct sja1105_static_config*,
+                                   uint16_t first, uint16_t last,
+                                   uint64_t ports);
+int  sja1105_vlan_lookup_range_set(struct sja1105_static_config*,
+                                   uint16_t first, uint16_t last,
+                                   uint64_t ports, uint64_t tagged);
+
+/* From schedule-compile.c */
+#define SJA1105_SCHEDULE_MAX_SUBSCHEDULES 8
+/* Largest DELTA of the schedule tables, in 200 ns ticks */
+#define SJA1105_SCHEDULE_DELTA_MAX        ((1 << 18) - 1)
+
+/* A window of a cycle, during which the gates of @gates_open (one bit
+ * per priority) are open on the ports of @destports. */
+struct sja1105_schedule_timeslot {
+	uint64_t delta;      /* Duration, in 200 ns ticks */
+	uint64_t destports;
+	uint64_t gates_open;
+};
+
+/* A cycle is a subschedule: its timeslots repeat one after the other */
+struct sja1105_schedule_cycle {
+	uint64_t start_time; /* In 200 ns ticks */
+	struct sja1105_schedule_timeslot *timeslots;
+	int timeslot_count;
+};
+
+struct sja1105_schedule_desc {
+	uint64_t clksrc;     /* As in the Schedule Entry Points Parameters */
+	struct sja1105_schedule_cycle cycles[SJA1105_SCHEDULE_MAX_SUBSCHEDULES];
+	int cycle_count;
+};
+
+int  sja1105_schedule_compile(struct sja1105_static_config*,
+                              const struct sja1105_schedule_desc*);
+
+/* From schedule-check.c */
+int  sja1105_schedule_check_valid(const struct sja1105_static_config*);
+
+/* From schedule-optimize.c */
+struct sja1105_schedule_budget {
+	int timeslots;       /* Timeslots in the description */
+	int merged;          /* Timeslots merged into the one before */
+	int split;           /* Entries added for long windows */
+	int entries;         /* Schedule entries needed */
+	int cycle_entries[SJA1105_SCHEDULE_MAX_SUBSCHEDULES];
+	int reordered;       /* Cycles were not in order of start time */
+};
+
+int  sja1105_schedule_optimize(struct sja1105_schedule_desc*,
+                               struct sja1105_schedule_budget*);
+
+
+/* From schedule-simulate.c */
+#define SJA1105_SCHEDULE_TICK_NS   200
+#define SJA1105_SCHEDULE_PORT_COUNT 5
+
+/* Gates of a port that stay open (one bit per priority) from @start
+ * to @end, in ns from the start of the timeline */
+struct sja1105_gate_segment {
+	uint64_t start;
+	uint64_t end;
+	uint64_t gates_open;
+};
+
+/* Gate states of each port over one hypercycle */
+struct sja1105_gate_timeline {
+	uint64_t offset;     /* Start of the timeline, in ns from the
+	                      * schedule start time */
+	uint64_t length;     /* Hypercycle, in ns */
+	struct sja1105_gate_segment *segments[SJA1105_SCHEDULE_PORT_COUNT];
+	int count[SJA1105_SCHEDULE_PORT_COUNT];
+	int capacity[SJA1105_SCHEDULE_PORT_COUNT];
+};
+
+/* A periodic stream of frames received on @ingress_port */
+struct sja1105_stream {
+	int ingress_port;
+	uint64_t egress_ports; /* 0 for those of the L2 Forwarding table */
+	uint64_t prio;         /* VLAN PCP of the frames */
+	uint64_t size;         /* Frame size in bytes, with FCS */
+	uint64_t period;       /* In ns */
+};
+
+#define SJA1105_LATENCY_UNBOUNDED UINT64_MAX
+
+struct sja1105_stream_report {
+	int egress_port;         /* Port with the worst latency */
+	int egress_prio;         /* Queue of the frames on that port */
+	uint64_t tx_time;        /* Time on the wire on that port, in ns */
+	uint64_t worst_latency;  /* Queueing plus transmission, in ns */
+	int violations;          /* Windows where a frame sent last may
+	                          * overrun the opening of another gate */
+	uint64_t worst_overrun;  /* In ns */
+	int overloaded;          /* Queue gets more than its windows send */
+};
+
+int  sja1105_gate_timeline_build(const struct sja1105_static_config*,
+                                 struct sja1105_gate_timeline*);
+void sja1105_gate_timeline_free(struct sja1105_gate_timeline*);
+int  sja1105_stream_analyze(const struct sja1105_static_config*,
+                            const struct sja1105_gate_timeline*,
+                            const struct sja1105_stream *streams,
+                            int count,
+                            struct sja1105_stream_report *reports);
+
 #endif
@@ -32,6 +32,7 @@
 #define _STATUS_PARSE_ARGS_H
 
 #include <stdint.h>
+#include <time.h>
 #include "spi.h"
 
 #define CORE_ADDR   0x000000
@@ -154,9 +155,97 @@ void sja1105_general_status_show(struct sja1105_general_status*,
 void sja1105_port_status_show(struct sja1105_port_status*,
                               int    port, char  *print_buf,
                               uint64_t device_id);
+/* Counters of all ports, read in a single SPI burst */
+struct sja1105_port_status_snapshot {
+	/* CLOCK_MONOTONIC, halfway through the burst */
+	struct timespec timestamp;
+	struct sja1105_port_status port[5];
+};
+
 int sja1105_port_status_get(struct sja1105_spi_setup*,
                             struct sja1105_port_status*,
                             int port);
+int sja1105_port_status_snapshot_get(struct sja1105_spi_setup*,
+                                     struct sja1105_port_status_snapshot*);
 int sja1105_port_status_clear(struct sja1105_spi_setup*, int);
 
+/* Counters that sja1105_counters_update widens into monotonic totals */
+enum sja1105_counter {
+	SJA1105_CNT_N_RUNT,
+	SJA1105_CNT_N_SOFERR,
+	SJA1105_CNT_N_ALIGNERR,
+	SJA1105_CNT_N_MIIERR,
+	SJA1105_CNT_N_N664ERR,
+	SJA1105_CNT_N_VLANERR,
+	SJA1105_CNT_N_UNRELEASED,
+	SJA1105_CNT_N_SIZERR,
+	SJA1105_CNT_N_CRCERR,
+	SJA1105_CNT_N_VLNOTFOUND,
+	SJA1105_CNT_N_BEPOLERR,
+	SJA1105_CNT_N_POLERR,
+	SJA1105_CNT_N_QFULL,
+	SJA1105_CNT_N_PART_DROP,
+	SJA1105_CNT_N_EGR_DISABLED,
+	SJA1105_CNT_N_NOT_REACH,
+	/* Traffic counters, the ones above are all drop reasons */
+	SJA1105_CNT_N_RXFRM,
+	SJA1105_CNT_N_RXBYTE,
+	SJA1105_CNT_N_TXFRM,
+	SJA1105_CNT_N_TXBYTE,
+	SJA1105_CNT_MAX,
+};
+
+#define SJA1105_CNT_NUM_DROP_REASONS SJA1105_CNT_N_RXFRM
+
+struct sja1105_port_counters {
+	uint64_t total[SJA1105_CNT_MAX]; /* Since the first sample */
+	uint64_t delta[SJA1105_CNT_MAX]; /* Since the previous sample */
+	uint64_t drops;                  /* Sum of the drop reason deltas */
+	/* Per second, over the last interval */
+	double   rx_frames_rate;
+	double   rx_bytes_rate;
+	double   tx_frames_rate;
+	double   tx_bytes_rate;
+	double   drops_rate;
+};
+
+struct sja1105_counters_sample {
+	uint64_t seq;            /* 1 for the first sample */
+	struct timespec timestamp;
+	uint64_t interval_ns;    /* Since the previous sample, 0 for the first */
+	struct sja1105_port_counters port[5];
+};
+
+/* Widens the wrapping hardware counters */
+struct sja1105_counters {
+	struct sja1105_port_status_snapshot last;
+	struct sja1105_counters_sample sample;
+};
+
+/* Shared memory ring of samples, with one writer (the poller) and any
+ * number of lock-free readers in other processes */
+struct sja1105_counters_ring;
+
+const char *sja1105_counter_name(enum sja1105_counter);
+void sja1105_counters_init(struct sja1105_counters*);
+void sja1105_counters_update(struct sja1105_counters*,
+                             const struct sja1105_port_status_snapshot*);
+int  sja1105_counters_poll(struct sja1105_spi_setup*, struct sja1105_counters*);
+int  sja1105_counters_run(struct sja1105_spi_setup*, struct sja1105_counters*,
+                          struct sja1105_counters_ring*,
+                          uint64_t interval_ns, uint64_t count,
+                          int (*cb)(const struct sja1105_counters_sample*,
+                                    void *priv),
+                          void *priv);
+int  sja1105_counters_ring_create(const char *path, int slot_count,
+                                  struct sja1105_counters_ring**);
+int  sja1105_counters_ring_open(const char *path,
+                                struct sja1105_counters_ring**);
+void sja1105_counters_ring_close(struct sja1105_counters_ring*);
+void sja1105_counters_ring_publish(struct sja1105_counters_ring*,
+                                   const struct sja1105_counters_sample*);
+int  sja1105_counters_ring_read(struct sja1105_counters_ring*, uint64_t seq,
+                                struct sja1105_counters_sample*);
+uint64_t sja1105_counters_ring_head(struct sja1105_counters_ring*);
+
 #endif
@@ -86,6 +86,8 @@ void sja1105_spi_message_show(struct sja1105_spi_message *msg)
  * This function should only be called if it is priorly known that
  * size_bytes is smaller than SIZE_SPI_MSG_MAXLEN. Larger packed buffers
  * are chunked in smaller pieces by sja1105_spi_send_long_packed_buf below.
+ *
+ * The payload is not copied, see sja1105_spi_queue_add.
  */
 inline int
 sja1105_spi_send_packed_buf(struct sja1105_spi_setup *spi_setup,
@@ -94,42 +96,66 @@ sja1105_spi_send_packed_buf(struct sja1105_spi_setup *spi_setup,
                             void    *packed_buf,
                             uint64_t size_bytes)
 {
-	const int MSG_LEN = size_bytes + SIZE_SPI_MSG_HEADER;
-	struct sja1105_spi_message msg;
-	uint8_t tx_buf[MSG_LEN];
-	uint8_t rx_buf[MSG_LEN];
+	/* A queue of one message, that needs no allocation */
+	struct sja1105_spi_queue_msg queue_msg;
+	uint8_t header[SIZE_SPI_MSG_HEADER];
+	struct sja1105_spi_queue queue = {
+		.msgs     = &queue_msg,
+		.headers  = header,
+		.capacity = 1,
+	};
 	int rc;
 
-	memset(rx_buf, 0, MSG_LEN);
+	rc = sja1105_spi_queue_add(&queue, read_or_write, reg_addr,
+	                           packed_buf, size_bytes);
+	if (rc < 0) {
+		goto out;
+	}
+	rc = sja1105_spi_queue_submit(spi_setup, &queue);
+	if (rc < 0) {
+		loge("sja1105_spi_queue_submit failed");
+	}
+out:
+	return rc;
+}
+
+/* Same as sja1105_spi_send_packed_buf, for callers that lay out the
+ * payload at SPI_MSG_PAYLOAD(msg_buf), leaving SIZE_SPI_MSG_HEADER
+ * bytes of headroom in front of it. The message header is packed
+ * into the headroom, and msg_buf goes to spidev as a single transfer.
+ * On SPI_READ, the payload is received in place.
+ */
+int sja1105_spi_send_msg_buf(struct sja1105_spi_setup *spi_setup,
+                             enum sja1105_spi_access_mode read_or_write,
+                             uint64_t reg_addr,
+                             void    *msg_buf,
+                             uint64_t size_bytes)
+{
+	struct sja1105_spi_message msg;
+	int rc;
 
+	if (size_bytes > SIZE_SPI_MSG_MAXLEN) {
+		loge("%s: message of %" PRIu64 " bytes is too long",
+		     __func__, size_bytes);
+		return -EINVAL;
+	}
+	if (read_or_write != SPI_READ && read_or_write != SPI_WRITE) {
+		loge("read_or_write must be SPI_READ or SPI_WRITE");
+		return -EINVAL;
+	}
 	msg.access     = read_or_write;
 	msg.read_count = (read_or_write == SPI_READ) ? (size_bytes / 4) : 0;
 	msg.address    = reg_addr;
-	sja1105_spi_message_pack(tx_buf, &msg);
-
+	sja1105_spi_message_pack(msg_buf, &msg);
 	if (read_or_write == SPI_READ) {
-		memset(tx_buf + SIZE_SPI_MSG_HEADER, 0, size_bytes);
-	} else if (read_or_write == SPI_WRITE) {
-		memcpy(tx_buf + SIZE_SPI_MSG_HEADER, /* dest */
-		       packed_buf,                   /* src */
-		       size_bytes);                  /* size */
-	} else {
-		loge("read_or_write must be SPI_READ or SPI_WRITE");
-		rc = -EINVAL;
-		goto out;
+		memset(SPI_MSG_PAYLOAD(msg_buf), 0, size_bytes);
 	}
-
-	rc = sja1105_spi_transfer(spi_setup, tx_buf, rx_buf, MSG_LEN);
+	rc = sja1105_spi_transfer(spi_setup, msg_buf,
+	                          (read_or_write == SPI_READ) ? msg_buf : NULL,
+	                          size_bytes + SIZE_SPI_MSG_HEADER);
 	if (rc < 0) {
 		loge("sja1105_spi_transfer failed");
-		goto out;
-	}
-	if (read_or_write == SPI_READ) {
-		memcpy(packed_buf,                   /* dest */
-		       rx_buf + SIZE_SPI_MSG_HEADER, /* src */
-		       size_bytes);                  /* size */
 	}
-out:
 	return rc;
 }
 
@@ -142,7 +168,7 @@ out:
  * The uint64_t *value is unpacked, meaning that it's stored in the native
  * CPU endianness and directly usable by software running on the core.
  *
- * This is a wrapper around sja1105_spi_send_packed_buf().
+ * This is a wrapper around sja1105_spi_send_msg_buf().
  *
  */
 inline int
@@ -152,21 +178,21 @@ sja1105_spi_send_int(struct sja1105_spi_setup *spi_setup,
                      uint64_t *value,
                      uint64_t size_bytes)
 {
-	uint8_t packed_buf[size_bytes];
+	uint8_t msg_buf[SIZE_SPI_MSG_HEADER + size_bytes];
 	int rc;
 
 	if (read_or_write == SPI_WRITE) {
-		gtable_pack(packed_buf,
+		gtable_pack(SPI_MSG_PAYLOAD(msg_buf),
 		            value, 8 * size_bytes - 1, 0,
 		            size_bytes);
 	}
-	rc = sja1105_spi_send_packed_buf(spi_setup,
-	                                 read_or_write,
-	                                 reg_addr,
-	                                 packed_buf,
-	                                 size_bytes);
+	rc = sja1105_spi_send_msg_buf(spi_setup,
+	                              read_or_write,
+	                              reg_addr,
+	                              msg_buf,
+	                              size_bytes);
 	if (read_or_write == SPI_READ) {
-		gtable_unpack(packed_buf,
+		gtable_unpack(SPI_MSG_PAYLOAD(msg_buf),
 		              value, 8 * size_bytes - 1, 0,
 		              size_bytes);
 	}
@@ -176,7 +202,8 @@ sja1105_spi_send_int(struct sja1105_spi_setup *spi_setup,
 /*
  * Should be used if a packed_buf larger than SIZE_SPI_MSG_MAXLEN must be
  * sent/received. Splitting the buffer into chunks and assembling those
- * into SPI messages is done automatically by this function.
+ * into SPI messages is done automatically by this function, and all
+ * chunks are submitted together through a struct sja1105_spi_queue.
  */
 int sja1105_spi_send_long_packed_buf(struct sja1105_spi_setup *spi_setup,
                                      enum sja1105_spi_access_mode read_or_write,
@@ -184,36 +211,20 @@ int sja1105_spi_send_long_packed_buf(struct sja1105_spi_setup *spi_setup,
                                      char    *packed_buf,
                                      uint64_t buf_len)
 {
-	struct chunk {
-		char    *buf_ptr;
-		int      len;
-		uint64_t spi_address;
-	} chunk;
-	int distance_to_end;
-	int rc = 0;
-
-	/* Initialize chunk */
-	chunk.buf_ptr = packed_buf;
-	chunk.spi_address = base_addr;
-	chunk.len = min(buf_len, SIZE_SPI_MSG_MAXLEN);
+	struct sja1105_spi_queue queue;
+	int rc;
 
-	while (chunk.len) {
-		rc = sja1105_spi_send_packed_buf(spi_setup,
-		                                 read_or_write,
-		                                 chunk.spi_address,
-		                                 chunk.buf_ptr,
-		                                 chunk.len);
-		if (rc < 0) {
-			loge("spi_send_packed_buf returned %d", rc);
-			goto out_send_failed;
-		}
-		chunk.buf_ptr += chunk.len;
-		chunk.spi_address += chunk.len / 4;
-		distance_to_end = (int) ((packed_buf + buf_len) -
-		                          chunk.buf_ptr);
-		chunk.len = min(distance_to_end, SIZE_SPI_MSG_MAXLEN);
+	sja1105_spi_queue_init(&queue);
+	rc = sja1105_spi_queue_add_long(&queue, read_or_write, base_addr,
+	                                packed_buf, buf_len);
+	if (rc < 0) {
+		goto out_free;
+	}
+	rc = sja1105_spi_queue_submit(spi_setup, &queue);
+	if (rc < 0) {
+		loge("sja1105_spi_queue_submit returned %d", rc);
 	}
-out_send_failed:
+out_free:
+	sja1105_spi_queue_free(&queue);
 	return rc;
 }
-
@@ -0,0 +1,325 @@
+/******************************************************************************
+ * Copyright (c) 2018, NXP Semiconductors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+#include <linux/spi/spidev.h>
+#include <sys/ioctl.h>
+#include <sys/file.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <inttypes.h>
+#include <errno.h>
+/* These are our own libraries */
+#include <lib/include/gtable.h>
+#include <lib/include/spi.h>
+#include <common.h>
+
+/* The spidev driver rejects SPI_IOC_MESSAGE(N) calls whose transfers
+ * add up to more than its "bufsiz" module parameter (4096 by default).
+ */
+#define SPIDEV_BUFSIZ_FILE    "/sys/module/spidev/parameters/bufsiz"
+#define SPIDEV_BUFSIZ_DEFAULT 4096
+/* The ioctl number encodes the size of the transfer array in 14 bits */
+#define SPI_QUEUE_MAX_XFERS   ((1 << _IOC_SIZEBITS) / \
+                               sizeof(struct spi_ioc_transfer) - 1)
+
+static size_t spidev_bufsiz(void)
+{
+	static size_t bufsiz;
+	unsigned long tmp;
+	FILE *fp;
+
+	if (bufsiz) {
+		return bufsiz;
+	}
+	bufsiz = SPIDEV_BUFSIZ_DEFAULT;
+	fp = fopen(SPIDEV_BUFSIZ_FILE, "r");
+	if (fp) {
+		if (fscanf(fp, "%lu", &tmp) == 1 &&
+		    tmp >= SIZE_SPI_MSG_HEADER + SIZE_SPI_MSG_MAXLEN) {
+			bufsiz = tmp;
+		}
+		fclose(fp);
+	}
+	return bufsiz;
+}
+
+void sja1105_spi_queue_init(struct sja1105_spi_queue *queue)
+{
+	memset(queue, 0, sizeof(*queue));
+}
+
+/* Drops all messages, but keeps the memory for reuse */
+void sja1105_spi_queue_reset(struct sja1105_spi_queue *queue)
+{
+	queue->count = 0;
+}
+
+void sja1105_spi_queue_free(struct sja1105_spi_queue *queue)
+{
+	free(queue->msgs);
+	free(queue->headers);
+	sja1105_spi_queue_init(queue);
+}
+
+static int sja1105_spi_queue_grow(struct sja1105_spi_queue *queue)
+{
+	struct sja1105_spi_queue_msg *msgs;
+	uint8_t *headers;
+	int capacity;
+
+	capacity = queue->capacity ? 2 * queue->capacity : 16;
+	msgs = realloc(queue->msgs, capacity * sizeof(*msgs));
+	if (!msgs) {
+		return -ENOMEM;
+	}
+	queue->msgs = msgs;
+	headers = realloc(queue->headers, capacity * SIZE_SPI_MSG_HEADER);
+	if (!headers) {
+		return -ENOMEM;
+	}
+	queue->headers = headers;
+	queue->capacity = capacity;
+	return 0;
+}
+
+/* Appends a single SPI message to the queue. Same rules as for
+ * sja1105_spi_send_packed_buf apply: size_bytes must not exceed
+ * SIZE_SPI_MSG_MAXLEN. The payload is not copied: packed_buf is
+ * handed to spidev as is, and must stay valid (and, for SPI_WRITE,
+ * unchanged) until the queue is submitted.
+ */
+int sja1105_spi_queue_add(struct sja1105_spi_queue *queue,
+                          enum sja1105_spi_access_mode read_or_write,
+                          uint64_t reg_addr,
+                          void    *packed_buf,
+                          uint64_t size_bytes)
+{
+	struct sja1105_spi_queue_msg *queue_msg;
+	struct sja1105_spi_message msg;
+	int rc;
+
+	if (size_bytes > SIZE_SPI_MSG_MAXLEN) {
+		loge("%s: message of %" PRIu64 " bytes is too long",
+		     __func__, size_bytes);
+		return -EINVAL;
+	}
+	if (read_or_write != SPI_READ && read_or_write != SPI_WRITE) {
+		loge("read_or_write must be SPI_READ or SPI_WRITE");
+		return -EINVAL;
+	}
+	if (queue->count == queue->capacity) {
+		rc = sja1105_spi_queue_grow(queue);
+		if (rc < 0) {
+			loge("%s: out of memory", __func__);
+			return rc;
+		}
+	}
+	queue_msg = &queue->msgs[queue->count];
+	queue_msg->read_or_write = read_or_write;
+	queue_msg->packed_buf    = packed_buf;
+	queue_msg->size_bytes    = size_bytes;
+
+	msg.access     = read_or_write;
+	msg.read_count = (read_or_write == SPI_READ) ? (size_bytes / 4) : 0;
+	msg.address    = reg_addr;
+	sja1105_spi_message_pack(queue->headers +
+	                         queue->count * SIZE_SPI_MSG_HEADER, &msg);
+	queue->count++;
+	return 0;
+}
+
+/* Appends as many SPI messages as needed to transfer a packed_buf
+ * larger than SIZE_SPI_MSG_MAXLEN, starting at base_addr.
+ */
+int sja1105_spi_queue_add_long(struct sja1105_spi_queue *queue,
+                               enum sja1105_spi_access_mode read_or_write,
+                               uint64_t base_addr,
+                               char    *packed_buf,
+                               uint64_t buf_len)
+{
+	/* The read count field of the message header is only 6 bits wide,
+	 * so reads cannot use the full SIZE_SPI_MSG_MAXLEN */
+	uint64_t max_len = (read_or_write == SPI_READ) ?
+	                   SIZE_SPI_MSG_MAXLEN - 4 : SIZE_SPI_MSG_MAXLEN;
+	uint64_t offset = 0;
+	uint64_t len;
+	int rc;
+
+	while (offset < buf_len) {
+		len = min(buf_len - offset, max_len);
+		rc = sja1105_spi_queue_add(queue, read_or_write,
+		                           base_addr + offset / 4,
+		                           packed_buf + offset, len);
+		if (rc < 0) {
+			return rc;
+		}
+		offset += len;
+	}
+	return 0;
+}
+
+static void sja1105_spi_queue_dry_run(struct sja1105_spi_queue *queue)
+{
+	uint8_t buf[SIZE_SPI_MSG_HEADER + SIZE_SPI_MSG_MAXLEN];
+	struct sja1105_spi_queue_msg *msg;
+	int len, i;
+
+	for (i = 0; i < queue->count; i++) {
+		msg = &queue->msgs[i];
+		len = SIZE_SPI_MSG_HEADER + msg->size_bytes;
+		memcpy(buf, queue->headers + i * SIZE_SPI_MSG_HEADER,
+		       SIZE_SPI_MSG_HEADER);
+		if (msg->read_or_write == SPI_WRITE) {
+			memcpy(buf + SIZE_SPI_MSG_HEADER, msg->packed_buf,
+			       msg->size_bytes);
+		} else {
+			memset(buf + SIZE_SPI_MSG_HEADER, 0, msg->size_bytes);
+			/* Nothing is read back in dry run mode */
+			memset(msg->packed_buf, 0, msg->size_bytes);
+		}
+		printf("spi-transfer: size %d bytes\n", len);
+		gtable_hexdump(buf, len);
+	}
+}
+
+/* Each message takes 2 transfers within the same chip select frame:
+ * the header from the queue, then the payload straight from/to the
+ * caller's buffer. Writes have no rx buffer and reads no tx buffer,
+ * so spidev does not copy anything that is not needed.
+ */
+static int
+sja1105_spi_queue_ioctl(const struct sja1105_spi_setup *spi_setup,
+                        struct sja1105_spi_queue *queue,
+                        struct spi_ioc_transfer *xfers,
+                        int first, int count)
+{
+	struct sja1105_spi_queue_msg *msg;
+	struct spi_ioc_transfer *hdr, *data;
+	size_t total = 0;
+	int i, rc;
+
+	memset(xfers, 0, 2 * count * sizeof(*xfers));
+	for (i = 0; i < count; i++) {
+		msg  = &queue->msgs[first + i];
+		hdr  = &xfers[2 * i];
+		data = &xfers[2 * i + 1];
+
+		hdr->tx_buf = (unsigned long) (queue->headers +
+		                               (first + i) * SIZE_SPI_MSG_HEADER);
+		hdr->len    = SIZE_SPI_MSG_HEADER;
+		if (msg->read_or_write == SPI_WRITE) {
+			data->tx_buf = (unsigned long) msg->packed_buf;
+		} else {
+			data->rx_buf = (unsigned long) msg->packed_buf;
+		}
+		data->len   = msg->size_bytes;
+		data->delay_usecs = spi_setup->delay;
+		/* Every SPI message of the SJA1105 is framed by its own
+		 * chip select, so it must toggle between messages */
+		data->cs_change = (i == count - 1) ? spi_setup->cs_change : 1;
+		hdr->speed_hz = data->speed_hz = spi_setup->speed;
+		hdr->bits_per_word = data->bits_per_word = spi_setup->bits;
+		total += hdr->len + data->len;
+	}
+	rc = ioctl(spi_setup->fd, SPI_IOC_MESSAGE(2 * count), xfers);
+	if (rc < 0) {
+		loge("ioctl failed");
+		return rc;
+	}
+	/* SPI_IOC_MESSAGE returns the number of transferred bytes */
+	return ((size_t) rc == total) ? 0 : -EIO;
+}
+
+/* Sends all queued messages to the switch, in order. The data of
+ * SPI_READ messages lands directly in their packed_buf. The SPI device
+ * is locked only once for the whole queue. The queue is left intact,
+ * call sja1105_spi_queue_reset to reuse it.
+ */
+int sja1105_spi_queue_submit(const struct sja1105_spi_setup *spi_setup,
+                             struct sja1105_spi_queue *queue)
+{
+	struct spi_ioc_transfer stack_xfers[2 * 8];
+	struct spi_ioc_transfer *xfers = stack_xfers;
+	struct sja1105_spi_queue_msg *msg;
+	size_t bufsiz = spidev_bufsiz();
+	size_t msg_len, total;
+	int max_count, first, count;
+	int rc = 0;
+
+	if (queue->count == 0) {
+		return 0;
+	}
+	if (spi_setup->dry_run) {
+		sja1105_spi_queue_dry_run(queue);
+		/* Do not fail */
+		return 0;
+	}
+	max_count = min(queue->count, (int) SPI_QUEUE_MAX_XFERS / 2);
+	if (2 * max_count > (int) ARRAY_SIZE(stack_xfers)) {
+		xfers = malloc(2 * max_count * sizeof(*xfers));
+		if (!xfers) {
+			return -ENOMEM;
+		}
+	}
+	if (flock(spi_setup->fd, LOCK_EX) < 0) {
+		loge("locking spi device failed");
+		rc = -EAGAIN;
+		goto out_free;
+	}
+	for (first = 0; first < queue->count; first += count) {
+		total = 0;
+		for (count = 0; first + count < queue->count &&
+		                count < max_count; count++) {
+			msg = &queue->msgs[first + count];
+			msg_len = SIZE_SPI_MSG_HEADER + msg->size_bytes;
+			if (count && total + msg_len > bufsiz) {
+				break;
+			}
+			total += msg_len;
+		}
+		rc = sja1105_spi_queue_ioctl(spi_setup, queue, xfers,
+		                             first, count);
+		if (rc < 0) {
+			break;
+		}
+	}
+	if (flock(spi_setup->fd, LOCK_UN) < 0) {
+		loge("unlocking spi device failed");
+		if (rc == 0) {
+			rc = -EAGAIN;
+		}
+	}
+out_free:
+	if (xfers != stack_xfers) {
+		free(xfers);
+	}
+	return rc;
+}
@@ -203,6 +203,11 @@ int sja1105_spi_configure(struct sja1105_spi_setup *spi_setup)
 	unsigned int i;
 	int fd, rc;
 
+	if (spi_setup->fd > 0) {
+		/* Already configured by an earlier command
+		 * in the same process (e.g. in batch mode) */
+		return 0;
+	}
 	if (spi_setup->dry_run) {
 		/* Pass an invalid fd, but also do not fail.
 		 * As long as the caller just passes the spi_setup
@@ -267,6 +272,8 @@ out_ok:
 	return rc;
 }
 
+/* rx may be NULL for write-only transfers, and may also be the same
+ * buffer as tx (spidev reads tx before it writes rx). */
 int sja1105_spi_transfer(const struct sja1105_spi_setup *spi_setup,
                          const void *tx, void *rx, int size)
 {
@@ -288,7 +295,6 @@ int sja1105_spi_transfer(const struct sja1105_spi_setup *spi_setup,
 		/* Do not fail */
 		saved_ioctl_result = size;
 	} else {
-		memset(rx, 0, size);
 		if (flock(spi_setup->fd, LOCK_EX) < 0) {
 			loge("locking spi device failed");
 			rc = -EAGAIN;
@@ -0,0 +1,285 @@
+/******************************************************************************
+ * Copyright (c) 2018, NXP Semiconductors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+/* These are our own include files */
+#include <lib/include/static-config.h>
+#include <common.h>
+
+/* Model of the hash that places entries in the L2 Address Lookup table
+ * of the SJA1105E/T.
+ *
+ * The table is made of SJA1105ET_L2_LOOKUP_BIN_COUNT bins of
+ * SJA1105ET_L2_LOOKUP_BIN_SIZE ways. The bin of an entry is the CRC-8
+ * of its 64-bit key {VLANID, MACADDR}, taken most significant byte
+ * first, starting from 0, with POLY from the L2 Lookup Parameters Table
+ * as polynomial (Koopman notation: x^8 implicit, x^0 left out). With
+ * SHARED_LEARN, VLANID is not part of the key.
+ *
+ * Since the CRC starts from 0, it is linear in the key: each bit of
+ * the hash is the parity of the key bits selected by a mask, and the
+ * 8 masks are computed once per polynomial. This needs no table
+ * lookups, so hashing a batch of keys vectorizes well.
+ */
+
+/* The CRC as the switch computes it, bit by bit */
+static uint8_t sja1105et_l2_crc8(uint8_t poly, uint64_t key)
+{
+	uint8_t crc = 0;
+	uint8_t byte;
+	int i, j;
+
+	for (i = 56; i >= 0; i -= 8) {
+		byte = (key >> i) & 0xff;
+		for (j = 0; j < 8; j++) {
+			if ((crc ^ byte) & 0x80) {
+				crc = (crc << 1) ^ poly;
+			} else {
+				crc <<= 1;
+			}
+			byte <<= 1;
+		}
+	}
+	return crc;
+}
+
+void sja1105et_l2_hash_init(struct sja1105et_l2_hash *hash,
+                            const struct sja1105_l2_lookup_params_entry *params)
+{
+	uint8_t  poly = (uint8_t) ((params->poly << 1) | 1);
+	uint64_t key_mask = 0xffffffffffffull;
+	uint8_t  crc;
+	int k, j;
+
+	if (!params->shared_learn) {
+		key_mask |= 0xfffull << 48;
+	}
+	hash->key_mask = key_mask;
+	memset(hash->mask, 0, sizeof(hash->mask));
+	for (k = 0; k < 64; k++) {
+		if (!(key_mask & (1ull << k))) {
+			continue;
+		}
+		crc = sja1105et_l2_crc8(poly, 1ull << k);
+		for (j = 0; j < 8; j++) {
+			if (crc & (1 << j)) {
+				hash->mask[j] |= 1ull << k;
+			}
+		}
+	}
+}
+
+static inline uint64_t sja1105et_l2_key(uint64_t macaddr, uint64_t vlanid)
+{
+	return ((vlanid & 0xfff) << 48) | (macaddr & 0xffffffffffffull);
+}
+
+static inline int
+sja1105et_l2_hash_key(const struct sja1105et_l2_hash *hash, uint64_t key)
+{
+	int bin = 0;
+	int j;
+
+	for (j = 0; j < 8; j++) {
+		bin |= __builtin_parityll(key & hash->mask[j]) << j;
+	}
+	return bin;
+}
+
+int sja1105et_l2_hash(const struct sja1105et_l2_hash *hash,
+                      uint64_t macaddr, uint64_t vlanid)
+{
+	return sja1105et_l2_hash_key(hash, sja1105et_l2_key(macaddr, vlanid));
+}
+
+/* Hashes @count keys, as built by (vlanid << 48 | macaddr), into @bins */
+void sja1105et_l2_hash_batch(const struct sja1105et_l2_hash *hash,
+                             const uint64_t *keys, int count, uint8_t *bins)
+{
+	int i;
+
+	for (i = 0; i < count; i++) {
+		bins[i] = sja1105et_l2_hash_key(hash, keys[i]);
+	}
+}
+
+/* Checks, or with @place, rewrites the INDEX of the static entries of
+ * the L2 Address Lookup table against the bins their keys hash to.
+ *
+ * When placing, entries that are already in a free way of their bin
+ * stay there, and the others take the first free way of their bin.
+ * Entries that find no free way (bin overflow) or that repeat the key
+ * of another entry are left untouched.
+ *
+ * Fills in @usage (if not NULL) and returns the number of entries that
+ * are not where the switch would look them up: overflowed, duplicate
+ * and (when only checking) misplaced ones. On P/Q/R/S, whose table
+ * is not hashed, there is nothing to check.
+ */
+int sja1105et_l2_lookup_place(struct sja1105_static_config *config,
+                              int place,
+                              struct sja1105_l2_lookup_usage *usage)
+{
+	const int way_count = MAX_L2_LOOKUP_COUNT;
+	struct sja1105_l2_lookup_entry *entry;
+	struct sja1105_l2_lookup_usage tmp;
+	struct sja1105et_l2_hash hash;
+	int per_bin[SJA1105ET_L2_LOOKUP_BIN_COUNT];
+	int16_t owner[MAX_L2_LOOKUP_COUNT];
+	uint64_t *keys;
+	uint8_t *bins;
+	int count = config->l2_lookup_count;
+	int bad = 0;
+	int changed = 0;
+	int i, w, way, bin, dyn_ways;
+
+	if (!usage) {
+		usage = &tmp;
+	}
+	memset(usage, 0, sizeof(*usage));
+	if (!IS_ET(config->device_id) || count == 0) {
+		return 0;
+	}
+	if (config->l2_lookup_params_count == 0) {
+		loge("l2-lookup-table not empty, but "
+		     "l2-lookup-parameters-table empty");
+		return -EINVAL;
+	}
+	keys = malloc(count * (sizeof(*keys) + sizeof(*bins)));
+	if (!keys) {
+		return -ENOMEM;
+	}
+	bins = (uint8_t*) (keys + count);
+
+	sja1105et_l2_hash_init(&hash, &config->l2_lookup_params[0]);
+	for (i = 0; i < count; i++) {
+		entry = &config->l2_lookup[i];
+		keys[i] = sja1105et_l2_key(entry->macaddr, entry->vlanid) &
+		          hash.key_mask;
+	}
+	sja1105et_l2_hash_batch(&hash, keys, count, bins);
+
+	for (w = 0; w < way_count; w++) {
+		owner[w] = -1;
+	}
+	/* First, the entries that already are in their bin */
+	for (i = 0; i < count; i++) {
+		entry = &config->l2_lookup[i];
+		if (entry->index >= (uint64_t) way_count ||
+		    entry->index / SJA1105ET_L2_LOOKUP_BIN_SIZE != bins[i] ||
+		    owner[entry->index] >= 0) {
+			continue;
+		}
+		owner[entry->index] = i;
+	}
+	/* Then the others, and the duplicates of all */
+	for (i = 0; i < count; i++) {
+		entry = &config->l2_lookup[i];
+		bin = bins[i];
+		way = -1;
+		for (w = bin * SJA1105ET_L2_LOOKUP_BIN_SIZE;
+		     w < (bin + 1) * SJA1105ET_L2_LOOKUP_BIN_SIZE; w++) {
+			if (owner[w] == i) {
+				way = w;
+				break;
+			}
+		}
+		for (w = bin * SJA1105ET_L2_LOOKUP_BIN_SIZE;
+		     w < (bin + 1) * SJA1105ET_L2_LOOKUP_BIN_SIZE; w++) {
+			if (owner[w] >= 0 && owner[w] < i &&
+			    keys[owner[w]] == keys[i]) {
+				break;
+			}
+		}
+		if (w < (bin + 1) * SJA1105ET_L2_LOOKUP_BIN_SIZE) {
+			loge("l2-lookup-table[%d] repeats the key of entry %d",
+			     i, owner[w]);
+			usage->duplicates++;
+			bad++;
+			continue;
+		}
+		if (way >= 0) {
+			continue;
+		}
+		if (!place) {
+			loge("l2-lookup-table[%d] has index %d, but hashes "
+			     "to bin %d", i, (int) entry->index, bin);
+			usage->misplaced++;
+			bad++;
+			continue;
+		}
+		for (w = bin * SJA1105ET_L2_LOOKUP_BIN_SIZE;
+		     w < (bin + 1) * SJA1105ET_L2_LOOKUP_BIN_SIZE; w++) {
+			if (owner[w] < 0) {
+				break;
+			}
+		}
+		if (w == (bin + 1) * SJA1105ET_L2_LOOKUP_BIN_SIZE) {
+			loge("l2-lookup-table[%d] does not fit in full bin %d",
+			     i, bin);
+			usage->overflows++;
+			bad++;
+			continue;
+		}
+		owner[w] = i;
+		entry->index = w;
+		changed++;
+	}
+	if (changed) {
+		sja1105_static_config_mark_dirty(config, BLKID_L2_LOOKUP_TABLE);
+	}
+
+	/* Utilisation. DYN_TBSZ ways of each bin are meant for learning. */
+	dyn_ways = min((int) config->l2_lookup_params[0].dyn_tbsz,
+	               SJA1105ET_L2_LOOKUP_BIN_SIZE);
+	memset(per_bin, 0, sizeof(per_bin));
+	for (w = 0; w < way_count; w++) {
+		if (owner[w] >= 0) {
+			per_bin[w / SJA1105ET_L2_LOOKUP_BIN_SIZE]++;
+		}
+	}
+	for (bin = 0; bin < SJA1105ET_L2_LOOKUP_BIN_COUNT; bin++) {
+		usage->placed += per_bin[bin];
+		usage->max_per_bin = max(usage->max_per_bin, per_bin[bin]);
+		if (per_bin[bin]) {
+			usage->bins_used++;
+		}
+		if (per_bin[bin] == SJA1105ET_L2_LOOKUP_BIN_SIZE) {
+			usage->bins_full++;
+		}
+		if (SJA1105ET_L2_LOOKUP_BIN_SIZE - per_bin[bin] < dyn_ways) {
+			usage->bins_short++;
+		}
+	}
+	free(keys);
+	return bad;
+}
@@ -0,0 +1,265 @@
+/******************************************************************************
+ * Copyright (c) 2018, NXP Semiconductors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+/* These are our own include files */
+#include <lib/include/static-config.h>
+#include <common.h>
+
+/* Virtual link window, from the Schedule entry that opens it to the one
+ * that closes it */
+struct sja1105_schedule_window {
+	uint64_t vlindex;
+	int start;
+	int end;
+};
+
+static int sja1105_schedule_window_cmp(const void *a, const void *b)
+{
+	const struct sja1105_schedule_window *wa = a;
+	const struct sja1105_schedule_window *wb = b;
+
+	if (wa->vlindex != wb->vlindex) {
+		return (wa->vlindex < wb->vlindex) ? -1 : 1;
+	}
+	return wa->start - wb->start;
+}
+
+/* Checks the ranges of the fields that packing would truncate */
+static int
+sja1105_schedule_entries_check(const struct sja1105_static_config *config)
+{
+	const struct sja1105_schedule_entry *entry;
+	int i;
+
+	for (i = 0; i < config->schedule_count; i++) {
+		entry = &config->schedule[i];
+		if (entry->delta == 0 ||
+		    entry->delta > SJA1105_SCHEDULE_DELTA_MAX) {
+			loge("schedule-table entry %d: delta %" PRIu64
+			     " out of range", i, entry->delta);
+			return -EINVAL;
+		}
+		if (entry->destports >= (1 << SJA1105_SCHEDULE_PORT_COUNT) ||
+		    entry->resmedia > 0xff ||
+		    entry->winstindex >= MAX_SCHEDULE_COUNT ||
+		    entry->vlindex >= MAX_VL_LOOKUP_COUNT) {
+			loge("schedule-table entry %d: field out of range", i);
+			return -EINVAL;
+		}
+	}
+	return 0;
+}
+
+/* Works out the subschedule of each Schedule entry from SUBSCHEIND,
+ * -1 for entries that no active subschedule reaches */
+static int
+sja1105_schedule_subschedules_check(const struct sja1105_static_config *config,
+                                    int count, int *subsch)
+{
+	const uint64_t *subscheind = config->schedule_params[0].subscheind;
+	int first = 0;
+	int i, k;
+
+	for (k = 0; k < config->schedule_count; k++) {
+		subsch[k] = -1;
+	}
+	for (i = 0; i < count; i++) {
+		if (subscheind[i] < (uint64_t) first ||
+		    subscheind[i] >= (uint64_t) config->schedule_count) {
+			loge("schedule-parameters-table: subscheind[%d] = %"
+			     PRIu64 " is not between %d and %d", i,
+			     subscheind[i], first, config->schedule_count - 1);
+			return -EINVAL;
+		}
+		for (k = first; k <= (int) subscheind[i]; k++) {
+			subsch[k] = i;
+		}
+		first = subscheind[i] + 1;
+	}
+	if (first < config->schedule_count) {
+		logi("schedule-table entries %d to %d belong to no active "
+		     "subschedule", first, config->schedule_count - 1);
+	}
+	return 0;
+}
+
+static int
+sja1105_schedule_entry_points_check(const struct sja1105_static_config *config,
+                                    int count, const int *subsch)
+{
+	const struct sja1105_schedule_entry_points_entry *ep;
+	int started[SJA1105_SCHEDULE_MAX_SUBSCHEDULES] = {0};
+	int i;
+
+	for (i = 0; i < config->schedule_entry_points_count; i++) {
+		ep = &config->schedule_entry_points[i];
+		if (ep->subschindx >= (uint64_t) count) {
+			loge("schedule-entry-points-table entry %d: subschedule "
+			     "%" PRIu64 " is not active (actsubsch is %d)", i,
+			     ep->subschindx, count - 1);
+			return -EINVAL;
+		}
+		if (ep->address >= (uint64_t) config->schedule_count ||
+		    subsch[ep->address] != (int) ep->subschindx) {
+			loge("schedule-entry-points-table entry %d: address %"
+			     PRIu64 " is outside subschedule %" PRIu64, i,
+			     ep->address, ep->subschindx);
+			return -EINVAL;
+		}
+		if (ep->delta == 0 || ep->delta > SJA1105_SCHEDULE_DELTA_MAX) {
+			loge("schedule-entry-points-table entry %d: delta %"
+			     PRIu64 " out of range", i, ep->delta);
+			return -EINVAL;
+		}
+		/* Entry points are taken in table order */
+		if (i > 0 && ep->delta <= config->schedule_entry_points[i - 1].delta) {
+			loge("schedule-entry-points-table entries %d and %d "
+			     "are not in order of their delta", i - 1, i);
+			return -EINVAL;
+		}
+		started[ep->subschindx] = 1;
+	}
+	for (i = 0; i < count; i++) {
+		if (!started[i]) {
+			loge("subschedule %d has no entry point", i);
+			return -EINVAL;
+		}
+	}
+	return 0;
+}
+
+/* Each window must close in the subschedule where it opened, and the
+ * windows of a virtual link must not overlap. Sorting them by VL, then
+ * by start, leaves only neighbours to compare. */
+static int
+sja1105_schedule_windows_check(const struct sja1105_static_config *config,
+                               const int *subsch)
+{
+	const struct sja1105_schedule_entry *entry;
+	struct sja1105_schedule_window *windows;
+	struct sja1105_schedule_window *prev;
+	int closed[MAX_SCHEDULE_COUNT] = {0};
+	int count = 0;
+	int rc = -EINVAL;
+	int k, start;
+
+	windows = malloc(config->schedule_count * sizeof(*windows));
+	if (windows == NULL) {
+		return -ENOMEM;
+	}
+	for (k = 0; k < config->schedule_count; k++) {
+		entry = &config->schedule[k];
+		if (entry->winst &&
+		    entry->vlindex >= (uint64_t) config->vl_lookup_count) {
+			loge("schedule-table entry %d: vlindex %" PRIu64
+			     " is not in vl-lookup-table", k, entry->vlindex);
+			goto out;
+		}
+		if (!entry->winend) {
+			continue;
+		}
+		start = entry->winstindex;
+		if (start > k || !config->schedule[start].winst ||
+		    subsch[start] != subsch[k]) {
+			loge("schedule-table entry %d: winstindex %d does not "
+			     "open a window of the same subschedule", k, start);
+			goto out;
+		}
+		if (closed[start]++) {
+			loge("schedule-table entry %d: window opened by entry "
+			     "%d is already closed", k, start);
+			goto out;
+		}
+		windows[count].vlindex = config->schedule[start].vlindex;
+		windows[count].start   = start;
+		windows[count].end     = k;
+		count++;
+	}
+	for (k = 0; k < config->schedule_count; k++) {
+		if (config->schedule[k].winst && !closed[k]) {
+			loge("schedule-table entry %d: window is never closed", k);
+			goto out;
+		}
+	}
+	qsort(windows, count, sizeof(*windows), sja1105_schedule_window_cmp);
+	for (k = 1; k < count; k++) {
+		prev = &windows[k - 1];
+		if (prev->vlindex == windows[k].vlindex &&
+		    windows[k].start <= prev->end) {
+			loge("schedule-table: windows of VL %" PRIu64 " at "
+			     "entries %d-%d and %d-%d overlap", prev->vlindex,
+			     prev->start, prev->end, windows[k].start,
+			     windows[k].end);
+			goto out;
+		}
+	}
+	rc = 0;
+out:
+	free(windows);
+	return rc;
+}
+
+/* Checks that the four schedule tables describe something the switch
+ * can run, so that a bad schedule does not cost a reset. Does nothing
+ * if there is no schedule. */
+int sja1105_schedule_check_valid(const struct sja1105_static_config *config)
+{
+	int subsch[MAX_SCHEDULE_COUNT];
+	int count;
+	int rc;
+
+	if (config->schedule_count == 0 ||
+	    config->schedule_params_count == 0 ||
+	    config->schedule_entry_points_params_count == 0) {
+		return 0;
+	}
+	count = config->schedule_entry_points_params[0].actsubsch + 1;
+	if (count > SJA1105_SCHEDULE_MAX_SUBSCHEDULES) {
+		loge("schedule-entry-points-parameters-table: actsubsch out of range");
+		return -EINVAL;
+	}
+	rc = sja1105_schedule_entries_check(config);
+	if (rc < 0) {
+		return rc;
+	}
+	rc = sja1105_schedule_subschedules_check(config, count, subsch);
+	if (rc < 0) {
+		return rc;
+	}
+	rc = sja1105_schedule_entry_points_check(config, count, subsch);
+	if (rc < 0) {
+		return rc;
+	}
+	return sja1105_schedule_windows_check(config, subsch);
+}
@@ -0,0 +1,172 @@
+/******************************************************************************
+ * Copyright (c) 2018, NXP Semiconductors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+/* These are our own include files */
+#include <lib/include/static-config.h>
+#include <common.h>
+
+/* Checks @desc against what the schedule tables can hold. Cycles are
+ * subschedules, and must start in order of their start time. */
+static int
+sja1105_schedule_desc_check(const struct sja1105_schedule_desc *desc)
+{
+	const struct sja1105_schedule_cycle *cycle;
+	const struct sja1105_schedule_timeslot *slot;
+	int total = 0;
+	int i, j;
+
+	if (desc->cycle_count < 1 ||
+	    desc->cycle_count > SJA1105_SCHEDULE_MAX_SUBSCHEDULES) {
+		loge("schedule needs 1 to %d cycles, not %d",
+		     SJA1105_SCHEDULE_MAX_SUBSCHEDULES, desc->cycle_count);
+		return -ERANGE;
+	}
+	if (desc->clksrc > 3) {
+		loge("invalid schedule clock source %" PRIu64, desc->clksrc);
+		return -EINVAL;
+	}
+	for (i = 0; i < desc->cycle_count; i++) {
+		cycle = &desc->cycles[i];
+		if (cycle->start_time == 0 ||
+		    cycle->start_time > SJA1105_SCHEDULE_DELTA_MAX) {
+			loge("cycle %d: start time %" PRIu64 " out of range "
+			     "(1 to %d)", i, cycle->start_time,
+			     SJA1105_SCHEDULE_DELTA_MAX);
+			return -ERANGE;
+		}
+		if (i > 0 && cycle->start_time <= desc->cycles[i - 1].start_time) {
+			loge("cycles %d and %d are not in order of their "
+			     "start time", i - 1, i);
+			return -EINVAL;
+		}
+		if (cycle->timeslot_count < 1) {
+			loge("cycle %d has no timeslots", i);
+			return -EINVAL;
+		}
+		for (j = 0; j < cycle->timeslot_count; j++) {
+			slot = &cycle->timeslots[j];
+			if (slot->delta == 0 ||
+			    slot->delta > SJA1105_SCHEDULE_DELTA_MAX) {
+				loge("cycle %d timeslot %d: duration %" PRIu64
+				     " out of range (1 to %d)", i, j,
+				     slot->delta, SJA1105_SCHEDULE_DELTA_MAX);
+				return -ERANGE;
+			}
+			if (slot->destports >= (1 << 5) ||
+			    slot->gates_open >= (1 << 8)) {
+				loge("cycle %d timeslot %d: invalid ports "
+				     "or gates", i, j);
+				return -EINVAL;
+			}
+		}
+		total += cycle->timeslot_count;
+	}
+	if (total > MAX_SCHEDULE_COUNT) {
+		loge("schedule has %d timeslots, more than the %d that fit",
+		     total, MAX_SCHEDULE_COUNT);
+		return -ERANGE;
+	}
+	return total;
+}
+
+/* Builds the Schedule, Schedule Entry Points, Schedule Parameters and
+ * Schedule Entry Points Parameters tables of @config from @desc. The
+ * timeslots of all cycles go into the Schedule table one after the
+ * other, each cycle being a subschedule with its own entry point.
+ * Nothing is changed if @desc does not fit the hardware.
+ */
+int sja1105_schedule_compile(struct sja1105_static_config *config,
+                             const struct sja1105_schedule_desc *desc)
+{
+	struct sja1105_schedule_entry_points_params_entry *ep_params;
+	struct sja1105_schedule_entry_points_entry *ep;
+	struct sja1105_schedule_params_entry *params;
+	const struct sja1105_schedule_cycle *cycle;
+	const struct sja1105_schedule_timeslot *slot;
+	struct sja1105_schedule_entry *entry;
+	int total;
+	int i, j, k;
+	int rc;
+
+	rc = sja1105_schedule_desc_check(desc);
+	if (rc < 0) {
+		return rc;
+	}
+	total = rc;
+	/* Start over from empty tables, so no field is left behind */
+	sja1105_static_config_resize(config, BLKID_SCHEDULE_TABLE, 0);
+	sja1105_static_config_resize(config, BLKID_SCHEDULE_ENTRY_POINTS_TABLE, 0);
+	sja1105_static_config_resize(config, BLKID_SCHEDULE_PARAMS_TABLE, 0);
+	sja1105_static_config_resize(config,
+	                             BLKID_SCHEDULE_ENTRY_POINTS_PARAMS_TABLE, 0);
+	if (sja1105_static_config_resize(config, BLKID_SCHEDULE_TABLE, total) ||
+	    sja1105_static_config_resize(config, BLKID_SCHEDULE_ENTRY_POINTS_TABLE,
+	                                 desc->cycle_count) ||
+	    sja1105_static_config_resize(config, BLKID_SCHEDULE_PARAMS_TABLE, 1) ||
+	    sja1105_static_config_resize(config,
+	                                 BLKID_SCHEDULE_ENTRY_POINTS_PARAMS_TABLE,
+	                                 1)) {
+		return -ENOMEM;
+	}
+	params = &config->schedule_params[0];
+	for (i = 0, k = 0; i < desc->cycle_count; i++) {
+		cycle = &desc->cycles[i];
+		ep = &config->schedule_entry_points[i];
+		ep->subschindx = i;
+		ep->delta      = cycle->start_time;
+		ep->address    = k;
+		for (j = 0; j < cycle->timeslot_count; j++, k++) {
+			slot  = &cycle->timeslots[j];
+			entry = &config->schedule[k];
+			entry->destports   = slot->destports;
+			entry->resmedia_en = 1;
+			entry->resmedia    = ~slot->gates_open & 0xff;
+			entry->delta       = slot->delta;
+		}
+		/* Unused subschedules end where the last one does */
+		for (j = i; j < SJA1105_SCHEDULE_MAX_SUBSCHEDULES; j++) {
+			params->subscheind[j] = k - 1;
+		}
+	}
+	ep_params = &config->schedule_entry_points_params[0];
+	ep_params->clksrc    = desc->clksrc;
+	ep_params->actsubsch = desc->cycle_count - 1;
+
+	sja1105_static_config_mark_dirty(config, BLKID_SCHEDULE_TABLE);
+	sja1105_static_config_mark_dirty(config, BLKID_SCHEDULE_ENTRY_POINTS_TABLE);
+	sja1105_static_config_mark_dirty(config, BLKID_SCHEDULE_PARAMS_TABLE);
+	sja1105_static_config_mark_dirty(config,
+	                                 BLKID_SCHEDULE_ENTRY_POINTS_PARAMS_TABLE);
+	return total;
+}
@@ -0,0 +1,151 @@
+/******************************************************************************
+ * Copyright (c) 2018, NXP Semiconductors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+/* These are our own include files */
+#include <lib/include/static-config.h>
+#include <common.h>
+
+/* Number of Schedule entries that a window of @ticks takes, DELTA being
+ * limited to SJA1105_SCHEDULE_DELTA_MAX */
+static int sja1105_schedule_window_entries(uint64_t ticks)
+{
+	/* Left for sja1105_schedule_compile to refuse */
+	if (ticks == 0) {
+		return 1;
+	}
+	return (ticks + SJA1105_SCHEDULE_DELTA_MAX - 1) /
+	       SJA1105_SCHEDULE_DELTA_MAX;
+}
+
+static int sja1105_schedule_same_gates(const struct sja1105_schedule_timeslot *a,
+                                       const struct sja1105_schedule_timeslot *b)
+{
+	return a->destports == b->destports && a->gates_open == b->gates_open;
+}
+
+/* Merges the runs of timeslots of @cycle that have the same gate states,
+ * then splits windows longer than DELTA_MAX into as few entries as
+ * possible. Done in place, in one pass over the timeslots, plus one
+ * more if something needs splitting. */
+static int sja1105_schedule_cycle_optimize(struct sja1105_schedule_cycle *cycle,
+                                           struct sja1105_schedule_budget *budget)
+{
+	struct sja1105_schedule_timeslot *slots = cycle->timeslots;
+	struct sja1105_schedule_timeslot *tmp;
+	uint64_t delta;
+	int count = 0;
+	int entries = 0;
+	int i, k;
+
+	for (i = 0; i < cycle->timeslot_count; i++) {
+		if (count > 0 && sja1105_schedule_same_gates(&slots[count - 1],
+		                                             &slots[i])) {
+			slots[count - 1].delta += slots[i].delta;
+			budget->merged++;
+			continue;
+		}
+		slots[count++] = slots[i];
+	}
+	for (i = 0; i < count; i++) {
+		entries += sja1105_schedule_window_entries(slots[i].delta);
+	}
+	if (entries > count) {
+		tmp = realloc(slots, entries * sizeof(*slots));
+		if (tmp == NULL) {
+			return -ENOMEM;
+		}
+		slots = tmp;
+		cycle->timeslots = slots;
+		/* Spread from the end, so that nothing is overwritten
+		 * before it is moved */
+		for (i = count - 1, k = entries; i >= 0; i--) {
+			delta = slots[i].delta;
+			while (delta > SJA1105_SCHEDULE_DELTA_MAX) {
+				slots[--k] = slots[i];
+				slots[k].delta = SJA1105_SCHEDULE_DELTA_MAX;
+				delta -= SJA1105_SCHEDULE_DELTA_MAX;
+				budget->split++;
+			}
+			slots[--k] = slots[i];
+			slots[k].delta = delta;
+		}
+	}
+	cycle->timeslot_count = entries;
+	return entries;
+}
+
+/* Rewrites @desc into the fewest Schedule entries that give the same gate
+ * timeline, and reports the result in @budget:
+ *   * adjacent timeslots of a cycle with the same ports and open gates
+ *     become one window;
+ *   * windows too long for a single DELTA take consecutive entries: one
+ *     with the remainder, then as many as needed with the largest DELTA;
+ *   * cycles are put in order of their start time, as the entry points
+ *     must be.
+ * The timeslots of each cycle must have been allocated with malloc, as
+ * they may be reallocated. Returns the number of Schedule entries that
+ * the result needs, which may be above MAX_SCHEDULE_COUNT: @budget then
+ * tells by how much.
+ */
+int sja1105_schedule_optimize(struct sja1105_schedule_desc *desc,
+                              struct sja1105_schedule_budget *budget)
+{
+	struct sja1105_schedule_cycle cycle;
+	int i, j, rc;
+
+	memset(budget, 0, sizeof(*budget));
+	if (desc->cycle_count > SJA1105_SCHEDULE_MAX_SUBSCHEDULES) {
+		return -ERANGE;
+	}
+	/* Insertion sort: there are at most 8 cycles, mostly in order */
+	for (i = 1; i < desc->cycle_count; i++) {
+		cycle = desc->cycles[i];
+		for (j = i; j > 0 &&
+		     desc->cycles[j - 1].start_time > cycle.start_time; j--) {
+			desc->cycles[j] = desc->cycles[j - 1];
+			budget->reordered = 1;
+		}
+		desc->cycles[j] = cycle;
+	}
+	for (i = 0; i < desc->cycle_count; i++) {
+		budget->timeslots += desc->cycles[i].timeslot_count;
+		rc = sja1105_schedule_cycle_optimize(&desc->cycles[i], budget);
+		if (rc < 0) {
+			return rc;
+		}
+		budget->cycle_entries[i] = rc;
+		budget->entries += rc;
+	}
+	return budget->entries;
+}
@@ -0,0 +1,629 @@
+/******************************************************************************
+ * Copyright (c) 2018, NXP Semiconductors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+/* These are our own include files */
+#include <lib/include/static-config.h>
+#include <common.h>
+
+/* Offline model of the time-aware scheduler.
+ *
+ * Each active subschedule starts at the DELTA of its entry point, then
+ * runs its Schedule entries from ADDRESS to SUBSCHEIND over and over,
+ * each entry setting the gates of its DESTPORTS and lasting for its
+ * DELTA. Until a port is touched by an entry, all its gates are open.
+ * Once the last subschedule has started, the gate states repeat with
+ * the least common multiple of the subschedule periods: this is the
+ * hypercycle that the timeline covers.
+ */
+
+/* Longest hypercycle and most schedule entries executed that we agree
+ * to simulate */
+#define SJA1105_GATE_TIMELINE_MAX_NS     ((uint64_t) 10000000000)
+#define SJA1105_GATE_TIMELINE_MAX_EVENTS (1 << 24)
+
+/* Preamble, SFD and inter-frame gap, on top of the frame */
+#define SJA1105_FRAME_OVERHEAD 20
+
+struct sja1105_subschedule {
+	uint64_t start;
+	uint64_t period;
+	uint64_t next;
+	int first;
+	int last;
+	int cur;
+};
+
+static uint64_t gcd(uint64_t a, uint64_t b)
+{
+	uint64_t t;
+
+	while (b) {
+		t = a % b;
+		a = b;
+		b = t;
+	}
+	return a;
+}
+
+static int
+sja1105_subschedules_get(const struct sja1105_static_config *config,
+                         struct sja1105_subschedule *subsch)
+{
+	const uint64_t *subscheind = config->schedule_params[0].subscheind;
+	const struct sja1105_schedule_entry_points_entry *ep;
+	int count;
+	int i, j;
+
+	if (config->schedule_count == 0 ||
+	    config->schedule_entry_points_count == 0 ||
+	    config->schedule_params_count == 0 ||
+	    config->schedule_entry_points_params_count == 0) {
+		loge("staging area has no schedule");
+		return -ENOENT;
+	}
+	/* Which also makes sure that the loop below finds everything */
+	if (sja1105_schedule_check_valid(config) < 0) {
+		return -EINVAL;
+	}
+	/* The first entry point of each subschedule starts it. Those
+	 * restarting it later on are not modelled. */
+	count = config->schedule_entry_points_params[0].actsubsch + 1;
+	for (i = 0; i < count; i++) {
+		for (j = config->schedule_entry_points_count - 1; j >= 0; j--) {
+			ep = &config->schedule_entry_points[j];
+			if (ep->subschindx == (uint64_t) i) {
+				subsch[i].cur   = ep->address;
+				subsch[i].start = ep->delta * SJA1105_SCHEDULE_TICK_NS;
+			}
+		}
+		subsch[i].first = i ? subscheind[i - 1] + 1 : 0;
+		subsch[i].last  = subscheind[i];
+		subsch[i].next  = subsch[i].start;
+		subsch[i].period = 0;
+		for (j = subsch[i].first; j <= subsch[i].last; j++) {
+			subsch[i].period += config->schedule[j].delta *
+			                    SJA1105_SCHEDULE_TICK_NS;
+		}
+	}
+	return count;
+}
+
+static int
+sja1105_gate_timeline_push(struct sja1105_gate_timeline *timeline, int port,
+                           uint64_t start, uint64_t end, uint64_t gates_open)
+{
+	struct sja1105_gate_segment *segments;
+	int capacity;
+
+	if (timeline->count[port] == timeline->capacity[port]) {
+		capacity = timeline->capacity[port] ?
+		           2 * timeline->capacity[port] : 16;
+		segments = realloc(timeline->segments[port],
+		                   capacity * sizeof(*segments));
+		if (segments == NULL) {
+			return -ENOMEM;
+		}
+		timeline->segments[port]  = segments;
+		timeline->capacity[port] = capacity;
+	}
+	segments = &timeline->segments[port][timeline->count[port]++];
+	segments->start      = start;
+	segments->end        = end;
+	segments->gates_open = gates_open;
+	return 0;
+}
+
+void sja1105_gate_timeline_free(struct sja1105_gate_timeline *timeline)
+{
+	int port;
+
+	for (port = 0; port < SJA1105_SCHEDULE_PORT_COUNT; port++) {
+		free(timeline->segments[port]);
+	}
+	memset(timeline, 0, sizeof(*timeline));
+}
+
+/* Expands the schedule tables of @config into the gate states of each
+ * port over one hypercycle. Consecutive segments of a port always have
+ * different gate states. Returns -E2BIG if the hypercycle is too long
+ * to simulate. */
+int sja1105_gate_timeline_build(const struct sja1105_static_config *config,
+                                struct sja1105_gate_timeline *timeline)
+{
+	struct sja1105_subschedule subsch[SJA1105_SCHEDULE_MAX_SUBSCHEDULES];
+	uint64_t mask[SJA1105_SCHEDULE_PORT_COUNT];
+	uint64_t since[SJA1105_SCHEDULE_PORT_COUNT];
+	const struct sja1105_schedule_entry *entry;
+	struct sja1105_gate_segment *last;
+	uint64_t hypercycle = 1;
+	uint64_t start = 0;
+	uint64_t events = 0;
+	uint64_t gates_open;
+	uint64_t t, end;
+	int started = 0;
+	int count;
+	int i, port, rc;
+
+	memset(timeline, 0, sizeof(*timeline));
+	rc = sja1105_subschedules_get(config, subsch);
+	if (rc < 0) {
+		return rc;
+	}
+	count = rc;
+	for (i = 0; i < count; i++) {
+		hypercycle = hypercycle / gcd(hypercycle, subsch[i].period) *
+		             subsch[i].period;
+		if (hypercycle > SJA1105_GATE_TIMELINE_MAX_NS) {
+			loge("hypercycle is longer than %" PRIu64 " ns",
+			     SJA1105_GATE_TIMELINE_MAX_NS);
+			return -E2BIG;
+		}
+		start = max(start, subsch[i].start);
+	}
+	end = start + hypercycle;
+	for (i = 0; i < count; i++) {
+		events += ((end - subsch[i].start) / subsch[i].period + 1) *
+		          (subsch[i].last - subsch[i].first + 1);
+	}
+	if (events > SJA1105_GATE_TIMELINE_MAX_EVENTS) {
+		loge("schedule needs more than %d entries executed",
+		     SJA1105_GATE_TIMELINE_MAX_EVENTS);
+		return -E2BIG;
+	}
+	timeline->offset = start;
+	timeline->length = hypercycle;
+	for (port = 0; port < SJA1105_SCHEDULE_PORT_COUNT; port++) {
+		mask[port] = 0xff;
+	}
+	while (1) {
+		/* Next entry due, the lowest subschedule first on a tie */
+		for (i = 0, rc = -1; i < count; i++) {
+			if (subsch[i].next < end &&
+			    (rc < 0 || subsch[i].next < subsch[rc].next)) {
+				rc = i;
+			}
+		}
+		if (rc < 0) {
+			break;
+		}
+		i = rc;
+		t = subsch[i].next;
+		if (!started && t >= start) {
+			for (port = 0; port < SJA1105_SCHEDULE_PORT_COUNT; port++) {
+				since[port] = 0;
+			}
+			started = 1;
+		}
+		entry = &config->schedule[subsch[i].cur];
+		gates_open = entry->resmedia_en ? (~entry->resmedia & 0xff) : 0xff;
+		for (port = 0; port < SJA1105_SCHEDULE_PORT_COUNT; port++) {
+			if (!(entry->destports & (1 << port)) ||
+			    mask[port] == gates_open) {
+				continue;
+			}
+			if (started && since[port] < t - start) {
+				rc = sja1105_gate_timeline_push(timeline, port,
+				                                since[port],
+				                                t - start,
+				                                mask[port]);
+				if (rc < 0) {
+					goto error;
+				}
+				since[port] = t - start;
+			}
+			/* A change back to the state of the previous
+			 * segment at the same time extends that one */
+			if (started && since[port] == t - start &&
+			    timeline->count[port] > 0) {
+				last = &timeline->segments[port][timeline->count[port] - 1];
+				if (last->end == since[port] &&
+				    last->gates_open == gates_open) {
+					since[port] = last->start;
+					timeline->count[port]--;
+				}
+			}
+			mask[port] = gates_open;
+		}
+		subsch[i].next += config->schedule[subsch[i].cur].delta *
+		                  SJA1105_SCHEDULE_TICK_NS;
+		subsch[i].cur = (subsch[i].cur == subsch[i].last) ?
+		                subsch[i].first : subsch[i].cur + 1;
+	}
+	for (port = 0; port < SJA1105_SCHEDULE_PORT_COUNT; port++) {
+		if (!started) {
+			since[port] = 0;
+		}
+		rc = sja1105_gate_timeline_push(timeline, port, since[port],
+		                                hypercycle, mask[port]);
+		if (rc < 0) {
+			goto error;
+		}
+	}
+	return 0;
+error:
+	sja1105_gate_timeline_free(timeline);
+	return rc;
+}
+
+/* A stretch of time during which one gate of a port stays open. The
+ * last window of a timeline may run past its end, into the first one
+ * of the next hypercycle. */
+struct sja1105_gate_window {
+	uint64_t start;
+	uint64_t end;
+};
+
+static int
+sja1105_gate_windows_get(const struct sja1105_gate_timeline *timeline,
+                         int port, int prio,
+                         struct sja1105_gate_window **windows)
+{
+	const struct sja1105_gate_segment *seg = timeline->segments[port];
+	struct sja1105_gate_window *w;
+	int count = 0;
+	int i;
+
+	w = malloc(timeline->count[port] * sizeof(*w));
+	if (w == NULL) {
+		return -ENOMEM;
+	}
+	for (i = 0; i < timeline->count[port]; i++) {
+		if (!(seg[i].gates_open & (1ull << prio))) {
+			continue;
+		}
+		if (count && w[count - 1].end == seg[i].start) {
+			w[count - 1].end = seg[i].end;
+		} else {
+			w[count].start = seg[i].start;
+			w[count].end   = seg[i].end;
+			count++;
+		}
+	}
+	if (count > 1 && w[0].start == 0 &&
+	    w[count - 1].end == timeline->length) {
+		w[count - 1].end += w[0].end;
+		memmove(w, w + 1, --count * sizeof(*w));
+	}
+	*windows = w;
+	return count;
+}
+
+static int
+sja1105_gate_always_open(const struct sja1105_gate_window *w, int count,
+                         uint64_t length)
+{
+	return (count == 1 && w[0].start == 0 && w[0].end == length);
+}
+
+/* Time at which a frame that is first in its queue at @cursor (at least
+ * one hypercycle in) is done sending, if it only starts when there is
+ * time left for @tx_time before its gate closes. */
+static uint64_t
+sja1105_gate_send(const struct sja1105_gate_window *w, int count,
+                  uint64_t length, uint64_t cursor, uint64_t tx_time)
+{
+	uint64_t base = cursor / length * length;
+	uint64_t start;
+	int lo, hi, mid;
+	int i, n;
+
+	if (count == 0) {
+		return SJA1105_LATENCY_UNBOUNDED;
+	}
+	if (sja1105_gate_always_open(w, count, length)) {
+		return cursor + tx_time;
+	}
+	if (w[count - 1].end > length &&
+	    cursor - base < w[count - 1].end - length) {
+		/* Still in the window left open from the last hypercycle */
+		base -= length;
+		i = count - 1;
+	} else {
+		/* First window that has not closed yet */
+		for (lo = 0, hi = count; lo < hi; ) {
+			mid = (lo + hi) / 2;
+			if (w[mid].end <= cursor - base) {
+				lo = mid + 1;
+			} else {
+				hi = mid;
+			}
+		}
+		i = lo;
+		if (i == count) {
+			i = 0;
+			base += length;
+		}
+	}
+	/* The first window may be partly gone, then all come once */
+	for (n = 0; n <= count; n++) {
+		start = max(cursor, base + w[i].start);
+		if (start + tx_time <= base + w[i].end) {
+			return start + tx_time;
+		}
+		if (++i == count) {
+			i = 0;
+			base += length;
+		}
+	}
+	return SJA1105_LATENCY_UNBOUNDED;
+}
+
+/* Completion of a burst of frames queued together at @arrival, the
+ * frame of interest being the last of them */
+static uint64_t
+sja1105_gate_send_burst(const struct sja1105_gate_window *w, int count,
+                        uint64_t length, uint64_t arrival,
+                        const uint64_t *tx_times, int frames)
+{
+	uint64_t cursor = arrival;
+	int i;
+
+	for (i = 0; i < frames; i++) {
+		cursor = sja1105_gate_send(w, count, length, cursor,
+		                           tx_times[i]);
+		if (cursor == SJA1105_LATENCY_UNBOUNDED) {
+			break;
+		}
+	}
+	return cursor;
+}
+
+static uint64_t
+sja1105_stream_egress_ports(const struct sja1105_static_config *config,
+                            const struct sja1105_stream *stream)
+{
+	uint64_t ports = (1 << SJA1105_SCHEDULE_PORT_COUNT) - 1;
+
+	if (stream->egress_ports) {
+		return stream->egress_ports & ports;
+	}
+	if (stream->ingress_port < config->l2_forwarding_count) {
+		ports &= config->l2_forwarding[stream->ingress_port].reach_port;
+	}
+	return ports & ~(1ull << stream->ingress_port);
+}
+
+/* Egress queue of the frames, as remapped by the ingress port */
+static int
+sja1105_stream_egress_prio(const struct sja1105_static_config *config,
+                           const struct sja1105_stream *stream)
+{
+	if (stream->ingress_port < config->l2_forwarding_count) {
+		return config->l2_forwarding[stream->ingress_port].
+		       vlan_pmap[stream->prio] & 7;
+	}
+	return stream->prio;
+}
+
+static uint64_t
+sja1105_stream_tx_time(const struct sja1105_static_config *config,
+                       int port, uint64_t size)
+{
+	uint64_t mbps = 1000;
+
+	if (port < config->mac_config_count) {
+		switch (config->mac_config[port].speed) {
+		case 2: mbps = 100; break;
+		case 3: mbps = 10;  break;
+		default: break;
+		}
+	}
+	return ((size + SJA1105_FRAME_OVERHEAD) * 8 * 1000 + mbps - 1) / mbps;
+}
+
+/* Counts the windows of @w after which another gate of @port opens
+ * while a frame of @tx_time, started just before the close, is still
+ * being sent */
+static int
+sja1105_gate_guard_band_check(const struct sja1105_gate_timeline *timeline,
+                              int port, int prio,
+                              const struct sja1105_gate_window *w, int count,
+                              uint64_t tx_time, uint64_t *worst_overrun)
+{
+	const struct sja1105_gate_segment *seg = timeline->segments[port];
+	int segments = timeline->count[port];
+	uint64_t length = timeline->length;
+	uint64_t base, closed, t, opened;
+	int violations = 0;
+	int lo, hi, mid;
+	int i, k, n;
+
+	if (sja1105_gate_always_open(w, count, length)) {
+		return 0;
+	}
+	for (i = 0; i < count; i++) {
+		closed = w[i].end % length;
+		base = w[i].end - closed;
+		/* Segment that starts at the close */
+		for (lo = 0, hi = segments - 1; lo < hi; ) {
+			mid = (lo + hi + 1) / 2;
+			if (seg[mid].start <= closed) {
+				lo = mid;
+			} else {
+				hi = mid - 1;
+			}
+		}
+		for (k = lo, n = 0; n < segments; n++) {
+			t = base + seg[k].start;
+			if (t >= w[i].end + tx_time) {
+				break;
+			}
+			opened = seg[k].gates_open &
+			         ~seg[(k + segments - 1) % segments].gates_open &
+			         ~(1ull << prio);
+			if (opened) {
+				violations++;
+				*worst_overrun = max(*worst_overrun,
+				                     w[i].end + tx_time - t);
+				break;
+			}
+			if (++k == segments) {
+				k = 0;
+				base += length;
+			}
+		}
+	}
+	return violations;
+}
+
+/* Works out, for each of the @count @streams, the worst-case latency of
+ * its frames through the gates of @timeline. Frames of all streams that
+ * share an egress queue are assumed to arrive together, the frame of
+ * interest last, and a frame only starts when it fits in what is left
+ * of its window. */
+int sja1105_stream_analyze(const struct sja1105_static_config *config,
+                           const struct sja1105_gate_timeline *timeline,
+                           const struct sja1105_stream *streams,
+                           int count,
+                           struct sja1105_stream_report *reports)
+{
+	struct sja1105_gate_window *w = NULL;
+	struct sja1105_stream_report *report;
+	uint64_t *tx_times = NULL;
+	uint64_t length = timeline->length;
+	uint64_t arrival[3];
+	uint64_t demand, open, done, latency, longest;
+	int windows, frames;
+	int prio, port;
+	int i, j, k, a;
+	int rc = 0;
+
+	for (i = 0; i < count; i++) {
+		if (streams[i].ingress_port < 0 ||
+		    streams[i].ingress_port >= SJA1105_SCHEDULE_PORT_COUNT ||
+		    streams[i].prio > 7 || streams[i].size == 0) {
+			loge("stream %d is invalid", i);
+			return -EINVAL;
+		}
+		if (sja1105_stream_egress_ports(config, &streams[i]) == 0) {
+			loge("stream %d is not forwarded to any port", i);
+			return -EINVAL;
+		}
+	}
+	tx_times = malloc((count + 1) * sizeof(*tx_times));
+	if (tx_times == NULL) {
+		return -ENOMEM;
+	}
+	for (i = 0; i < count; i++) {
+		report = &reports[i];
+		memset(report, 0, sizeof(*report));
+		report->egress_port = -1;
+		prio = sja1105_stream_egress_prio(config, &streams[i]);
+		for (port = 0; port < SJA1105_SCHEDULE_PORT_COUNT; port++) {
+			if (!(sja1105_stream_egress_ports(config, &streams[i]) &
+			      (1ull << port))) {
+				continue;
+			}
+			rc = sja1105_gate_windows_get(timeline, port, prio, &w);
+			if (rc < 0) {
+				goto out;
+			}
+			windows = rc;
+			/* Others sharing the queue first, then our own */
+			frames = 0;
+			demand = 0;
+			for (j = 0; j <= count; j++) {
+				k = (j == count) ? i : j;
+				if (j == i ||
+				    sja1105_stream_egress_prio(config, &streams[k]) != prio ||
+				    !(sja1105_stream_egress_ports(config, &streams[k]) &
+				      (1ull << port))) {
+					continue;
+				}
+				tx_times[frames] = sja1105_stream_tx_time(config,
+				                   port, streams[k].size);
+				demand += tx_times[frames] * (streams[k].period ?
+				          (length + streams[k].period - 1) /
+				          streams[k].period : 1);
+				frames++;
+			}
+			open = 0;
+			longest = 0;
+			for (j = 0; j < windows; j++) {
+				open += w[j].end - w[j].start;
+				longest = max(longest, w[j].end - w[j].start);
+			}
+			latency = 0;
+			for (j = 0; j < frames; j++) {
+				if (tx_times[j] > longest) {
+					latency = SJA1105_LATENCY_UNBOUNDED;
+				}
+			}
+			/* Arrivals just as a window opens, just too late for
+			 * the first frame to fit, and as it closes */
+			for (j = 0; j < windows &&
+			     latency != SJA1105_LATENCY_UNBOUNDED; j++) {
+				arrival[0] = w[j].start;
+				arrival[1] = (w[j].end - w[j].start > tx_times[0]) ?
+				             w[j].end - tx_times[0] + 1 : w[j].start;
+				arrival[2] = w[j].end;
+				for (a = 0; a < 3; a++) {
+					done = sja1105_gate_send_burst(w, windows,
+					       length, length + arrival[a],
+					       tx_times, frames);
+					if (done == SJA1105_LATENCY_UNBOUNDED) {
+						latency = done;
+						break;
+					}
+					latency = max(latency,
+					              done - length - arrival[a]);
+				}
+			}
+			if (windows == 0) {
+				latency = SJA1105_LATENCY_UNBOUNDED;
+			}
+			if (report->egress_port < 0 ||
+			    latency > report->worst_latency) {
+				report->egress_port   = port;
+				report->egress_prio   = prio;
+				report->tx_time       = tx_times[frames - 1];
+				report->worst_latency = latency;
+			}
+			if (demand > open) {
+				report->overloaded = 1;
+			}
+			report->violations += sja1105_gate_guard_band_check(
+			                      timeline, port, prio, w, windows,
+			                      tx_times[frames - 1],
+			                      &report->worst_overrun);
+			free(w);
+			w = NULL;
+		}
+	}
+	rc = 0;
+out:
+	free(w);
+	free(tx_times);
+	return rc;
+}
@@ -30,6 +30,7 @@
  *****************************************************************************/
 #include <inttypes.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
 /* These are our own include files */
 #include <lib/include/static-config.h>
@@ -37,35 +38,332 @@
 #include <common.h>
 #include <stddef.h>
 
-static void sja1105_table_write_crc(char *table_start, char *crc_ptr)
+/* Writes the data CRC of a freshly packed table, reusing the cached one
+ * if the table was not changed. Returns @running_crc (the CRC of the
+ * packed buffer up to @table_start) extended over the table data and CRC.
+ */
+static uint32_t
+sja1105_table_write_crc(char *table_start, char *crc_ptr,
+                        struct sja1105_table_cache *cache,
+                        uint32_t running_crc)
 {
-	uint64_t computed_crc;
+	uint64_t data_crc;
 	int len_bytes;
 
 	len_bytes = (int) (crc_ptr - table_start);
-	computed_crc = ether_crc32_le(table_start, len_bytes);
-	gtable_pack(crc_ptr, &computed_crc, 31, 0, 4);
+	if (!cache->valid || cache->len != len_bytes) {
+		cache->crc = ether_crc32_le(table_start, len_bytes);
+		cache->len = len_bytes;
+		cache->valid = 1;
+	}
+	data_crc = cache->crc;
+	gtable_pack(crc_ptr, &data_crc, 31, 0, 4);
+	running_crc = ether_crc32_combine(running_crc, cache->crc, len_bytes);
+	return ether_crc32_le_update(running_crc, crc_ptr, 4);
 }
 
-#define CHECK_COUNT(entry_count, max_entry_count, table_name)                 \
+static struct sja1105_table_cache*
+sja1105_table_cache_get(struct sja1105_static_config *config, int blk_id)
+{
+	switch (blk_id) {
+	case BLKID_SCHEDULE_TABLE:
+		return &config->schedule_cache;
+	case BLKID_SCHEDULE_ENTRY_POINTS_TABLE:
+		return &config->schedule_entry_points_cache;
+	case BLKID_VL_LOOKUP_TABLE:
+		return &config->vl_lookup_cache;
+	case BLKID_VL_POLICING_TABLE:
+		return &config->vl_policing_cache;
+	case BLKID_VL_FORWARDING_TABLE:
+		return &config->vl_forwarding_cache;
+	case BLKID_L2_LOOKUP_TABLE:
+		return &config->l2_lookup_cache;
+	case BLKID_L2_POLICING_TABLE:
+		return &config->l2_policing_cache;
+	case BLKID_VLAN_LOOKUP_TABLE:
+		return &config->vlan_lookup_cache;
+	case BLKID_L2_FORWARDING_TABLE:
+		return &config->l2_forwarding_cache;
+	case BLKID_MAC_CONFIG_TABLE:
+		return &config->mac_config_cache;
+	case BLKID_SCHEDULE_PARAMS_TABLE:
+		return &config->schedule_params_cache;
+	case BLKID_SCHEDULE_ENTRY_POINTS_PARAMS_TABLE:
+		return &config->schedule_entry_points_params_cache;
+	case BLKID_VL_FORWARDING_PARAMS_TABLE:
+		return &config->vl_forwarding_params_cache;
+	case BLKID_L2_LOOKUP_PARAMS_TABLE:
+		return &config->l2_lookup_params_cache;
+	case BLKID_L2_FORWARDING_PARAMS_TABLE:
+		return &config->l2_forwarding_params_cache;
+	case BLKID_AVB_PARAMS_TABLE:
+		return &config->avb_params_cache;
+	case BLKID_GENERAL_PARAMS_TABLE:
+		return &config->general_params_cache;
+	case BLKID_RETAGGING_TABLE:
+		return &config->retagging_cache;
+	case BLKID_XMII_MODE_PARAMS_TABLE:
+		return &config->xmii_params_cache;
+	case BLKID_SGMII_TABLE:
+		return &config->sgmii_cache;
+	default:
+		return NULL;
+	}
+}
+
+void sja1105_static_config_mark_dirty(struct sja1105_static_config *config,
+                                      int blk_id)
+{
+	struct sja1105_table_cache *cache;
+
+	cache = sja1105_table_cache_get(config, blk_id);
+	if (cache != NULL) {
+		cache->valid = 0;
+	}
+}
+
+/* Where the entries of one table of the unpacked config are kept */
+struct sja1105_table_storage {
+	void      **entries;
+	int        *count;
+	int        *capacity;
+	size_t      entry_size;
+	int         max_count;
+	const char *name;
+};
+
+#define TABLE_STORAGE(table, max_entry_count, table_name)                    \
 {                                                                             \
-	if ((entry_count) > (max_entry_count)) {                              \
-		printf("There can be no more than %d %s entries "             \
-		       "(%d present)\n",  (max_entry_count),                  \
-		       (table_name), (entry_count));                          \
-		return -1;                                                    \
-	}                                                                     \
+	storage->entries    = (void**) &config->table;                        \
+	storage->count      = &config->table##_count;                         \
+	storage->capacity   = &config->table##_capacity;                      \
+	storage->entry_size = sizeof(*config->table);                         \
+	storage->max_count  = (max_entry_count);                              \
+	storage->name       = (table_name);                                   \
+}
+
+static int
+sja1105_table_storage_get(struct sja1105_static_config *config, int blk_id,
+                          struct sja1105_table_storage *storage)
+{
+	switch (blk_id) {
+	case BLKID_SCHEDULE_TABLE:
+		TABLE_STORAGE(schedule, MAX_SCHEDULE_COUNT, "Schedule Table");
+		break;
+	case BLKID_SCHEDULE_ENTRY_POINTS_TABLE:
+		TABLE_STORAGE(schedule_entry_points, MAX_SCHEDULE_ENTRY_POINTS_COUNT, "Schedule Entry Points");
+		break;
+	case BLKID_VL_LOOKUP_TABLE:
+		TABLE_STORAGE(vl_lookup, MAX_VL_LOOKUP_COUNT, "VL Lookup");
+		break;
+	case BLKID_VL_POLICING_TABLE:
+		TABLE_STORAGE(vl_policing, MAX_VL_POLICING_COUNT, "VL Policing");
+		break;
+	case BLKID_VL_FORWARDING_TABLE:
+		TABLE_STORAGE(vl_forwarding, MAX_VL_FORWARDING_COUNT, "VL Forwarding");
+		break;
+	case BLKID_L2_LOOKUP_TABLE:
+		TABLE_STORAGE(l2_lookup, MAX_L2_LOOKUP_COUNT, "L2 Lookup");
+		break;
+	case BLKID_L2_POLICING_TABLE:
+		TABLE_STORAGE(l2_policing, MAX_L2_POLICING_COUNT, "L2 Policing");
+		break;
+	case BLKID_VLAN_LOOKUP_TABLE:
+		TABLE_STORAGE(vlan_lookup, MAX_VLAN_LOOKUP_COUNT, "VLAN Lookup");
+		break;
+	case BLKID_L2_FORWARDING_TABLE:
+		TABLE_STORAGE(l2_forwarding, MAX_L2_FORWARDING_COUNT, "L2 Forwarding");
+		break;
+	case BLKID_MAC_CONFIG_TABLE:
+		TABLE_STORAGE(mac_config, MAX_MAC_CONFIG_COUNT, "Mac Configuration");
+		break;
+	case BLKID_SCHEDULE_PARAMS_TABLE:
+		TABLE_STORAGE(schedule_params, MAX_SCHEDULE_PARAMS_COUNT, "Schedule Parameters");
+		break;
+	case BLKID_SCHEDULE_ENTRY_POINTS_PARAMS_TABLE:
+		TABLE_STORAGE(schedule_entry_points_params, MAX_SCHEDULE_ENTRY_POINTS_PARAMS_COUNT, "Schedule Entry Points Parameters");
+		break;
+	case BLKID_VL_FORWARDING_PARAMS_TABLE:
+		TABLE_STORAGE(vl_forwarding_params, MAX_VL_FORWARDING_PARAMS_COUNT, "VL Forwarding Parameters");
+		break;
+	case BLKID_L2_LOOKUP_PARAMS_TABLE:
+		TABLE_STORAGE(l2_lookup_params, MAX_L2_LOOKUP_PARAMS_COUNT, "L2 Lookup Parameters");
+		break;
+	case BLKID_L2_FORWARDING_PARAMS_TABLE:
+		TABLE_STORAGE(l2_forwarding_params, MAX_L2_FORWARDING_PARAMS_COUNT, "L2 Forwarding Parameters");
+		break;
+	case BLKID_AVB_PARAMS_TABLE:
+		TABLE_STORAGE(avb_params, MAX_AVB_PARAMS_COUNT, "AVB Parameters");
+		break;
+	case BLKID_GENERAL_PARAMS_TABLE:
+		TABLE_STORAGE(general_params, MAX_GENERAL_PARAMS_COUNT, "General Parameters");
+		break;
+	case BLKID_RETAGGING_TABLE:
+		TABLE_STORAGE(retagging, MAX_RETAGGING_COUNT, "Retagging");
+		break;
+	case BLKID_XMII_MODE_PARAMS_TABLE:
+		TABLE_STORAGE(xmii_params, MAX_XMII_PARAMS_COUNT, "xMII Parameters");
+		break;
+	case BLKID_SGMII_TABLE:
+		TABLE_STORAGE(sgmii, MAX_SGMII_COUNT, "SGMII Table");
+		break;
+	default:
+		return -EINVAL;
+	}
+	return 0;
 }
 
-#define POPULATE_CONFIG_TABLE(device, table, buf,                             \
-                              max_entry_count, table_name)                    \
+static const int sja1105_table_blk_ids[] = {
+	BLKID_SCHEDULE_TABLE,
+	BLKID_SCHEDULE_ENTRY_POINTS_TABLE,
+	BLKID_VL_LOOKUP_TABLE,
+	BLKID_VL_POLICING_TABLE,
+	BLKID_VL_FORWARDING_TABLE,
+	BLKID_L2_LOOKUP_TABLE,
+	BLKID_L2_POLICING_TABLE,
+	BLKID_VLAN_LOOKUP_TABLE,
+	BLKID_L2_FORWARDING_TABLE,
+	BLKID_MAC_CONFIG_TABLE,
+	BLKID_SCHEDULE_PARAMS_TABLE,
+	BLKID_SCHEDULE_ENTRY_POINTS_PARAMS_TABLE,
+	BLKID_VL_FORWARDING_PARAMS_TABLE,
+	BLKID_L2_LOOKUP_PARAMS_TABLE,
+	BLKID_L2_FORWARDING_PARAMS_TABLE,
+	BLKID_AVB_PARAMS_TABLE,
+	BLKID_GENERAL_PARAMS_TABLE,
+	BLKID_RETAGGING_TABLE,
+	BLKID_XMII_MODE_PARAMS_TABLE,
+	BLKID_SGMII_TABLE,
+};
+
+/* Makes room for at least @capacity entries. The new room is zeroed.
+ * Coming from an empty table, calloc lets the pages of entries that
+ * are never written stay untouched. */
+static int
+sja1105_table_reserve(struct sja1105_table_storage *storage, int capacity)
+{
+	char *entries;
+
+	if (capacity <= *storage->capacity) {
+		return 0;
+	}
+	if (*storage->entries == NULL) {
+		entries = calloc(capacity, storage->entry_size);
+	} else {
+		entries = realloc(*storage->entries,
+		                  capacity * storage->entry_size);
+	}
+	if (!entries) {
+		loge("Cannot allocate %d %s entries", capacity, storage->name);
+		return -ENOMEM;
+	}
+	if (*storage->entries != NULL) {
+		memset(entries + *storage->capacity * storage->entry_size, 0,
+		       (capacity - *storage->capacity) * storage->entry_size);
+	}
+	*storage->entries  = entries;
+	*storage->capacity = capacity;
+	return 0;
+}
+
+/* A static config without any table. Same as zeroing it. */
+void sja1105_static_config_init(struct sja1105_static_config *config)
+{
+	memset(config, 0, sizeof(*config));
+}
+
+/* Releases the memory of all tables and leaves @config initialized,
+ * so that it can be reused. */
+void sja1105_static_config_free(struct sja1105_static_config *config)
+{
+	struct sja1105_table_storage storage;
+	unsigned int i;
+
+	for (i = 0; i < ARRAY_SIZE(sja1105_table_blk_ids); i++) {
+		sja1105_table_storage_get(config, sja1105_table_blk_ids[i],
+		                          &storage);
+		free(*storage.entries);
+	}
+	sja1105_static_config_init(config);
+}
+
+/* Sets the entry count of table @blk_id. Entries that become valid
+ * start out zeroed. Memory is only ever grown, so shrinking a table and
+ * growing it back does not allocate again.
+ */
+int sja1105_static_config_resize(struct sja1105_static_config *config,
+                                 int blk_id, int count)
+{
+	struct sja1105_table_storage storage;
+	int stale;
+	int rc;
+
+	rc = sja1105_table_storage_get(config, blk_id, &storage);
+	if (rc < 0) {
+		return rc;
+	}
+	if (count < 0 || count > storage.max_count) {
+		loge("There can be no more than %d %s entries (%d requested)",
+		     storage.max_count, storage.name, count);
+		return -ERANGE;
+	}
+	/* Clear leftovers of a previous shrink. Whatever
+	 * sja1105_table_reserve adds is zeroed already. */
+	stale = min(count, *storage.capacity) - *storage.count;
+	if (stale > 0) {
+		memset((char*) *storage.entries +
+		       *storage.count * storage.entry_size, 0,
+		       stale * storage.entry_size);
+	}
+	rc = sja1105_table_reserve(&storage, count);
+	if (rc < 0) {
+		return rc;
+	}
+	*storage.count = count;
+	return 0;
+}
+
+/* Adds a copy of @entry at the end of table @blk_id. @entry must be of
+ * the type that the table holds. The memory grows geometrically, so
+ * that building a table one entry at a time stays linear.
+ */
+int sja1105_static_config_append(struct sja1105_static_config *config,
+                                 int blk_id, const void *entry)
+{
+	struct sja1105_table_storage storage;
+	int capacity;
+	int rc;
+
+	rc = sja1105_table_storage_get(config, blk_id, &storage);
+	if (rc < 0) {
+		return rc;
+	}
+	if (*storage.count >= storage.max_count) {
+		loge("There can be no more than %d %s entries",
+		     storage.max_count, storage.name);
+		return -ERANGE;
+	}
+	if (*storage.count == *storage.capacity) {
+		capacity = max(*storage.capacity * 2, 4);
+		capacity = min(capacity, storage.max_count);
+		rc = sja1105_table_reserve(&storage, capacity);
+		if (rc < 0) {
+			return rc;
+		}
+	}
+	memcpy((char*) *storage.entries + *storage.count * storage.entry_size,
+	       entry, storage.entry_size);
+	(*storage.count)++;
+	return 0;
+}
+
+#define POPULATE_CONFIG_TABLE(device, table, buf)                             \
 {                                                                             \
-	int count = config->table##_count;                                    \
 	struct sja1105_##table##_entry entry;                                 \
-	CHECK_COUNT(count, (max_entry_count), (table_name));                  \
 	sja1105##device##_##table##_entry_unpack(buf, &entry);                \
-	config->table[count++] = entry;                                       \
-	config->table##_count = count;                                        \
+	if (sja1105_static_config_append(config, hdr->block_id, &entry) < 0) {\
+		return -1;                                                    \
+	}                                                                     \
 }
 
 /* Input: struct sja1105_table_header *hdr
@@ -84,92 +382,92 @@ int sja1105_static_config_add_entry(struct sja1105_table_header *hdr, void *buf,
 	switch (hdr->block_id) {
 	case BLKID_SCHEDULE_TABLE:
 	{
-		POPULATE_CONFIG_TABLE(, schedule, buf, MAX_SCHEDULE_COUNT, "Schedule Table");
+		POPULATE_CONFIG_TABLE(, schedule, buf);
 		return SIZE_SCHEDULE_ENTRY;
 	}
 	case BLKID_SCHEDULE_ENTRY_POINTS_TABLE:
 	{
-		POPULATE_CONFIG_TABLE(, schedule_entry_points, buf, MAX_SCHEDULE_ENTRY_POINTS_COUNT, "Schedule Entry Points");
+		POPULATE_CONFIG_TABLE(, schedule_entry_points, buf);
 		return SIZE_SCHEDULE_ENTRY_POINTS_ENTRY;
 	}
 	case BLKID_VL_LOOKUP_TABLE:
 	{
-		POPULATE_CONFIG_TABLE(, vl_lookup, buf, MAX_VL_LOOKUP_COUNT, "VL Lookup");
+		POPULATE_CONFIG_TABLE(, vl_lookup, buf);
 		return SIZE_VL_LOOKUP_ENTRY;
 	}
 	case BLKID_VL_POLICING_TABLE:
 	{
-		POPULATE_CONFIG_TABLE(, vl_policing, buf, MAX_VL_POLICING_COUNT, "VL Policing");
+		POPULATE_CONFIG_TABLE(, vl_policing, buf);
 		return SIZE_VL_POLICING_ENTRY;
 	}
 	case BLKID_VL_FORWARDING_TABLE:
 	{
-		POPULATE_CONFIG_TABLE(, vl_forwarding, buf, MAX_VL_FORWARDING_COUNT, "VL Forwarding");
+		POPULATE_CONFIG_TABLE(, vl_forwarding, buf);
 		return SIZE_VL_FORWARDING_ENTRY;
 	}
 	case BLKID_L2_LOOKUP_TABLE:
 	{
 		if (IS_ET(config->device_id)) {
-			POPULATE_CONFIG_TABLE(et, l2_lookup, buf, MAX_L2_LOOKUP_COUNT, "L2 Lookup");
+			POPULATE_CONFIG_TABLE(et, l2_lookup, buf);
 			return SIZE_L2_LOOKUP_ENTRY_ET;
 		} else {
-			POPULATE_CONFIG_TABLE(pqrs, l2_lookup, buf, MAX_L2_LOOKUP_COUNT, "L2 Lookup");
+			POPULATE_CONFIG_TABLE(pqrs, l2_lookup, buf);
 			return SIZE_L2_LOOKUP_ENTRY_PQRS;
 		}
 	}
 	case BLKID_L2_POLICING_TABLE:
 	{
-		POPULATE_CONFIG_TABLE(, l2_policing, buf, MAX_L2_POLICING_COUNT, "L2 Policing");
+		POPULATE_CONFIG_TABLE(, l2_policing, buf);
 		return SIZE_L2_POLICING_ENTRY;
 	}
 	case BLKID_VLAN_LOOKUP_TABLE:
 	{
-		POPULATE_CONFIG_TABLE(, vlan_lookup, buf, MAX_VLAN_LOOKUP_COUNT, "VLAN Lookup");
+		POPULATE_CONFIG_TABLE(, vlan_lookup, buf);
 		return SIZE_VLAN_LOOKUP_ENTRY;
 	}
 	case BLKID_L2_FORWARDING_TABLE:
 	{
-		POPULATE_CONFIG_TABLE(, l2_forwarding, buf, MAX_L2_FORWARDING_COUNT, "L2 Forwarding");
+		POPULATE_CONFIG_TABLE(, l2_forwarding, buf);
 		return SIZE_L2_FORWARDING_ENTRY;
 	}
 	case BLKID_MAC_CONFIG_TABLE:
 	{
 		if (IS_ET(config->device_id)) {
-			POPULATE_CONFIG_TABLE(et, mac_config, buf, MAX_MAC_CONFIG_COUNT, "Mac Configuration");
+			POPULATE_CONFIG_TABLE(et, mac_config, buf);
 			return SIZE_MAC_CONFIG_ENTRY_ET;
 		} else {
-			POPULATE_CONFIG_TABLE(pqrs, mac_config, buf, MAX_MAC_CONFIG_COUNT, "Mac Configuration");
+			POPULATE_CONFIG_TABLE(pqrs, mac_config, buf);
 			return SIZE_MAC_CONFIG_ENTRY_PQRS;
 		}
 	}
 	case BLKID_SCHEDULE_PARAMS_TABLE:
 	{
-		POPULATE_CONFIG_TABLE(, schedule_params, buf, MAX_SCHEDULE_PARAMS_COUNT, "Schedule Parameters");
+		POPULATE_CONFIG_TABLE(, schedule_params, buf);
 		return SIZE_SCHEDULE_PARAMS_ENTRY;
 	}
 	case BLKID_SCHEDULE_ENTRY_POINTS_PARAMS_TABLE:
 	{
-		POPULATE_CONFIG_TABLE(, schedule_entry_points_params, buf, MAX_SCHEDULE_ENTRY_POINTS_PARAMS_COUNT, "Schedule Entry Points Parameters");
+		POPULATE_CONFIG_TABLE(, schedule_entry_points_params, buf);
 		return SIZE_SCHEDULE_ENTRY_POINTS_PARAMS_ENTRY;
 	}
 	case BLKID_VL_FORWARDING_PARAMS_TABLE:
 	{
-		POPULATE_CONFIG_TABLE(, vl_forwarding_params, buf, MAX_VL_FORWARDING_PARAMS_COUNT, "VL Forwarding Parameters");
+		POPULATE_CONFIG_TABLE(, vl_forwarding_params, buf);
 		return SIZE_VL_FORWARDING_PARAMS_ENTRY;
 	}
 	case BLKID_L2_LOOKUP_PARAMS_TABLE:
 	{
 		if (IS_ET(config->device_id)) {
-			POPULATE_CONFIG_TABLE(et, l2_lookup_params, buf, MAX_L2_LOOKUP_PARAMS_COUNT, "L2 Lookup Parameters");
+			POPULATE_CONFIG_TABLE(et, l2_lookup_params, buf);
 			return SIZE_L2_LOOKUP_PARAMS_ENTRY_ET;
 		} else {
-			POPULATE_CONFIG_TABLE(pqrs, l2_lookup_params, buf, MAX_L2_LOOKUP_PARAMS_COUNT, "L2 Lookup Parameters");
+			POPULATE_CONFIG_TABLE(pqrs, l2_lookup_params, buf);
 			return SIZE_L2_LOOKUP_PARAMS_ENTRY_PQRS;
 		}
 	}
 	case BLKID_L2_FORWARDING_PARAMS_TABLE:
 	{
-		POPULATE_CONFIG_TABLE(, l2_forwarding_params, buf, MAX_L2_FORWARDING_PARAMS_COUNT, "L2 Forwarding Parameters");
+		POPULATE_CONFIG_TABLE(, l2_forwarding_params, buf);
 		return SIZE_L2_FORWARDING_PARAMS_ENTRY;
 	}
 	case BLKID_CLK_SYNC_PARAMS_TABLE:
@@ -179,29 +477,21 @@ int sja1105_static_config_add_entry(struct sja1105_table_header *hdr, void *buf,
 	}
 	case BLKID_AVB_PARAMS_TABLE:
 	{
-		struct sja1105_avb_params_entry entry;
-		CHECK_COUNT(config->avb_params_count, MAX_AVB_PARAMS_COUNT, "AVB Parameters");
 		if (IS_ET(config->device_id)) {
-			sja1105et_avb_params_entry_unpack(buf, &entry);
-			config->avb_params[config->avb_params_count++] = entry;
+			POPULATE_CONFIG_TABLE(et, avb_params, buf);
 			return SIZE_AVB_PARAMS_ENTRY_ET;
 		} else {
-			sja1105pqrs_avb_params_entry_unpack(buf, &entry);
-			config->avb_params[config->avb_params_count++] = entry;
+			POPULATE_CONFIG_TABLE(pqrs, avb_params, buf);
 			return SIZE_AVB_PARAMS_ENTRY_PQRS;
 		}
 	}
 	case BLKID_GENERAL_PARAMS_TABLE:
 	{
-		struct sja1105_general_params_entry entry;
-		CHECK_COUNT(config->general_params_count, MAX_GENERAL_PARAMS_COUNT, "General Parameters");
 		if (IS_ET(config->device_id)) {
-			sja1105et_general_params_entry_unpack(buf, &entry);
-			config->general_params[config->general_params_count++] = entry;
+			POPULATE_CONFIG_TABLE(et, general_params, buf);
 			return SIZE_GENERAL_PARAMS_ENTRY_ET;
 		} else {
-			sja1105pqrs_general_params_entry_unpack(buf, &entry);
-			config->general_params[config->general_params_count++] = entry;
+			POPULATE_CONFIG_TABLE(pqrs, general_params, buf);
 			return SIZE_GENERAL_PARAMS_ENTRY_PQRS;
 		}
 	}
@@ -212,12 +502,12 @@ int sja1105_static_config_add_entry(struct sja1105_table_header *hdr, void *buf,
 	}
 	case BLKID_XMII_MODE_PARAMS_TABLE:
 	{
-		POPULATE_CONFIG_TABLE(, xmii_params, buf, MAX_XMII_PARAMS_COUNT, "xMII Parameters");
+		POPULATE_CONFIG_TABLE(, xmii_params, buf);
 		return SIZE_XMII_MODE_PARAMS_ENTRY;
 	}
 	case BLKID_SGMII_TABLE:
 	{
-		POPULATE_CONFIG_TABLE(, sgmii, buf, MAX_SGMII_COUNT, "SGMII Table");
+		POPULATE_CONFIG_TABLE(, sgmii, buf);
 		return SIZE_SGMII_ENTRY;
 	}
 	default:
@@ -237,7 +527,7 @@ int sja1105_static_config_hexdump(void *buf)
 	char *table_end;
 	int bytes;
 
-	memset(&config, 0, sizeof(config));
+	sja1105_static_config_init(&config);
 	/* Retrieve device_id from first 4 bytes of packed buffer */
 	gtable_unpack(p, &config.device_id, 31, 0, 4);
 	printf("Device ID is 0x%08" PRIx64 " (%s)\n",
@@ -278,8 +568,10 @@ int sja1105_static_config_hexdump(void *buf)
 		p += 4;
 		printf("\n");
 	}
+	sja1105_static_config_free(&config);
 	return ((ptrdiff_t) (p - (char*) buf)) * sizeof(*buf);
 error:
+	sja1105_static_config_free(&config);
 	return -1;
 }
 
@@ -288,9 +580,16 @@ sja1105_static_config_patch_vllupformat(struct sja1105_static_config *config)
 {
 	int i;
 
+	if (config->general_params_count == 0) {
+		return;
+	}
 	for (i = 0; i < config->vl_lookup_count; i++) {
 		config->vl_lookup[i].format = config->general_params->vllupformat;
 	}
+	if (config->general_params->vllupformat != 0) {
+		/* Entries were unpacked with the other format */
+		config->vl_lookup_cache.valid = 0;
+	}
 }
 
 int
@@ -329,6 +628,8 @@ sja1105_static_config_check_memory_size(struct sja1105_static_config *config)
 
 int sja1105_static_config_check_valid(struct sja1105_static_config *config)
 {
+	struct sja1105_vlan_lookup_index vlan_index;
+
 	if (config->schedule_count > 0) {
 		if (config->schedule_entry_points_count == 0) {
 			loge("schedule-table not empty, but schedule-entry-points-table empty");
@@ -342,6 +643,9 @@ int sja1105_static_config_check_valid(struct sja1105_static_config *config)
 			loge("schedule-table not empty, but schedule-entry-points-parameters-table empty");
 			return -1;
 		}
+		if (sja1105_schedule_check_valid(config) < 0) {
+			return -1;
+		}
 	}
 	if (config->vl_lookup_count > 0) {
 		if (config->vl_policing_count == 0) {
@@ -365,6 +669,10 @@ int sja1105_static_config_check_valid(struct sja1105_static_config *config)
 		loge("vlan-lookup-table empty");
 		return -1;
 	}
+	if (sja1105_vlan_lookup_index_build(&vlan_index, config->vlan_lookup,
+	                                    config->vlan_lookup_count) < 0) {
+		return -1;
+	}
 	if (config->l2_forwarding_count != MAX_L2_FORWARDING_COUNT) {
 		loge("l2-forwarding-table does not have %d entries",
 		     MAX_L2_FORWARDING_PARAMS_COUNT);
@@ -388,20 +696,104 @@ int sja1105_static_config_check_valid(struct sja1105_static_config *config)
 		loge("xmii-mode-parameters-table is empty");
 		return -1;
 	}
+	if (sja1105et_l2_lookup_place(config, 0, NULL) != 0) {
+		loge("l2-lookup-table has entries the switch would not find, "
+		     "see \"sja1105-tool config l2-place\"");
+		return -1;
+	}
 	return sja1105_static_config_check_memory_size(config);
 }
 
-int
-sja1105_static_config_unpack(void *buf, struct sja1105_static_config *config)
+/* Decodes the table block whose header is at @p into @config, checking
+ * the header and data CRCs. Entries are appended to those already there.
+ * Returns the number of bytes taken by the block, including the header
+ * and the data CRC.
+ */
+static int
+sja1105_static_config_unpack_block(char *p, struct sja1105_static_config *config)
 {
+	struct sja1105_table_storage storage;
+	struct sja1105_table_cache *cache;
 	struct sja1105_table_header hdr;
-	char *p = buf;
+	char *block_start = p;
 	char *table_end;
+	int entry_size;
+	int count;
 	int bytes;
 	uint64_t read_crc;
 	uint64_t computed_crc;
 
-	memset(config, 0, sizeof(*config));
+	sja1105_table_header_unpack(p, &hdr);
+	/* Print table header with same verbosity level as "logv" */
+	if (SJA1105_VERBOSE_CONDITION) {
+		sja1105_table_header_show(&hdr);
+	}
+	computed_crc = ether_crc32_le(p, SIZE_TABLE_HEADER - 4);
+	computed_crc &= 0xFFFFFFFF;
+	read_crc = hdr.crc & 0xFFFFFFFF;
+	if (read_crc != computed_crc) {
+		loge("Table header CRC is invalid, exiting.");
+		loge("Read %" PRIX64 ", computed %" PRIX64,
+		     read_crc, computed_crc);
+		return -1;
+	}
+	p += SIZE_TABLE_HEADER;
+
+	/* The header tells how many entries follow, so allocate
+	 * the table once, at its final size */
+	entry_size = sja1105_static_config_entry_size(config->device_id,
+	                                              hdr.block_id);
+	if (entry_size > 0 && sja1105_table_storage_get(config,
+	                      hdr.block_id, &storage) == 0) {
+		count = min(*storage.count + (int) (hdr.len * 4 / entry_size),
+		            storage.max_count);
+		if (sja1105_table_reserve(&storage, count) < 0) {
+			return -1;
+		}
+	}
+	table_end = p + hdr.len * 4;
+	computed_crc = ether_crc32_le(p, hdr.len * 4);
+	while (p < table_end) {
+		bytes = sja1105_static_config_add_entry(&hdr, p, config);
+		if (bytes < 0) {
+			return -1;
+		}
+		p += bytes;
+	};
+	if (p != table_end) {
+		loge("WARNING: Incorrect table length for:");
+		sja1105_table_header_show(&hdr);
+		loge("Table data has %td extra bytes compared to header!",
+		     (ptrdiff_t) (table_end - p));
+		p = table_end;
+	}
+	gtable_unpack(p, &read_crc, 31, 0, 4);
+	p += 4;
+	if (computed_crc != read_crc) {
+		loge("Data CRC is invalid, exiting.");
+		loge("Read %" PRIX64 ", computed %" PRIX64,
+		     read_crc, computed_crc);
+		return -1;
+	}
+	cache = sja1105_table_cache_get(config, hdr.block_id);
+	if (cache != NULL) {
+		/* Only a table that came in one piece
+		 * will be packed back the same way */
+		cache->valid = (cache->len == 0);
+		cache->len += hdr.len * 4;
+		cache->crc = computed_crc;
+	}
+	return (int) (p - block_start);
+}
+
+int
+sja1105_static_config_unpack(void *buf, struct sja1105_static_config *config)
+{
+	struct sja1105_table_header hdr;
+	char *p = buf;
+	int bytes;
+
+	sja1105_static_config_free(config);
 	/* Retrieve device_id from first 4 bytes of packed buffer */
 	gtable_unpack(p, &config->device_id, 31, 0, 4);
 	logv("Device ID is 0x%08" PRIx64 " (%s)",
@@ -420,46 +812,11 @@ sja1105_static_config_unpack(void *buf, struct sja1105_static_config *config)
 		if (hdr.len == 0) {
 			break;
 		}
-		/* Print table header with same verbosity level as "logv" */
-		if (SJA1105_VERBOSE_CONDITION) {
-			sja1105_table_header_show(&hdr);
-		}
-		computed_crc = ether_crc32_le(p, SIZE_TABLE_HEADER - 4);
-		computed_crc &= 0xFFFFFFFF;
-		read_crc = hdr.crc & 0xFFFFFFFF;
-		if (read_crc != computed_crc) {
-			loge("Table header CRC is invalid, exiting.");
-			loge("Read %" PRIX64 ", computed %" PRIX64,
-			     read_crc, computed_crc);
-			goto error;
-		}
-		p += SIZE_TABLE_HEADER;
-
-		table_end = p + hdr.len * 4;
-		computed_crc = ether_crc32_le(p, hdr.len * 4);
-		while (p < table_end) {
-			bytes = sja1105_static_config_add_entry(&hdr, p,
-			                                        config);
-			if (bytes < 0) {
-				goto error;
-			}
-			p += bytes;
-		};
-		if (p != table_end) {
-			loge("WARNING: Incorrect table length for:");
-			sja1105_table_header_show(&hdr);
-			loge("Table data has %td extra bytes compared to header!",
-			     (ptrdiff_t) (table_end - p));
-			p = table_end;
-		}
-		gtable_unpack(p, &read_crc, 31, 0, 4);
-		p += 4;
-		if (computed_crc != read_crc) {
-			loge("Data CRC is invalid, exiting.");
-			loge("Read %" PRIX64 ", computed %" PRIX64,
-			     read_crc, computed_crc);
+		bytes = sja1105_static_config_unpack_block(p, config);
+		if (bytes < 0) {
 			goto error;
 		}
+		p += bytes;
 	}
 	sja1105_static_config_patch_vllupformat(config);
 	return 0;
@@ -475,20 +832,23 @@ sja1105_static_config_pack(void *buf, struct sja1105_static_config *config)
 		header.block_id = (blk_id);                                  \
 		header.len = (entry_count) * (entry_size) / 4;               \
 		sja1105_table_header_pack_with_crc(p, &header);              \
+		crc = ether_crc32_le_update(crc, p, SIZE_TABLE_HEADER);      \
 		p += SIZE_TABLE_HEADER;                                      \
 		table_start = p;                                             \
 		for (i = 0; i < (entry_count); i++) {                        \
 			set_fn(p, &(array)[i]);                              \
 			p += (entry_size);                                   \
 		}                                                            \
-		sja1105_table_write_crc(table_start, p);                     \
+		crc = sja1105_table_write_crc(table_start, p,                \
+		                              &(array##_cache), crc);        \
 		p += 4;                                                      \
 	}
 
 	struct sja1105_table_header header = {0};
-	char  *p = buf;
-	char  *table_start;
-	int    i;
+	char    *p = buf;
+	char    *table_start;
+	uint32_t crc;
+	int      i;
 
 	if (!DEVICE_ID_VALID(config->device_id)) {
 		loge("Cannot pack invalid Device ID 0x08%"
@@ -497,6 +857,7 @@ sja1105_static_config_pack(void *buf, struct sja1105_static_config *config)
 	}
 
 	gtable_pack(p, &config->device_id, 31, 0, 4);
+	crc = ether_crc32_le(p, SIZE_SJA1105_DEVICE_ID);
 	p += SIZE_SJA1105_DEVICE_ID;
 
 	PACK_TABLE_IN_BUF_FN(config->schedule_count,
@@ -542,6 +903,10 @@ sja1105_static_config_pack(void *buf, struct sja1105_static_config *config)
 	                     BLKID_L2_POLICING_TABLE,
 	                     sja1105_l2_policing_entry_pack,
 	                     config->l2_policing);
+	/* The switch expects the VLAN Lookup entries in VID order */
+	if (sja1105_vlan_lookup_sort(config) < 0) {
+		return -ENOMEM;
+	}
 	PACK_TABLE_IN_BUF_FN(config->vlan_lookup_count,
 	                     SIZE_VLAN_LOOKUP_ENTRY,
 	                     BLKID_VLAN_LOOKUP_TABLE,
@@ -639,6 +1004,8 @@ sja1105_static_config_pack(void *buf, struct sja1105_static_config *config)
 	header.len = 0;           /* Marks that header is final */
 	header.crc = 0xDEADBEEF;  /* Will be replaced on-the-fly on "config upload" */
 	sja1105_table_header_pack(p, &header);
+	config->packed_crc = ether_crc32_le_update(crc, p,
+	                                           SIZE_TABLE_HEADER - 4);
 	return 0;
 }
 
@@ -695,3 +1062,438 @@ sja1105_static_config_get_length(struct sja1105_static_config *config)
 	return sum;
 }
 
+
+int sja1105_static_config_entry_size(uint64_t device_id, int blk_id)
+{
+	switch (blk_id) {
+	case BLKID_SCHEDULE_TABLE:
+		return SIZE_SCHEDULE_ENTRY;
+	case BLKID_SCHEDULE_ENTRY_POINTS_TABLE:
+		return SIZE_SCHEDULE_ENTRY_POINTS_ENTRY;
+	case BLKID_VL_LOOKUP_TABLE:
+		return SIZE_VL_LOOKUP_ENTRY;
+	case BLKID_VL_POLICING_TABLE:
+		return SIZE_VL_POLICING_ENTRY;
+	case BLKID_VL_FORWARDING_TABLE:
+		return SIZE_VL_FORWARDING_ENTRY;
+	case BLKID_L2_LOOKUP_TABLE:
+		return IS_ET(device_id) ? SIZE_L2_LOOKUP_ENTRY_ET :
+		                          SIZE_L2_LOOKUP_ENTRY_PQRS;
+	case BLKID_L2_POLICING_TABLE:
+		return SIZE_L2_POLICING_ENTRY;
+	case BLKID_VLAN_LOOKUP_TABLE:
+		return SIZE_VLAN_LOOKUP_ENTRY;
+	case BLKID_L2_FORWARDING_TABLE:
+		return SIZE_L2_FORWARDING_ENTRY;
+	case BLKID_MAC_CONFIG_TABLE:
+		return IS_ET(device_id) ? SIZE_MAC_CONFIG_ENTRY_ET :
+		                          SIZE_MAC_CONFIG_ENTRY_PQRS;
+	case BLKID_SCHEDULE_PARAMS_TABLE:
+		return SIZE_SCHEDULE_PARAMS_ENTRY;
+	case BLKID_SCHEDULE_ENTRY_POINTS_PARAMS_TABLE:
+		return SIZE_SCHEDULE_ENTRY_POINTS_PARAMS_ENTRY;
+	case BLKID_VL_FORWARDING_PARAMS_TABLE:
+		return SIZE_VL_FORWARDING_PARAMS_ENTRY;
+	case BLKID_L2_LOOKUP_PARAMS_TABLE:
+		return IS_ET(device_id) ? SIZE_L2_LOOKUP_PARAMS_ENTRY_ET :
+		                          SIZE_L2_LOOKUP_PARAMS_ENTRY_PQRS;
+	case BLKID_L2_FORWARDING_PARAMS_TABLE:
+		return SIZE_L2_FORWARDING_PARAMS_ENTRY;
+	case BLKID_CLK_SYNC_PARAMS_TABLE:
+		return SIZE_CLK_SYNC_PARAMS_ENTRY;
+	case BLKID_AVB_PARAMS_TABLE:
+		return IS_ET(device_id) ? SIZE_AVB_PARAMS_ENTRY_ET :
+		                          SIZE_AVB_PARAMS_ENTRY_PQRS;
+	case BLKID_GENERAL_PARAMS_TABLE:
+		return IS_ET(device_id) ? SIZE_GENERAL_PARAMS_ENTRY_ET :
+		                          SIZE_GENERAL_PARAMS_ENTRY_PQRS;
+	case BLKID_RETAGGING_TABLE:
+		return SIZE_RETAGGING_ENTRY;
+	case BLKID_XMII_MODE_PARAMS_TABLE:
+		return SIZE_XMII_MODE_PARAMS_ENTRY;
+	case BLKID_SGMII_TABLE:
+		return SIZE_SGMII_ENTRY;
+	default:
+		return -EINVAL;
+	}
+}
+
+/* Walks the table headers of a packed static config, without
+ * looking at any table data, and reports where @blk_id is.
+ * Returns -ENOENT if the table is not present in @buf.
+ */
+int sja1105_static_config_locate(void *buf, unsigned int buf_len, int blk_id,
+                                 struct sja1105_table_location *loc)
+{
+	struct sja1105_table_header hdr;
+	uint64_t device_id;
+	uint64_t computed_crc;
+	char *p = buf;
+	char *end = p + buf_len;
+	int found = 0;
+
+	if (buf_len < SIZE_SJA1105_DEVICE_ID) {
+		return -EINVAL;
+	}
+	gtable_unpack(p, &device_id, 31, 0, 4);
+	if (DEVICE_ID_VALID(device_id) == 0) {
+		return -EINVAL;
+	}
+	p += SIZE_SJA1105_DEVICE_ID;
+
+	while (1) {
+		if (end - p < SIZE_TABLE_HEADER) {
+			return -EINVAL;
+		}
+		sja1105_table_header_unpack(p, &hdr);
+		/* This should match on last table header */
+		if (hdr.len == 0) {
+			break;
+		}
+		computed_crc = ether_crc32_le(p, SIZE_TABLE_HEADER - 4);
+		if ((hdr.crc & 0xFFFFFFFF) != computed_crc) {
+			loge("Table header CRC is invalid");
+			return -EINVAL;
+		}
+		p += SIZE_TABLE_HEADER;
+		if ((end - p) / 4 < (ptrdiff_t) hdr.len + 1) {
+			return -EINVAL;
+		}
+		if (hdr.block_id == (uint64_t) blk_id) {
+			if (found) {
+				logv("Table 0x%02x is split in multiple blocks",
+				     blk_id);
+				return -EINVAL;
+			}
+			loc->block_id = blk_id;
+			loc->data = (int) (p - (char*) buf);
+			loc->len = hdr.len * 4;
+			found = 1;
+		}
+		p += hdr.len * 4 + 4;
+	}
+	if (!found) {
+		return -ENOENT;
+	}
+	loc->entry_size = sja1105_static_config_entry_size(device_id, blk_id);
+	if (loc->entry_size <= 0 || loc->len % loc->entry_size) {
+		return -EINVAL;
+	}
+	loc->entry_count = loc->len / loc->entry_size;
+	return 0;
+}
+
+/* Walks the table headers of a packed static config of @buf_len bytes
+ * and records where each table block is, without reading any table data.
+ * Header CRCs are checked here; data CRCs only when a table gets
+ * decoded by sja1105_static_config_unpack_table.
+ */
+int sja1105_static_config_index(void *buf, unsigned int buf_len,
+                                struct sja1105_static_config_index *index)
+{
+	struct sja1105_table_location *blocks;
+	struct sja1105_table_location *block;
+	struct sja1105_table_header hdr;
+	uint64_t computed_crc;
+	char *p = buf;
+	char *end = p + buf_len;
+	int capacity = 0;
+
+	memset(index, 0, sizeof(*index));
+	if (buf_len < SIZE_SJA1105_DEVICE_ID) {
+		loge("Staging area is too short");
+		return -EINVAL;
+	}
+	gtable_unpack(p, &index->device_id, 31, 0, 4);
+	logv("Device ID is 0x%08" PRIx64 " (%s)",
+	     index->device_id, sja1105_device_id_string_get(
+	     index->device_id, SJA1105_PART_NR_DONT_CARE));
+	if (DEVICE_ID_VALID(index->device_id) == 0) {
+		loge("Invalid device id in staging area: 0x%08" PRIx64,
+		     index->device_id);
+		return -EINVAL;
+	}
+	p += SIZE_SJA1105_DEVICE_ID;
+
+	while (1) {
+		if (end - p < SIZE_TABLE_HEADER) {
+			loge("Staging area ends before its last table header");
+			goto error;
+		}
+		sja1105_table_header_unpack(p, &hdr);
+		/* This should match on last table header */
+		if (hdr.len == 0) {
+			break;
+		}
+		computed_crc = ether_crc32_le(p, SIZE_TABLE_HEADER - 4);
+		if ((hdr.crc & 0xFFFFFFFF) != computed_crc) {
+			loge("Table header CRC is invalid");
+			goto error;
+		}
+		p += SIZE_TABLE_HEADER;
+		if ((end - p) / 4 < (ptrdiff_t) hdr.len + 1) {
+			loge("Table 0x%02" PRIx64 " runs past the end of the "
+			     "staging area", hdr.block_id);
+			goto error;
+		}
+		if (index->block_count == capacity) {
+			capacity = max(2 * capacity, 8);
+			blocks = realloc(index->blocks,
+			                 capacity * sizeof(*blocks));
+			if (blocks == NULL) {
+				loge("realloc failed");
+				goto error;
+			}
+			index->blocks = blocks;
+		}
+		block = &index->blocks[index->block_count++];
+		block->block_id = hdr.block_id;
+		block->data = (int) (p - (char*) buf);
+		block->len = hdr.len * 4;
+		block->entry_size = sja1105_static_config_entry_size(
+		                    index->device_id, hdr.block_id);
+		block->entry_count = (block->entry_size > 0) ?
+		                     block->len / block->entry_size : 0;
+		p += hdr.len * 4 + 4;
+	}
+	return 0;
+error:
+	sja1105_static_config_index_free(index);
+	return -EINVAL;
+}
+
+void sja1105_static_config_index_free(struct sja1105_static_config_index *index)
+{
+	free(index->blocks);
+	index->blocks = NULL;
+	index->block_count = 0;
+}
+
+/* Decodes table @blk_id of the indexed @buf into @config, unless that
+ * was already done. @config must have been freed or initialized when
+ * the index was built, and only filled in by this function since.
+ * Decoding the VL Lookup Table also decodes the General Parameters
+ * Table, whose vllupformat gives the entry layout.
+ */
+int sja1105_static_config_unpack_table(void *buf,
+                                       struct sja1105_static_config_index *index,
+                                       int blk_id,
+                                       struct sja1105_static_config *config)
+{
+	uint32_t mask = 1u << (blk_id % 32);
+	char *hdr_ptr;
+	int rc;
+	int i;
+
+	if (blk_id < 0 || blk_id >= 256) {
+		return -EINVAL;
+	}
+	if (index->unpacked[blk_id / 32] & mask) {
+		return 0;
+	}
+	if (blk_id == BLKID_VL_LOOKUP_TABLE) {
+		rc = sja1105_static_config_unpack_table(buf, index,
+		                                        BLKID_GENERAL_PARAMS_TABLE,
+		                                        config);
+		if (rc < 0) {
+			return rc;
+		}
+	}
+	config->device_id = index->device_id;
+	for (i = 0; i < index->block_count; i++) {
+		if (index->blocks[i].block_id != blk_id) {
+			continue;
+		}
+		hdr_ptr = (char*) buf + index->blocks[i].data - SIZE_TABLE_HEADER;
+		if (sja1105_static_config_unpack_block(hdr_ptr, config) < 0) {
+			return -EINVAL;
+		}
+	}
+	index->unpacked[blk_id / 32] |= mask;
+	if (blk_id == BLKID_VL_LOOKUP_TABLE ||
+	    blk_id == BLKID_GENERAL_PARAMS_TABLE) {
+		sja1105_static_config_patch_vllupformat(config);
+	}
+	return 0;
+}
+
+/* Decodes all tables of the indexed @buf that are not decoded yet */
+int sja1105_static_config_unpack_tables(void *buf,
+                                        struct sja1105_static_config_index *index,
+                                        struct sja1105_static_config *config)
+{
+	int rc;
+	int i;
+
+	for (i = 0; i < index->block_count; i++) {
+		rc = sja1105_static_config_unpack_table(buf, index,
+		                                        index->blocks[i].block_id,
+		                                        config);
+		if (rc < 0) {
+			return rc;
+		}
+	}
+	return 0;
+}
+
+#define ACCESS_CONFIG_ENTRY(device, table)                                    \
+{                                                                             \
+	if (write) {                                                          \
+		sja1105##device##_##table##_entry_pack(buf,                   \
+		                                       &config->table[index]);\
+	} else {                                                              \
+		if (sja1105_static_config_resize(config, blk_id, count) < 0) {\
+			return -ENOMEM;                                       \
+		}                                                             \
+		sja1105##device##_##table##_entry_unpack(buf,                 \
+		                                       &config->table[index]);\
+	}                                                                     \
+}
+
+static int
+sja1105_static_config_entry_access(void *buf, int blk_id, int index, int count,
+                                   struct sja1105_static_config *config,
+                                   int write)
+{
+	switch (blk_id) {
+	case BLKID_SCHEDULE_TABLE:
+		ACCESS_CONFIG_ENTRY(, schedule);
+		break;
+	case BLKID_SCHEDULE_ENTRY_POINTS_TABLE:
+		ACCESS_CONFIG_ENTRY(, schedule_entry_points);
+		break;
+	case BLKID_VL_POLICING_TABLE:
+		ACCESS_CONFIG_ENTRY(, vl_policing);
+		break;
+	case BLKID_VL_FORWARDING_TABLE:
+		ACCESS_CONFIG_ENTRY(, vl_forwarding);
+		break;
+	case BLKID_L2_LOOKUP_TABLE:
+		if (IS_ET(config->device_id)) {
+			ACCESS_CONFIG_ENTRY(et, l2_lookup);
+		} else {
+			ACCESS_CONFIG_ENTRY(pqrs, l2_lookup);
+		}
+		break;
+	case BLKID_L2_POLICING_TABLE:
+		ACCESS_CONFIG_ENTRY(, l2_policing);
+		break;
+	case BLKID_VLAN_LOOKUP_TABLE:
+		ACCESS_CONFIG_ENTRY(, vlan_lookup);
+		break;
+	case BLKID_L2_FORWARDING_TABLE:
+		ACCESS_CONFIG_ENTRY(, l2_forwarding);
+		break;
+	case BLKID_MAC_CONFIG_TABLE:
+		if (IS_ET(config->device_id)) {
+			ACCESS_CONFIG_ENTRY(et, mac_config);
+		} else {
+			ACCESS_CONFIG_ENTRY(pqrs, mac_config);
+		}
+		break;
+	case BLKID_SCHEDULE_PARAMS_TABLE:
+		ACCESS_CONFIG_ENTRY(, schedule_params);
+		break;
+	case BLKID_SCHEDULE_ENTRY_POINTS_PARAMS_TABLE:
+		ACCESS_CONFIG_ENTRY(, schedule_entry_points_params);
+		break;
+	case BLKID_VL_FORWARDING_PARAMS_TABLE:
+		ACCESS_CONFIG_ENTRY(, vl_forwarding_params);
+		break;
+	case BLKID_L2_LOOKUP_PARAMS_TABLE:
+		if (IS_ET(config->device_id)) {
+			ACCESS_CONFIG_ENTRY(et, l2_lookup_params);
+		} else {
+			ACCESS_CONFIG_ENTRY(pqrs, l2_lookup_params);
+		}
+		break;
+	case BLKID_L2_FORWARDING_PARAMS_TABLE:
+		ACCESS_CONFIG_ENTRY(, l2_forwarding_params);
+		break;
+	case BLKID_AVB_PARAMS_TABLE:
+		if (IS_ET(config->device_id)) {
+			ACCESS_CONFIG_ENTRY(et, avb_params);
+		} else {
+			ACCESS_CONFIG_ENTRY(pqrs, avb_params);
+		}
+		break;
+	case BLKID_GENERAL_PARAMS_TABLE:
+		if (IS_ET(config->device_id)) {
+			ACCESS_CONFIG_ENTRY(et, general_params);
+		} else {
+			ACCESS_CONFIG_ENTRY(pqrs, general_params);
+		}
+		break;
+	case BLKID_XMII_MODE_PARAMS_TABLE:
+		ACCESS_CONFIG_ENTRY(, xmii_params);
+		break;
+	case BLKID_SGMII_TABLE:
+		ACCESS_CONFIG_ENTRY(, sgmii);
+		break;
+	default:
+		/* The VL Lookup entry layout depends on
+		 * general-parameters-table.vllupformat, and the
+		 * clock sync and retagging tables are not implemented.
+		 */
+		return -EINVAL;
+	}
+	return 0;
+}
+
+/* Unpacks only entry @index of the table at @loc into @config,
+ * and sets its entry count as found in @buf. The other entries of
+ * the table read as zeroes. Nothing else in @config is touched apart
+ * from the device id.
+ */
+int sja1105_static_config_entry_unpack(void *buf,
+                                       struct sja1105_table_location *loc,
+                                       int index,
+                                       struct sja1105_static_config *config)
+{
+	char *p = (char*) buf + loc->data + index * loc->entry_size;
+
+	if (index < 0 || index >= loc->entry_count) {
+		return -ERANGE;
+	}
+	gtable_unpack(buf, &config->device_id, 31, 0, 4);
+	return sja1105_static_config_entry_access(p, loc->block_id, index,
+	                                          loc->entry_count, config, 0);
+}
+
+/* Packs entry @index of the table at @loc back into @buf and fixes
+ * up the data CRC of that table. The CRC is updated from the old and
+ * new entry bytes alone, so the cost does not depend on table size.
+ */
+int sja1105_static_config_entry_pack(void *buf,
+                                     struct sja1105_table_location *loc,
+                                     int index,
+                                     struct sja1105_static_config *config)
+{
+	char *p = (char*) buf + loc->data + index * loc->entry_size;
+	char *crc_ptr = (char*) buf + loc->data + loc->len;
+	uint64_t data_crc = 0;
+	uint32_t diff_crc;
+	int rc;
+
+	if (index < 0 || index >= loc->entry_count) {
+		return -ERANGE;
+	}
+	diff_crc = ether_crc32_le(p, loc->entry_size);
+	rc = sja1105_static_config_entry_access(p, loc->block_id, index,
+	                                        loc->entry_count, config, 1);
+	if (rc < 0) {
+		return rc;
+	}
+	/* For two messages of equal length, the XOR of their CRCs
+	 * is the CRC of their bitwise difference without the init and
+	 * final XOR. Append the zeroes of the entries that follow to it,
+	 * and it becomes the change in CRC of the whole table.
+	 */
+	diff_crc ^= ether_crc32_le(p, loc->entry_size);
+	diff_crc = ether_crc32_combine(diff_crc, 0, loc->len -
+	                               (index + 1) * loc->entry_size);
+	gtable_unpack(crc_ptr, &data_crc, 31, 0, 4);
+	data_crc ^= diff_crc;
+	gtable_pack(crc_ptr, &data_crc, 31, 0, 4);
+	return 0;
+}
@@ -39,44 +39,50 @@
 #include <lib/helpers.h>
 #include <common.h>
 
+static const struct gtable_field sja1105et_avb_params_entry_fields[] = {
+	GTABLE_FIELD(struct sja1105_avb_params_entry, destmeta, 95, 48),
+	GTABLE_FIELD(struct sja1105_avb_params_entry, srcmeta,  47,  0),
+};
+
+static struct gtable_plan sja1105et_avb_params_entry_plan =
+	GTABLE_PLAN(sja1105et_avb_params_entry_fields, SIZE_AVB_PARAMS_ENTRY_ET);
+
 static void sja1105et_avb_params_entry_access(
 		void *buf,
 		struct sja1105_avb_params_entry *entry,
 		int write)
 {
-	int  (*pack_or_unpack)(void*, uint64_t*, int, int, int);
-	int    size = SIZE_AVB_PARAMS_ENTRY_ET;
-
 	if (write == 0) {
-		pack_or_unpack = gtable_unpack;
 		memset(entry, 0, sizeof(*entry));
+		gtable_plan_unpack(&sja1105et_avb_params_entry_plan, buf, entry);
 	} else {
-		pack_or_unpack = gtable_pack;
-		memset(buf, 0, size);
+		memset(buf, 0, SIZE_AVB_PARAMS_ENTRY_ET);
+		gtable_plan_pack(&sja1105et_avb_params_entry_plan, buf, entry);
 	}
-	pack_or_unpack(buf, &entry->destmeta, 95, 48, size);
-	pack_or_unpack(buf, &entry->srcmeta,  47,  0, size);
 }
 
+static const struct gtable_field sja1105pqrs_avb_params_entry_fields[] = {
+	GTABLE_FIELD(struct sja1105_avb_params_entry, l2cbs,      127, 127),
+	GTABLE_FIELD(struct sja1105_avb_params_entry, cas_master, 126, 126),
+	GTABLE_FIELD(struct sja1105_avb_params_entry, destmeta,   125,  78),
+	GTABLE_FIELD(struct sja1105_avb_params_entry, srcmeta,     77,  33),
+};
+
+static struct gtable_plan sja1105pqrs_avb_params_entry_plan =
+	GTABLE_PLAN(sja1105pqrs_avb_params_entry_fields, SIZE_AVB_PARAMS_ENTRY_PQRS);
+
 static void sja1105pqrs_avb_params_entry_access(
 		void *buf,
 		struct sja1105_avb_params_entry *entry,
 		int write)
 {
-	int  (*pack_or_unpack)(void*, uint64_t*, int, int, int);
-	int    size = SIZE_AVB_PARAMS_ENTRY_PQRS;
-
 	if (write == 0) {
-		pack_or_unpack = gtable_unpack;
 		memset(entry, 0, sizeof(*entry));
+		gtable_plan_unpack(&sja1105pqrs_avb_params_entry_plan, buf, entry);
 	} else {
-		pack_or_unpack = gtable_pack;
-		memset(buf, 0, size);
+		memset(buf, 0, SIZE_AVB_PARAMS_ENTRY_PQRS);
+		gtable_plan_pack(&sja1105pqrs_avb_params_entry_plan, buf, entry);
 	}
-	pack_or_unpack(buf, &entry->l2cbs,      127, 127, size);
-	pack_or_unpack(buf, &entry->cas_master, 126, 126, size);
-	pack_or_unpack(buf, &entry->destmeta,   125,  78, size);
-	pack_or_unpack(buf, &entry->srcmeta,     77,  33, size);
 }
 /*
  * sja1105et_avb_params_entry_pack
@@ -39,83 +39,89 @@
 #include <lib/helpers.h>
 #include <common.h>
 
+static const struct gtable_field sja1105et_general_params_entry_fields[] = {
+	GTABLE_FIELD(struct sja1105_general_params_entry, vllupformat, 319, 319),
+	GTABLE_FIELD(struct sja1105_general_params_entry, mirr_ptacu,  318, 318),
+	GTABLE_FIELD(struct sja1105_general_params_entry, switchid,    317, 315),
+	GTABLE_FIELD(struct sja1105_general_params_entry, hostprio,    314, 312),
+	GTABLE_FIELD(struct sja1105_general_params_entry, mac_fltres1, 311, 264),
+	GTABLE_FIELD(struct sja1105_general_params_entry, mac_fltres0, 263, 216),
+	GTABLE_FIELD(struct sja1105_general_params_entry, mac_flt1,    215, 168),
+	GTABLE_FIELD(struct sja1105_general_params_entry, mac_flt0,    167, 120),
+	GTABLE_FIELD(struct sja1105_general_params_entry, incl_srcpt1, 119, 119),
+	GTABLE_FIELD(struct sja1105_general_params_entry, incl_srcpt0, 118, 118),
+	GTABLE_FIELD(struct sja1105_general_params_entry, send_meta1,  117, 117),
+	GTABLE_FIELD(struct sja1105_general_params_entry, send_meta0,  116, 116),
+	GTABLE_FIELD(struct sja1105_general_params_entry, casc_port,   115, 113),
+	GTABLE_FIELD(struct sja1105_general_params_entry, host_port,   112, 110),
+	GTABLE_FIELD(struct sja1105_general_params_entry, mirr_port,   109, 107),
+	GTABLE_FIELD(struct sja1105_general_params_entry, vlmarker,    106,  75),
+	GTABLE_FIELD(struct sja1105_general_params_entry, vlmask,       74,  43),
+	GTABLE_FIELD(struct sja1105_general_params_entry, tpid,         42,  27),
+	GTABLE_FIELD(struct sja1105_general_params_entry, ignore2stf,   26,  26),
+	GTABLE_FIELD(struct sja1105_general_params_entry, tpid2,        25,  10),
+};
+
+static struct gtable_plan sja1105et_general_params_entry_plan =
+	GTABLE_PLAN(sja1105et_general_params_entry_fields, SIZE_GENERAL_PARAMS_ENTRY_ET);
+
 static void sja1105et_general_params_entry_access(
 		void *buf,
 		struct sja1105_general_params_entry *entry,
 		int write)
 {
-	int  (*pack_or_unpack)(void*, uint64_t*, int, int, int);
-	int    size = SIZE_GENERAL_PARAMS_ENTRY_ET;
-
 	if (write == 0) {
-		pack_or_unpack = gtable_unpack;
 		memset(entry, 0, sizeof(*entry));
+		gtable_plan_unpack(&sja1105et_general_params_entry_plan, buf, entry);
 	} else {
-		pack_or_unpack = gtable_pack;
-		memset(buf, 0, size);
+		memset(buf, 0, SIZE_GENERAL_PARAMS_ENTRY_ET);
+		gtable_plan_pack(&sja1105et_general_params_entry_plan, buf, entry);
 	}
-	pack_or_unpack(buf, &entry->vllupformat, 319, 319, size);
-	pack_or_unpack(buf, &entry->mirr_ptacu,  318, 318, size);
-	pack_or_unpack(buf, &entry->switchid,    317, 315, size);
-	pack_or_unpack(buf, &entry->hostprio,    314, 312, size);
-	pack_or_unpack(buf, &entry->mac_fltres1, 311, 264, size);
-	pack_or_unpack(buf, &entry->mac_fltres0, 263, 216, size);
-	pack_or_unpack(buf, &entry->mac_flt1,    215, 168, size);
-	pack_or_unpack(buf, &entry->mac_flt0,    167, 120, size);
-	pack_or_unpack(buf, &entry->incl_srcpt1, 119, 119, size);
-	pack_or_unpack(buf, &entry->incl_srcpt0, 118, 118, size);
-	pack_or_unpack(buf, &entry->send_meta1,  117, 117, size);
-	pack_or_unpack(buf, &entry->send_meta0,  116, 116, size);
-	pack_or_unpack(buf, &entry->casc_port,   115, 113, size);
-	pack_or_unpack(buf, &entry->host_port,   112, 110, size);
-	pack_or_unpack(buf, &entry->mirr_port,   109, 107, size);
-	pack_or_unpack(buf, &entry->vlmarker,    106,  75, size);
-	pack_or_unpack(buf, &entry->vlmask,       74,  43, size);
-	pack_or_unpack(buf, &entry->tpid,         42,  27, size);
-	pack_or_unpack(buf, &entry->ignore2stf,   26,  26, size);
-	pack_or_unpack(buf, &entry->tpid2,        25,  10, size);
 }
 
+static const struct gtable_field sja1105pqrs_general_params_entry_fields[] = {
+	GTABLE_FIELD(struct sja1105_general_params_entry, vllupformat, 351, 351),
+	GTABLE_FIELD(struct sja1105_general_params_entry, mirr_ptacu,  350, 350),
+	GTABLE_FIELD(struct sja1105_general_params_entry, switchid,    349, 347),
+	GTABLE_FIELD(struct sja1105_general_params_entry, hostprio,    346, 344),
+	GTABLE_FIELD(struct sja1105_general_params_entry, mac_fltres1, 343, 296),
+	GTABLE_FIELD(struct sja1105_general_params_entry, mac_fltres0, 295, 248),
+	GTABLE_FIELD(struct sja1105_general_params_entry, mac_flt1,    247, 200),
+	GTABLE_FIELD(struct sja1105_general_params_entry, mac_flt0,    199, 152),
+	GTABLE_FIELD(struct sja1105_general_params_entry, incl_srcpt1, 151, 151),
+	GTABLE_FIELD(struct sja1105_general_params_entry, incl_srcpt0, 150, 150),
+	GTABLE_FIELD(struct sja1105_general_params_entry, send_meta1,  149, 149),
+	GTABLE_FIELD(struct sja1105_general_params_entry, send_meta0,  148, 148),
+	GTABLE_FIELD(struct sja1105_general_params_entry, casc_port,   147, 145),
+	GTABLE_FIELD(struct sja1105_general_params_entry, host_port,   144, 142),
+	GTABLE_FIELD(struct sja1105_general_params_entry, mirr_port,   141, 139),
+	GTABLE_FIELD(struct sja1105_general_params_entry, vlmarker,    138, 107),
+	GTABLE_FIELD(struct sja1105_general_params_entry, vlmask,      106,  75),
+	GTABLE_FIELD(struct sja1105_general_params_entry, tpid,         74,  59),
+	GTABLE_FIELD(struct sja1105_general_params_entry, ignore2stf,   58,  58),
+	GTABLE_FIELD(struct sja1105_general_params_entry, tpid2,        57,  42),
+	GTABLE_FIELD(struct sja1105_general_params_entry, queue_ts,     41,  41),
+	GTABLE_FIELD(struct sja1105_general_params_entry, egrmirrvid,   40,  29),
+	GTABLE_FIELD(struct sja1105_general_params_entry, egrmirrpcp,   28,  26),
+	GTABLE_FIELD(struct sja1105_general_params_entry, egrmirrdei,   25,  25),
+	GTABLE_FIELD(struct sja1105_general_params_entry, replay_port,  24,  22),
+};
+
+static struct gtable_plan sja1105pqrs_general_params_entry_plan =
+	GTABLE_PLAN(sja1105pqrs_general_params_entry_fields, SIZE_GENERAL_PARAMS_ENTRY_PQRS);
+
 static void sja1105pqrs_general_params_entry_access(
 		void *buf,
 		struct sja1105_general_params_entry *entry,
 		int write)
 {
-	int  (*pack_or_unpack)(void*, uint64_t*, int, int, int);
-	int    size = SIZE_GENERAL_PARAMS_ENTRY_PQRS;
-
 	if (write == 0) {
-		pack_or_unpack = gtable_unpack;
 		memset(entry, 0, sizeof(*entry));
+		gtable_plan_unpack(&sja1105pqrs_general_params_entry_plan, buf, entry);
 	} else {
-		pack_or_unpack = gtable_pack;
-		memset(buf, 0, size);
+		memset(buf, 0, SIZE_GENERAL_PARAMS_ENTRY_PQRS);
+		gtable_plan_pack(&sja1105pqrs_general_params_entry_plan, buf, entry);
 	}
-	pack_or_unpack(buf, &entry->vllupformat, 351, 351, size);
-	pack_or_unpack(buf, &entry->mirr_ptacu,  350, 350, size);
-	pack_or_unpack(buf, &entry->switchid,    349, 347, size);
-	pack_or_unpack(buf, &entry->hostprio,    346, 344, size);
-	pack_or_unpack(buf, &entry->mac_fltres1, 343, 296, size);
-	pack_or_unpack(buf, &entry->mac_fltres0, 295, 248, size);
-	pack_or_unpack(buf, &entry->mac_flt1,    247, 200, size);
-	pack_or_unpack(buf, &entry->mac_flt0,    199, 152, size);
-	pack_or_unpack(buf, &entry->incl_srcpt1, 151, 151, size);
-	pack_or_unpack(buf, &entry->incl_srcpt0, 150, 150, size);
-	pack_or_unpack(buf, &entry->send_meta1,  149, 149, size);
-	pack_or_unpack(buf, &entry->send_meta0,  148, 148, size);
-	pack_or_unpack(buf, &entry->casc_port,   147, 145, size);
-	pack_or_unpack(buf, &entry->host_port,   144, 142, size);
-	pack_or_unpack(buf, &entry->mirr_port,   141, 139, size);
-	pack_or_unpack(buf, &entry->vlmarker,    138, 107, size);
-	pack_or_unpack(buf, &entry->vlmask,      106,  75, size);
-	pack_or_unpack(buf, &entry->tpid,         74,  59, size);
-	pack_or_unpack(buf, &entry->ignore2stf,   58,  58, size);
-	pack_or_unpack(buf, &entry->tpid2,        57,  42, size);
-	pack_or_unpack(buf, &entry->queue_ts,     41,  41, size);
-	pack_or_unpack(buf, &entry->egrmirrvid,   40,  29, size);
-	pack_or_unpack(buf, &entry->egrmirrpcp,   28,  26, size);
-	pack_or_unpack(buf, &entry->egrmirrdei,   25,  25, size);
-	pack_or_unpack(buf, &entry->replay_port,  24,  22, size);
 }
 /* Device-specific pack/unpack accessors
  * sja1105et_general_params_entry_pack
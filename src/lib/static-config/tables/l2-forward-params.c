@@ -38,28 +38,25 @@
 #include <lib/include/gtable.h>
 #include <common.h>
 
+static const struct gtable_field sja1105_l2_forwarding_params_entry_fields[] = {
+	GTABLE_FIELD(struct sja1105_l2_forwarding_params_entry, max_dynp, 95, 93),
+	GTABLE_ARRAY_FIELD(struct sja1105_l2_forwarding_params_entry, part_spc, 22, 13, 8, 10),
+};
+
+static struct gtable_plan sja1105_l2_forwarding_params_entry_plan =
+	GTABLE_PLAN(sja1105_l2_forwarding_params_entry_fields, SIZE_L2_FORWARDING_PARAMS_ENTRY);
+
 static void sja1105_l2_forwarding_params_entry_access(
 		void *buf,
 		struct sja1105_l2_forwarding_params_entry *entry,
 		int write)
 {
-	int  (*pack_or_unpack)(void*, uint64_t*, int, int, int);
-	int    size = SIZE_L2_FORWARDING_PARAMS_ENTRY;
-	int    offset;
-	int    i;
-
 	if (write == 0) {
-		pack_or_unpack = gtable_unpack;
 		memset(entry, 0, sizeof(*entry));
+		gtable_plan_unpack(&sja1105_l2_forwarding_params_entry_plan, buf, entry);
 	} else {
-		pack_or_unpack = gtable_pack;
-		memset(buf, 0, size);
-	}
-	pack_or_unpack(buf, &entry->max_dynp, 95, 93, size);
-	offset = 13;
-	for (i = 0; i < 8; i++) {
-		pack_or_unpack(buf, &entry->part_spc[i], offset + 9, offset + 0, size);
-		offset += 10;
+		memset(buf, 0, SIZE_L2_FORWARDING_PARAMS_ENTRY);
+		gtable_plan_pack(&sja1105_l2_forwarding_params_entry_plan, buf, entry);
 	}
 }
 /*
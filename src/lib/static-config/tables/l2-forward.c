@@ -38,30 +38,27 @@
 #include <lib/include/gtable.h>
 #include <common.h>
 
+static const struct gtable_field sja1105_l2_forwarding_entry_fields[] = {
+	GTABLE_FIELD(struct sja1105_l2_forwarding_entry, bc_domain,  63, 59),
+	GTABLE_FIELD(struct sja1105_l2_forwarding_entry, reach_port, 58, 54),
+	GTABLE_FIELD(struct sja1105_l2_forwarding_entry, fl_domain,  53, 49),
+	GTABLE_ARRAY_FIELD(struct sja1105_l2_forwarding_entry, vlan_pmap, 27, 25, 8, 3),
+};
+
+static struct gtable_plan sja1105_l2_forwarding_entry_plan =
+	GTABLE_PLAN(sja1105_l2_forwarding_entry_fields, SIZE_L2_FORWARDING_ENTRY);
+
 static void sja1105_l2_forwarding_entry_access(
 		void *buf,
 		struct sja1105_l2_forwarding_entry *entry,
 		int write)
 {
-	int  (*pack_or_unpack)(void*, uint64_t*, int, int, int);
-	int    size = SIZE_L2_FORWARDING_ENTRY;
-	int    offset;
-	int    i;
-
 	if (write == 0) {
-		pack_or_unpack = gtable_unpack;
 		memset(entry, 0, sizeof(*entry));
+		gtable_plan_unpack(&sja1105_l2_forwarding_entry_plan, buf, entry);
 	} else {
-		pack_or_unpack = gtable_pack;
-		memset(buf, 0, size);
-	}
-	pack_or_unpack(buf, &entry->bc_domain,  63, 59, size);
-	pack_or_unpack(buf, &entry->reach_port, 58, 54, size);
-	pack_or_unpack(buf, &entry->fl_domain,  53, 49, size);
-	offset = 25;
-	for (i = 0; i < 8; i++) {
-		pack_or_unpack(buf, &entry->vlan_pmap[i], offset + 2, offset + 0, size);
-		offset += 3;
+		memset(buf, 0, SIZE_L2_FORWARDING_ENTRY);
+		gtable_plan_pack(&sja1105_l2_forwarding_entry_plan, buf, entry);
 	}
 }
 /*
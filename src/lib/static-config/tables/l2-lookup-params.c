@@ -38,63 +38,63 @@
 #include <lib/include/gtable.h>
 #include <common.h>
 
+static const struct gtable_field sja1105et_l2_lookup_params_entry_fields[] = {
+	GTABLE_FIELD(struct sja1105_l2_lookup_params_entry, maxage,         31, 17),
+	GTABLE_FIELD(struct sja1105_l2_lookup_params_entry, dyn_tbsz,       16, 14),
+	GTABLE_FIELD(struct sja1105_l2_lookup_params_entry, poly,           13,  6),
+	GTABLE_FIELD(struct sja1105_l2_lookup_params_entry, shared_learn,    5,  5),
+	GTABLE_FIELD(struct sja1105_l2_lookup_params_entry, no_enf_hostprt,  4,  4),
+	GTABLE_FIELD(struct sja1105_l2_lookup_params_entry, no_mgmt_learn,   3,  3),
+};
+
+static struct gtable_plan sja1105et_l2_lookup_params_entry_plan =
+	GTABLE_PLAN(sja1105et_l2_lookup_params_entry_fields, SIZE_L2_LOOKUP_PARAMS_ENTRY_ET);
+
 static void sja1105et_l2_lookup_params_entry_access(
 		void *buf,
 		struct sja1105_l2_lookup_params_entry *entry,
 		int write)
 {
-	int  (*pack_or_unpack)(void*, uint64_t*, int, int, int);
-	int    size = SIZE_L2_LOOKUP_PARAMS_ENTRY_ET;
-
 	if (write == 0) {
-		pack_or_unpack = gtable_unpack;
 		memset(entry, 0, sizeof(*entry));
+		gtable_plan_unpack(&sja1105et_l2_lookup_params_entry_plan, buf, entry);
 	} else {
-		pack_or_unpack = gtable_pack;
-		memset(buf, 0, size);
+		memset(buf, 0, SIZE_L2_LOOKUP_PARAMS_ENTRY_ET);
+		gtable_plan_pack(&sja1105et_l2_lookup_params_entry_plan, buf, entry);
 	}
-	pack_or_unpack(buf, &entry->maxage,         31, 17, size);
-	pack_or_unpack(buf, &entry->dyn_tbsz,       16, 14, size);
-	pack_or_unpack(buf, &entry->poly,           13,  6, size);
-	pack_or_unpack(buf, &entry->shared_learn,    5,  5, size);
-	pack_or_unpack(buf, &entry->no_enf_hostprt,  4,  4, size);
-	pack_or_unpack(buf, &entry->no_mgmt_learn,   3,  3, size);
 }
 
+static const struct gtable_field sja1105pqrs_l2_lookup_params_entry_fields[] = {
+	GTABLE_FIELD(struct sja1105_l2_lookup_params_entry, drpbc,          127, 123),
+	GTABLE_FIELD(struct sja1105_l2_lookup_params_entry, drpmc,          122, 118),
+	GTABLE_FIELD(struct sja1105_l2_lookup_params_entry, drpuni,         117, 113),
+	GTABLE_ARRAY_FIELD(struct sja1105_l2_lookup_params_entry, maxaddrp,  68,  58, 5, 11),
+	GTABLE_FIELD(struct sja1105_l2_lookup_params_entry, maxage,          57,  43),
+	GTABLE_FIELD(struct sja1105_l2_lookup_params_entry, start_dynspc,    42,  33),
+	GTABLE_FIELD(struct sja1105_l2_lookup_params_entry, drpnolearn,      32,  28),
+	GTABLE_FIELD(struct sja1105_l2_lookup_params_entry, shared_learn,    27,  27),
+	GTABLE_FIELD(struct sja1105_l2_lookup_params_entry, no_enf_hostprt,  26,  26),
+	GTABLE_FIELD(struct sja1105_l2_lookup_params_entry, no_mgmt_learn,   25,  25),
+	GTABLE_FIELD(struct sja1105_l2_lookup_params_entry, use_static,      24,  24),
+	GTABLE_FIELD(struct sja1105_l2_lookup_params_entry, owr_dyn,         23,  23),
+	GTABLE_FIELD(struct sja1105_l2_lookup_params_entry, learn_once,      22,  22),
+};
+
+static struct gtable_plan sja1105pqrs_l2_lookup_params_entry_plan =
+	GTABLE_PLAN(sja1105pqrs_l2_lookup_params_entry_fields, SIZE_L2_LOOKUP_PARAMS_ENTRY_PQRS);
+
 static void sja1105pqrs_l2_lookup_params_entry_access(
 		void *buf,
 		struct sja1105_l2_lookup_params_entry *entry,
 		int write)
 {
-	int  (*pack_or_unpack)(void*, uint64_t*, int, int, int);
-	int    size = SIZE_L2_LOOKUP_PARAMS_ENTRY_PQRS;
-	int    offset;
-	int    i;
-
 	if (write == 0) {
-		pack_or_unpack = gtable_unpack;
 		memset(entry, 0, sizeof(*entry));
+		gtable_plan_unpack(&sja1105pqrs_l2_lookup_params_entry_plan, buf, entry);
 	} else {
-		pack_or_unpack = gtable_pack;
-		memset(buf, 0, size);
-	}
-	pack_or_unpack(buf, &entry->drpbc,          127, 123, size);
-	pack_or_unpack(buf, &entry->drpmc,          122, 118, size);
-	pack_or_unpack(buf, &entry->drpuni,         117, 113, size);
-	offset = 58;
-	for (i = 0; i < 5; i++) {
-		pack_or_unpack(buf, &entry->maxaddrp[i], offset + 10, offset + 0, size);
-		offset += 11;
+		memset(buf, 0, SIZE_L2_LOOKUP_PARAMS_ENTRY_PQRS);
+		gtable_plan_pack(&sja1105pqrs_l2_lookup_params_entry_plan, buf, entry);
 	}
-	pack_or_unpack(buf, &entry->maxage,          57,  43, size);
-	pack_or_unpack(buf, &entry->start_dynspc,    42,  33, size);
-	pack_or_unpack(buf, &entry->drpnolearn,      32,  28, size);
-	pack_or_unpack(buf, &entry->shared_learn,    27,  27, size);
-	pack_or_unpack(buf, &entry->no_enf_hostprt,  26,  26, size);
-	pack_or_unpack(buf, &entry->no_mgmt_learn,   25,  25, size);
-	pack_or_unpack(buf, &entry->use_static,      24,  24, size);
-	pack_or_unpack(buf, &entry->owr_dyn,         23,  23, size);
-	pack_or_unpack(buf, &entry->learn_once,      22,  22, size);
 }
 
 /*
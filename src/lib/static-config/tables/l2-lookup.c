@@ -39,59 +39,65 @@
 #include <lib/helpers.h>
 #include <common.h>
 
+static const struct gtable_field sja1105et_l2_lookup_entry_fields[] = {
+	GTABLE_FIELD(struct sja1105_l2_lookup_entry, vlanid,    95, 84),
+	GTABLE_FIELD(struct sja1105_l2_lookup_entry, macaddr,   83, 36),
+	GTABLE_FIELD(struct sja1105_l2_lookup_entry, destports, 35, 31),
+	GTABLE_FIELD(struct sja1105_l2_lookup_entry, enfport,   30, 30),
+	GTABLE_FIELD(struct sja1105_l2_lookup_entry, index,     29, 20),
+};
+
+static struct gtable_plan sja1105et_l2_lookup_entry_plan =
+	GTABLE_PLAN(sja1105et_l2_lookup_entry_fields, SIZE_L2_LOOKUP_ENTRY_ET);
+
 void sja1105et_l2_lookup_entry_access(void *buf,
                                       struct sja1105_l2_lookup_entry *entry,
                                       int write)
 {
-	int  (*pack_or_unpack)(void*, uint64_t*, int, int, int);
-	int    size = SIZE_L2_LOOKUP_ENTRY_ET;
-
 	if (write == 0) {
-		pack_or_unpack = gtable_unpack;
 		memset(entry, 0, sizeof(*entry));
+		gtable_plan_unpack(&sja1105et_l2_lookup_entry_plan, buf, entry);
 	} else {
-		pack_or_unpack = gtable_pack;
-		memset(buf, 0, size);
+		memset(buf, 0, SIZE_L2_LOOKUP_ENTRY_ET);
+		gtable_plan_pack(&sja1105et_l2_lookup_entry_plan, buf, entry);
 	}
-	pack_or_unpack(buf, &entry->vlanid,    95, 84, size);
-	pack_or_unpack(buf, &entry->macaddr,   83, 36, size);
-	pack_or_unpack(buf, &entry->destports, 35, 31, size);
-	pack_or_unpack(buf, &entry->enfport,   30, 30, size);
-	pack_or_unpack(buf, &entry->index,     29, 20, size);
 }
 
+/* These are static L2 lookup entries, so the structure
+ * should match UM11040 Table 16/17 definitions when
+ * LOCKEDS is 1.
+ */
+static const struct gtable_field sja1105pqrs_l2_lookup_entry_fields[] = {
+	GTABLE_FIELD(struct sja1105_l2_lookup_entry, tsreg,        159, 159),
+	GTABLE_FIELD(struct sja1105_l2_lookup_entry, mirrvlan,     158, 147),
+	GTABLE_FIELD(struct sja1105_l2_lookup_entry, takets,       146, 146),
+	GTABLE_FIELD(struct sja1105_l2_lookup_entry, mirr,         145, 145),
+	GTABLE_FIELD(struct sja1105_l2_lookup_entry, retag,        144, 144),
+	GTABLE_FIELD(struct sja1105_l2_lookup_entry, mask_iotag,   143, 143),
+	GTABLE_FIELD(struct sja1105_l2_lookup_entry, mask_vlanid,  142, 131),
+	GTABLE_FIELD(struct sja1105_l2_lookup_entry, mask_macaddr, 130,  83),
+	GTABLE_FIELD(struct sja1105_l2_lookup_entry, iotag,         82,  82),
+	GTABLE_FIELD(struct sja1105_l2_lookup_entry, vlanid,        81,  70),
+	GTABLE_FIELD(struct sja1105_l2_lookup_entry, macaddr,       69,  22),
+	GTABLE_FIELD(struct sja1105_l2_lookup_entry, destports,     21,  17),
+	GTABLE_FIELD(struct sja1105_l2_lookup_entry, enfport,       16,  16),
+	GTABLE_FIELD(struct sja1105_l2_lookup_entry, index,         15,   6),
+};
+
+static struct gtable_plan sja1105pqrs_l2_lookup_entry_plan =
+	GTABLE_PLAN(sja1105pqrs_l2_lookup_entry_fields, SIZE_L2_LOOKUP_ENTRY_PQRS);
+
 void sja1105pqrs_l2_lookup_entry_access(void *buf,
                                         struct sja1105_l2_lookup_entry *entry,
                                         int write)
 {
-	int  (*pack_or_unpack)(void*, uint64_t*, int, int, int);
-	int    size = SIZE_L2_LOOKUP_ENTRY_PQRS;
-
 	if (write == 0) {
-		pack_or_unpack = gtable_unpack;
 		memset(entry, 0, sizeof(*entry));
+		gtable_plan_unpack(&sja1105pqrs_l2_lookup_entry_plan, buf, entry);
 	} else {
-		pack_or_unpack = gtable_pack;
-		memset(buf, 0, size);
+		memset(buf, 0, SIZE_L2_LOOKUP_ENTRY_PQRS);
+		gtable_plan_pack(&sja1105pqrs_l2_lookup_entry_plan, buf, entry);
 	}
-	/* These are static L2 lookup entries, so the structure
-	 * should match UM11040 Table 16/17 definitions when
-	 * LOCKEDS is 1.
-	 */
-	pack_or_unpack(buf, &entry->tsreg,        159, 159, size);
-	pack_or_unpack(buf, &entry->mirrvlan,     158, 147, size);
-	pack_or_unpack(buf, &entry->takets,       146, 146, size);
-	pack_or_unpack(buf, &entry->mirr,         145, 145, size);
-	pack_or_unpack(buf, &entry->retag,        144, 144, size);
-	pack_or_unpack(buf, &entry->mask_iotag,   143, 143, size);
-	pack_or_unpack(buf, &entry->mask_vlanid,  142, 131, size);
-	pack_or_unpack(buf, &entry->mask_macaddr, 130,  83, size);
-	pack_or_unpack(buf, &entry->iotag,         82,  82, size);
-	pack_or_unpack(buf, &entry->vlanid,        81,  70, size);
-	pack_or_unpack(buf, &entry->macaddr,       69,  22, size);
-	pack_or_unpack(buf, &entry->destports,     21,  17, size);
-	pack_or_unpack(buf, &entry->enfport,       16,  16, size);
-	pack_or_unpack(buf, &entry->index,         15,   6, size);
 }
 
 /*
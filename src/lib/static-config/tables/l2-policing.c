@@ -39,26 +39,29 @@
 #include <lib/helpers.h>
 #include <common.h>
 
+static const struct gtable_field sja1105_l2_policing_entry_fields[] = {
+	GTABLE_FIELD(struct sja1105_l2_policing_entry, sharindx,  63, 58),
+	GTABLE_FIELD(struct sja1105_l2_policing_entry, smax,      57, 42),
+	GTABLE_FIELD(struct sja1105_l2_policing_entry, rate,      41, 26),
+	GTABLE_FIELD(struct sja1105_l2_policing_entry, maxlen,    25, 15),
+	GTABLE_FIELD(struct sja1105_l2_policing_entry, partition, 14, 12),
+};
+
+static struct gtable_plan sja1105_l2_policing_entry_plan =
+	GTABLE_PLAN(sja1105_l2_policing_entry_fields, SIZE_L2_POLICING_ENTRY);
+
 static void sja1105_l2_policing_entry_access(
 		void *buf,
 		struct sja1105_l2_policing_entry *table,
 		int write)
 {
-	int  (*pack_or_unpack)(void*, uint64_t*, int, int, int);
-	int    size = SIZE_L2_POLICING_ENTRY;
-
 	if (write == 0) {
-		pack_or_unpack = gtable_unpack;
 		memset(table, 0, sizeof(*table));
+		gtable_plan_unpack(&sja1105_l2_policing_entry_plan, buf, table);
 	} else {
-		pack_or_unpack = gtable_pack;
-		memset(buf, 0, size);
+		memset(buf, 0, SIZE_L2_POLICING_ENTRY);
+		gtable_plan_pack(&sja1105_l2_policing_entry_plan, buf, table);
 	}
-	pack_or_unpack(buf, &table->sharindx,  63, 58, size);
-	pack_or_unpack(buf, &table->smax,      57, 42, size);
-	pack_or_unpack(buf, &table->rate,      41, 26, size);
-	pack_or_unpack(buf, &table->maxlen,    25, 15, size);
-	pack_or_unpack(buf, &table->partition, 14, 12, size);
 }
 /*
  * sja1105_l2_policing_entry_pack
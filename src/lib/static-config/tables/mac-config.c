@@ -38,95 +38,89 @@
 #include <lib/include/gtable.h>
 #include <common.h>
 
+static const struct gtable_field sja1105et_mac_config_entry_fields[] = {
+	GTABLE_ARRAY_FIELD(struct sja1105_mac_config_entry, enabled, 72, 72, 8, 19),
+	GTABLE_ARRAY_FIELD(struct sja1105_mac_config_entry, base,    81, 73, 8, 19),
+	GTABLE_ARRAY_FIELD(struct sja1105_mac_config_entry, top,     90, 82, 8, 19),
+	GTABLE_FIELD(struct sja1105_mac_config_entry, ifg,         71, 67),
+	GTABLE_FIELD(struct sja1105_mac_config_entry, speed,       66, 65),
+	GTABLE_FIELD(struct sja1105_mac_config_entry, tp_delin,    64, 49),
+	GTABLE_FIELD(struct sja1105_mac_config_entry, tp_delout,   48, 33),
+	GTABLE_FIELD(struct sja1105_mac_config_entry, maxage,      32, 25),
+	GTABLE_FIELD(struct sja1105_mac_config_entry, vlanprio,    24, 22),
+	GTABLE_FIELD(struct sja1105_mac_config_entry, vlanid,      21, 10),
+	GTABLE_FIELD(struct sja1105_mac_config_entry, ing_mirr,     9,  9),
+	GTABLE_FIELD(struct sja1105_mac_config_entry, egr_mirr,     8,  8),
+	GTABLE_FIELD(struct sja1105_mac_config_entry, drpnona664,   7,  7),
+	GTABLE_FIELD(struct sja1105_mac_config_entry, drpdtag,      6,  6),
+	GTABLE_FIELD(struct sja1105_mac_config_entry, drpuntag,     5,  5),
+	GTABLE_FIELD(struct sja1105_mac_config_entry, retag,        4,  4),
+	GTABLE_FIELD(struct sja1105_mac_config_entry, dyn_learn,    3,  3),
+	GTABLE_FIELD(struct sja1105_mac_config_entry, egress,       2,  2),
+	GTABLE_FIELD(struct sja1105_mac_config_entry, ingress,      1,  1),
+};
+
+static struct gtable_plan sja1105et_mac_config_entry_plan =
+	GTABLE_PLAN(sja1105et_mac_config_entry_fields, SIZE_MAC_CONFIG_ENTRY_ET);
+
 static void
 sja1105et_mac_config_entry_access(void *buf,
                                   struct sja1105_mac_config_entry *entry,
                                   int write)
 {
-	int  (*pack_or_unpack)(void*, uint64_t*, int, int, int);
-	int    size = SIZE_MAC_CONFIG_ENTRY_ET;
-	int    offset;
-	int    i;
-
 	if (write == 0) {
-		pack_or_unpack = gtable_unpack;
 		memset(entry, 0, sizeof(*entry));
+		gtable_plan_unpack(&sja1105et_mac_config_entry_plan, buf, entry);
 	} else {
-		pack_or_unpack = gtable_pack;
-		memset(buf, 0, size);
-	}
-	offset = 72;
-	for (i = 0; i < 8; i++) {
-		pack_or_unpack(buf, &entry->enabled[i], offset +  0, offset +  0, size);
-		pack_or_unpack(buf, &entry->base[i],    offset +  9, offset +  1, size);
-		pack_or_unpack(buf, &entry->top[i],     offset + 18, offset + 10, size);
-		offset += 19;
+		memset(buf, 0, SIZE_MAC_CONFIG_ENTRY_ET);
+		gtable_plan_pack(&sja1105et_mac_config_entry_plan, buf, entry);
 	}
-	pack_or_unpack(buf, &entry->ifg,         71, 67, size);
-	pack_or_unpack(buf, &entry->speed,       66, 65, size);
-	pack_or_unpack(buf, &entry->tp_delin,    64, 49, size);
-	pack_or_unpack(buf, &entry->tp_delout,   48, 33, size);
-	pack_or_unpack(buf, &entry->maxage,      32, 25, size);
-	pack_or_unpack(buf, &entry->vlanprio,    24, 22, size);
-	pack_or_unpack(buf, &entry->vlanid,      21, 10, size);
-	pack_or_unpack(buf, &entry->ing_mirr,     9,  9, size);
-	pack_or_unpack(buf, &entry->egr_mirr,     8,  8, size);
-	pack_or_unpack(buf, &entry->drpnona664,   7,  7, size);
-	pack_or_unpack(buf, &entry->drpdtag,      6,  6, size);
-	pack_or_unpack(buf, &entry->drpuntag,     5,  5, size);
-	pack_or_unpack(buf, &entry->retag,        4,  4, size);
-	pack_or_unpack(buf, &entry->dyn_learn,    3,  3, size);
-	pack_or_unpack(buf, &entry->egress,       2,  2, size);
-	pack_or_unpack(buf, &entry->ingress,      1,  1, size);
 }
 
+static const struct gtable_field sja1105pqrs_mac_config_entry_fields[] = {
+	GTABLE_ARRAY_FIELD(struct sja1105_mac_config_entry, enabled, 104, 104, 8, 19),
+	GTABLE_ARRAY_FIELD(struct sja1105_mac_config_entry, base,    113, 105, 8, 19),
+	GTABLE_ARRAY_FIELD(struct sja1105_mac_config_entry, top,     122, 114, 8, 19),
+	GTABLE_FIELD(struct sja1105_mac_config_entry, ifg,        103, 99),
+	GTABLE_FIELD(struct sja1105_mac_config_entry, speed,       98, 97),
+	GTABLE_FIELD(struct sja1105_mac_config_entry, tp_delin,    96, 81),
+	GTABLE_FIELD(struct sja1105_mac_config_entry, tp_delout,   80, 65),
+	GTABLE_FIELD(struct sja1105_mac_config_entry, maxage,      64, 57),
+	GTABLE_FIELD(struct sja1105_mac_config_entry, vlanprio,    56, 54),
+	GTABLE_FIELD(struct sja1105_mac_config_entry, vlanid,      53, 42),
+	GTABLE_FIELD(struct sja1105_mac_config_entry, ing_mirr,    41, 41),
+	GTABLE_FIELD(struct sja1105_mac_config_entry, egr_mirr,    40, 40),
+	GTABLE_FIELD(struct sja1105_mac_config_entry, drpnona664,  39, 39),
+	GTABLE_FIELD(struct sja1105_mac_config_entry, drpdtag,     38, 38),
+	GTABLE_FIELD(struct sja1105_mac_config_entry, drpsotag,    37, 37),
+	GTABLE_FIELD(struct sja1105_mac_config_entry, drpsitag,    36, 36),
+	GTABLE_FIELD(struct sja1105_mac_config_entry, drpuntag,    35, 35),
+	GTABLE_FIELD(struct sja1105_mac_config_entry, retag,       34, 34),
+	GTABLE_FIELD(struct sja1105_mac_config_entry, dyn_learn,   33, 33),
+	GTABLE_FIELD(struct sja1105_mac_config_entry, egress,      32, 32),
+	GTABLE_FIELD(struct sja1105_mac_config_entry, ingress,     31, 31),
+	GTABLE_FIELD(struct sja1105_mac_config_entry, mirrcie,     30, 30),
+	GTABLE_FIELD(struct sja1105_mac_config_entry, mirrcetag,   29, 29),
+	GTABLE_FIELD(struct sja1105_mac_config_entry, ingmirrvid,  28, 17),
+	GTABLE_FIELD(struct sja1105_mac_config_entry, ingmirrpcp,  16, 14),
+	GTABLE_FIELD(struct sja1105_mac_config_entry, ingmirrdei,  13, 13),
+};
+
+static struct gtable_plan sja1105pqrs_mac_config_entry_plan =
+	GTABLE_PLAN(sja1105pqrs_mac_config_entry_fields, SIZE_MAC_CONFIG_ENTRY_PQRS);
+
 static void
 sja1105pqrs_mac_config_entry_access(void *buf,
                                     struct sja1105_mac_config_entry *entry,
                                     int write)
 {
-	int  (*pack_or_unpack)(void*, uint64_t*, int, int, int);
-	int    size = SIZE_MAC_CONFIG_ENTRY_PQRS;
-	int    offset;
-	int    i;
-
 	if (write == 0) {
-		pack_or_unpack = gtable_unpack;
 		memset(entry, 0, sizeof(*entry));
+		gtable_plan_unpack(&sja1105pqrs_mac_config_entry_plan, buf, entry);
 	} else {
-		pack_or_unpack = gtable_pack;
-		memset(buf, 0, size);
-	}
-	offset = 104;
-	for (i = 0; i < 8; i++) {
-		pack_or_unpack(buf, &entry->enabled[i], offset +  0, offset +  0, size);
-		pack_or_unpack(buf, &entry->base[i],    offset +  9, offset +  1, size);
-		pack_or_unpack(buf, &entry->top[i],     offset + 18, offset + 10, size);
-		offset += 19;
+		memset(buf, 0, SIZE_MAC_CONFIG_ENTRY_PQRS);
+		gtable_plan_pack(&sja1105pqrs_mac_config_entry_plan, buf, entry);
 	}
-	pack_or_unpack(buf, &entry->ifg,        103, 99, size);
-	pack_or_unpack(buf, &entry->speed,       98, 97, size);
-	pack_or_unpack(buf, &entry->tp_delin,    96, 81, size);
-	pack_or_unpack(buf, &entry->tp_delout,   80, 65, size);
-	pack_or_unpack(buf, &entry->maxage,      64, 57, size);
-	pack_or_unpack(buf, &entry->vlanprio,    56, 54, size);
-	pack_or_unpack(buf, &entry->vlanid,      53, 42, size);
-	pack_or_unpack(buf, &entry->ing_mirr,    41, 41, size);
-	pack_or_unpack(buf, &entry->egr_mirr,    40, 40, size);
-	pack_or_unpack(buf, &entry->drpnona664,  39, 39, size);
-	pack_or_unpack(buf, &entry->drpdtag,     38, 38, size);
-	pack_or_unpack(buf, &entry->drpsotag,    37, 37, size);
-	pack_or_unpack(buf, &entry->drpsitag,    36, 36, size);
-	pack_or_unpack(buf, &entry->drpuntag,    35, 35, size);
-	pack_or_unpack(buf, &entry->retag,       34, 34, size);
-	pack_or_unpack(buf, &entry->dyn_learn,   33, 33, size);
-	pack_or_unpack(buf, &entry->egress,      32, 32, size);
-	pack_or_unpack(buf, &entry->ingress,     31, 31, size);
-	pack_or_unpack(buf, &entry->mirrcie,     30, 30, size);
-	pack_or_unpack(buf, &entry->mirrcetag,   29, 29, size);
-	pack_or_unpack(buf, &entry->ingmirrvid,  28, 17, size);
-	pack_or_unpack(buf, &entry->ingmirrpcp,  16, 14, size);
-	pack_or_unpack(buf, &entry->ingmirrdei,  13, 13, size);
 }
 /*
  * sja1105et_mac_config_entry_pack
@@ -38,23 +38,26 @@
 #include <lib/include/gtable.h>
 #include <common.h>
 
+static const struct gtable_field sja1105_schedule_entry_points_params_entry_fields[] = {
+	GTABLE_FIELD(struct sja1105_schedule_entry_points_params_entry, clksrc,    31, 30),
+	GTABLE_FIELD(struct sja1105_schedule_entry_points_params_entry, actsubsch, 29, 27),
+};
+
+static struct gtable_plan sja1105_schedule_entry_points_params_entry_plan =
+	GTABLE_PLAN(sja1105_schedule_entry_points_params_entry_fields, SIZE_SCHEDULE_ENTRY_POINTS_PARAMS_ENTRY);
+
 static void sja1105_schedule_entry_points_params_entry_access(
 		void *buf,
 		struct sja1105_schedule_entry_points_params_entry *entry,
 		int write)
 {
-	int  (*pack_or_unpack)(void*, uint64_t*, int, int, int);
-	int    size = SIZE_SCHEDULE_ENTRY_POINTS_PARAMS_ENTRY;
-
 	if (write == 0) {
-		pack_or_unpack = gtable_unpack;
 		memset(entry, 0, sizeof(*entry));
+		gtable_plan_unpack(&sja1105_schedule_entry_points_params_entry_plan, buf, entry);
 	} else {
-		pack_or_unpack = gtable_pack;
-		memset(buf, 0, size);
+		memset(buf, 0, SIZE_SCHEDULE_ENTRY_POINTS_PARAMS_ENTRY);
+		gtable_plan_pack(&sja1105_schedule_entry_points_params_entry_plan, buf, entry);
 	}
-	pack_or_unpack(buf, &entry->clksrc,    31, 30, size);
-	pack_or_unpack(buf, &entry->actsubsch, 29, 27, size);
 }
 /*
  * sja1105_schedule_entry_points_params_entry_pack
@@ -38,24 +38,27 @@
 #include <lib/include/gtable.h>
 #include <common.h>
 
+static const struct gtable_field sja1105_schedule_entry_points_entry_fields[] = {
+	GTABLE_FIELD(struct sja1105_schedule_entry_points_entry, subschindx, 31, 29),
+	GTABLE_FIELD(struct sja1105_schedule_entry_points_entry, delta,      28, 11),
+	GTABLE_FIELD(struct sja1105_schedule_entry_points_entry, address,    10,  1),
+};
+
+static struct gtable_plan sja1105_schedule_entry_points_entry_plan =
+	GTABLE_PLAN(sja1105_schedule_entry_points_entry_fields, SIZE_SCHEDULE_ENTRY_POINTS_ENTRY);
+
 static void sja1105_schedule_entry_points_entry_access(
 		void *buf,
 		struct sja1105_schedule_entry_points_entry *entry,
 		int write)
 {
-	int  (*pack_or_unpack)(void*, uint64_t*, int, int, int);
-	int    size = SIZE_SCHEDULE_ENTRY_POINTS_ENTRY;
-
 	if (write == 0) {
-		pack_or_unpack = gtable_unpack;
 		memset(entry, 0, sizeof(*entry));
+		gtable_plan_unpack(&sja1105_schedule_entry_points_entry_plan, buf, entry);
 	} else {
-		pack_or_unpack = gtable_pack;
-		memset(buf, 0, size);
+		memset(buf, 0, SIZE_SCHEDULE_ENTRY_POINTS_ENTRY);
+		gtable_plan_pack(&sja1105_schedule_entry_points_entry_plan, buf, entry);
 	}
-	pack_or_unpack(buf, &entry->subschindx, 31, 29, size);
-	pack_or_unpack(buf, &entry->delta,      28, 11, size);
-	pack_or_unpack(buf, &entry->address,    10, 1,  size);
 }
 /*
  * sja1105_schedule_entry_points_entry_pack
@@ -38,27 +38,24 @@
 #include <lib/include/gtable.h>
 #include <common.h>
 
+static const struct gtable_field sja1105_schedule_params_entry_fields[] = {
+	GTABLE_ARRAY_FIELD(struct sja1105_schedule_params_entry, subscheind, 25, 16, 8, 10),
+};
+
+static struct gtable_plan sja1105_schedule_params_entry_plan =
+	GTABLE_PLAN(sja1105_schedule_params_entry_fields, SIZE_SCHEDULE_PARAMS_ENTRY);
+
 static void sja1105_schedule_params_entry_access(
 		void *buf,
 		struct sja1105_schedule_params_entry *entry,
 		int write)
 {
-	int  (*pack_or_unpack)(void*, uint64_t*, int, int, int);
-	int    size = SIZE_SCHEDULE_PARAMS_ENTRY;
-	int    i;
-	int    offset;
-
 	if (write == 0) {
-		pack_or_unpack = gtable_unpack;
 		memset(entry, 0, sizeof(*entry));
+		gtable_plan_unpack(&sja1105_schedule_params_entry_plan, buf, entry);
 	} else {
-		pack_or_unpack = gtable_pack;
-		memset(buf, 0, size);
-	}
-	offset = 16;
-	for (i = 0; i < 8; i++) {
-		pack_or_unpack(buf, &entry->subscheind[i], offset + 9, offset + 0, size);
-		offset += 10;
+		memset(buf, 0, SIZE_SCHEDULE_PARAMS_ENTRY);
+		gtable_plan_pack(&sja1105_schedule_params_entry_plan, buf, entry);
 	}
 }
 /*
@@ -38,31 +38,34 @@
 #include <lib/include/gtable.h>
 #include <common.h>
 
+static const struct gtable_field sja1105_schedule_entry_fields[] = {
+	GTABLE_FIELD(struct sja1105_schedule_entry, winstindex,  63, 54),
+	GTABLE_FIELD(struct sja1105_schedule_entry, winend,      53, 53),
+	GTABLE_FIELD(struct sja1105_schedule_entry, winst,       52, 52),
+	GTABLE_FIELD(struct sja1105_schedule_entry, destports,   51, 47),
+	GTABLE_FIELD(struct sja1105_schedule_entry, setvalid,    46, 46),
+	GTABLE_FIELD(struct sja1105_schedule_entry, txen,        45, 45),
+	GTABLE_FIELD(struct sja1105_schedule_entry, resmedia_en, 44, 44),
+	GTABLE_FIELD(struct sja1105_schedule_entry, resmedia,    43, 36),
+	GTABLE_FIELD(struct sja1105_schedule_entry, vlindex,     35, 26),
+	GTABLE_FIELD(struct sja1105_schedule_entry, delta,       25,  8),
+};
+
+static struct gtable_plan sja1105_schedule_entry_plan =
+	GTABLE_PLAN(sja1105_schedule_entry_fields, SIZE_SCHEDULE_ENTRY);
+
 static void sja1105_schedule_entry_access(
 		void *buf,
 		struct sja1105_schedule_entry *entry,
 		int write)
 {
-	int (*pack_or_unpack)(void*, uint64_t*, int, int, int);
-	int size = SIZE_SCHEDULE_ENTRY;
-
 	if (write == 0) {
-		pack_or_unpack = gtable_unpack;
 		memset(entry, 0, sizeof(*entry));
+		gtable_plan_unpack(&sja1105_schedule_entry_plan, buf, entry);
 	} else {
-		pack_or_unpack = gtable_pack;
-		memset(buf, 0, size);
+		memset(buf, 0, SIZE_SCHEDULE_ENTRY);
+		gtable_plan_pack(&sja1105_schedule_entry_plan, buf, entry);
 	}
-	pack_or_unpack(buf, &entry->winstindex,  63, 54, size);
-	pack_or_unpack(buf, &entry->winend,      53, 53, size);
-	pack_or_unpack(buf, &entry->winst,       52, 52, size);
-	pack_or_unpack(buf, &entry->destports,   51, 47, size);
-	pack_or_unpack(buf, &entry->setvalid,    46, 46, size);
-	pack_or_unpack(buf, &entry->txen,        45, 45, size);
-	pack_or_unpack(buf, &entry->resmedia_en, 44, 44, size);
-	pack_or_unpack(buf, &entry->resmedia,    43, 36, size);
-	pack_or_unpack(buf, &entry->vlindex,     35, 26, size);
-	pack_or_unpack(buf, &entry->delta,       25, 8,  size);
 }
 /*
  * sja1105_schedule_entry_pack
@@ -38,30 +38,35 @@
 #include <lib/include/gtable.h>
 #include <common.h>
 
+static const struct gtable_field sja1105_sgmii_entry_fields[] = {
+	GTABLE_FIELD(struct sja1105_sgmii_entry, digital_error_cnt, 1151, 1120),
+	GTABLE_FIELD(struct sja1105_sgmii_entry, digital_control_2, 1119, 1088),
+	GTABLE_FIELD(struct sja1105_sgmii_entry, debug_control,      383,  352),
+	GTABLE_FIELD(struct sja1105_sgmii_entry, test_control,       351,  320),
+	GTABLE_FIELD(struct sja1105_sgmii_entry, autoneg_control,    287,  256),
+	GTABLE_FIELD(struct sja1105_sgmii_entry, digital_control_1,  255,  224),
+	GTABLE_FIELD(struct sja1105_sgmii_entry, autoneg_adv,        223,  192),
+	GTABLE_FIELD(struct sja1105_sgmii_entry, basic_control,      191,  160),
+};
+
+static struct gtable_plan sja1105_sgmii_entry_plan =
+	GTABLE_PLAN(sja1105_sgmii_entry_fields, SIZE_SGMII_ENTRY);
+
 static void
 sja1105_sgmii_entry_access(void *buf,
                            struct sja1105_sgmii_entry *entry,
                            int write)
 {
-	int  (*pack_or_unpack)(void*, uint64_t*, int, int, int);
 	int    size = SIZE_SGMII_ENTRY;
 	uint64_t tmp;
 
 	if (write == 0) {
-		pack_or_unpack = gtable_unpack;
 		memset(entry, 0, sizeof(*entry));
+		gtable_plan_unpack(&sja1105_sgmii_entry_plan, buf, entry);
 	} else {
-		pack_or_unpack = gtable_pack;
 		memset(buf, 0, size);
+		gtable_plan_pack(&sja1105_sgmii_entry_plan, buf, entry);
 	}
-	pack_or_unpack(buf, &entry->digital_error_cnt, 1151, 1120, size);
-	pack_or_unpack(buf, &entry->digital_control_2, 1119, 1088, size);
-	pack_or_unpack(buf, &entry->debug_control,      383,  352, size);
-	pack_or_unpack(buf, &entry->test_control,       351,  320, size);
-	pack_or_unpack(buf, &entry->autoneg_control,    287,  256, size);
-	pack_or_unpack(buf, &entry->digital_control_1,  255,  224, size);
-	pack_or_unpack(buf, &entry->autoneg_adv,        223,  192, size);
-	pack_or_unpack(buf, &entry->basic_control,      191,  160, size);
 	/* Reserved areas */
 	if (write == 1) {
 		tmp = 0x00000000ull; gtable_pack(buf, &tmp, 1087, 1056, size);
@@ -38,24 +38,27 @@
 #include <lib/include/gtable.h>
 #include <common.h>
 
+static const struct gtable_field sja1105_table_header_fields[] = {
+	GTABLE_FIELD(struct sja1105_table_header, block_id, 31, 24),
+	GTABLE_FIELD(struct sja1105_table_header, len,      55, 32),
+	GTABLE_FIELD(struct sja1105_table_header, crc,      95, 64),
+};
+
+static struct gtable_plan sja1105_table_header_plan =
+	GTABLE_PLAN(sja1105_table_header_fields, SIZE_TABLE_HEADER);
+
 void sja1105_table_header_access(
 		void *buf,
 		struct sja1105_table_header *hdr,
 		int write)
 {
-	int (*pack_or_unpack)(void*, uint64_t*, int, int, int);
-	int size = SIZE_TABLE_HEADER;
-
 	if (write == 0) {
-		pack_or_unpack = gtable_unpack;
 		memset(hdr, 0, sizeof(*hdr));
+		gtable_plan_unpack(&sja1105_table_header_plan, buf, hdr);
 	} else {
-		pack_or_unpack = gtable_pack;
-		memset(buf, 0, size);
+		memset(buf, 0, SIZE_TABLE_HEADER);
+		gtable_plan_pack(&sja1105_table_header_plan, buf, hdr);
 	}
-	pack_or_unpack(buf, &hdr->block_id, 31, 24, size);
-	pack_or_unpack(buf, &hdr->len,      55, 32, size);
-	pack_or_unpack(buf, &hdr->crc,      95, 64, size);
 }
 
 void sja1105_table_header_unpack(
@@ -38,29 +38,26 @@
 #include <lib/include/gtable.h>
 #include <common.h>
 
+static const struct gtable_field sja1105_vl_forwarding_params_entry_fields[] = {
+	GTABLE_ARRAY_FIELD(struct sja1105_vl_forwarding_params_entry, partspc, 25, 16, 8, 10),
+	GTABLE_FIELD(struct sja1105_vl_forwarding_params_entry, debugen, 15, 15),
+};
+
+static struct gtable_plan sja1105_vl_forwarding_params_entry_plan =
+	GTABLE_PLAN(sja1105_vl_forwarding_params_entry_fields, SIZE_VL_FORWARDING_PARAMS_ENTRY);
+
 static void sja1105_vl_forwarding_params_entry_access(
 		void *buf,
 		struct sja1105_vl_forwarding_params_entry *entry,
 		int write)
 {
-	int  (*pack_or_unpack)(void*, uint64_t*, int, int, int);
-	int    size = SIZE_VL_FORWARDING_PARAMS_ENTRY;
-	int    offset;
-	int    i;
-
 	if (write == 0) {
-		pack_or_unpack = gtable_unpack;
 		memset(entry, 0, sizeof(*entry));
+		gtable_plan_unpack(&sja1105_vl_forwarding_params_entry_plan, buf, entry);
 	} else {
-		pack_or_unpack = gtable_pack;
-		memset(buf, 0, size);
-	}
-	offset = 16;
-	for (i = 0; i < 8; i++) {
-		pack_or_unpack(buf, &entry->partspc[i], offset + 9, offset + 0, size);
-		offset += 10;
+		memset(buf, 0, SIZE_VL_FORWARDING_PARAMS_ENTRY);
+		gtable_plan_pack(&sja1105_vl_forwarding_params_entry_plan, buf, entry);
 	}
-	pack_or_unpack(buf, &entry->debugen, 15, 15, size);
 }
 /*
  * sja1105_vl_forwarding_params_entry_pack
@@ -38,25 +38,28 @@
 #include <lib/include/gtable.h>
 #include <common.h>
 
+static const struct gtable_field sja1105_vl_forwarding_entry_fields[] = {
+	GTABLE_FIELD(struct sja1105_vl_forwarding_entry, type,      31, 31),
+	GTABLE_FIELD(struct sja1105_vl_forwarding_entry, priority,  30, 28),
+	GTABLE_FIELD(struct sja1105_vl_forwarding_entry, partition, 27, 25),
+	GTABLE_FIELD(struct sja1105_vl_forwarding_entry, destports, 24, 20),
+};
+
+static struct gtable_plan sja1105_vl_forwarding_entry_plan =
+	GTABLE_PLAN(sja1105_vl_forwarding_entry_fields, SIZE_VL_FORWARDING_ENTRY);
+
 static void sja1105_vl_forwarding_entry_access(
 		void *buf,
 		struct sja1105_vl_forwarding_entry *entry,
 		int write)
 {
-	int  (*pack_or_unpack)(void*, uint64_t*, int, int, int);
-	int    size = SIZE_VL_FORWARDING_ENTRY;
-
 	if (write == 0) {
-		pack_or_unpack = gtable_unpack;
 		memset(entry, 0, sizeof(*entry));
+		gtable_plan_unpack(&sja1105_vl_forwarding_entry_plan, buf, entry);
 	} else {
-		pack_or_unpack = gtable_pack;
-		memset(buf, 0, size);
+		memset(buf, 0, SIZE_VL_FORWARDING_ENTRY);
+		gtable_plan_pack(&sja1105_vl_forwarding_entry_plan, buf, entry);
 	}
-	pack_or_unpack(buf, &entry->type,      31, 31, size);
-	pack_or_unpack(buf, &entry->priority,  30, 28, size);
-	pack_or_unpack(buf, &entry->partition, 27, 25, size);
-	pack_or_unpack(buf, &entry->destports, 24, 20, size);
 }
 /*
  * sja1105_vl_forwarding_entry_pack
@@ -39,35 +39,51 @@
 #include <lib/helpers.h>
 #include <common.h>
 
+static const struct gtable_field sja1105_vl_lookup_entry_fmt0_fields[] = {
+	GTABLE_FIELD(struct sja1105_vl_lookup_entry, destports,  95, 91),
+	GTABLE_FIELD(struct sja1105_vl_lookup_entry, iscritical, 90, 90),
+	GTABLE_FIELD(struct sja1105_vl_lookup_entry, macaddr,    89, 42),
+	GTABLE_FIELD(struct sja1105_vl_lookup_entry, vlanid,     41, 30),
+	GTABLE_FIELD(struct sja1105_vl_lookup_entry, port,       29, 27),
+	GTABLE_FIELD(struct sja1105_vl_lookup_entry, vlanprior,  26, 24),
+};
+
+static struct gtable_plan sja1105_vl_lookup_entry_fmt0_plan =
+	GTABLE_PLAN(sja1105_vl_lookup_entry_fmt0_fields, SIZE_VL_LOOKUP_ENTRY);
+
+static const struct gtable_field sja1105_vl_lookup_entry_fmt1_fields[] = {
+	GTABLE_FIELD(struct sja1105_vl_lookup_entry, egrmirr,    95, 91),
+	GTABLE_FIELD(struct sja1105_vl_lookup_entry, ingrmirr,   90, 90),
+	GTABLE_FIELD(struct sja1105_vl_lookup_entry, vlid,       57, 42),
+	GTABLE_FIELD(struct sja1105_vl_lookup_entry, port,       29, 27),
+};
+
+static struct gtable_plan sja1105_vl_lookup_entry_fmt1_plan =
+	GTABLE_PLAN(sja1105_vl_lookup_entry_fmt1_fields, SIZE_VL_LOOKUP_ENTRY);
+
 static void sja1105_vl_lookup_entry_access(
 		void *buf,
 		struct sja1105_vl_lookup_entry *entry,
 		int write)
 {
-	int  (*pack_or_unpack)(void*, uint64_t*, int, int, int);
-	int    size = SIZE_VL_LOOKUP_ENTRY;
+	struct gtable_plan *plan;
 
 	if (write == 0) {
-		pack_or_unpack = gtable_unpack;
 		memset(entry, 0, sizeof(*entry));
 	} else {
-		pack_or_unpack = gtable_pack;
-		memset(buf, 0, size);
+		memset(buf, 0, SIZE_VL_LOOKUP_ENTRY);
 	}
 	if (entry->format == 0) {
 		logv("Interpreting vllupformat as 0");
-		pack_or_unpack(buf, &entry->destports,  95, 91, size);
-		pack_or_unpack(buf, &entry->iscritical, 90, 90, size);
-		pack_or_unpack(buf, &entry->macaddr,    89, 42, size);
-		pack_or_unpack(buf, &entry->vlanid,     41, 30, size);
-		pack_or_unpack(buf, &entry->port,       29, 27, size);
-		pack_or_unpack(buf, &entry->vlanprior,  26, 24, size);
+		plan = &sja1105_vl_lookup_entry_fmt0_plan;
 	} else {
 		logv("Interpreting vllupformat as 1");
-		pack_or_unpack(buf, &entry->egrmirr,    95, 91, size);
-		pack_or_unpack(buf, &entry->ingrmirr,   90, 90, size);
-		pack_or_unpack(buf, &entry->vlid,       57, 42, size);
-		pack_or_unpack(buf, &entry->port,       29, 27, size);
+		plan = &sja1105_vl_lookup_entry_fmt1_plan;
+	}
+	if (write == 0) {
+		gtable_plan_unpack(plan, buf, entry);
+	} else {
+		gtable_plan_pack(plan, buf, entry);
 	}
 }
 
@@ -38,27 +38,40 @@
 #include <lib/include/gtable.h>
 #include <common.h>
 
+static const struct gtable_field sja1105_vl_policing_entry_fields[] = {
+	GTABLE_FIELD(struct sja1105_vl_policing_entry, type,      63, 63),
+	GTABLE_FIELD(struct sja1105_vl_policing_entry, maxlen,    62, 52),
+	GTABLE_FIELD(struct sja1105_vl_policing_entry, sharindx,  51, 42),
+};
+
+static struct gtable_plan sja1105_vl_policing_entry_plan =
+	GTABLE_PLAN(sja1105_vl_policing_entry_fields, SIZE_VL_POLICING_ENTRY);
+
+static const struct gtable_field sja1105_vl_policing_entry_type0_fields[] = {
+	GTABLE_FIELD(struct sja1105_vl_policing_entry, bag,       41, 28),
+	GTABLE_FIELD(struct sja1105_vl_policing_entry, jitter,    27, 18),
+};
+
+static struct gtable_plan sja1105_vl_policing_entry_type0_plan =
+	GTABLE_PLAN(sja1105_vl_policing_entry_type0_fields, SIZE_VL_POLICING_ENTRY);
+
 static void sja1105_vl_policing_entry_access(
 		void *buf,
 		struct sja1105_vl_policing_entry *entry,
 		int write)
 {
-	int  (*pack_or_unpack)(void*, uint64_t*, int, int, int);
-	int    size = SIZE_VL_POLICING_ENTRY;
+	void (*pack_or_unpack)(struct gtable_plan*, void*, void*);
 
 	if (write == 0) {
-		pack_or_unpack = gtable_unpack;
+		pack_or_unpack = gtable_plan_unpack;
 		memset(entry, 0, sizeof(*entry));
 	} else {
-		pack_or_unpack = gtable_pack;
-		memset(buf, 0, size);
+		pack_or_unpack = gtable_plan_pack;
+		memset(buf, 0, SIZE_VL_POLICING_ENTRY);
 	}
-	pack_or_unpack(buf, &entry->type,      63, 63, size);
-	pack_or_unpack(buf, &entry->maxlen,    62, 52, size);
-	pack_or_unpack(buf, &entry->sharindx,  51, 42, size);
+	pack_or_unpack(&sja1105_vl_policing_entry_plan, buf, entry);
 	if (entry->type == 0) {
-		pack_or_unpack(buf, &entry->bag,    41, 28, size);
-		pack_or_unpack(buf, &entry->jitter, 27, 18, size);
+		pack_or_unpack(&sja1105_vl_policing_entry_type0_plan, buf, entry);
 	}
 }
 /*
@@ -38,27 +38,30 @@
 #include <lib/include/gtable.h>
 #include <common.h>
 
+static const struct gtable_field sja1105_vlan_lookup_entry_fields[] = {
+	GTABLE_FIELD(struct sja1105_vlan_lookup_entry, ving_mirr,  63, 59),
+	GTABLE_FIELD(struct sja1105_vlan_lookup_entry, vegr_mirr,  58, 54),
+	GTABLE_FIELD(struct sja1105_vlan_lookup_entry, vmemb_port, 53, 49),
+	GTABLE_FIELD(struct sja1105_vlan_lookup_entry, vlan_bc,    48, 44),
+	GTABLE_FIELD(struct sja1105_vlan_lookup_entry, tag_port,   43, 39),
+	GTABLE_FIELD(struct sja1105_vlan_lookup_entry, vlanid,     38, 27),
+};
+
+static struct gtable_plan sja1105_vlan_lookup_entry_plan =
+	GTABLE_PLAN(sja1105_vlan_lookup_entry_fields, SIZE_VLAN_LOOKUP_ENTRY);
+
 static void sja1105_vlan_lookup_entry_access(
 		void *buf,
 		struct sja1105_vlan_lookup_entry *entry,
 		int write)
 {
-	int  (*pack_or_unpack)(void*, uint64_t*, int, int, int);
-	int    size = SIZE_VLAN_LOOKUP_ENTRY;
-
 	if (write == 0) {
-		pack_or_unpack = gtable_unpack;
 		memset(entry, 0, sizeof(*entry));
+		gtable_plan_unpack(&sja1105_vlan_lookup_entry_plan, buf, entry);
 	} else {
-		pack_or_unpack = gtable_pack;
-		memset(buf, 0, size);
+		memset(buf, 0, SIZE_VLAN_LOOKUP_ENTRY);
+		gtable_plan_pack(&sja1105_vlan_lookup_entry_plan, buf, entry);
 	}
-	pack_or_unpack(buf, &entry->ving_mirr,  63, 59, size);
-	pack_or_unpack(buf, &entry->vegr_mirr,  58, 54, size);
-	pack_or_unpack(buf, &entry->vmemb_port, 53, 49, size);
-	pack_or_unpack(buf, &entry->vlan_bc,    48, 44, size);
-	pack_or_unpack(buf, &entry->tag_port,   43, 39, size);
-	pack_or_unpack(buf, &entry->vlanid,     38, 27, size);
 }
 
 /*
@@ -38,28 +38,25 @@
 #include <lib/include/gtable.h>
 #include <common.h>
 
+static const struct gtable_field sja1105_xmii_params_entry_fields[] = {
+	GTABLE_ARRAY_FIELD(struct sja1105_xmii_params_entry, xmii_mode, 18, 17, 5, 3),
+	GTABLE_ARRAY_FIELD(struct sja1105_xmii_params_entry, phy_mac,   19, 19, 5, 3),
+};
+
+static struct gtable_plan sja1105_xmii_params_entry_plan =
+	GTABLE_PLAN(sja1105_xmii_params_entry_fields, SIZE_XMII_MODE_PARAMS_ENTRY);
+
 static void sja1105_xmii_params_entry_access(
 		void *buf,
 		struct sja1105_xmii_params_entry *entry,
 		int write)
 {
-	int  (*pack_or_unpack)(void*, uint64_t*, int, int, int);
-	int    size = SIZE_XMII_MODE_PARAMS_ENTRY;
-	int    offset;
-	int    i;
-
 	if (write == 0) {
-		pack_or_unpack = gtable_unpack;
 		memset(entry, 0, sizeof(*entry));
+		gtable_plan_unpack(&sja1105_xmii_params_entry_plan, buf, entry);
 	} else {
-		pack_or_unpack = gtable_pack;
-		memset(buf, 0, size);
-	}
-	offset = 17;
-	for (i = 0; i < 5; i++) {
-		pack_or_unpack(buf, &entry->xmii_mode[i], offset + 1, offset + 0, size);
-		pack_or_unpack(buf, &entry->phy_mac[i],   offset + 2, offset + 2, size);
-		offset += 3;
+		memset(buf, 0, SIZE_XMII_MODE_PARAMS_ENTRY);
+		gtable_plan_pack(&sja1105_xmii_params_entry_plan, buf, entry);
 	}
 }
 /*
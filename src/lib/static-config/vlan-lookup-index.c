@@ -0,0 +1,295 @@
+/******************************************************************************
+ * Copyright (c) 2018, NXP Semiconductors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+/* These are our own include files */
+#include <lib/include/static-config.h>
+#include <common.h>
+
+/* Sparse index of the VLAN Lookup table by VID.
+ *
+ * Bit v of @present tells whether VID v has an entry. The positions in
+ * the table of the present VIDs are kept densely in @entry, in VID
+ * order, and @rank holds the number of present VIDs below each 64-bit
+ * word of the bitmap. The position of a VID is then found with one
+ * popcount, and a VID seen twice shows up as a bit that is already set.
+ */
+
+#define VLAN_WORD(vid) ((vid) / 64)
+#define VLAN_BIT(vid)  (1ull << ((vid) % 64))
+
+/* Indexes the @count VLAN Lookup entries at @entries. Returns -EEXIST
+ * if a VID is repeated and -ERANGE if one is out of range. */
+int sja1105_vlan_lookup_index_build(struct sja1105_vlan_lookup_index *index,
+                                    const struct sja1105_vlan_lookup_entry *entries,
+                                    int count)
+{
+	uint64_t vid;
+	int pos = 0;
+	int w, i;
+
+	memset(index->present, 0, sizeof(index->present));
+	for (i = 0; i < count; i++) {
+		vid = entries[i].vlanid;
+		if (vid >= MAX_VLAN_LOOKUP_COUNT) {
+			loge("vlan-lookup-table[%d] has invalid VID %" PRIu64,
+			     i, vid);
+			return -ERANGE;
+		}
+		if (index->present[VLAN_WORD(vid)] & VLAN_BIT(vid)) {
+			loge("vlan-lookup-table[%d] repeats VID %" PRIu64,
+			     i, vid);
+			return -EEXIST;
+		}
+		index->present[VLAN_WORD(vid)] |= VLAN_BIT(vid);
+	}
+	for (w = 0; w < SJA1105_VLAN_INDEX_WORDS; w++) {
+		index->rank[w] = pos;
+		pos += __builtin_popcountll(index->present[w]);
+	}
+	index->count = pos;
+	for (i = 0; i < count; i++) {
+		vid = entries[i].vlanid;
+		pos = index->rank[VLAN_WORD(vid)] +
+		      __builtin_popcountll(index->present[VLAN_WORD(vid)] &
+		                           (VLAN_BIT(vid) - 1));
+		index->entry[pos] = i;
+	}
+	return 0;
+}
+
+/* Returns the position in the VLAN Lookup table of the entry for @vid,
+ * or -ENOENT if there is none */
+int sja1105_vlan_lookup_index_find(const struct sja1105_vlan_lookup_index *index,
+                                   uint16_t vid)
+{
+	uint64_t word;
+
+	if (vid >= MAX_VLAN_LOOKUP_COUNT) {
+		return -ENOENT;
+	}
+	word = index->present[VLAN_WORD(vid)];
+	if (!(word & VLAN_BIT(vid))) {
+		return -ENOENT;
+	}
+	return index->entry[index->rank[VLAN_WORD(vid)] +
+	                    __builtin_popcountll(word & (VLAN_BIT(vid) - 1))];
+}
+
+/* Puts the VLAN Lookup table in VID order, as the switch expects it.
+ * The sort is stable, so it also goes through (invalid) duplicates.
+ * Entries with an out-of-range VID are left for the caller to reject,
+ * at the end. */
+int sja1105_vlan_lookup_sort(struct sja1105_static_config *config)
+{
+	struct sja1105_vlan_lookup_entry *sorted;
+	uint16_t *start;
+	uint64_t vid;
+	int count = config->vlan_lookup_count;
+	int i, pos;
+
+	for (i = 1; i < count; i++) {
+		if (config->vlan_lookup[i].vlanid <
+		    config->vlan_lookup[i - 1].vlanid) {
+			break;
+		}
+	}
+	if (i >= count) {
+		return 0;
+	}
+	/* Counting sort. One more bucket for the invalid VIDs. */
+	start = calloc(MAX_VLAN_LOOKUP_COUNT + 1, sizeof(*start));
+	sorted = malloc(count * sizeof(*sorted));
+	if (!start || !sorted) {
+		free(start);
+		free(sorted);
+		return -ENOMEM;
+	}
+	for (i = 0; i < count; i++) {
+		vid = min(config->vlan_lookup[i].vlanid,
+		          (uint64_t) MAX_VLAN_LOOKUP_COUNT);
+		if (vid < MAX_VLAN_LOOKUP_COUNT) {
+			start[vid + 1]++;
+		}
+	}
+	for (i = 1; i <= MAX_VLAN_LOOKUP_COUNT; i++) {
+		start[i] += start[i - 1];
+	}
+	for (i = 0; i < count; i++) {
+		vid = min(config->vlan_lookup[i].vlanid,
+		          (uint64_t) MAX_VLAN_LOOKUP_COUNT);
+		pos = start[vid]++;
+		sorted[pos] = config->vlan_lookup[i];
+	}
+	memcpy(config->vlan_lookup, sorted, count * sizeof(*sorted));
+	sja1105_static_config_mark_dirty(config, BLKID_VLAN_LOOKUP_TABLE);
+	free(sorted);
+	free(start);
+	return 0;
+}
+
+/* VIDs of [@first, @last] that fall in word @w of the bitmap */
+static uint64_t vlan_range_word(int w, uint16_t first, uint16_t last)
+{
+	int lo = max((int) first, w * 64);
+	int hi = min((int) last, w * 64 + 63);
+
+	if (lo > hi) {
+		return 0;
+	}
+	return (~0ull >> (63 - (hi - lo))) << (lo % 64);
+}
+
+#define VLAN_PORTS_ADD 0
+#define VLAN_PORTS_DEL 1
+#define VLAN_PORTS_SET 2
+
+/* Rebuilds the VLAN Lookup table in VID order, applying a port change
+ * to the VIDs in [@first, @last]:
+ * - VLAN_PORTS_ADD: @ports become members of (and receive the broadcasts
+ *   of) each VID, creating the entries that are missing. Those of @ports
+ *   that are also in @tagged egress the VLAN tagged, the others untagged.
+ * - VLAN_PORTS_DEL: @ports are removed from each VID.
+ * - VLAN_PORTS_SET: @ports become the only members of each VID, with
+ *   @tagged as above. Mirroring settings are kept.
+ * Entries left with no member port are dropped.
+ */
+static int
+sja1105_vlan_lookup_range_apply(struct sja1105_static_config *config,
+                                uint16_t first, uint16_t last,
+                                uint64_t ports, uint64_t tagged, int op)
+{
+	struct sja1105_vlan_lookup_index *index;
+	struct sja1105_vlan_lookup_entry *table;
+	struct sja1105_vlan_lookup_entry *entry;
+	uint64_t in_range, bits;
+	int count = 0;
+	int pos, w, b;
+	int rc;
+
+	if (first > last || last >= MAX_VLAN_LOOKUP_COUNT) {
+		loge("Invalid VID range %u-%u", first, last);
+		return -ERANGE;
+	}
+	if (ports & ~0x1full || tagged & ~ports) {
+		loge("Invalid port mask 0x%" PRIx64 " (tagged 0x%" PRIx64 ")",
+		     ports, tagged);
+		return -EINVAL;
+	}
+	index = malloc(sizeof(*index));
+	table = malloc(MAX_VLAN_LOOKUP_COUNT * sizeof(*table));
+	if (!index || !table) {
+		rc = -ENOMEM;
+		goto out;
+	}
+	rc = sja1105_vlan_lookup_index_build(index, config->vlan_lookup,
+	                                     config->vlan_lookup_count);
+	if (rc < 0) {
+		goto out;
+	}
+	for (w = 0; w < SJA1105_VLAN_INDEX_WORDS; w++) {
+		in_range = vlan_range_word(w, first, last);
+		bits = index->present[w];
+		if (op != VLAN_PORTS_DEL) {
+			bits |= in_range;
+		}
+		while (bits) {
+			b = __builtin_ctzll(bits);
+			bits &= bits - 1;
+			entry = &table[count];
+			pos = sja1105_vlan_lookup_index_find(index, w * 64 + b);
+			if (pos >= 0) {
+				*entry = config->vlan_lookup[pos];
+			} else {
+				memset(entry, 0, sizeof(*entry));
+				entry->vlanid = w * 64 + b;
+			}
+			if (in_range & (1ull << b)) {
+				if (op == VLAN_PORTS_SET) {
+					entry->vmemb_port = 0;
+					entry->vlan_bc    = 0;
+					entry->tag_port   = 0;
+				}
+				if (op == VLAN_PORTS_DEL) {
+					entry->vmemb_port &= ~ports;
+					entry->vlan_bc    &= ~ports;
+					entry->tag_port   &= ~ports;
+				} else {
+					entry->vmemb_port |= ports;
+					entry->vlan_bc    |= ports;
+					entry->tag_port    = (entry->tag_port & ~ports) |
+					                     tagged;
+				}
+				if (entry->vmemb_port == 0) {
+					continue;
+				}
+			}
+			count++;
+		}
+	}
+	rc = sja1105_static_config_resize(config, BLKID_VLAN_LOOKUP_TABLE,
+	                                  count);
+	if (rc < 0) {
+		goto out;
+	}
+	memcpy(config->vlan_lookup, table, count * sizeof(*table));
+	sja1105_static_config_mark_dirty(config, BLKID_VLAN_LOOKUP_TABLE);
+out:
+	free(table);
+	free(index);
+	return rc;
+}
+
+int sja1105_vlan_lookup_range_add(struct sja1105_static_config *config,
+                                  uint16_t first, uint16_t last,
+                                  uint64_t ports, uint64_t tagged)
+{
+	return sja1105_vlan_lookup_range_apply(config, first, last,
+	                                       ports, tagged, VLAN_PORTS_ADD);
+}
+
+int sja1105_vlan_lookup_range_del(struct sja1105_static_config *config,
+                                  uint16_t first, uint16_t last,
+                                  uint64_t ports)
+{
+	return sja1105_vlan_lookup_range_apply(config, first, last,
+	                                       ports, 0, VLAN_PORTS_DEL);
+}
+
+int sja1105_vlan_lookup_range_set(struct sja1105_static_config *config,
+                                  uint16_t first, uint16_t last,
+                                  uint64_t ports, uint64_t tagged)
+{
+	return sja1105_vlan_lookup_range_apply(config, first, last,
+	                                       ports, tagged, VLAN_PORTS_SET);
+}
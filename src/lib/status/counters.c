@@ -0,0 +1,417 @@
+/******************************************************************************
+ * Copyright (c) 2018, NXP Semiconductors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+/* These are our include files */
+#include <lib/include/status.h>
+#include <lib/include/spi.h>
+#include <common.h>
+
+#define NSEC_PER_SEC 1000000000ull
+
+#define COUNTER(id, field, bits) \
+	[id] = { #field, offsetof(struct sja1105_port_status, field), bits }
+
+/* How many bits wide the hardware counters are. Anything narrower
+ * than 64 bits wraps around, and the frame and byte counters are
+ * already extended to 64 bits by sja1105_port_status_get. */
+static const struct {
+	const char *name;
+	size_t      offset;
+	int         width;
+} sja1105_counter_info[SJA1105_CNT_MAX] = {
+	COUNTER(SJA1105_CNT_N_RUNT,         n_runt,          8),
+	COUNTER(SJA1105_CNT_N_SOFERR,       n_soferr,        8),
+	COUNTER(SJA1105_CNT_N_ALIGNERR,     n_alignerr,      8),
+	COUNTER(SJA1105_CNT_N_MIIERR,       n_miierr,        8),
+	COUNTER(SJA1105_CNT_N_N664ERR,      n_n664err,      32),
+	COUNTER(SJA1105_CNT_N_VLANERR,      n_vlanerr,      32),
+	COUNTER(SJA1105_CNT_N_UNRELEASED,   n_unreleased,   32),
+	COUNTER(SJA1105_CNT_N_SIZERR,       n_sizerr,       32),
+	COUNTER(SJA1105_CNT_N_CRCERR,       n_crcerr,       32),
+	COUNTER(SJA1105_CNT_N_VLNOTFOUND,   n_vlnotfound,   32),
+	COUNTER(SJA1105_CNT_N_BEPOLERR,     n_bepolerr,     32),
+	COUNTER(SJA1105_CNT_N_POLERR,       n_polerr,       32),
+	COUNTER(SJA1105_CNT_N_QFULL,        n_qfull,        32),
+	COUNTER(SJA1105_CNT_N_PART_DROP,    n_part_drop,    32),
+	COUNTER(SJA1105_CNT_N_EGR_DISABLED, n_egr_disabled, 32),
+	COUNTER(SJA1105_CNT_N_NOT_REACH,    n_not_reach,    32),
+	COUNTER(SJA1105_CNT_N_RXFRM,        n_rxfrm,        64),
+	COUNTER(SJA1105_CNT_N_RXBYTE,       n_rxbyte,       64),
+	COUNTER(SJA1105_CNT_N_TXFRM,        n_txfrm,        64),
+	COUNTER(SJA1105_CNT_N_TXBYTE,       n_txbyte,       64),
+};
+
+const char *sja1105_counter_name(enum sja1105_counter counter)
+{
+	if (counter < 0 || counter >= SJA1105_CNT_MAX) {
+		return NULL;
+	}
+	return sja1105_counter_info[counter].name;
+}
+
+void sja1105_counters_init(struct sja1105_counters *counters)
+{
+	memset(counters, 0, sizeof(*counters));
+}
+
+static uint64_t timespec_to_ns(const struct timespec *ts)
+{
+	return (uint64_t) ts->tv_sec * NSEC_PER_SEC + ts->tv_nsec;
+}
+
+static double per_second(uint64_t delta, uint64_t interval_ns)
+{
+	return interval_ns ? (double) delta * NSEC_PER_SEC / interval_ns : 0;
+}
+
+/* Accounts for a new snapshot of the hardware counters. Counters
+ * that are read at least once per wrap-around period never lose
+ * increments. The totals of the first sample are the raw values. */
+void sja1105_counters_update(struct sja1105_counters *counters,
+                             const struct sja1105_port_status_snapshot *snapshot)
+{
+	struct sja1105_counters_sample *sample = &counters->sample;
+	struct sja1105_port_counters *port;
+	const int num_ports = ARRAY_SIZE(snapshot->port);
+	uint64_t prev, cur, mask;
+	int first = (sample->seq == 0);
+	int i, p;
+
+	sample->interval_ns = first ? 0 :
+	                      timespec_to_ns(&snapshot->timestamp) -
+	                      timespec_to_ns(&counters->last.timestamp);
+	sample->timestamp = snapshot->timestamp;
+	sample->seq++;
+
+	for (p = 0; p < num_ports; p++) {
+		port = &sample->port[p];
+		port->drops = 0;
+		for (i = 0; i < SJA1105_CNT_MAX; i++) {
+			cur  = *(const uint64_t*) ((const char*) &snapshot->port[p] +
+			                           sja1105_counter_info[i].offset);
+			prev = *(const uint64_t*) ((const char*) &counters->last.port[p] +
+			                           sja1105_counter_info[i].offset);
+			mask = (sja1105_counter_info[i].width == 64) ? ~0ull :
+			       (1ull << sja1105_counter_info[i].width) - 1;
+			if (first) {
+				port->delta[i] = 0;
+				port->total[i] = cur;
+			} else {
+				port->delta[i] = (cur - prev) & mask;
+				port->total[i] += port->delta[i];
+			}
+			if (i < SJA1105_CNT_NUM_DROP_REASONS) {
+				port->drops += port->delta[i];
+			}
+		}
+		port->rx_frames_rate = per_second(port->delta[SJA1105_CNT_N_RXFRM],
+		                                  sample->interval_ns);
+		port->rx_bytes_rate  = per_second(port->delta[SJA1105_CNT_N_RXBYTE],
+		                                  sample->interval_ns);
+		port->tx_frames_rate = per_second(port->delta[SJA1105_CNT_N_TXFRM],
+		                                  sample->interval_ns);
+		port->tx_bytes_rate  = per_second(port->delta[SJA1105_CNT_N_TXBYTE],
+		                                  sample->interval_ns);
+		port->drops_rate     = per_second(port->drops, sample->interval_ns);
+	}
+	counters->last = *snapshot;
+}
+
+/* Takes one snapshot of all ports and accounts for it */
+int sja1105_counters_poll(struct sja1105_spi_setup *spi_setup,
+                          struct sja1105_counters *counters)
+{
+	struct sja1105_port_status_snapshot snapshot;
+	int rc;
+
+	rc = sja1105_port_status_snapshot_get(spi_setup, &snapshot);
+	if (rc < 0) {
+		loge("sja1105_port_status_snapshot_get failed");
+		return rc;
+	}
+	sja1105_counters_update(counters, &snapshot);
+	return 0;
+}
+
+/* Samples all ports every interval_ns, on absolute deadlines so that
+ * the period does not drift with the time spent on SPI. Each sample is
+ * published to ring (if not NULL) and then passed to cb (if not NULL).
+ * Stops after count samples (0 means never), or when cb returns
+ * non-zero.
+ */
+int sja1105_counters_run(struct sja1105_spi_setup *spi_setup,
+                         struct sja1105_counters *counters,
+                         struct sja1105_counters_ring *ring,
+                         uint64_t interval_ns, uint64_t count,
+                         int (*cb)(const struct sja1105_counters_sample*,
+                                   void *priv),
+                         void *priv)
+{
+	struct timespec deadline;
+	uint64_t deadline_ns;
+	uint64_t i;
+	int rc;
+
+	if (interval_ns == 0) {
+		return -EINVAL;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &deadline);
+	deadline_ns = timespec_to_ns(&deadline);
+	for (i = 0; count == 0 || i < count; i++) {
+		if (i) {
+			deadline_ns += interval_ns;
+			deadline.tv_sec  = deadline_ns / NSEC_PER_SEC;
+			deadline.tv_nsec = deadline_ns % NSEC_PER_SEC;
+			while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME,
+			                       &deadline, NULL) == EINTR);
+		}
+		rc = sja1105_counters_poll(spi_setup, counters);
+		if (rc < 0) {
+			return rc;
+		}
+		if (ring) {
+			sja1105_counters_ring_publish(ring, &counters->sample);
+		}
+		if (cb) {
+			rc = cb(&counters->sample, priv);
+			if (rc) {
+				return (rc < 0) ? rc : 0;
+			}
+		}
+	}
+	return 0;
+}
+
+/* Shared memory ring
+ *
+ * Each slot is protected by a sequence lock: its seq is odd while the
+ * poller is rewriting it, and 2 * sample.seq once the sample is
+ * complete. Readers copy the slot and retry if seq changed meanwhile,
+ * so they never block the poller, nor each other.
+ */
+#define RING_MAGIC   0x53313130 /* "S110" */
+#define RING_VERSION 1
+
+struct sja1105_counters_ring_slot {
+	uint64_t seq;
+	struct sja1105_counters_sample sample;
+};
+
+struct sja1105_counters_ring_hdr {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t slot_count;
+	uint32_t slot_size;
+	uint64_t head; /* seq of the newest complete sample, 0 if none */
+	struct sja1105_counters_ring_slot slots[];
+};
+
+struct sja1105_counters_ring {
+	struct sja1105_counters_ring_hdr *hdr;
+	size_t len;
+};
+
+static size_t ring_len(int slot_count)
+{
+	return sizeof(struct sja1105_counters_ring_hdr) +
+	       slot_count * sizeof(struct sja1105_counters_ring_slot);
+}
+
+static int
+ring_map(const char *path, int writable, int slot_count,
+         struct sja1105_counters_ring **ringp)
+{
+	struct sja1105_counters_ring *ring;
+	struct stat st;
+	size_t len;
+	void *addr;
+	int fd, rc;
+
+	ring = calloc(1, sizeof(*ring));
+	if (!ring) {
+		return -ENOMEM;
+	}
+	fd = writable ? open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644) :
+	                open(path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0) {
+		rc = -errno;
+		loge("cannot open %s: %s", path, strerror(errno));
+		goto out_free;
+	}
+	if (writable) {
+		len = ring_len(slot_count);
+		/* Readers of a previous poller must not see stale samples */
+		if (ftruncate(fd, 0) < 0 || ftruncate(fd, len) < 0) {
+			rc = -errno;
+			goto out_close;
+		}
+	} else {
+		if (fstat(fd, &st) < 0) {
+			rc = -errno;
+			goto out_close;
+		}
+		len = st.st_size;
+		if (len < sizeof(struct sja1105_counters_ring_hdr)) {
+			rc = -EINVAL;
+			goto out_close;
+		}
+	}
+	addr = mmap(NULL, len, writable ? PROT_READ | PROT_WRITE : PROT_READ,
+	            MAP_SHARED, fd, 0);
+	if (addr == MAP_FAILED) {
+		rc = -errno;
+		goto out_close;
+	}
+	close(fd);
+	ring->hdr = addr;
+	ring->len = len;
+	*ringp = ring;
+	return 0;
+out_close:
+	close(fd);
+out_free:
+	free(ring);
+	return rc;
+}
+
+int sja1105_counters_ring_create(const char *path, int slot_count,
+                                 struct sja1105_counters_ring **ringp)
+{
+	struct sja1105_counters_ring_hdr *hdr;
+	int rc;
+
+	if (slot_count < 2) {
+		return -EINVAL;
+	}
+	rc = ring_map(path, 1, slot_count, ringp);
+	if (rc < 0) {
+		return rc;
+	}
+	hdr = (*ringp)->hdr;
+	hdr->version    = RING_VERSION;
+	hdr->slot_count = slot_count;
+	hdr->slot_size  = sizeof(struct sja1105_counters_ring_slot);
+	/* Readers check the magic first */
+	__atomic_store_n(&hdr->magic, RING_MAGIC, __ATOMIC_RELEASE);
+	return 0;
+}
+
+int sja1105_counters_ring_open(const char *path,
+                               struct sja1105_counters_ring **ringp)
+{
+	struct sja1105_counters_ring_hdr *hdr;
+	int rc;
+
+	rc = ring_map(path, 0, 0, ringp);
+	if (rc < 0) {
+		return rc;
+	}
+	hdr = (*ringp)->hdr;
+	if (__atomic_load_n(&hdr->magic, __ATOMIC_ACQUIRE) != RING_MAGIC ||
+	    hdr->version != RING_VERSION ||
+	    hdr->slot_size != sizeof(struct sja1105_counters_ring_slot) ||
+	    (*ringp)->len < ring_len(hdr->slot_count)) {
+		loge("%s is not a counters ring of this version", path);
+		sja1105_counters_ring_close(*ringp);
+		return -EINVAL;
+	}
+	return 0;
+}
+
+void sja1105_counters_ring_close(struct sja1105_counters_ring *ring)
+{
+	if (!ring) {
+		return;
+	}
+	munmap(ring->hdr, ring->len);
+	free(ring);
+}
+
+void sja1105_counters_ring_publish(struct sja1105_counters_ring *ring,
+                                   const struct sja1105_counters_sample *sample)
+{
+	struct sja1105_counters_ring_hdr *hdr = ring->hdr;
+	struct sja1105_counters_ring_slot *slot;
+
+	slot = &hdr->slots[sample->seq % hdr->slot_count];
+	__atomic_store_n(&slot->seq, 2 * sample->seq - 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	memcpy(&slot->sample, sample, sizeof(*sample));
+	__atomic_store_n(&slot->seq, 2 * sample->seq, __ATOMIC_RELEASE);
+	__atomic_store_n(&hdr->head, sample->seq, __ATOMIC_RELEASE);
+}
+
+uint64_t sja1105_counters_ring_head(struct sja1105_counters_ring *ring)
+{
+	return __atomic_load_n(&ring->hdr->head, __ATOMIC_ACQUIRE);
+}
+
+/* Copies sample number seq (or the newest one, if seq is 0) out of the
+ * ring. Returns -EAGAIN if it was not published yet, and -ENOENT if it
+ * was already overwritten. */
+int sja1105_counters_ring_read(struct sja1105_counters_ring *ring,
+                               uint64_t seq,
+                               struct sja1105_counters_sample *sample)
+{
+	struct sja1105_counters_ring_hdr *hdr = ring->hdr;
+	struct sja1105_counters_ring_slot *slot;
+	uint64_t head = sja1105_counters_ring_head(ring);
+	uint64_t before, after;
+
+	if (seq == 0) {
+		seq = head;
+	}
+	if (seq == 0 || seq > head) {
+		return -EAGAIN;
+	}
+	slot = &hdr->slots[seq % hdr->slot_count];
+	do {
+		before = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+		if (before != 2 * seq) {
+			/* Being rewritten, or already rewritten,
+			 * with a newer sample */
+			return -ENOENT;
+		}
+		memcpy(sample, &slot->sample, sizeof(*sample));
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		after = __atomic_load_n(&slot->seq, __ATOMIC_RELAXED);
+	} while (before != after);
+	return 0;
+}
@@ -33,6 +33,7 @@
 #include <string.h>
 #include <inttypes.h>
 #include <unistd.h>
+#include <time.h>
 /* These are our include files */
 #include <lib/include/static-config.h>
 #include <lib/include/status.h>
@@ -190,75 +191,142 @@ sja1105pqrs_port_status_qlevel_unpack(void *buf, struct
 	}
 }
 
+/* Diagnostic counter areas, relative to CORE_ADDR. The areas of the
+ * 5 ports are laid out back to back, so each can be read for all
+ * ports at once. The queue levels (P/Q/R/S only) are part of the
+ * high-level 2 area, at word offset 0x4.
+ */
+#define MAC_AREA_ADDR       0x200
+#define HL1_AREA_ADDR       0x400
+#define HL2_AREA_ADDR       0x600
+#define SIZE_MAC_AREA       (0x02 * 4)
+#define SIZE_HL_AREA        (0x10 * 4)
+#define QLEVEL_AREA_OFFSET  (0x04 * 4)
+
+static void
+sja1105_port_status_unpack(uint64_t device_id, uint8_t *mac_buf,
+                           uint8_t *hl1_buf, uint8_t *hl2_buf,
+                           struct sja1105_port_status *status)
+{
+	memset(status, 0, sizeof(*status));
+	sja1105_port_status_mac_unpack(mac_buf, status);
+	sja1105_port_status_hl1_unpack(hl1_buf, status);
+	sja1105_port_status_hl2_unpack(hl2_buf, status);
+	if (IS_PQRS(device_id)) {
+		sja1105pqrs_port_status_qlevel_unpack(hl2_buf +
+		                                      QLEVEL_AREA_OFFSET,
+		                                      status);
+	}
+}
+
+/* Queues the reads of the diagnostic areas of port_count ports,
+ * starting with first_port, into mac_buf, hl1_buf and hl2_buf. */
+static int
+sja1105_port_status_queue(struct sja1105_spi_queue *queue,
+                          int first_port, int port_count,
+                          uint8_t *mac_buf, uint8_t *hl1_buf,
+                          uint8_t *hl2_buf)
+{
+	struct {
+		uint64_t addr;
+		uint8_t *buf;
+		int      size;
+	} areas[] = {
+		{MAC_AREA_ADDR, mac_buf, SIZE_MAC_AREA},
+		{HL1_AREA_ADDR, hl1_buf, SIZE_HL_AREA},
+		{HL2_AREA_ADDR, hl2_buf, SIZE_HL_AREA},
+	};
+	unsigned int i;
+	int rc;
+
+	for (i = 0; i < ARRAY_SIZE(areas); i++) {
+		rc = sja1105_spi_queue_add_long(queue, SPI_READ,
+		                                CORE_ADDR + areas[i].addr +
+		                                first_port * areas[i].size / 4,
+		                                (char*) areas[i].buf,
+		                                port_count * areas[i].size);
+		if (rc < 0) {
+			return rc;
+		}
+	}
+	return 0;
+}
+
 int sja1105_port_status_get(struct sja1105_spi_setup *spi_setup,
                             struct sja1105_port_status *status,
                             int port)
 {
-	const int SIZE_MAC_AREA    = 0x02 * 4;
-	const int SIZE_HL_AREA     = 0x10 * 4;
-	const int SIZE_QLEVEL_AREA =  0x8 * 4; /* 0x4 to 0xB */
-	/* The larger of the 3. Reusing some space. */
-	const int BUF_LEN       = SIZE_HL_AREA;
-	const uint64_t mac_base_addr[]          = {0x200, 0x202, 0x204, 0x206, 0x208};
-	const uint64_t high_level_1_base_addr[] = {0x400, 0x410, 0x420, 0x430, 0x440};
-	const uint64_t high_level_2_base_addr[] = {0x600, 0x610, 0x620, 0x630, 0x640};
-	const uint64_t qlevel_base_addr[]       = {0x604, 0x614, 0x624, 0x634, 0x644};
-	uint8_t packed_buf[BUF_LEN];
-	int rc = 0;
-
-	memset(status, 0, sizeof(*status));
+	uint8_t mac_buf[SIZE_MAC_AREA];
+	uint8_t hl1_buf[SIZE_HL_AREA];
+	uint8_t hl2_buf[SIZE_HL_AREA];
+	struct sja1105_spi_queue queue;
+	int rc;
 
-	/* MAC area */
-	rc = sja1105_spi_send_packed_buf(spi_setup,
-	                                 SPI_READ,
-	                                 CORE_ADDR + mac_base_addr[port],
-	                                 packed_buf,
-	                                 SIZE_MAC_AREA);
+	sja1105_spi_queue_init(&queue);
+	rc = sja1105_port_status_queue(&queue, port, 1, mac_buf,
+	                               hl1_buf, hl2_buf);
 	if (rc < 0) {
-		loge("failed to read mac registers");
 		goto out;
 	}
-	sja1105_port_status_mac_unpack(packed_buf, status);
-
-	/* High-level 1 */
-	rc = sja1105_spi_send_packed_buf(spi_setup,
-	                                 SPI_READ,
-	                                 CORE_ADDR + high_level_1_base_addr[port],
-	                                 packed_buf,
-	                                 SIZE_HL_AREA);
+	rc = sja1105_spi_queue_submit(spi_setup, &queue);
 	if (rc < 0) {
-		loge("failed to read high-level 1 registers");
+		loge("failed to read port %d status registers", port);
 		goto out;
 	}
-	sja1105_port_status_hl1_unpack(packed_buf, status);
+	sja1105_port_status_unpack(spi_setup->device_id, mac_buf,
+	                           hl1_buf, hl2_buf, status);
+out:
+	sja1105_spi_queue_free(&queue);
+	return rc;
+}
 
-	/* High-level 2 */
-	rc = sja1105_spi_send_packed_buf(spi_setup,
-	                                 SPI_READ,
-	                                 CORE_ADDR + high_level_2_base_addr[port],
-	                                 packed_buf,
-	                                 SIZE_HL_AREA);
-	if (rc < 0) {
-		loge("failed to read high-level 2 registers");
-		goto out;
-	}
-	sja1105_port_status_hl2_unpack(packed_buf, status);
+static uint64_t timespec_to_ns(const struct timespec *ts)
+{
+	return (uint64_t) ts->tv_sec * 1000000000ull + ts->tv_nsec;
+}
+
+/* Reads the diagnostic counters of all ports in a single burst (one
+ * ioctl, in practice), so that they are sampled as close together in
+ * time as possible. The timestamp is the middle of the burst.
+ */
+int sja1105_port_status_snapshot_get(struct sja1105_spi_setup *spi_setup,
+                                     struct sja1105_port_status_snapshot *snapshot)
+{
+	const int num_ports = ARRAY_SIZE(snapshot->port);
+	uint8_t mac_buf[num_ports * SIZE_MAC_AREA];
+	uint8_t hl1_buf[num_ports * SIZE_HL_AREA];
+	uint8_t hl2_buf[num_ports * SIZE_HL_AREA];
+	struct sja1105_spi_queue queue;
+	struct timespec before, after;
+	uint64_t mid_ns;
+	int port;
+	int rc;
 
-	if (IS_ET(spi_setup->device_id)) {
-		/* Code below is strictly P/Q/R/S specific. */
+	sja1105_spi_queue_init(&queue);
+	rc = sja1105_port_status_queue(&queue, 0, num_ports, mac_buf,
+	                               hl1_buf, hl2_buf);
+	if (rc < 0) {
 		goto out;
 	}
-	rc = sja1105_spi_send_packed_buf(spi_setup,
-	                                 SPI_READ,
-	                                 CORE_ADDR + qlevel_base_addr[port],
-	                                 packed_buf,
-	                                 SIZE_QLEVEL_AREA);
+	clock_gettime(CLOCK_MONOTONIC, &before);
+	rc = sja1105_spi_queue_submit(spi_setup, &queue);
+	clock_gettime(CLOCK_MONOTONIC, &after);
 	if (rc < 0) {
-		loge("failed to read high-level 1 registers");
+		loge("failed to read port status registers");
 		goto out;
 	}
-	sja1105pqrs_port_status_qlevel_unpack(packed_buf, status);
+	mid_ns = (timespec_to_ns(&before) + timespec_to_ns(&after)) / 2;
+	snapshot->timestamp.tv_sec  = mid_ns / 1000000000ull;
+	snapshot->timestamp.tv_nsec = mid_ns % 1000000000ull;
+	for (port = 0; port < num_ports; port++) {
+		sja1105_port_status_unpack(spi_setup->device_id,
+		                           mac_buf + port * SIZE_MAC_AREA,
+		                           hl1_buf + port * SIZE_HL_AREA,
+		                           hl2_buf + port * SIZE_HL_AREA,
+		                           &snapshot->port[port]);
+	}
 out:
+	sja1105_spi_queue_free(&queue);
 	return rc;
 }
 
@@ -0,0 +1,598 @@
+/******************************************************************************
+ * Copyright (c) 2018, NXP Semiconductors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <sys/stat.h>
+#include "xml/read/external.h"
+#include "xml/write/external.h"
+#include "internal.h"
+
+#define BATCH_MAX_ARGS 64
+
+static void print_usage()
+{
+	printf("Usage: sja1105-tool batch [-f|--file <filename>]\n");
+	printf("Reads commands from <filename>, or from stdin, one per line.\n");
+	printf("Each line is a regular sja1105-tool command without the\n");
+	printf("program name, e.g. \"config modify mac-config[1] speed 2\".\n");
+	printf("Supported commands: config, status, reset, reg, ptp, fdb,\n"
+	       "vlan, policer, link, schedule.\n");
+	printf("Changes to the staging area are saved once, at the end, and\n");
+	printf("only if all commands succeeded, or as soon as a vlan, policer\n");
+	printf("or link command changed the running switch. \"config upload\"\n");
+	printf("and the -f|--flush options are deferred until the end.\n");
+}
+
+/* Splits @line in place into whitespace-separated words.
+ * Words may be quoted with "" or '', and an array value such as
+ * [1 2 3] is kept as a single word. Everything after a # that
+ * starts a word is a comment.
+ * Returns the number of words, or a negative error code.
+ */
+static int batch_split_line(char *line, char **argv, int max_args)
+{
+	char *p = line;
+	char *word;
+	char  delim;
+	int   argc = 0;
+
+	while (1) {
+		while (isspace((unsigned char) *p)) {
+			p++;
+		}
+		if (*p == '\0' || *p == '#') {
+			break;
+		}
+		if (argc == max_args) {
+			loge("too many arguments");
+			return -E2BIG;
+		}
+		if (*p == '"' || *p == '\'') {
+			delim = *p++;
+			word = p;
+			p = strchr(p, delim);
+		} else if (*p == '[') {
+			word = p;
+			p = strchr(p, ']');
+			if (p != NULL) {
+				p++;
+			}
+			delim = 0;
+		} else {
+			word = p;
+			while (*p != '\0' && !isspace((unsigned char) *p)) {
+				p++;
+			}
+			delim = 0;
+		}
+		if (p == NULL) {
+			loge("unterminated %s", delim ? "quote" : "array");
+			return -EINVAL;
+		}
+		argv[argc++] = word;
+		if (delim) {
+			/* Skip past the closing quote */
+			*p++ = '\0';
+		} else if (*p != '\0') {
+			*p++ = '\0';
+		}
+	}
+	return argc;
+}
+
+static void
+batch_get_force_mode(struct batch_state *state, int *argc, char ***argv)
+{
+	if ((*argc) && ((strcmp(*argv[0], "-F") == 0 ||
+	                (strcmp(*argv[0], "--force") == 0)))) {
+		state->force = 1;
+		(*argc)--; (*argv)++;
+	}
+}
+
+static void
+batch_get_flush_mode(struct sja1105_spi_setup *spi_setup,
+                     struct batch_state *state, int *argc, char ***argv)
+{
+	if (spi_setup->flush) {
+		/* auto_flush in sja1105.conf */
+		state->flush = 1;
+	}
+	batch_get_force_mode(state, argc, argv);
+	if ((*argc) && ((strcmp(*argv[0], "-f") == 0 ||
+	                (strcmp(*argv[0], "--flush") == 0)))) {
+		state->flush = 1;
+		(*argc)--; (*argv)++;
+	}
+	batch_get_force_mode(state, argc, argv);
+}
+
+/* Remembers which version of the staging area file
+ * the in-memory copy corresponds to */
+static void
+batch_stat_update(struct sja1105_spi_setup *spi_setup,
+                  struct batch_state *state)
+{
+	if (stat(spi_setup->staging_area, &state->file_stat) < 0) {
+		memset(&state->file_stat, 0, sizeof(state->file_stat));
+	}
+}
+
+static int
+batch_file_changed(struct sja1105_spi_setup *spi_setup,
+                   struct batch_state *state)
+{
+	struct stat st;
+
+	if (stat(spi_setup->staging_area, &st) < 0) {
+		return 1;
+	}
+	return st.st_ino != state->file_stat.st_ino ||
+	       st.st_size != state->file_stat.st_size ||
+	       st.st_mtim.tv_sec != state->file_stat.st_mtim.tv_sec ||
+	       st.st_mtim.tv_nsec != state->file_stat.st_mtim.tv_nsec;
+}
+
+static int
+batch_staging_area_get(struct sja1105_spi_setup *spi_setup,
+                       struct batch_state *state)
+{
+	int rc;
+
+	if (state->loaded) {
+		/* Only a long-lived state (sja1105d) can see the
+		 * file being rewritten by someone else */
+		if (state->dirty || !batch_file_changed(spi_setup, state)) {
+			return 0;
+		}
+		logv("staging area changed on disk, reloading");
+	}
+	rc = staging_area_load(spi_setup->staging_area, &state->staging_area);
+	if (rc < 0) {
+		state->loaded = 0;
+		return rc;
+	}
+	batch_stat_update(spi_setup, state);
+	state->loaded = 1;
+	return 0;
+}
+
+static int
+batch_hexdump(struct batch_state *state)
+{
+	struct sja1105_static_config *config;
+	char *buf;
+	int   rc;
+
+	config = &state->staging_area.static_config;
+	buf = malloc(sja1105_static_config_get_length(config));
+	if (!buf) {
+		loge("malloc failed");
+		return -ENOMEM;
+	}
+	rc = sja1105_static_config_pack(buf, config);
+	if (rc < 0) {
+		goto out;
+	}
+	printf("Static configuration:\n");
+	rc = sja1105_static_config_hexdump(buf);
+	if (rc < 0) {
+		loge("error while interpreting config");
+		goto out;
+	}
+	logi("static config: dumped %d bytes", rc);
+	rc = 0;
+out:
+	free(buf);
+	return rc;
+}
+
+/* Same commands as config_parse_args, but applied
+ * to the staging area held in @state */
+static int
+batch_config(struct sja1105_spi_setup *spi_setup, struct batch_state *state,
+             int argc, char **argv)
+{
+	const char *options[] = {
+		"load",
+		"save",
+		"default",
+		"modify",
+		"new",
+		"upload",
+		"show",
+		"hexdump",
+		"l2-place",
+		"vlan",
+	};
+	struct sja1105_static_config *config;
+	int match;
+	int rc = 0;
+
+	config = &state->staging_area.static_config;
+
+	if (argc < 1) {
+		goto parse_error;
+	}
+	match = get_match(argv[0], options, ARRAY_SIZE(options));
+	argc--; argv++;
+	if (match < 0) {
+		goto parse_error;
+	} else if (strcmp(options[match], "load") == 0) {
+		batch_get_flush_mode(spi_setup, state, &argc, &argv);
+		if (argc != 1) {
+			goto parse_error;
+		}
+		rc = sja1105_staging_area_from_xml(argv[0], &state->staging_area);
+		if (rc < 0) {
+			goto invalid_xml_error;
+		}
+		state->loaded = 1;
+		state->dirty = 1;
+	} else if (strcmp(options[match], "save") == 0) {
+		if (argc != 1) {
+			goto parse_error;
+		}
+		rc = batch_staging_area_get(spi_setup, state);
+		if (rc < 0) {
+			goto propagated_error;
+		}
+		rc = sja1105_staging_area_to_xml(argv[0], &state->staging_area);
+		if (rc < 0) {
+			goto invalid_xml_error;
+		}
+	} else if (strcmp(options[match], "default") == 0) {
+		batch_get_flush_mode(spi_setup, state, &argc, &argv);
+		if (argc != 1 || matches(argv[0], "ls1021atsn") != 0) {
+			loge("Unrecognized default config");
+			goto parse_error;
+		}
+		rc = sja1105_default_staging_area(&state->staging_area,
+		                                  LS1021ATSN);
+		if (rc < 0) {
+			goto invalid_staging_area_error;
+		}
+		state->loaded = 1;
+		state->dirty = 1;
+	} else if (strcmp(options[match], "modify") == 0) {
+		batch_get_flush_mode(spi_setup, state, &argc, &argv);
+		rc = batch_staging_area_get(spi_setup, state);
+		if (rc < 0) {
+			goto propagated_error;
+		}
+		rc = staging_area_modify_parse(&state->staging_area,
+		                               &argc, &argv);
+		if (rc < 0) {
+			goto propagated_error;
+		}
+		state->dirty = 1;
+	} else if (strcmp(options[match], "new") == 0) {
+		sja1105_static_config_free(config);
+		if (argc == 2 && ((matches(argv[0], "-d") == 0) ||
+		                  (matches(argv[0], "--device-id") == 0))) {
+			rc = reliable_uint64_from_string(&config->device_id,
+			                                 argv[1], NULL);
+			if (rc < 0) {
+				loge("Invalid device id provided: %s", argv[1]);
+				goto parse_error;
+			}
+		} else if (argc == 0) {
+			config->device_id = SJA1105T_DEVICE_ID;
+		} else {
+			goto parse_error;
+		}
+		state->loaded = 1;
+		state->dirty = 1;
+	} else if (strcmp(options[match], "upload") == 0) {
+		batch_get_force_mode(state, &argc, &argv);
+		if (argc != 0) {
+			goto parse_error;
+		}
+		rc = batch_staging_area_get(spi_setup, state);
+		if (rc < 0) {
+			goto propagated_error;
+		}
+		state->flush = 1;
+	} else if (strcmp(options[match], "show") == 0) {
+		if (argc != 0 && argc != 1) {
+			goto parse_error;
+		}
+		rc = batch_staging_area_get(spi_setup, state);
+		if (rc < 0) {
+			goto propagated_error;
+		}
+		rc = sja1105_staging_area_show(&state->staging_area,
+		                               argc ? argv[0] : NULL);
+		if (rc < 0) {
+			goto invalid_staging_area_error;
+		}
+	} else if (strcmp(options[match], "hexdump") == 0) {
+		if (argc != 0) {
+			goto parse_error;
+		}
+		rc = batch_staging_area_get(spi_setup, state);
+		if (rc < 0) {
+			goto propagated_error;
+		}
+		rc = batch_hexdump(state);
+		if (rc < 0) {
+			goto invalid_staging_area_error;
+		}
+	} else if (strcmp(options[match], "l2-place") == 0) {
+		batch_get_flush_mode(spi_setup, state, &argc, &argv);
+		if (argc != 0) {
+			goto parse_error;
+		}
+		rc = batch_staging_area_get(spi_setup, state);
+		if (rc < 0) {
+			goto propagated_error;
+		}
+		rc = config_l2_place(config);
+		if (rc < 0) {
+			goto invalid_staging_area_error;
+		}
+		state->dirty = 1;
+	} else if (strcmp(options[match], "vlan") == 0) {
+		batch_get_flush_mode(spi_setup, state, &argc, &argv);
+		rc = batch_staging_area_get(spi_setup, state);
+		if (rc < 0) {
+			goto propagated_error;
+		}
+		rc = config_vlan(config, argc, argv);
+		if (rc == -EINVAL) {
+			goto parse_error;
+		} else if (rc < 0) {
+			goto invalid_staging_area_error;
+		}
+		state->dirty = 1;
+	}
+	return SJA1105_ERR_OK;
+invalid_staging_area_error:
+	sja1105_err_remap(rc, SJA1105_ERR_STAGING_AREA_INVALID);
+	return rc;
+invalid_xml_error:
+	sja1105_err_remap(rc, SJA1105_ERR_INVALID_XML);
+	return rc;
+parse_error:
+	sja1105_err_remap(rc, SJA1105_ERR_CMDLINE_PARSE);
+	return rc;
+propagated_error:
+	return rc;
+}
+
+static int
+batch_save(struct sja1105_spi_setup *spi_setup, struct batch_state *state)
+{
+	int rc;
+
+	rc = staging_area_save(spi_setup->staging_area, &state->staging_area);
+	if (rc < 0) {
+		sja1105_err_remap(rc, SJA1105_ERR_FILESYSTEM);
+		return rc;
+	}
+	batch_stat_update(spi_setup, state);
+	state->dirty = 0;
+	return 0;
+}
+
+/* The vlan, policer and link commands change the running switch right away,
+ * and the staging area held in @state along with it. schedule only changes
+ * the staging area, the same way.
+ * Once the switch was changed, the file must follow at once, as with
+ * staging_area_live_run: a later command failing must not leave it behind.
+ */
+static int
+batch_live(struct sja1105_spi_setup *spi_setup, struct batch_state *state,
+           int (*run)(struct sja1105_spi_setup*,
+                      struct sja1105_static_config*,
+                      int argc, char **argv),
+           int touches_switch, int argc, char **argv)
+{
+	int save_rc;
+	int rc;
+
+	rc = batch_staging_area_get(spi_setup, state);
+	if (rc < 0) {
+		return rc;
+	}
+	rc = run(spi_setup, &state->staging_area.static_config, argc, argv);
+	if (rc < 0 &&
+	    rc != -SJA1105_ERR_HW_NOT_RESPONDING_STAGING_AREA_DIRTY) {
+		return rc;
+	}
+	state->dirty = 1;
+	if (touches_switch) {
+		save_rc = batch_save(spi_setup, state);
+		if (save_rc < 0) {
+			rc = save_rc;
+		}
+	}
+	return rc;
+}
+
+/* Runs a single command (without the program name) on @state */
+int batch_run(struct sja1105_spi_setup *spi_setup, struct batch_state *state,
+              int argc, char **argv)
+{
+	const char *options[] = {
+		"configure",
+		"status",
+		"reset",
+		"reg",
+		"ptp",
+		"fdb",
+		"vlan",
+		"policer",
+		"link",
+		"schedule",
+	};
+	int (*next_parse_args[])(struct sja1105_spi_setup*, int, char**) = {
+		NULL,
+		status_parse_args,
+		rgu_parse_args,
+		reg_parse_args,
+		ptp_parse_args,
+		fdb_parse_args,
+		NULL,
+		NULL,
+		NULL,
+		NULL,
+	};
+	int (*live_run[])(struct sja1105_spi_setup*,
+	                  struct sja1105_static_config*, int, char**) = {
+		NULL,
+		NULL,
+		NULL,
+		NULL,
+		NULL,
+		NULL,
+		vlan_run,
+		policer_run,
+		link_run,
+		schedule_run,
+	};
+	int rc;
+
+	rc = get_match(argv[0], options, ARRAY_SIZE(options));
+	if (rc < 0) {
+		sja1105_err_remap(rc, SJA1105_ERR_CMDLINE_PARSE);
+		return rc;
+	}
+	argc--; argv++;
+	if (live_run[rc] != NULL) {
+		return batch_live(spi_setup, state, live_run[rc],
+		                  live_run[rc] != schedule_run, argc, argv);
+	}
+	if (next_parse_args[rc] == NULL) {
+		return batch_config(spi_setup, state, argc, argv);
+	}
+	return next_parse_args[rc](spi_setup, argc, argv);
+}
+
+/* Saves and uploads the staging area held in @state, if needed */
+int batch_commit(struct sja1105_spi_setup *spi_setup, struct batch_state *state)
+{
+	int force = state->force;
+	int rc = 0;
+
+	state->force = 0;
+	if (state->dirty) {
+		rc = batch_save(spi_setup, state);
+		if (rc < 0) {
+			goto propagated_error;
+		}
+	}
+	if (state->flush) {
+		state->flush = 0;
+		rc = sja1105_spi_configure(spi_setup);
+		if (rc < 0) {
+			loge("sja1105_spi_configure failed");
+			goto hardware_not_responding_error;
+		}
+		/* spi_setup outlives the batch when running in sja1105d */
+		spi_setup->force = force;
+		rc = staging_area_flush(spi_setup, &state->staging_area);
+		spi_setup->force = 0;
+		if (rc < 0) {
+			goto propagated_error;
+		}
+	}
+	return rc;
+hardware_not_responding_error:
+	sja1105_err_remap(rc, SJA1105_ERR_HW_NOT_RESPONDING);
+	return rc;
+propagated_error:
+	return rc;
+}
+
+int batch_parse_args(struct sja1105_spi_setup *spi_setup, int argc, char **argv)
+{
+	struct batch_state state = {0};
+	char  *cmd_argv[BATCH_MAX_ARGS + 1];
+	int    cmd_argc;
+	char  *filename = NULL;
+	char  *line = NULL;
+	size_t line_size = 0;
+	int    line_no = 0;
+	FILE  *f = stdin;
+	int    rc = 0;
+
+	if (argc == 1 && matches(argv[0], "help") == 0) {
+		print_usage();
+		return SJA1105_ERR_OK;
+	} else if (argc == 2 && ((strcmp(argv[0], "-f") == 0) ||
+	                         (strcmp(argv[0], "--file") == 0))) {
+		filename = argv[1];
+	} else if (argc != 0) {
+		print_usage();
+		rc = -SJA1105_ERR_CMDLINE_PARSE;
+		goto out;
+	}
+	if (filename != NULL) {
+		f = fopen(filename, "r");
+		if (f == NULL) {
+			loge("could not open %s", filename);
+			rc = -SJA1105_ERR_FILESYSTEM;
+			goto out;
+		}
+	}
+	while (getline(&line, &line_size, f) >= 0) {
+		line_no++;
+		cmd_argc = batch_split_line(line, cmd_argv, BATCH_MAX_ARGS);
+		if (cmd_argc == 0) {
+			continue;
+		}
+		/* Like the argv of main, nothing stale after the last one */
+		cmd_argv[max(cmd_argc, 0)] = NULL;
+		if (cmd_argc < 0) {
+			rc = -SJA1105_ERR_CMDLINE_PARSE;
+		} else {
+			rc = batch_run(spi_setup, &state, cmd_argc, cmd_argv);
+		}
+		if (rc < 0) {
+			loge("%s:%d: command failed, "
+			     "pending changes were not saved",
+			     filename ? filename : "stdin", line_no);
+			goto out_free;
+		}
+	}
+	rc = batch_commit(spi_setup, &state);
+out_free:
+	free(line);
+	sja1105_static_config_free(&state.staging_area.static_config);
+	if (filename != NULL) {
+		fclose(f);
+	}
+out:
+	return rc;
+}
@@ -70,6 +70,24 @@ out:
 	return rc;
 }
 
+/* The new entries of a grown table start out zeroed */
+static int entry_count_modify(struct sja1105_static_config *config,
+                              int blk_id, char *field_val)
+{
+	uint64_t count;
+	int rc;
+
+	rc = reliable_uint64_from_string(&count, field_val, NULL);
+	if (rc < 0) {
+		return rc;
+	}
+	if (count > INT32_MAX) {
+		loge("Invalid entry count %s", field_val);
+		return -ERANGE;
+	}
+	return sja1105_static_config_resize(config, blk_id, count);
+}
+
 static int schedule_table_entry_modify(
 		struct sja1105_static_config *config,
 		int    entry_index,
@@ -101,12 +119,10 @@ static int schedule_table_entry_modify(
 		&config->schedule[entry_index].delta,
 	};
 	int entry_field_counts[] = {1, 1, 1, 1, 1, 1, 1, 1, 1, 1,};
-	uint64_t tmp;
 	int rc;
 
 	if (matches(field_name, "entry-count") == 0) {
-		rc = reliable_uint64_from_string(&tmp, field_val, NULL);
-		config->schedule_count = tmp;
+		rc = entry_count_modify(config, BLKID_SCHEDULE_TABLE, field_val);
 		goto out;
 	}
 	rc = get_match(field_name, options, ARRAY_SIZE(options));
@@ -140,12 +156,10 @@ static int schedule_entry_points_table_entry_modify(
 		&config->schedule_entry_points[entry_index].address,
 	};
 	int entry_field_counts[] = {1, 1, 1,};
-	uint64_t tmp;
 	int rc;
 
 	if (matches(field_name, "entry-count") == 0) {
-		rc = reliable_uint64_from_string(&tmp, field_val, NULL);
-		config->schedule_entry_points_count = tmp;
+		rc = entry_count_modify(config, BLKID_SCHEDULE_ENTRY_POINTS_TABLE, field_val);
 		goto out;
 	}
 	rc = get_match(field_name, options, ARRAY_SIZE(options));
@@ -201,12 +215,10 @@ static int l2_lookup_table_entry_modify(
 		&config->l2_lookup[entry_index].index,
 	};
 	int entry_field_counts[] = {1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,};
-	uint64_t tmp;
 	int rc;
 
 	if (matches(field_name, "entry-count") == 0) {
-		rc = reliable_uint64_from_string(&tmp, field_val, NULL);
-		config->l2_lookup_count = tmp;
+		rc = entry_count_modify(config, BLKID_L2_LOOKUP_TABLE, field_val);
 		goto out;
 	}
 	rc = get_match(field_name, options, ARRAY_SIZE(options));
@@ -244,12 +256,10 @@ static int l2_policing_table_entry_modify(
 		&config->l2_policing[entry_index].partition,
 	};
 	int entry_field_counts[] = {1, 1, 1, 1, 1,};
-	uint64_t tmp;
 	int rc;
 
 	if (matches(field_name, "entry-count") == 0) {
-		rc = reliable_uint64_from_string(&tmp, field_val, NULL);
-		config->l2_policing_count = tmp;
+		rc = entry_count_modify(config, BLKID_L2_POLICING_TABLE, field_val);
 		goto out;
 	}
 
@@ -290,12 +300,10 @@ static int vlan_lookup_table_entry_modify(
 		&config->vlan_lookup[entry_index].vlanid,
 	};
 	int entry_field_counts[] = {1, 1, 1, 1, 1, 1,};
-	uint64_t tmp;
 	int rc;
 
 	if (matches(field_name, "entry-count") == 0) {
-		rc = reliable_uint64_from_string(&tmp, field_val, NULL);
-		config->vlan_lookup_count = tmp;
+		rc = entry_count_modify(config, BLKID_VLAN_LOOKUP_TABLE, field_val);
 		goto out;
 	}
 
@@ -332,12 +340,10 @@ static int l2_fw_table_entry_modify(
 		config->l2_forwarding[entry_index].vlan_pmap,
 	};
 	int entry_field_counts[] = {1, 1, 1, 8, 1,};
-	uint64_t tmp;
 	int rc;
 
 	if (matches(field_name, "entry-count") == 0) {
-		rc = reliable_uint64_from_string(&tmp, field_val, NULL);
-		config->l2_forwarding_count = tmp;
+		rc = entry_count_modify(config, BLKID_L2_FORWARDING_TABLE, field_val);
 		goto out;
 	}
 
@@ -418,12 +424,10 @@ static int mac_config_table_entry_modify(
 		&config->mac_config[entry_index].ingmirrdei,
 	};
 	int entry_field_counts[] = {8, 8, 8, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,};
-	uint64_t tmp;
 	int rc;
 
 	if (matches(field_name, "entry-count") == 0) {
-		rc = reliable_uint64_from_string(&tmp, field_val, NULL);
-		config->mac_config_count = tmp;
+		rc = entry_count_modify(config, BLKID_MAC_CONFIG_TABLE, field_val);
 		goto out;
 	}
 	rc = get_match(field_name, options, ARRAY_SIZE(options));
@@ -453,12 +457,10 @@ static int schedule_params_table_entry_modify(
 		config->schedule_params[entry_index].subscheind,
 	};
 	int entry_field_counts[] = {8,};
-	uint64_t tmp;
 	int rc;
 
 	if (matches(field_name, "entry-count") == 0) {
-		rc = reliable_uint64_from_string(&tmp, field_val, NULL);
-		config->schedule_params_count = tmp;
+		rc = entry_count_modify(config, BLKID_SCHEDULE_PARAMS_TABLE, field_val);
 		goto out;
 	}
 	rc = get_match(field_name, options, ARRAY_SIZE(options));
@@ -490,12 +492,10 @@ static int schedule_entry_points_params_table_entry_modify(
 		&config->schedule_entry_points_params[entry_index].actsubsch,
 	};
 	int entry_field_counts[] = {1, 1,};
-	uint64_t tmp;
 	int rc;
 
 	if (matches(field_name, "entry-count") == 0) {
-		rc = reliable_uint64_from_string(&tmp, field_val, NULL);
-		config->schedule_entry_points_params_count = tmp;
+		rc = entry_count_modify(config, BLKID_SCHEDULE_ENTRY_POINTS_PARAMS_TABLE, field_val);
 		goto out;
 	}
 	rc = get_match(field_name, options, ARRAY_SIZE(options));
@@ -553,12 +553,10 @@ static int l2_lookup_params_table_entry_modify(
 		&config->l2_lookup_params[entry_index].learn_once,
 	};
 	int entry_field_counts[] = {1, 1, 1, 5, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,};
-	uint64_t tmp;
 	int rc;
 
 	if (matches(field_name, "entry-count") == 0) {
-		rc = reliable_uint64_from_string(&tmp, field_val, NULL);
-		config->l2_lookup_params_count = tmp;
+		rc = entry_count_modify(config, BLKID_L2_LOOKUP_PARAMS_TABLE, field_val);
 		goto out;
 	}
 	rc = get_match(field_name, options, ARRAY_SIZE(options));
@@ -590,12 +588,10 @@ static int l2_fw_params_table_entry_modify(
 		config->l2_forwarding_params[entry_index].part_spc,
 	};
 	int entry_field_counts[] = {1, 8,};
-	uint64_t tmp;
 	int rc;
 
 	if (matches(field_name, "entry-count") == 0) {
-		rc = reliable_uint64_from_string(&tmp, field_val, NULL);
-		config->l2_forwarding_params_count = tmp;
+		rc = entry_count_modify(config, BLKID_L2_FORWARDING_PARAMS_TABLE, field_val);
 		goto out;
 	}
 	rc = get_match(field_name, options, ARRAY_SIZE(options));
@@ -673,12 +669,10 @@ static int general_params_table_entry_modify(
 		&config->general_params[entry_index].replay_port,
 	};
 	int entry_field_counts[] = {1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,};
-	uint64_t tmp;
 	int rc;
 
 	if (matches(field_name, "entry-count") == 0) {
-		rc = reliable_uint64_from_string(&tmp, field_val, NULL);
-		config->general_params_count = tmp;
+		rc = entry_count_modify(config, BLKID_GENERAL_PARAMS_TABLE, field_val);
 		goto out;
 	}
 	rc = get_match(field_name, options, ARRAY_SIZE(options));
@@ -710,12 +704,10 @@ static int xmii_table_entry_modify(
 		config->xmii_params[entry_index].xmii_mode,
 	};
 	int entry_field_counts[] = {5, 5,};
-	uint64_t tmp;
 	int rc;
 
 	if (matches(field_name, "entry-count") == 0) {
-		rc = reliable_uint64_from_string(&tmp, field_val, NULL);
-		config->xmii_params_count = tmp;
+		rc = entry_count_modify(config, BLKID_XMII_MODE_PARAMS_TABLE, field_val);
 		goto out;
 	}
 	rc = get_match(field_name, options, ARRAY_SIZE(options));
@@ -759,12 +751,10 @@ static int sgmii_table_entry_modify(
 		&config->sgmii[entry_index].basic_control,
 	};
 	int entry_field_counts[] = {1, 1, 1, 1, 1, 1, 1, 1,};
-	uint64_t tmp;
 	int rc;
 
 	if (matches(field_name, "entry-count") == 0) {
-		rc = reliable_uint64_from_string(&tmp, field_val, NULL);
-		config->sgmii_count = tmp;
+		rc = entry_count_modify(config, BLKID_SGMII_TABLE, field_val);
 		goto out;
 	}
 	rc = get_match(field_name, options, ARRAY_SIZE(options));
@@ -810,12 +800,10 @@ static int vl_lookup_table_entry_modify(
 		&config->vl_lookup[entry_index].vlid,
 	};
 	int entry_field_counts[] = {1, 1, 1, 1, 1, 1, 1, 1, 1,};
-	uint64_t tmp;
 	int rc;
 
 	if (matches(field_name, "entry-count") == 0) {
-		rc = reliable_uint64_from_string(&tmp, field_val, NULL);
-		config->vl_lookup_count = tmp;
+		rc = entry_count_modify(config, BLKID_VL_LOOKUP_TABLE, field_val);
 		goto out;
 	}
 	rc = get_match(field_name, options, ARRAY_SIZE(options));
@@ -853,12 +841,10 @@ static int vl_policing_table_entry_modify(
 		&config->vl_policing[entry_index].jitter,
 	};
 	int entry_field_counts[] = {1, 1, 1, 1, 1,};
-	uint64_t tmp;
 	int rc;
 
 	if (matches(field_name, "entry-count") == 0) {
-		rc = reliable_uint64_from_string(&tmp, field_val, NULL);
-		config->vl_policing_count = tmp;
+		rc = entry_count_modify(config, BLKID_VL_POLICING_TABLE, field_val);
 		goto out;
 	}
 	rc = get_match(field_name, options, ARRAY_SIZE(options));
@@ -894,12 +880,10 @@ static int vl_fw_table_entry_modify(
 		&config->vl_forwarding[entry_index].destports,
 	};
 	int entry_field_counts[] = {1, 1, 1, 1,};
-	uint64_t tmp;
 	int rc;
 
 	if (matches(field_name, "entry-count") == 0) {
-		rc = reliable_uint64_from_string(&tmp, field_val, NULL);
-		config->vl_forwarding_count = tmp;
+		rc = entry_count_modify(config, BLKID_VL_FORWARDING_TABLE, field_val);
 		goto out;
 	}
 	rc = get_match(field_name, options, ARRAY_SIZE(options));
@@ -945,12 +929,10 @@ static int avb_params_table_entry_modify(
 		&config->avb_params[entry_index].srcmeta,
 	};
 	int entry_field_counts[] = {1, 1, 1, 1,};
-	uint64_t tmp;
 	int rc;
 
 	if (matches(field_name, "entry-count") == 0) {
-		rc = reliable_uint64_from_string(&tmp, field_val, NULL);
-		config->avb_params_count = tmp;
+		rc = entry_count_modify(config, BLKID_AVB_PARAMS_TABLE, field_val);
 		goto out;
 	}
 	rc = get_match(field_name, options, ARRAY_SIZE(options));
@@ -992,12 +974,10 @@ vl_fw_params_table_entry_modify(struct sja1105_static_config *config,
 		&config->vl_forwarding_params[entry_index].debugen,
 	};
 	int entry_field_counts[] = {8, 1,};
-	uint64_t tmp;
 	int rc;
 
 	if (matches(field_name, "entry-count") == 0) {
-		rc = reliable_uint64_from_string(&tmp, field_val, NULL);
-		config->vl_forwarding_params_count = tmp;
+		rc = entry_count_modify(config, BLKID_VL_FORWARDING_PARAMS_TABLE, field_val);
 		goto out;
 	}
 	rc = get_match(field_name, options, ARRAY_SIZE(options));
@@ -1014,73 +994,93 @@ out:
 	return rc;
 }
 
-int
-staging_area_modify(struct sja1105_staging_area *staging_area,
-                    char *table_name,
-                    char *field_name,
-                    char *field_val)
-{
-	const char *static_config_options[] = {
-		"schedule-table",
-		"schedule-entry-points-table",
-		"vl-lookup-table",
-		"vl-policing-table",
-		"vl-forwarding-table",
-		"l2-address-lookup-table",
-		"l2-policing-table",
-		"vlan-lookup-table",
-		"l2-forwarding-table",
-		"mac-configuration-table",
-		"schedule-parameters-table",
-		"schedule-entry-points-parameters-table",
-		"vl-forwarding-parameters-table",
-		"l2-address-lookup-parameters-table",
-		"l2-forwarding-parameters-table",
-		"clock-synchronization-parameters-table",
-		"avb-parameters-table",
-		"general-parameters-table",
-		"retagging-table",
-		"xmii-mode-parameters-table",
-		"sgmii-table",
-	};
-	int (*next_static_table_modify[])(struct sja1105_static_config*, \
-	                                  int, char*, char*) = {
-		schedule_table_entry_modify,
-		schedule_entry_points_table_entry_modify,
-		vl_lookup_table_entry_modify,
-		vl_policing_table_entry_modify,
-		vl_fw_table_entry_modify,
-		l2_lookup_table_entry_modify,
-		l2_policing_table_entry_modify,
-		vlan_lookup_table_entry_modify,
-		l2_fw_table_entry_modify,
-		mac_config_table_entry_modify,
-		schedule_params_table_entry_modify,
-		schedule_entry_points_params_table_entry_modify,
-		vl_fw_params_table_entry_modify,
-		l2_lookup_params_table_entry_modify,
-		l2_fw_params_table_entry_modify,
-		clock_sync_params_table_entry_modify,
-		avb_params_table_entry_modify,
-		general_params_table_entry_modify,
-		retagging_table_entry_modify,
-		xmii_table_entry_modify,
-		sgmii_table_entry_modify,
-	};
-	struct   sja1105_static_config *static_config;
-	uint64_t entry_index;
-	char    *index_ptr;
-	int      rc;
+static const char *static_config_options[] = {
+	"schedule-table",
+	"schedule-entry-points-table",
+	"vl-lookup-table",
+	"vl-policing-table",
+	"vl-forwarding-table",
+	"l2-address-lookup-table",
+	"l2-policing-table",
+	"vlan-lookup-table",
+	"l2-forwarding-table",
+	"mac-configuration-table",
+	"schedule-parameters-table",
+	"schedule-entry-points-parameters-table",
+	"vl-forwarding-parameters-table",
+	"l2-address-lookup-parameters-table",
+	"l2-forwarding-parameters-table",
+	"clock-synchronization-parameters-table",
+	"avb-parameters-table",
+	"general-parameters-table",
+	"retagging-table",
+	"xmii-mode-parameters-table",
+	"sgmii-table",
+};
 
-	static_config = &staging_area->static_config;
+static int (*next_static_table_modify[])(struct sja1105_static_config*,
+                                         int, char*, char*) = {
+	schedule_table_entry_modify,
+	schedule_entry_points_table_entry_modify,
+	vl_lookup_table_entry_modify,
+	vl_policing_table_entry_modify,
+	vl_fw_table_entry_modify,
+	l2_lookup_table_entry_modify,
+	l2_policing_table_entry_modify,
+	vlan_lookup_table_entry_modify,
+	l2_fw_table_entry_modify,
+	mac_config_table_entry_modify,
+	schedule_params_table_entry_modify,
+	schedule_entry_points_params_table_entry_modify,
+	vl_fw_params_table_entry_modify,
+	l2_lookup_params_table_entry_modify,
+	l2_fw_params_table_entry_modify,
+	clock_sync_params_table_entry_modify,
+	avb_params_table_entry_modify,
+	general_params_table_entry_modify,
+	retagging_table_entry_modify,
+	xmii_table_entry_modify,
+	sgmii_table_entry_modify,
+};
+
+static const int static_config_blk_ids[] = {
+	BLKID_SCHEDULE_TABLE,
+	BLKID_SCHEDULE_ENTRY_POINTS_TABLE,
+	BLKID_VL_LOOKUP_TABLE,
+	BLKID_VL_POLICING_TABLE,
+	BLKID_VL_FORWARDING_TABLE,
+	BLKID_L2_LOOKUP_TABLE,
+	BLKID_L2_POLICING_TABLE,
+	BLKID_VLAN_LOOKUP_TABLE,
+	BLKID_L2_FORWARDING_TABLE,
+	BLKID_MAC_CONFIG_TABLE,
+	BLKID_SCHEDULE_PARAMS_TABLE,
+	BLKID_SCHEDULE_ENTRY_POINTS_PARAMS_TABLE,
+	BLKID_VL_FORWARDING_PARAMS_TABLE,
+	BLKID_L2_LOOKUP_PARAMS_TABLE,
+	BLKID_L2_FORWARDING_PARAMS_TABLE,
+	BLKID_CLK_SYNC_PARAMS_TABLE,
+	BLKID_AVB_PARAMS_TABLE,
+	BLKID_GENERAL_PARAMS_TABLE,
+	BLKID_RETAGGING_TABLE,
+	BLKID_XMII_MODE_PARAMS_TABLE,
+	BLKID_SGMII_TABLE,
+};
+
+/* Resolves "<table>[<index>]" to a position in the arrays above */
+static int
+staging_area_modify_lookup(char *table_name, int *table, uint64_t *entry_index)
+{
+	char *index_ptr;
+	int   rc;
 
 	index_ptr = strchr(table_name, '[');
 	if (index_ptr == NULL) {
-		entry_index = 0;
+		*entry_index = 0;
 	} else {
 		/* Little trick to reuse the code, since the index
 		 * is surrounded by [ ], same as an array would be */
-		rc = read_array(index_ptr, &entry_index, 1);
+		rc = read_array(index_ptr, entry_index, 1);
 		if (rc < 0) {
 			goto out;
 		}
@@ -1089,11 +1089,44 @@ staging_area_modify(struct sja1105_staging_area *staging_area,
 	}
 	rc = get_match(table_name, static_config_options,
 	               ARRAY_SIZE(static_config_options));
+	if (index_ptr != NULL) {
+		*index_ptr = '[';
+	}
+	if (rc < 0) {
+		goto out;
+	}
+	*table = rc;
+out:
+	return rc;
+}
+
+int
+staging_area_modify(struct sja1105_staging_area *staging_area,
+                    char *table_name,
+                    char *field_name,
+                    char *field_val)
+{
+	/* Only used to print the fields of a table. The modify
+	 * functions take the address of table entries, which needs
+	 * a config to look the (missing) tables up in. */
+	static struct sja1105_static_config empty_config;
+	struct   sja1105_static_config *static_config;
+	uint64_t entry_index;
+	int      table;
+	int      rc;
+
+	if (staging_area != NULL) {
+		static_config = &staging_area->static_config;
+	} else {
+		static_config = &empty_config;
+	}
+
+	rc = staging_area_modify_lookup(table_name, &table, &entry_index);
 	if (rc < 0) {
 		goto out;
 	}
 	logv("Table %s, entry %" PRIu64", field %s, value %s",
-	     static_config_options[rc], entry_index, field_name, field_val);
+	     static_config_options[table], entry_index, field_name, field_val);
 	if (field_name == NULL) {
 		rc = -EINVAL;
 		print_usage("sja1105-tool");
@@ -1103,8 +1136,12 @@ staging_area_modify(struct sja1105_staging_area *staging_area,
 		printf("Please supply a value for field %s!\n", field_name);
 		goto out;
 	}
-	rc = next_static_table_modify[rc](static_config, entry_index,
-	                                  field_name, field_val);
+	rc = next_static_table_modify[table](static_config, entry_index,
+	                                     field_name, field_val);
+	if (staging_area != NULL) {
+		sja1105_static_config_mark_dirty(static_config,
+		                                 static_config_blk_ids[table]);
+	}
 	if (rc < 0) {
 		loge("modify failed!");
 		goto out;
@@ -1113,6 +1150,43 @@ out:
 	return rc;
 }
 
+/* Same as staging_area_modify, but works on the packed staging area file
+ * instead of an unpacked copy. Returns -EAGAIN if this is not possible,
+ * e.g. when changing the entry count of a table, or the VID of a VLAN
+ * Lookup entry (the table must be repacked to stay in VID order).
+ */
+int
+staging_area_modify_in_place(const char *staging_area_file,
+                             char *table_name,
+                             char *field_name,
+                             char *field_val)
+{
+	uint64_t entry_index;
+	int      table;
+	int      rc;
+
+	rc = staging_area_modify_lookup(table_name, &table, &entry_index);
+	if (rc < 0) {
+		return rc;
+	}
+	if (matches(field_name, "entry-count") == 0) {
+		return -EAGAIN;
+	}
+	if (static_config_blk_ids[table] == BLKID_VLAN_LOOKUP_TABLE &&
+	    matches(field_name, "vlanid") == 0) {
+		return -EAGAIN;
+	}
+	if (entry_index > INT32_MAX) {
+		return -EAGAIN;
+	}
+	logv("Table %s, entry %" PRIu64", field %s, value %s",
+	     static_config_options[table], entry_index, field_name, field_val);
+	return staging_area_patch(staging_area_file,
+	                          static_config_blk_ids[table], entry_index,
+	                          next_static_table_modify[table],
+	                          field_name, field_val);
+}
+
 int staging_area_modify_parse(struct sja1105_staging_area *staging_area,
                               int *argc, char ***argv)
 {
@@ -124,9 +124,12 @@ clock_sync_params_table_show(__attribute__((unused)) struct sja1105_static_confi
 	return 0;
 }
 
-int
-sja1105_staging_area_show(struct sja1105_staging_area *staging_area,
-                          char *table_name)
+/* Shows @table_name of @staging_area, or all tables if it is empty.
+ * With a @map, tables are first decoded from it as they are needed.
+ */
+static int
+config_show(struct sja1105_staging_area *staging_area,
+            struct staging_area_map *map, char *table_name)
 {
 	const char *options[] = {
 		"schedule-table",
@@ -174,23 +177,55 @@ sja1105_staging_area_show(struct sja1105_staging_area *staging_area,
 		xmii_params_table_show,
 		sgmii_table_show,
 	};
+	const int blk_ids[] = {
+		BLKID_SCHEDULE_TABLE,
+		BLKID_SCHEDULE_ENTRY_POINTS_TABLE,
+		BLKID_VL_LOOKUP_TABLE,
+		BLKID_VL_POLICING_TABLE,
+		BLKID_VL_FORWARDING_TABLE,
+		BLKID_L2_LOOKUP_TABLE,
+		BLKID_L2_POLICING_TABLE,
+		BLKID_VLAN_LOOKUP_TABLE,
+		BLKID_L2_FORWARDING_TABLE,
+		BLKID_MAC_CONFIG_TABLE,
+		BLKID_SCHEDULE_PARAMS_TABLE,
+		BLKID_SCHEDULE_ENTRY_POINTS_PARAMS_TABLE,
+		BLKID_VL_FORWARDING_PARAMS_TABLE,
+		BLKID_L2_LOOKUP_PARAMS_TABLE,
+		BLKID_L2_FORWARDING_PARAMS_TABLE,
+		BLKID_CLK_SYNC_PARAMS_TABLE,
+		BLKID_AVB_PARAMS_TABLE,
+		BLKID_GENERAL_PARAMS_TABLE,
+		BLKID_RETAGGING_TABLE,
+		BLKID_XMII_MODE_PARAMS_TABLE,
+		BLKID_SGMII_TABLE,
+	};
 	struct sja1105_static_config *static_config;
 	char *index_ptr;
 	uint64_t entry_index_u64;
 	int entry_index;
 	unsigned int i;
+	int match;
 	int rc = 0;
 
 	static_config = &staging_area->static_config;
 
 	if (table_name == NULL || strlen(table_name) == 0) {
 		logv("Showing all config tables");
+		if (map != NULL) {
+			rc = staging_area_map_get_all(map);
+			if (rc < 0) {
+				goto out;
+			}
+		}
 		printf("Device ID is 0x%08" PRIx64 " (%s)\n",
 		       static_config->device_id, sja1105_device_id_string_get(
 		       static_config->device_id, SJA1105_PART_NR_DONT_CARE));
+		/* Empty tables are only an error when asked for by name */
 		for (i = 0; i < ARRAY_SIZE(next_config_table_show); i++) {
-			rc = next_config_table_show[i](static_config, -1);
+			next_config_table_show[i](static_config, -1);
 		}
+		rc = 0;
 	} else {
 		index_ptr = strchr(table_name, '[');
 		if (index_ptr == NULL) {
@@ -213,9 +248,46 @@ sja1105_staging_area_show(struct sja1105_staging_area *staging_area,
 		if (rc < 0) {
 			goto out;
 		}
-		rc = next_config_table_show[rc](static_config, entry_index);
+		match = rc;
+		if (map != NULL) {
+			rc = staging_area_map_get(map, blk_ids[match]);
+			if (rc < 0) {
+				goto out;
+			}
+		}
+		rc = next_config_table_show[match](static_config, entry_index);
 	}
 out:
 	return rc;
 }
 
+int
+sja1105_staging_area_show(struct sja1105_staging_area *staging_area,
+                          char *table_name)
+{
+	return config_show(staging_area, NULL, table_name);
+}
+
+/* Like sja1105_staging_area_show, but reads @staging_area_file and only
+ * decodes the tables that are shown.
+ */
+int
+staging_area_show_file(const char *staging_area_file,
+                       struct sja1105_staging_area *staging_area,
+                       char *table_name)
+{
+	struct staging_area_map map;
+	int rc;
+
+	rc = staging_area_map_open(staging_area_file, &map, staging_area);
+	if (rc < 0) {
+		return rc;
+	}
+	rc = config_show(staging_area, &map, table_name);
+	if (rc < 0) {
+		sja1105_err_remap(rc, SJA1105_ERR_STAGING_AREA_INVALID);
+	}
+	staging_area_map_close(&map);
+	return rc;
+}
+
@@ -279,7 +279,7 @@ sja1105_staging_area_from_xml(const char *xml_file,
 		loge("failed to get root element");
 		goto out;
 	}
-	memset(staging_area, 0, sizeof(*staging_area));
+	sja1105_static_config_free(&staging_area->static_config);
 	rc = parse_root(root, staging_area);
 out:
 	xmlFreeDoc(doc);
@@ -0,0 +1,587 @@
+/******************************************************************************
+ * Copyright (c) 2018, NXP Semiconductors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <signal.h>
+#include <limits.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <common.h>
+#include "internal.h"
+
+/* sja1105d keeps the SPI device open and the staging area unpacked in
+ * memory, and runs sja1105-tool commands on behalf of clients that
+ * connect to its Unix socket. One command is served per connection.
+ *
+ * Request:  u32 count, then count times (u32 len, char[len]).
+ *           The first string is the working directory of the client,
+ *           the rest are the command line arguments after
+ *           "sja1105-tool".
+ * Response: s32 rc, u32 out_len, u32 err_len, char[out_len] (stdout),
+ *           char[err_len] (stderr).
+ *
+ * All integers are in host byte order.
+ */
+#define DAEMON_MAX_ARGS    256
+#define DAEMON_MAX_ARG_LEN (64 * 1024)
+#define DAEMON_TIMEOUT_SEC 5
+
+static volatile sig_atomic_t daemon_stop;
+
+static void print_usage()
+{
+	printf("Usage: sja1105-tool daemon [-b|--background]\n");
+}
+
+static int daemon_read_full(int fd, void *buf, size_t len)
+{
+	ssize_t rc;
+	size_t done = 0;
+
+	while (done < len) {
+		rc = read(fd, (char*) buf + done, len - done);
+		if (rc < 0 && errno == EINTR) {
+			continue;
+		}
+		if (rc <= 0) {
+			return -EIO;
+		}
+		done += rc;
+	}
+	return 0;
+}
+
+static int daemon_write_full(int fd, const void *buf, size_t len)
+{
+	ssize_t rc;
+	size_t done = 0;
+
+	while (done < len) {
+		rc = write(fd, (const char*) buf + done, len - done);
+		if (rc < 0 && errno == EINTR) {
+			continue;
+		}
+		if (rc <= 0) {
+			return -EIO;
+		}
+		done += rc;
+	}
+	return 0;
+}
+
+static int daemon_sockaddr(struct sockaddr_un *addr, const char *path)
+{
+	memset(addr, 0, sizeof(*addr));
+	addr->sun_family = AF_UNIX;
+	if (strlen(path) >= sizeof(addr->sun_path)) {
+		loge("Socket path %s is too long", path);
+		return -EINVAL;
+	}
+	strcpy(addr->sun_path, path);
+	return 0;
+}
+
+static int daemon_connect(const char *path)
+{
+	struct sockaddr_un addr;
+	int fd;
+
+	if (daemon_sockaddr(&addr, path) < 0) {
+		return -EINVAL;
+	}
+	fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (fd < 0) {
+		return -errno;
+	}
+	if (connect(fd, (struct sockaddr*) &addr, sizeof(addr)) < 0) {
+		close(fd);
+		return -errno;
+	}
+	return fd;
+}
+
+/* Copies everything written to @fd since it was last rewound
+ * to the client socket, and rewinds it again */
+static int daemon_send_captured(int conn, int fd, uint32_t len)
+{
+	char buf[4096];
+	uint32_t done = 0;
+	ssize_t rc;
+
+	while (done < len) {
+		rc = pread(fd, buf, (len - done) < sizeof(buf) ?
+		           (len - done) : sizeof(buf), done);
+		if (rc <= 0) {
+			return -EIO;
+		}
+		if (daemon_write_full(conn, buf, rc) < 0) {
+			return -EIO;
+		}
+		done += rc;
+	}
+	return 0;
+}
+
+static int daemon_capture_len(int fd, uint32_t *len)
+{
+	off_t off = lseek(fd, 0, SEEK_CUR);
+
+	if (off < 0) {
+		return -errno;
+	}
+	*len = off;
+	return 0;
+}
+
+static int daemon_capture_reset(int fd)
+{
+	if (ftruncate(fd, 0) < 0 || lseek(fd, 0, SEEK_SET) < 0) {
+		return -errno;
+	}
+	return 0;
+}
+
+/* Commands that run until interrupted would hold up the daemon
+ * and every client behind them */
+static int daemon_command_streams(int argc, char **argv)
+{
+	if (argc < 2) {
+		return 0;
+	}
+	if (matches(argv[0], "status") == 0 && matches(argv[1], "poll") == 0) {
+		return 1;
+	}
+	if (matches(argv[0], "fdb") == 0 && matches(argv[1], "watch") == 0) {
+		return 1;
+	}
+	return 0;
+}
+
+/* "-" stands for stdin (or stdout) of the client, which sja1105d
+ * doesn't have: once detached, its own stdin is /dev/null */
+static int daemon_command_uses_stdio(int argc, char **argv)
+{
+	const char *eq;
+	int i;
+
+	for (i = 0; i < argc; i++) {
+		eq = strchr(argv[i], '=');
+		if (strcmp(argv[i], "-") == 0 ||
+		    (eq != NULL && strcmp(eq, "=-") == 0)) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+static int daemon_serve(struct sja1105_spi_setup *spi_setup,
+                        struct batch_state *state,
+                        int conn, int out_fd, int err_fd)
+{
+	struct timeval tv = { .tv_sec = DAEMON_TIMEOUT_SEC };
+	char *args[DAEMON_MAX_ARGS];
+	uint32_t count, len, i;
+	int saved_stdout = -1;
+	int saved_stderr = -1;
+	uint32_t reply[3];
+	int rc;
+
+	setsockopt(conn, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+	setsockopt(conn, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+
+	memset(args, 0, sizeof(args));
+	rc = daemon_read_full(conn, &count, sizeof(count));
+	if (rc < 0 || count < 2 || count > DAEMON_MAX_ARGS) {
+		rc = -EINVAL;
+		goto out_free;
+	}
+	for (i = 0; i < count; i++) {
+		rc = daemon_read_full(conn, &len, sizeof(len));
+		if (rc < 0 || len > DAEMON_MAX_ARG_LEN) {
+			rc = -EINVAL;
+			goto out_free;
+		}
+		args[i] = calloc(len + 1, 1);
+		if (!args[i]) {
+			rc = -ENOMEM;
+			goto out_free;
+		}
+		rc = daemon_read_full(conn, args[i], len);
+		if (rc < 0) {
+			goto out_free;
+		}
+	}
+	/* Relative file names (config load, save) are
+	 * resolved against the client's working directory */
+	if (chdir(args[0]) < 0) {
+		logv("cannot change directory to %s", args[0]);
+	}
+	rc = daemon_capture_reset(out_fd);
+	if (rc < 0) {
+		goto out_chdir;
+	}
+	rc = daemon_capture_reset(err_fd);
+	if (rc < 0) {
+		goto out_chdir;
+	}
+	fflush(stdout);
+	fflush(stderr);
+	saved_stdout = dup(STDOUT_FILENO);
+	saved_stderr = dup(STDERR_FILENO);
+	dup2(out_fd, STDOUT_FILENO);
+	dup2(err_fd, STDERR_FILENO);
+
+	if (daemon_command_streams(count - 1, args + 1)) {
+		loge("%s %s cannot be run by sja1105d", args[1], args[2]);
+		rc = -SJA1105_ERR_CMDLINE_PARSE;
+	} else if (daemon_command_uses_stdio(count - 1, args + 1)) {
+		loge("sja1105d cannot read from the stdin of the client");
+		rc = -SJA1105_ERR_CMDLINE_PARSE;
+	} else {
+		rc = batch_run(spi_setup, state, count - 1, args + 1);
+	}
+	if (rc == 0) {
+		rc = batch_commit(spi_setup, state);
+	}
+	if (rc < 0) {
+		/* Don't let a half-applied command linger
+		 * in memory for the next client */
+		state->loaded = 0;
+		state->dirty = 0;
+		state->flush = 0;
+	} else {
+		logv("ok");
+	}
+
+	fflush(stdout);
+	fflush(stderr);
+	dup2(saved_stdout, STDOUT_FILENO);
+	dup2(saved_stderr, STDERR_FILENO);
+	close(saved_stdout);
+	close(saved_stderr);
+
+	reply[0] = rc;
+	if (daemon_capture_len(out_fd, &reply[1]) < 0 ||
+	    daemon_capture_len(err_fd, &reply[2]) < 0) {
+		rc = -EIO;
+		goto out_chdir;
+	}
+	if (daemon_write_full(conn, reply, sizeof(reply)) < 0 ||
+	    daemon_send_captured(conn, out_fd, reply[1]) < 0 ||
+	    daemon_send_captured(conn, err_fd, reply[2]) < 0) {
+		loge("failed to send reply to client");
+	}
+out_chdir:
+	if (chdir("/") < 0) {
+		loge("cannot change directory to /");
+	}
+out_free:
+	for (i = 0; i < DAEMON_MAX_ARGS; i++) {
+		free(args[i]);
+	}
+	return rc;
+}
+
+static void daemon_signal_handler(int signum)
+{
+	(void) signum;
+	daemon_stop = 1;
+}
+
+static int daemon_listen(const char *path)
+{
+	struct sockaddr_un addr;
+	int fd;
+	int rc;
+
+	rc = daemon_sockaddr(&addr, path);
+	if (rc < 0) {
+		return rc;
+	}
+	fd = daemon_connect(path);
+	if (fd >= 0) {
+		loge("sja1105d is already running on %s", path);
+		close(fd);
+		return -EEXIST;
+	}
+	/* Nobody is listening, remove a socket left over from a crash */
+	unlink(path);
+	fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (fd < 0) {
+		rc = -errno;
+		loge("socket failed: %s", strerror(errno));
+		return rc;
+	}
+	if (bind(fd, (struct sockaddr*) &addr, sizeof(addr)) < 0) {
+		rc = -errno;
+		loge("cannot bind to %s: %s", path, strerror(errno));
+		goto out_close;
+	}
+	/* The daemon has full control over the switch */
+	if (chmod(path, 0600) < 0 || listen(fd, 16) < 0) {
+		rc = -errno;
+		loge("cannot listen on %s: %s", path, strerror(errno));
+		goto out_unlink;
+	}
+	return fd;
+out_unlink:
+	unlink(path);
+out_close:
+	close(fd);
+	return rc;
+}
+
+/* The working directory changes with every client,
+ * so the staging area is pinned to an absolute path */
+static int daemon_absolute_staging_area(struct sja1105_spi_setup *spi_setup)
+{
+	extern const char *default_staging_area;
+	char cwd[PATH_MAX];
+	char *path;
+
+	if (spi_setup->staging_area[0] == '/') {
+		return 0;
+	}
+	if (!getcwd(cwd, sizeof(cwd))) {
+		return -errno;
+	}
+	path = malloc(strlen(cwd) + strlen(spi_setup->staging_area) + 2);
+	if (!path) {
+		return -ENOMEM;
+	}
+	sprintf(path, "%s/%s", cwd, spi_setup->staging_area);
+	if (spi_setup->staging_area != default_staging_area) {
+		free((char*) spi_setup->staging_area);
+	}
+	spi_setup->staging_area = path;
+	return 0;
+}
+
+static int daemon_run(struct sja1105_spi_setup *spi_setup, int background)
+{
+	const char *path = general_config.daemon_socket;
+	struct batch_state *state;
+	struct sigaction sa;
+	FILE *out_file = NULL;
+	FILE *err_file = NULL;
+	int listen_fd;
+	int conn;
+	int rc;
+
+	if (!path) {
+		loge("daemon_socket is set to none in the config file");
+		rc = -EINVAL;
+		goto out;
+	}
+	rc = daemon_absolute_staging_area(spi_setup);
+	if (rc < 0) {
+		goto out;
+	}
+	state = calloc(1, sizeof(*state));
+	if (!state) {
+		rc = -ENOMEM;
+		goto out;
+	}
+	out_file = tmpfile();
+	err_file = tmpfile();
+	if (!out_file || !err_file) {
+		loge("cannot create capture files");
+		rc = -errno;
+		goto out_free;
+	}
+	rc = sja1105_spi_configure(spi_setup);
+	if (rc < 0) {
+		loge("sja1105_spi_configure failed");
+		goto out_free;
+	}
+	listen_fd = daemon_listen(path);
+	if (listen_fd < 0) {
+		rc = listen_fd;
+		goto out_free;
+	}
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = daemon_signal_handler;
+	/* No SA_RESTART: accept() must return on SIGTERM */
+	sigaction(SIGTERM, &sa, NULL);
+	sigaction(SIGINT, &sa, NULL);
+	signal(SIGPIPE, SIG_IGN);
+
+	if (background && daemon(0, 0) < 0) {
+		rc = -errno;
+		loge("cannot detach: %s", strerror(errno));
+		goto out_close;
+	}
+	if (chdir("/") < 0) {
+		rc = -errno;
+		goto out_close;
+	}
+	logv("listening on %s", path);
+	while (!daemon_stop) {
+		conn = accept(listen_fd, NULL, NULL);
+		if (conn < 0) {
+			if (errno != EINTR) {
+				loge("accept failed: %s", strerror(errno));
+			}
+			continue;
+		}
+		daemon_serve(spi_setup, state, conn, fileno(out_file),
+		             fileno(err_file));
+		close(conn);
+	}
+	logv("exiting");
+	rc = 0;
+out_close:
+	close(listen_fd);
+	unlink(path);
+out_free:
+	if (out_file) {
+		fclose(out_file);
+	}
+	if (err_file) {
+		fclose(err_file);
+	}
+	sja1105_static_config_free(&state->staging_area.static_config);
+	free(state);
+out:
+	return rc;
+}
+
+int daemon_parse_args(struct sja1105_spi_setup *spi_setup, int argc, char **argv)
+{
+	int background = 0;
+	int rc;
+
+	if (argc == 1 && (strcmp(argv[0], "-b") == 0 ||
+	                  strcmp(argv[0], "--background") == 0)) {
+		background = 1;
+	} else if (argc == 1 && strcmp(argv[0], "help") == 0) {
+		print_usage();
+		return 0;
+	} else if (argc != 0) {
+		rc = -EINVAL;
+		goto parse_error;
+	}
+	rc = daemon_run(spi_setup, background);
+	if (rc < 0) {
+		goto hardware_not_responding_error;
+	}
+	sja1105_err_remap(rc, SJA1105_ERR_OK);
+	return rc;
+hardware_not_responding_error:
+	sja1105_err_remap(rc, SJA1105_ERR_HW_NOT_RESPONDING);
+	return rc;
+parse_error:
+	sja1105_err_remap(rc, SJA1105_ERR_CMDLINE_PARSE);
+	print_usage();
+	return rc;
+}
+
+/* Runs the command on the resident sja1105d, if there is one.
+ * Returns -EAGAIN if the command must be run locally. */
+int daemon_client_forward(const char *socket_path, int argc, char **argv)
+{
+	char cwd[PATH_MAX];
+	uint32_t reply[3];
+	uint32_t count;
+	uint32_t len;
+	char buf[4096];
+	int fd;
+	int i;
+	int rc;
+
+	if (!socket_path || argc < 1) {
+		return -EAGAIN;
+	}
+	/* These are the ones that sja1105d itself is made of */
+	if (matches(argv[0], "batch") == 0 ||
+	    matches(argv[0], "daemon") == 0) {
+		return -EAGAIN;
+	}
+	if (daemon_command_streams(argc, argv) ||
+	    daemon_command_uses_stdio(argc, argv)) {
+		return -EAGAIN;
+	}
+	if (!getcwd(cwd, sizeof(cwd))) {
+		return -EAGAIN;
+	}
+	fd = daemon_connect(socket_path);
+	if (fd < 0) {
+		return -EAGAIN;
+	}
+	count = argc + 1;
+	rc = daemon_write_full(fd, &count, sizeof(count));
+	for (i = -1; i < argc && rc == 0; i++) {
+		const char *arg = (i < 0) ? cwd : argv[i];
+
+		len = strlen(arg);
+		rc = daemon_write_full(fd, &len, sizeof(len));
+		if (rc == 0) {
+			rc = daemon_write_full(fd, arg, len);
+		}
+	}
+	if (rc < 0) {
+		/* The request could not have been run
+		 * if it wasn't entirely sent */
+		close(fd);
+		return -EAGAIN;
+	}
+	rc = daemon_read_full(fd, reply, sizeof(reply));
+	if (rc < 0) {
+		loge("sja1105d did not reply");
+		rc = -EIO;
+		goto out;
+	}
+	for (i = 1; i <= 2; i++) {
+		FILE *stream = (i == 1) ? stdout : stderr;
+
+		while (reply[i]) {
+			len = (reply[i] < sizeof(buf)) ? reply[i] : sizeof(buf);
+			rc = daemon_read_full(fd, buf, len);
+			if (rc < 0) {
+				loge("truncated reply from sja1105d");
+				rc = -EIO;
+				goto out;
+			}
+			fwrite(buf, 1, len, stream);
+			reply[i] -= len;
+		}
+	}
+	fflush(stdout);
+	rc = (int32_t) reply[0];
+out:
+	close(fd);
+	return rc;
+}
@@ -31,11 +31,13 @@
 #ifndef _SJA1105_TOOL_INTERNAL
 #define _SJA1105_TOOL_INTERNAL
 
+#include <sys/stat.h>
 #include <common.h>
 #include <lib/include/staging-area.h>
 #include <lib/include/spi.h>
 
 struct general_config {
+	const char *daemon_socket;
 	char *staging_area;
 	int   screen_width;
 	int   entries_per_line;
@@ -51,19 +53,107 @@ extern int SJA1105_DEBUG_CONDITION;
 int read_config_file(char*, struct sja1105_spi_setup*, struct general_config*);
 int rgu_parse_args(struct sja1105_spi_setup*, int argc, char **argv);
 int ptp_parse_args(struct sja1105_spi_setup*, int argc, char **argv);
+int fdb_parse_args(struct sja1105_spi_setup*, int argc, char **argv);
+int vlan_parse_args(struct sja1105_spi_setup*, int argc, char **argv);
+int vlan_run(struct sja1105_spi_setup*, struct sja1105_static_config*,
+             int argc, char **argv);
+int policer_parse_args(struct sja1105_spi_setup*, int argc, char **argv);
+int policer_run(struct sja1105_spi_setup*, struct sja1105_static_config*,
+                int argc, char **argv);
+int link_parse_args(struct sja1105_spi_setup*, int argc, char **argv);
+int link_run(struct sja1105_spi_setup*, struct sja1105_static_config*,
+             int argc, char **argv);
+int schedule_parse_args(struct sja1105_spi_setup*, int argc, char **argv);
+int schedule_run(struct sja1105_spi_setup*, struct sja1105_static_config*,
+                 int argc, char **argv);
 int config_parse_args(struct sja1105_spi_setup*, int argc, char **argv);
 int status_parse_args(struct sja1105_spi_setup*, int argc, char **argv);
 int reg_parse_args(struct sja1105_spi_setup*, int argc, char **argv);
+int batch_parse_args(struct sja1105_spi_setup*, int argc, char **argv);
+int daemon_parse_args(struct sja1105_spi_setup*, int argc, char **argv);
+int daemon_client_forward(const char *socket_path, int argc, char **argv);
+
+/* A staging area that is kept in memory across commands, by
+ * "sja1105-tool batch" and by sja1105d. Defined in batch.c. */
+struct batch_state {
+	struct sja1105_staging_area staging_area;
+	struct stat file_stat; /* staging area file that was loaded/saved */
+	int loaded;            /* staging_area holds a valid config */
+	int dirty;             /* staging_area must be saved */
+	int flush;             /* staging_area must be uploaded */
+	int force;             /* upload even if the switch runs it already */
+};
+
+int batch_run(struct sja1105_spi_setup*, struct batch_state*,
+              int argc, char **argv);
+int batch_commit(struct sja1105_spi_setup*, struct batch_state*);
 int staging_area_modify(struct sja1105_staging_area*, char*, char*, char*);
 int staging_area_modify_parse(struct sja1105_staging_area*,
                               int *argc, char ***argv);
+int staging_area_modify_in_place(const char*, char*, char*, char*);
+int config_l2_place(struct sja1105_static_config*);
+int config_vlan(struct sja1105_static_config*, int argc, char **argv);
 int sja1105_staging_area_show(struct sja1105_staging_area*, char *table_name);
+int staging_area_show_file(const char*, struct sja1105_staging_area*,
+                           char *table_name);
+
+/* A staging area file mapped into memory, from which tables are only
+ * decoded when they are asked for. Defined in staging-area.c. */
+struct staging_area_map {
+	struct sja1105_static_config_index index;
+	struct sja1105_staging_area *staging_area;
+	char  *buf;
+	size_t len;
+};
 
+int staging_area_map_open(const char*, struct staging_area_map*,
+                          struct sja1105_staging_area*);
+int staging_area_map_get(struct staging_area_map*, int blk_id);
+int staging_area_map_get_all(struct staging_area_map*);
+void staging_area_map_close(struct staging_area_map*);
 int staging_area_load(const char*, struct sja1105_staging_area*);
 int staging_area_save(const char*, struct sja1105_staging_area*);
 int staging_area_flush(struct sja1105_spi_setup*,
                        struct sja1105_staging_area*);
 int staging_area_hexdump(const char*);
+void staging_area_upload_forget(struct sja1105_spi_setup*);
+int staging_area_change_begin(struct sja1105_spi_setup*,
+                              struct sja1105_static_config*);
+void staging_area_change_end(struct sja1105_spi_setup*,
+                             struct sja1105_static_config*);
+int staging_area_live_run(struct sja1105_spi_setup*,
+                          int (*run)(struct sja1105_spi_setup*,
+                                     struct sja1105_static_config*,
+                                     int argc, char **argv),
+                          int argc, char **argv);
+int staging_area_patch(const char*, int blk_id, int entry_index,
+                       int (*modify)(struct sja1105_static_config*,
+                                     int, char*, char*),
+                       char*, char*);
+
+/* From json.c. Numbers are kept as text, like strings; a member of
+ * an object has a @key. */
+enum json_type {
+	JSON_NULL,
+	JSON_BOOL,
+	JSON_NUMBER,
+	JSON_STRING,
+	JSON_ARRAY,
+	JSON_OBJECT,
+};
+
+struct json_value {
+	enum json_type type;
+	char *key;
+	char *text;
+	struct json_value *items;
+	int count;
+};
+
+int json_parse(const char *text, struct json_value*);
+int json_parse_file(const char *filename, struct json_value*);
+struct json_value *json_get(struct json_value *object, const char *key);
+void json_free(struct json_value*);
 
 /* From strings.c, mainly */
 char *trimwhitespace(char *str);
@@ -76,6 +166,8 @@ void  linewise_concat(char **buffers, int count);
 int   read_array(char *array_str, uint64_t *array_val, int max_count);
 int   reliable_uint64_from_string(uint64_t *to, char *from, char**);
 int   reliable_double_from_string(double *to, char *from, char**);
+int   mac_addr_from_string(uint64_t *to, char *from, char **endptr);
+int   vid_range_from_string(uint16_t *first, uint16_t *last, char *from);
 
 #define SJA1105_NETCONF_ROOT "sja1105"
 #define SJA1105_NETCONF_NS   "http://nxp.com/ns/yang/tsn/sja1105"
@@ -0,0 +1,298 @@
+/******************************************************************************
+ * Copyright (c) 2018, NXP Semiconductors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <common.h>
+#include "internal.h"
+
+/* A small JSON reader, for the schedule descriptions that were
+ * previously fed to jq. Numbers are kept as text, so that the caller
+ * decides how to convert them; strings support the usual escapes
+ * except \u, which is only accepted for ASCII characters.
+ */
+
+struct json_parser {
+	const char *p;
+	int line;
+};
+
+static int json_parse_value(struct json_parser*, struct json_value*);
+
+static void json_skip_space(struct json_parser *parser)
+{
+	while (isspace((unsigned char) *parser->p)) {
+		if (*parser->p == '\n') {
+			parser->line++;
+		}
+		parser->p++;
+	}
+}
+
+static int json_error(struct json_parser *parser, const char *what)
+{
+	loge("JSON line %d: %s", parser->line, what);
+	return -EINVAL;
+}
+
+static int json_parse_string(struct json_parser *parser, char **out)
+{
+	const char *start = ++parser->p;
+	unsigned int c;
+	char *s;
+	int len = 0;
+
+	/* Escapes only ever shrink the string */
+	while (*parser->p && *parser->p != '"') {
+		if (*parser->p == '\\' && parser->p[1]) {
+			parser->p++;
+		}
+		parser->p++;
+	}
+	if (*parser->p != '"') {
+		return json_error(parser, "unterminated string");
+	}
+	s = malloc(parser->p - start + 1);
+	if (s == NULL) {
+		return -ENOMEM;
+	}
+	for (parser->p = start; *parser->p != '"'; parser->p++) {
+		if (*parser->p != '\\') {
+			s[len++] = *parser->p;
+			continue;
+		}
+		switch (*++parser->p) {
+		case 'n': s[len++] = '\n'; break;
+		case 't': s[len++] = '\t'; break;
+		case 'r': s[len++] = '\r'; break;
+		case 'b': s[len++] = '\b'; break;
+		case 'f': s[len++] = '\f'; break;
+		case 'u':
+			if (sscanf(parser->p + 1, "%4x", &c) != 1 || c > 0x7f) {
+				free(s);
+				return json_error(parser, "unsupported \\u escape");
+			}
+			s[len++] = c;
+			parser->p += 4;
+			break;
+		default: s[len++] = *parser->p; break;
+		}
+	}
+	parser->p++;
+	s[len] = 0;
+	*out = s;
+	return 0;
+}
+
+/* Parses the members of an array (@close is ']') or an object ('}') */
+static int json_parse_members(struct json_parser *parser,
+                              struct json_value *value, char close)
+{
+	struct json_value *items;
+	struct json_value *item;
+	int capacity = 0;
+	int rc;
+
+	parser->p++;
+	json_skip_space(parser);
+	if (*parser->p == close) {
+		parser->p++;
+		return 0;
+	}
+	while (1) {
+		if (value->count == capacity) {
+			capacity = capacity ? 2 * capacity : 4;
+			items = realloc(value->items, capacity * sizeof(*items));
+			if (items == NULL) {
+				return -ENOMEM;
+			}
+			value->items = items;
+		}
+		item = &value->items[value->count];
+		memset(item, 0, sizeof(*item));
+		value->count++;
+		json_skip_space(parser);
+		if (close == '}') {
+			if (*parser->p != '"') {
+				return json_error(parser, "expected a member name");
+			}
+			rc = json_parse_string(parser, &item->key);
+			if (rc < 0) {
+				return rc;
+			}
+			json_skip_space(parser);
+			if (*parser->p != ':') {
+				return json_error(parser, "expected ':'");
+			}
+			parser->p++;
+		}
+		rc = json_parse_value(parser, item);
+		if (rc < 0) {
+			return rc;
+		}
+		json_skip_space(parser);
+		if (*parser->p == close) {
+			parser->p++;
+			return 0;
+		}
+		if (*parser->p != ',') {
+			return json_error(parser, "expected ',' or end of list");
+		}
+		parser->p++;
+	}
+}
+
+static int json_parse_value(struct json_parser *parser,
+                            struct json_value *value)
+{
+	const char *start;
+
+	json_skip_space(parser);
+	switch (*parser->p) {
+	case '{':
+		value->type = JSON_OBJECT;
+		return json_parse_members(parser, value, '}');
+	case '[':
+		value->type = JSON_ARRAY;
+		return json_parse_members(parser, value, ']');
+	case '"':
+		value->type = JSON_STRING;
+		return json_parse_string(parser, &value->text);
+	}
+	/* Numbers, true, false and null */
+	start = parser->p;
+	while (isalnum((unsigned char) *parser->p) ||
+	       *parser->p == '-' || *parser->p == '+' || *parser->p == '.') {
+		parser->p++;
+	}
+	if (parser->p == start) {
+		return json_error(parser, "expected a value");
+	}
+	value->text = strndup(start, parser->p - start);
+	if (value->text == NULL) {
+		return -ENOMEM;
+	}
+	if (strcmp(value->text, "null") == 0) {
+		value->type = JSON_NULL;
+	} else if (strcmp(value->text, "true") == 0 ||
+	           strcmp(value->text, "false") == 0) {
+		value->type = JSON_BOOL;
+	} else {
+		value->type = JSON_NUMBER;
+	}
+	return 0;
+}
+
+void json_free(struct json_value *value)
+{
+	int i;
+
+	for (i = 0; i < value->count; i++) {
+		json_free(&value->items[i]);
+	}
+	free(value->items);
+	free(value->key);
+	free(value->text);
+	memset(value, 0, sizeof(*value));
+}
+
+int json_parse(const char *text, struct json_value *value)
+{
+	struct json_parser parser = { .p = text, .line = 1 };
+	int rc;
+
+	memset(value, 0, sizeof(*value));
+	rc = json_parse_value(&parser, value);
+	if (rc == 0) {
+		json_skip_space(&parser);
+		if (*parser.p) {
+			rc = json_error(&parser, "trailing characters");
+		}
+	}
+	if (rc < 0) {
+		json_free(value);
+	}
+	return rc;
+}
+
+/* Reads and parses @filename, or stdin if it is "-" */
+int json_parse_file(const char *filename, struct json_value *value)
+{
+	FILE *f = stdin;
+	char *text = NULL;
+	size_t len = 0;
+	size_t n;
+	int rc;
+
+	if (strcmp(filename, "-") != 0) {
+		f = fopen(filename, "r");
+		if (f == NULL) {
+			loge("could not open %s", filename);
+			return -errno;
+		}
+	}
+	do {
+		char *tmp = realloc(text, len + 4096 + 1);
+
+		if (tmp == NULL) {
+			rc = -ENOMEM;
+			goto out;
+		}
+		text = tmp;
+		n = fread(text + len, 1, 4096, f);
+		len += n;
+	} while (n == 4096);
+	text[len] = 0;
+	rc = json_parse(text, value);
+out:
+	free(text);
+	if (f != stdin) {
+		fclose(f);
+	}
+	return rc;
+}
+
+/* Member @key of @object, or NULL */
+struct json_value *json_get(struct json_value *object, const char *key)
+{
+	int i;
+
+	if (object->type != JSON_OBJECT) {
+		return NULL;
+	}
+	for (i = 0; i < object->count; i++) {
+		if (strcmp(object->items[i].key, key) == 0) {
+			return &object->items[i];
+		}
+	}
+	return NULL;
+}
@@ -31,6 +31,7 @@
  *****************************************************************************/
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 #include <lib/include/spi.h>
 #include <lib/include/static-config.h>
@@ -48,6 +49,14 @@ void print_usage()
 	       "   * status\n"
 	       "   * reset\n"
 	       "   * reg\n"
+	       "   * ptp\n"
+	       "   * fdb\n"
+	       "   * vlan\n"
+	       "   * policer\n"
+	       "   * link\n"
+	       "   * schedule\n"
+	       "   * batch\n"
+	       "   * daemon\n"
 	       "   * help | -h | --help\n"
 	       "   * version | -V | --version\n");
 	printf("\n");
@@ -117,12 +126,28 @@ static int parse_args(struct sja1105_spi_setup *spi_setup, int argc, char **argv
 		"status",
 		"reset",
 		"reg",
+		"ptp",
+		"fdb",
+		"vlan",
+		"policer",
+		"link",
+		"schedule",
+		"batch",
+		"daemon",
 	};
 	int (*next_parse_args[])(struct sja1105_spi_setup*, int, char**) = {
 		config_parse_args,
 		status_parse_args,
 		rgu_parse_args,
 		reg_parse_args,
+		ptp_parse_args,
+		fdb_parse_args,
+		vlan_parse_args,
+		policer_parse_args,
+		link_parse_args,
+		schedule_parse_args,
+		batch_parse_args,
+		daemon_parse_args,
 	};
 	int  rc;
 
@@ -145,6 +170,7 @@ void cleanup(struct sja1105_spi_setup *spi_setup)
 {
 	extern const char *default_device;
 	extern const char *default_staging_area;
+	extern const char *default_upload_state;
 
 	if (spi_setup->device && spi_setup->device != default_device) {
 		free((char*) spi_setup->device);
@@ -153,6 +179,10 @@ void cleanup(struct sja1105_spi_setup *spi_setup)
 	    spi_setup->staging_area != default_staging_area) {
 		free((char*) spi_setup->staging_area);
 	}
+	if (spi_setup->upload_state &&
+	    spi_setup->upload_state != default_upload_state) {
+		free((char*) spi_setup->upload_state);
+	}
 	if (spi_setup->fd) {
 		close(spi_setup->fd);
 	}
@@ -167,10 +197,28 @@ int main(int argc, char *argv[])
 {
 	char *sja1105_conf_file = (char*) default_sja1105_conf_file;
 	struct sja1105_spi_setup spi_setup;
+	/* "sja1105d [options]" is "sja1105-tool daemon [options]" */
+	char *daemon_argv[] = { "daemon", argc > 1 ? argv[1] : NULL };
+	char *prog_name = strrchr(argv[0], '/');
 	int rc = SJA1105_ERR_OK;
 
+	prog_name = prog_name ? prog_name + 1 : argv[0];
 	/* discard program name */
 	argc--; argv++;
+	if (strcmp(prog_name, "sja1105d") == 0) {
+		if (argc > 0 && (matches(argv[0], "-c") == 0 ||
+		                 matches(argv[0], "--config-file") == 0)) {
+			if (argc < 2) {
+				print_usage();
+				goto out;
+			}
+			sja1105_conf_file = argv[1];
+			argc -= 2; argv += 2;
+		}
+		daemon_argv[1] = argc ? argv[0] : NULL;
+		argc = argc ? 2 : 1;
+		argv = daemon_argv;
+	}
 	if (argc == 0) {
 		print_usage();
 		goto out;
@@ -182,10 +230,16 @@ int main(int argc, char *argv[])
 	read_config_file(sja1105_conf_file, &spi_setup, &general_config);
 	/* Adjust gtable for SJA1105 SPI memory layout */
 	gtable_configure(QUIRK_LSW32_IS_FIRST);
+	/* Let sja1105d do the work, if it is running */
+	rc = daemon_client_forward(general_config.daemon_socket, argc, argv);
+	if (rc != -EAGAIN) {
+		goto out_cleanup;
+	}
 	rc = parse_args(&spi_setup, argc, argv);
 	if (rc == SJA1105_ERR_OK) {
 		logv("ok");
 	}
+out_cleanup:
 	cleanup(&spi_setup);
 out:
 	return reinterpreted_return_code(rc);
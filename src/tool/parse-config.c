@@ -31,6 +31,7 @@
 #include "xml/read/external.h"
 #include "xml/write/external.h"
 #include "internal.h"
+#include <inttypes.h>
 #include <string.h>
 
 static void print_usage()
@@ -38,27 +39,135 @@ static void print_usage()
 	printf("Usage: sja1105-tool config <command> [<options>] \n");
 	printf("<command> can be:\n");
 	printf("* new [-d|--device-id <value>], default 0x9e00030e (SJA1105T)\n");
-	printf("* load [-f|--flush] <filename.xml>\n");
+	printf("* load [-f|--flush] [-F|--force] <filename.xml>\n");
 	printf("* save <filename.xml>\n");
-	printf("* default [-f|--flush] <config>, which can be:\n");
+	printf("* default [-f|--flush] [-F|--force] <config>, which can be:\n");
 	printf("    * ls1021atsn - load a built-in config compatible with the NXP LS1021ATSN board\n");
-	printf("* modify [-f|--flush] <table>[<entry_index>] <field> <value>\n");
-	printf("* upload\n");
+	printf("* modify [-f|--flush] [-F|--force] <table>[<entry_index>] <field> <value>\n");
+	printf("* upload [-F|--force]\n");
+	printf("* l2-place [-f|--flush] [-F|--force]. Sets the index of the static\n"
+	       "  l2-lookup-table entries to where the E/T switch looks them up.\n");
+	printf("* vlan [-f|--flush] [-F|--force] add|set <vid>[-<vid>] <ports> [<tagged>]\n"
+	       "  vlan [-f|--flush] [-F|--force] del <vid>[-<vid>] [<ports>]. Adds\n"
+	       "  port mask <ports> to (sets it as, removes it from) a range of VLANs.\n");
 	printf("* show [<table>]. If no table is specified, shows entire config.\n");
 	printf("* hexdump [<table>]. If no table is specified, dumps entire config.\n");
 }
 
+static void
+get_force_mode(struct sja1105_spi_setup *spi_setup, int *argc, char ***argv)
+{
+	if ((*argc) && ((strcmp(*argv[0], "-F") == 0 ||
+	                (strcmp(*argv[0], "--force") == 0)))) {
+		spi_setup->force = 1;
+		(*argc)--; (*argv)++;
+	}
+}
+
 static void
 get_flush_mode(struct sja1105_spi_setup *spi_setup, int *argc, char ***argv)
 {
+	get_force_mode(spi_setup, argc, argv);
 	if ((*argc) && ((strcmp(*argv[0], "-f") == 0 ||
 	                (strcmp(*argv[0], "--flush") == 0)))) {
 		spi_setup->flush = 1;
 		(*argc)--; (*argv)++;
 	}
+	get_force_mode(spi_setup, argc, argv);
 }
 
-int config_parse_args(struct sja1105_spi_setup *spi_setup, int argc, char **argv)
+/* Places the static L2 lookup entries and reports how full the bins are */
+int config_l2_place(struct sja1105_static_config *config)
+{
+	struct sja1105_l2_lookup_usage usage;
+	int rc;
+
+	if (!IS_ET(config->device_id)) {
+		printf("l2-lookup-table is not hashed on this device\n");
+		return 0;
+	}
+	rc = sja1105et_l2_lookup_place(config, 1, &usage);
+	if (rc < 0) {
+		return rc;
+	}
+	printf("%d static entries in %d of %d bins, at most %d in a bin\n",
+	       usage.placed, usage.bins_used, SJA1105ET_L2_LOOKUP_BIN_COUNT,
+	       usage.max_per_bin);
+	/* Only an empty l2-lookup-table gets here without the parameters */
+	if (config->l2_lookup_params_count != 0) {
+		printf("Bins with no way left for learning: %d, "
+		       "with fewer than DYN_TBSZ (%" PRIu64 ") ways left: %d\n",
+		       usage.bins_full, config->l2_lookup_params[0].dyn_tbsz,
+		       usage.bins_short);
+	}
+	if (rc > 0) {
+		loge("%d entries overflow their bin, %d are duplicates",
+		     usage.overflows, usage.duplicates);
+		return -ENOSPC;
+	}
+	return 0;
+}
+
+/* Applies "add|set <vid>[-<vid>] <ports> [<tagged>]" or
+ * "del <vid>[-<vid>] [<ports>]" to the VLAN Lookup table.
+ * Returns -EINVAL if the arguments make no sense. */
+int config_vlan(struct sja1105_static_config *config, int argc, char **argv)
+{
+	uint64_t ports = 0x1f;
+	uint64_t tagged = 0;
+	uint16_t first, last;
+	int del;
+	int rc;
+
+	if (argc < 2 || argc > 4) {
+		return -EINVAL;
+	}
+	del = (strcmp(argv[0], "del") == 0);
+	if (!del && strcmp(argv[0], "add") != 0 &&
+	    strcmp(argv[0], "set") != 0) {
+		return -EINVAL;
+	}
+	if ((!del && argc < 3) || (del && argc > 3)) {
+		return -EINVAL;
+	}
+	rc = vid_range_from_string(&first, &last, argv[1]);
+	if (rc < 0) {
+		return -EINVAL;
+	}
+	if (argc > 2) {
+		rc = reliable_uint64_from_string(&ports, argv[2], NULL);
+		if (rc < 0 || ports > 0x1f) {
+			loge("Invalid port mask %s", argv[2]);
+			return -EINVAL;
+		}
+	}
+	if (argc > 3) {
+		rc = reliable_uint64_from_string(&tagged, argv[3], NULL);
+		if (rc < 0 || (tagged & ~ports)) {
+			loge("Invalid tagged port mask %s", argv[3]);
+			return -EINVAL;
+		}
+	}
+	if (del) {
+		rc = sja1105_vlan_lookup_range_del(config, first, last, ports);
+	} else if (strcmp(argv[0], "add") == 0) {
+		rc = sja1105_vlan_lookup_range_add(config, first, last,
+		                                   ports, tagged);
+	} else {
+		rc = sja1105_vlan_lookup_range_set(config, first, last,
+		                                   ports, tagged);
+	}
+	if (rc < 0) {
+		return rc;
+	}
+	logv("vlan-lookup-table now has %d entries", config->vlan_lookup_count);
+	return 0;
+}
+
+static int
+config_run(struct sja1105_spi_setup *spi_setup,
+           struct sja1105_staging_area *staging_area,
+           int argc, char **argv)
 {
 	const char *options[] = {
 		"help",
@@ -70,8 +179,9 @@ int config_parse_args(struct sja1105_spi_setup *spi_setup, int argc, char **argv
 		"upload",
 		"show",
 		"hexdump",
+		"l2-place",
+		"vlan",
 	};
-	struct sja1105_staging_area staging_area;
 	int match;
 	int rc = SJA1105_ERR_OK;
 
@@ -89,11 +199,11 @@ int config_parse_args(struct sja1105_spi_setup *spi_setup, int argc, char **argv
 		if (argc != 1) {
 			goto parse_error;
 		}
-		rc = sja1105_staging_area_from_xml(argv[0], &staging_area);
+		rc = sja1105_staging_area_from_xml(argv[0], staging_area);
 		if (rc < 0) {
 			goto invalid_xml_error;
 		}
-		rc = staging_area_save(spi_setup->staging_area, &staging_area);
+		rc = staging_area_save(spi_setup->staging_area, staging_area);
 		if (rc < 0) {
 			goto filesystem_error;
 		}
@@ -103,7 +213,7 @@ int config_parse_args(struct sja1105_spi_setup *spi_setup, int argc, char **argv
 				loge("sja1105_spi_configure failed");
 				goto hardware_not_responding_error;
 			}
-			rc = staging_area_flush(spi_setup, &staging_area);
+			rc = staging_area_flush(spi_setup, staging_area);
 			if (rc < 0) {
 				loge("staging_area_flush failed");
 				/* We have enough context to know that the staging
@@ -117,11 +227,11 @@ int config_parse_args(struct sja1105_spi_setup *spi_setup, int argc, char **argv
 		if (argc != 1) {
 			goto parse_error;
 		}
-		rc = staging_area_load(spi_setup->staging_area, &staging_area);
+		rc = staging_area_load(spi_setup->staging_area, staging_area);
 		if (rc < 0) {
 			goto propagated_error;
 		}
-		rc = sja1105_staging_area_to_xml(argv[0], &staging_area);
+		rc = sja1105_staging_area_to_xml(argv[0], staging_area);
 		if (rc < 0) {
 			goto invalid_xml_error;
 		}
@@ -142,12 +252,12 @@ int config_parse_args(struct sja1105_spi_setup *spi_setup, int argc, char **argv
 			loge("Unrecognized default config %s", argv[0]);
 			goto parse_error;
 		}
-		rc = sja1105_default_staging_area(&staging_area,
+		rc = sja1105_default_staging_area(staging_area,
 		                                  default_configs[match]);
 		if (rc < 0) {
 			goto invalid_staging_area_error;
 		}
-		rc = staging_area_save(spi_setup->staging_area, &staging_area);
+		rc = staging_area_save(spi_setup->staging_area, staging_area);
 		if (rc < 0) {
 			goto filesystem_error;
 		}
@@ -157,7 +267,7 @@ int config_parse_args(struct sja1105_spi_setup *spi_setup, int argc, char **argv
 				loge("sja1105_spi_configure failed");
 				goto hardware_not_responding_staging_area_dirty_error;
 			}
-			rc = staging_area_flush(spi_setup, &staging_area);
+			rc = staging_area_flush(spi_setup, staging_area);
 			if (rc < 0) {
 				/* We have enough context to know that the staging
 				 * area is dirty, so we force this error instead of
@@ -167,10 +277,11 @@ int config_parse_args(struct sja1105_spi_setup *spi_setup, int argc, char **argv
 			}
 		}
 	} else if (strcmp(options[match], "upload") == 0) {
+		get_force_mode(spi_setup, &argc, &argv);
 		if (argc != 0) {
 			goto parse_error;
 		}
-		rc = staging_area_load(spi_setup->staging_area, &staging_area);
+		rc = staging_area_load(spi_setup->staging_area, staging_area);
 		if (rc < 0) {
 			goto propagated_error;
 		}
@@ -179,21 +290,33 @@ int config_parse_args(struct sja1105_spi_setup *spi_setup, int argc, char **argv
 			loge("sja1105_spi_configure failed");
 			goto hardware_not_responding_error;
 		}
-		rc = staging_area_flush(spi_setup, &staging_area);
+		rc = staging_area_flush(spi_setup, staging_area);
 		if (rc < 0) {
 			goto propagated_error;
 		}
 	} else if (strcmp(options[match], "modify") == 0) {
 		get_flush_mode(spi_setup, &argc, &argv);
-		rc = staging_area_load(spi_setup->staging_area, &staging_area);
+		if (!spi_setup->flush && argc == 3) {
+			/* Nothing else needs the unpacked staging area,
+			 * so try to only rewrite the affected entry. */
+			rc = staging_area_modify_in_place(spi_setup->staging_area,
+			                                  argv[0], argv[1], argv[2]);
+			if (rc != -EAGAIN) {
+				if (rc < 0) {
+					goto propagated_error;
+				}
+				goto out;
+			}
+		}
+		rc = staging_area_load(spi_setup->staging_area, staging_area);
 		if (rc < 0) {
 			goto propagated_error;
 		}
-		rc = staging_area_modify_parse(&staging_area, &argc, &argv);
+		rc = staging_area_modify_parse(staging_area, &argc, &argv);
 		if (rc < 0) {
 			goto propagated_error;
 		}
-		rc = staging_area_save(spi_setup->staging_area, &staging_area);
+		rc = staging_area_save(spi_setup->staging_area, staging_area);
 		if (rc < 0) {
 			goto filesystem_error;
 		}
@@ -203,7 +326,7 @@ int config_parse_args(struct sja1105_spi_setup *spi_setup, int argc, char **argv
 				loge("sja1105_spi_configure failed");
 				goto hardware_not_responding_staging_area_dirty_error;
 			}
-			rc = staging_area_flush(spi_setup, &staging_area);
+			rc = staging_area_flush(spi_setup, staging_area);
 			if (rc < 0) {
 				/* We have enough context to know that the staging
 				 * area is dirty, so we force this error instead of
@@ -220,12 +343,11 @@ int config_parse_args(struct sja1105_spi_setup *spi_setup, int argc, char **argv
 			 */
 			goto parse_error;
 		}
-		memset(&staging_area, 0, sizeof(staging_area));
 		if (argc == 2) {
 			if ((matches(argv[0], "-d") == 0) ||
 			    (matches(argv[0], "--device-id") == 0)) {
 				/* sja1105-config new -d <device_id> was provided */
-				rc = reliable_uint64_from_string(&staging_area.static_config.device_id,
+				rc = reliable_uint64_from_string(&staging_area->static_config.device_id,
 				                                 argv[1], NULL);
 				if (rc < 0) {
 					loge("Invalid device id provided: %s", argv[1]);
@@ -234,9 +356,9 @@ int config_parse_args(struct sja1105_spi_setup *spi_setup, int argc, char **argv
 			}
 		} else {
 			logv("No device id provided, defaulting to SJA1105T");
-			staging_area.static_config.device_id = SJA1105T_DEVICE_ID;
+			staging_area->static_config.device_id = SJA1105T_DEVICE_ID;
 		}
-		rc = staging_area_save(spi_setup->staging_area, &staging_area);
+		rc = staging_area_save(spi_setup->staging_area, staging_area);
 		if (rc < 0) {
 			goto filesystem_error;
 		}
@@ -244,14 +366,67 @@ int config_parse_args(struct sja1105_spi_setup *spi_setup, int argc, char **argv
 		if (argc != 0 && argc != 1) {
 			goto parse_error;
 		}
-		rc = staging_area_load(spi_setup->staging_area, &staging_area);
+		/* Only the tables that are shown get decoded */
+		rc = staging_area_show_file(spi_setup->staging_area,
+		                            staging_area, argv[0]);
+		if (rc < 0) {
+			goto propagated_error;
+		}
+	} else if (strcmp(options[match], "l2-place") == 0) {
+		get_flush_mode(spi_setup, &argc, &argv);
+		if (argc != 0) {
+			goto parse_error;
+		}
+		rc = staging_area_load(spi_setup->staging_area, staging_area);
 		if (rc < 0) {
 			goto propagated_error;
 		}
-		rc = sja1105_staging_area_show(&staging_area, argv[0]);
+		rc = config_l2_place(&staging_area->static_config);
+		if (rc < 0) {
+			goto invalid_staging_area_error;
+		}
+		rc = staging_area_save(spi_setup->staging_area, staging_area);
 		if (rc < 0) {
+			goto filesystem_error;
+		}
+		if (spi_setup->flush) {
+			rc = sja1105_spi_configure(spi_setup);
+			if (rc < 0) {
+				loge("sja1105_spi_configure failed");
+				goto hardware_not_responding_staging_area_dirty_error;
+			}
+			rc = staging_area_flush(spi_setup, staging_area);
+			if (rc < 0) {
+				goto hardware_left_floating_staging_area_dirty_error;
+			}
+		}
+	} else if (strcmp(options[match], "vlan") == 0) {
+		get_flush_mode(spi_setup, &argc, &argv);
+		rc = staging_area_load(spi_setup->staging_area, staging_area);
+		if (rc < 0) {
+			goto propagated_error;
+		}
+		rc = config_vlan(&staging_area->static_config, argc, argv);
+		if (rc == -EINVAL) {
+			goto parse_error;
+		} else if (rc < 0) {
 			goto invalid_staging_area_error;
 		}
+		rc = staging_area_save(spi_setup->staging_area, staging_area);
+		if (rc < 0) {
+			goto filesystem_error;
+		}
+		if (spi_setup->flush) {
+			rc = sja1105_spi_configure(spi_setup);
+			if (rc < 0) {
+				loge("sja1105_spi_configure failed");
+				goto hardware_not_responding_staging_area_dirty_error;
+			}
+			rc = staging_area_flush(spi_setup, staging_area);
+			if (rc < 0) {
+				goto hardware_left_floating_staging_area_dirty_error;
+			}
+		}
 	} else if (strcmp(options[match], "hexdump") == 0) {
 		if (argc != 0) {
 			goto parse_error;
@@ -263,6 +438,7 @@ int config_parse_args(struct sja1105_spi_setup *spi_setup, int argc, char **argv
 	} else {
 		goto parse_error;
 	}
+out:
 	sja1105_err_remap(rc, SJA1105_ERR_OK);
 	return rc;
 invalid_staging_area_error:
@@ -290,3 +466,14 @@ parse_error:
 propagated_error:
 	return rc;
 }
+
+int config_parse_args(struct sja1105_spi_setup *spi_setup, int argc, char **argv)
+{
+	struct sja1105_staging_area staging_area;
+	int rc;
+
+	sja1105_static_config_init(&staging_area.static_config);
+	rc = config_run(spi_setup, &staging_area, argc, argv);
+	sja1105_static_config_free(&staging_area.static_config);
+	return rc;
+}
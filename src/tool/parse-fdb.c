@@ -0,0 +1,376 @@
+/******************************************************************************
+ * Copyright (c) 2018, NXP Semiconductors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+#include <inttypes.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <lib/include/dynamic-config.h>
+#include <lib/include/static-config.h>
+#include <lib/helpers.h>
+#include <common.h>
+#include "internal.h"
+
+static void print_usage()
+{
+	printf("Usage:\n");
+	printf(" * sja1105-tool fdb show [<index>]\n");
+	printf(" * sja1105-tool fdb watch [-i|--interval <ms>] (default 1000)\n"
+	       "                          [-n|--count <scans>] (default 0, forever)\n");
+	printf(" * sja1105-tool fdb get <macaddr> <vlanid>\n");
+	printf(" * sja1105-tool fdb add <macaddr> <vlanid> <destports>\n");
+	printf(" * sja1105-tool fdb del <macaddr> <vlanid>\n");
+}
+
+static void fdb_brief_show(const struct sja1105_fdb_brief *brief)
+{
+	char mac_buf[MAC_ADDR_SIZE];
+
+	mac_addr_sprintf(mac_buf, brief->macaddr);
+	printf("%4u  %s  %4u  0x%02x  %s\n", brief->index, mac_buf,
+	       brief->vlanid, brief->destports,
+	       brief->lockeds ? "static" : "learned");
+}
+
+static void fdb_entry_show(struct sja1105_fdb_entry *entry)
+{
+	struct sja1105_fdb_brief brief;
+
+	sja1105_fdb_brief_from_entry(&brief, entry);
+	fdb_brief_show(&brief);
+}
+
+static void fdb_header_show()
+{
+	printf("%4s  %-17s  %4s  %4s  %s\n",
+	       "IDX", "MACADDR", "VID", "PORTS", "TYPE");
+}
+
+/* The placement of E/T entries depends on the L2 Lookup Parameters
+ * the switch was configured with, which are taken from the staging
+ * area. P/Q/R/S switches search their table by themselves. */
+static int
+fdb_params_get(struct sja1105_spi_setup *spi_setup,
+               struct sja1105_l2_lookup_params_entry *params)
+{
+	struct sja1105_staging_area staging_area;
+	struct sja1105_static_config *config = &staging_area.static_config;
+	struct staging_area_map map;
+	int rc;
+
+	memset(params, 0, sizeof(*params));
+	if (!IS_ET(spi_setup->device_id)) {
+		return 0;
+	}
+	sja1105_static_config_init(config);
+	rc = staging_area_map_open(spi_setup->staging_area, &map, &staging_area);
+	if (rc < 0) {
+		goto out_free;
+	}
+	rc = staging_area_map_get(&map, BLKID_L2_LOOKUP_PARAMS_TABLE);
+	if (rc < 0) {
+		goto out_close;
+	}
+	if (config->l2_lookup_params_count == 0) {
+		loge("staging area has no L2 Lookup Parameters Table");
+		rc = -EINVAL;
+		sja1105_err_remap(rc, SJA1105_ERR_STAGING_AREA_INVALID);
+		goto out_close;
+	}
+	*params = config->l2_lookup_params[0];
+out_close:
+	staging_area_map_close(&map);
+out_free:
+	sja1105_static_config_free(config);
+	return rc;
+}
+
+static int fdb_key_parse(char **argv, uint64_t *macaddr, uint64_t *vlanid)
+{
+	int rc;
+
+	rc = mac_addr_from_string(macaddr, argv[0], NULL);
+	if (rc < 0) {
+		loge("Invalid MAC address %s", argv[0]);
+		return rc;
+	}
+	rc = reliable_uint64_from_string(vlanid, argv[1], NULL);
+	if (rc < 0 || *vlanid > 4095) {
+		loge("Invalid VLAN ID %s", argv[1]);
+		return -EINVAL;
+	}
+	return 0;
+}
+
+static int fdb_show(struct sja1105_spi_setup *spi_setup, int argc, char **argv)
+{
+	struct sja1105_fdb_brief *entries;
+	struct sja1105_fdb_entry entry;
+	uint64_t index;
+	int count, i;
+	int rc;
+
+	if (argc == 1) {
+		rc = reliable_uint64_from_string(&index, argv[0], NULL);
+		if (rc < 0 || index >= MAX_L2_LOOKUP_COUNT) {
+			loge("Invalid index %s", argv[0]);
+			return -EINVAL;
+		}
+		rc = sja1105_fdb_get(spi_setup, index, &entry);
+		if (rc == -ENOENT) {
+			printf("Entry %" PRIu64 " is not valid\n", index);
+			rc = 0;
+		} else if (rc == 0) {
+			fdb_header_show();
+			fdb_entry_show(&entry);
+		}
+		return rc;
+	}
+	entries = calloc(MAX_L2_LOOKUP_COUNT, sizeof(*entries));
+	if (!entries) {
+		return -ENOMEM;
+	}
+	count = sja1105_fdb_dump(spi_setup, entries);
+	if (count < 0) {
+		rc = count;
+		goto out;
+	}
+	fdb_header_show();
+	for (i = 0; i < count; i++) {
+		fdb_brief_show(&entries[i]);
+	}
+	rc = 0;
+out:
+	free(entries);
+	return rc;
+}
+
+static int fdb_watch_cb(enum sja1105_fdb_change change,
+                        const struct sja1105_fdb_brief *old_entry,
+                        const struct sja1105_fdb_brief *new_entry,
+                        void *priv)
+{
+	char mac_buf[MAC_ADDR_SIZE];
+
+	(void) priv;
+	switch (change) {
+	case SJA1105_FDB_ADDED:
+		printf("+ ");
+		fdb_brief_show(new_entry);
+		break;
+	case SJA1105_FDB_REMOVED:
+		printf("- ");
+		fdb_brief_show(old_entry);
+		break;
+	case SJA1105_FDB_MOVED:
+		mac_addr_sprintf(mac_buf, new_entry->macaddr);
+		printf("~ %4u  %s  %4u  0x%02x -> 0x%02x\n", new_entry->index,
+		       mac_buf, new_entry->vlanid, old_entry->destports,
+		       new_entry->destports);
+		break;
+	}
+	fflush(stdout);
+	return 0;
+}
+
+static volatile sig_atomic_t fdb_watch_stop;
+
+static void fdb_watch_signal_handler(int signum)
+{
+	(void) signum;
+	fdb_watch_stop = 1;
+}
+
+static int fdb_watch(struct sja1105_spi_setup *spi_setup, int argc, char **argv)
+{
+	struct sigaction sa, old_int, old_term;
+	uint64_t interval_ms = 1000;
+	uint64_t count = 0;
+	int rc;
+
+	for (; argc; argc--, argv++) {
+		if (argc < 2) {
+			return -EINVAL;
+		} else if (matches(argv[0], "-i") == 0 ||
+		           matches(argv[0], "--interval") == 0) {
+			rc = reliable_uint64_from_string(&interval_ms, argv[1], NULL);
+			if (rc < 0 || interval_ms == 0) {
+				loge("Invalid interval %s", argv[1]);
+				return -EINVAL;
+			}
+		} else if (matches(argv[0], "-n") == 0 ||
+		           matches(argv[0], "--count") == 0) {
+			rc = reliable_uint64_from_string(&count, argv[1], NULL);
+			if (rc < 0) {
+				loge("Invalid count %s", argv[1]);
+				return -EINVAL;
+			}
+		} else {
+			return -EINVAL;
+		}
+		argc--; argv++;
+	}
+	fdb_header_show();
+	/* Ctrl-C ends the watch, without SA_RESTART so that the
+	 * wait between dumps is cut short */
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = fdb_watch_signal_handler;
+	sigemptyset(&sa.sa_mask);
+	fdb_watch_stop = 0;
+	sigaction(SIGINT, &sa, &old_int);
+	sigaction(SIGTERM, &sa, &old_term);
+	rc = sja1105_fdb_watch(spi_setup, interval_ms * 1000000ull, count,
+	                       fdb_watch_cb, NULL, &fdb_watch_stop);
+	sigaction(SIGINT, &old_int, NULL);
+	sigaction(SIGTERM, &old_term, NULL);
+	return rc;
+}
+
+int fdb_parse_args(struct sja1105_spi_setup *spi_setup, int argc, char **argv)
+{
+	const char *fdb_options[] = {
+		"help",
+		"show",
+		"watch",
+		"get",
+		"add",
+		"del",
+	};
+	struct sja1105_l2_lookup_params_entry params;
+	struct sja1105_fdb_entry entry;
+	uint64_t macaddr, vlanid;
+	int match;
+	int rc;
+
+	if (argc < 1) {
+		goto out_parse_error_usage;
+	}
+	match = get_match(argv[0], fdb_options, ARRAY_SIZE(fdb_options));
+	if (match < 0) {
+		goto out_parse_error_usage;
+	}
+	argc--; argv++;
+	if (strcmp(fdb_options[match], "help") == 0) {
+		print_usage();
+		rc = 0;
+		goto out_ok;
+	}
+	if (strcmp(fdb_options[match], "show") == 0) {
+		if (argc > 1) {
+			goto out_parse_error_usage;
+		}
+	} else if (strcmp(fdb_options[match], "watch") == 0) {
+		/* Options are parsed by fdb_watch */
+	} else if (strcmp(fdb_options[match], "add") == 0) {
+		if (argc != 3) {
+			goto out_parse_error_usage;
+		}
+	} else if (strcmp(fdb_options[match], "get") == 0 ||
+	           strcmp(fdb_options[match], "del") == 0) {
+		if (argc != 2) {
+			goto out_parse_error_usage;
+		}
+	}
+	memset(&entry, 0, sizeof(entry));
+	if (strcmp(fdb_options[match], "show") != 0 &&
+	    strcmp(fdb_options[match], "watch") != 0) {
+		rc = fdb_key_parse(argv, &macaddr, &vlanid);
+		if (rc < 0) {
+			goto out_parse_error;
+		}
+	}
+	if (argc == 3) {
+		rc = reliable_uint64_from_string(&entry.l2.destports,
+		                                 argv[2], NULL);
+		if (rc < 0 || entry.l2.destports > 0x1f) {
+			loge("Invalid port mask %s", argv[2]);
+			goto out_parse_error;
+		}
+	}
+	rc = sja1105_spi_configure(spi_setup);
+	if (rc < 0) {
+		loge("failed to open spi device");
+		goto out_spi_configure_failed;
+	}
+	if (strcmp(fdb_options[match], "show") == 0) {
+		rc = fdb_show(spi_setup, argc, argv);
+		goto out_check_parse_error;
+	} else if (strcmp(fdb_options[match], "watch") == 0) {
+		rc = fdb_watch(spi_setup, argc, argv);
+		goto out_check_parse_error;
+	}
+	rc = fdb_params_get(spi_setup, &params);
+	if (rc < 0) {
+		goto out_propagated_error;
+	}
+	if (strcmp(fdb_options[match], "get") != 0) {
+		/* The running FDB is about to differ from the staging
+		 * area, so the next upload must not be skipped as a no-op */
+		staging_area_upload_forget(spi_setup);
+	}
+	if (strcmp(fdb_options[match], "get") == 0) {
+		rc = sja1105_fdb_search(spi_setup, &params, macaddr,
+		                        vlanid, &entry);
+		if (rc == -ENOENT) {
+			printf("Not found\n");
+		} else if (rc == 0) {
+			fdb_header_show();
+			fdb_entry_show(&entry);
+		}
+	} else if (strcmp(fdb_options[match], "add") == 0) {
+		entry.l2.macaddr = macaddr;
+		entry.l2.vlanid  = vlanid;
+		entry.lockeds    = 1;
+		rc = sja1105_fdb_add(spi_setup, &params, &entry);
+		if (rc == 0) {
+			logv("added at index %" PRIu64, entry.l2.index);
+		}
+	} else if (strcmp(fdb_options[match], "del") == 0) {
+		rc = sja1105_fdb_del(spi_setup, &params, macaddr, vlanid);
+		if (rc == -ENOENT) {
+			loge("No such entry in the FDB");
+		}
+	}
+out_check_parse_error:
+	if (rc == -EINVAL) {
+		goto out_parse_error_usage;
+	}
+	goto out_ok;
+
+out_parse_error_usage:
+	print_usage();
+out_parse_error:
+	rc = -EINVAL;
+out_spi_configure_failed:
+out_propagated_error:
+out_ok:
+	return rc;
+}
@@ -0,0 +1,195 @@
+/******************************************************************************
+ * Copyright (c) 2018, NXP Semiconductors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <lib/include/dynamic-config.h>
+#include <lib/include/port-control.h>
+#include <lib/include/static-config.h>
+#include <lib/include/clock.h>
+#include <common.h>
+#include "internal.h"
+
+static void print_usage()
+{
+	printf("Usage:\n");
+	printf(" * sja1105-tool link show\n");
+	printf(" * sja1105-tool link speed <port> 10|100|1000 [<port> <speed> ...]\n");
+}
+
+/* MAC Configuration table SPEED for a link speed in Mbps */
+static int link_speed_from_mbps(uint64_t *speed, uint64_t mbps)
+{
+	switch (mbps) {
+	case 1000: *speed = 1; break;
+	case 100:  *speed = 2; break;
+	case 10:   *speed = 3; break;
+	default:
+		loge("Invalid link speed %" PRIu64 "Mbps", mbps);
+		return -EINVAL;
+	}
+	return 0;
+}
+
+static void link_show(struct sja1105_static_config *config)
+{
+	const char *xmii_mode[] = {"MII", "RMII", "RGMII", "SGMII"};
+	const char *speed[] = {"auto", "1000", "100", "10"};
+	struct sja1105_xmii_params_entry *params = &config->xmii_params[0];
+	int i;
+
+	printf("%-4s  %-5s  %-4s  %s\n", "PORT", "XMII", "ROLE", "SPEED(Mbps)");
+	for (i = 0; i < config->mac_config_count; i++) {
+		printf("%-4d  %-5s  %-4s  %s\n", i,
+		       xmii_mode[params->xmii_mode[i] & 3],
+		       (params->phy_mac[i] == XMII_MODE_PHY) ? "PHY" : "MAC",
+		       speed[config->mac_config[i].speed & 3]);
+	}
+}
+
+/* Applies a link command to @config and, for "speed", to the running
+ * switch: the MAC Configuration entry of each port is rewritten through
+ * the reconfiguration registers and its clocks set up again, while the
+ * other ports keep forwarding. See vlan_run. */
+int link_run(struct sja1105_spi_setup *spi_setup,
+             struct sja1105_static_config *config,
+             int argc, char **argv)
+{
+	struct sja1105_mac_config_entry entries[SJA1105T_NUM_PORTS];
+	uint64_t port, mbps;
+	int changed[SJA1105T_NUM_PORTS] = {0};
+	int running;
+	int i, rc;
+
+	if (config->mac_config_count != SJA1105T_NUM_PORTS ||
+	    config->xmii_params_count == 0) {
+		loge("staging area has no complete mac-config and "
+		     "xmii-params tables");
+		rc = -EINVAL;
+		goto invalid_staging_area_error;
+	}
+	if (argc == 1 && strcmp(argv[0], "show") == 0) {
+		link_show(config);
+		return SJA1105_ERR_OK;
+	}
+	if (argc < 3 || (argc % 2) != 1 || strcmp(argv[0], "speed") != 0) {
+		rc = -EINVAL;
+		goto parse_error;
+	}
+	memcpy(entries, config->mac_config, sizeof(entries));
+	for (i = 1; i < argc; i += 2) {
+		rc = reliable_uint64_from_string(&port, argv[i], NULL);
+		if (rc < 0 || port >= SJA1105T_NUM_PORTS) {
+			loge("Invalid port %s", argv[i]);
+			rc = -EINVAL;
+			goto parse_error;
+		}
+		rc = reliable_uint64_from_string(&mbps, argv[i + 1], NULL);
+		if (rc < 0) {
+			loge("Invalid link speed %s", argv[i + 1]);
+			goto parse_error;
+		}
+		rc = link_speed_from_mbps(&entries[port].speed, mbps);
+		if (rc < 0) {
+			goto parse_error;
+		}
+		changed[port] = 1;
+	}
+	rc = sja1105_spi_configure(spi_setup);
+	if (rc < 0) {
+		loge("sja1105_spi_configure failed");
+		goto hardware_not_responding_error;
+	}
+	running = staging_area_change_begin(spi_setup, config);
+	memcpy(config->mac_config, entries, sizeof(entries));
+	sja1105_static_config_mark_dirty(config, BLKID_MAC_CONFIG_TABLE);
+	for (i = 0; i < SJA1105T_NUM_PORTS; i++) {
+		if (!changed[i]) {
+			continue;
+		}
+		rc = sja1105_mac_config_set(spi_setup, i, &entries[i]);
+		if (rc < 0) {
+			loge("failed to reconfigure the MAC of port %d", i);
+			goto hardware_not_responding_staging_area_dirty_error;
+		}
+		rc = sja1105_port_clocking_setup(spi_setup, i,
+		                                 &config->xmii_params[0],
+		                                 &entries[i]);
+		if (rc < 0) {
+			loge("failed to set up the clocks of port %d", i);
+			goto hardware_not_responding_staging_area_dirty_error;
+		}
+		logv("port %d now runs at %sMbps", i,
+		     (entries[i].speed == 1) ? "1000" :
+		     (entries[i].speed == 2) ? "100" : "10");
+	}
+	if (running) {
+		staging_area_change_end(spi_setup, config);
+	}
+	return SJA1105_ERR_OK;
+parse_error:
+	sja1105_err_remap(rc, SJA1105_ERR_CMDLINE_PARSE);
+	print_usage();
+	return rc;
+invalid_staging_area_error:
+	sja1105_err_remap(rc, SJA1105_ERR_STAGING_AREA_INVALID);
+	return rc;
+hardware_not_responding_error:
+	sja1105_err_remap(rc, SJA1105_ERR_HW_NOT_RESPONDING);
+	return rc;
+hardware_not_responding_staging_area_dirty_error:
+	sja1105_err_remap(rc, SJA1105_ERR_HW_NOT_RESPONDING_STAGING_AREA_DIRTY);
+	return rc;
+}
+
+int link_parse_args(struct sja1105_spi_setup *spi_setup,
+                    int argc, char **argv)
+{
+	if (argc < 1 || matches(argv[0], "help") == 0) {
+		print_usage();
+		return (argc < 1) ? -SJA1105_ERR_CMDLINE_PARSE : SJA1105_ERR_OK;
+	}
+	if (strcmp(argv[0], "show") == 0) {
+		struct sja1105_staging_area staging_area;
+		int rc;
+
+		sja1105_static_config_init(&staging_area.static_config);
+		rc = staging_area_load(spi_setup->staging_area, &staging_area);
+		if (rc == 0) {
+			rc = link_run(spi_setup, &staging_area.static_config,
+			              argc, argv);
+		}
+		sja1105_static_config_free(&staging_area.static_config);
+		return rc;
+	}
+	return staging_area_live_run(spi_setup, link_run, argc, argv);
+}
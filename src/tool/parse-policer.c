@@ -0,0 +1,291 @@
+/******************************************************************************
+ * Copyright (c) 2018, NXP Semiconductors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <lib/include/dynamic-config.h>
+#include <lib/include/port-control.h>
+#include <lib/include/static-config.h>
+#include <common.h>
+#include "internal.h"
+
+/* Policers 0 to 39 are per port and priority, 40 to 44 for broadcast */
+#define POLICER_PRIO_COUNT  8
+#define POLICER_BCAST_BASE  (SJA1105T_NUM_PORTS * POLICER_PRIO_COUNT)
+
+static void print_usage()
+{
+	printf("Usage:\n");
+	printf(" * sja1105-tool policer show\n");
+	printf(" * sja1105-tool policer set <policer> [rate=<mbps>] [burst=<bytes>]\n"
+	       "                               [maxlen=<bytes>] [sharindx=<index>]\n"
+	       "                               [<policer> ...]\n");
+	printf("<policer> is <port>:<prio> or <port>:bcast\n");
+}
+
+/* Reads "<port>:<prio>" or "<port>:bcast" into an L2 Policing index */
+static int policer_index_from_string(int *index, char *arg)
+{
+	char *from = arg;
+	unsigned long port, prio;
+	char *p;
+
+	/* Not reliable_uint64_from_string, which takes
+	 * anything with a colon for a MAC address */
+	port = strtoul(from, &p, 10);
+	if (p == from || *p != ':' || port >= SJA1105T_NUM_PORTS) {
+		goto error;
+	}
+	from = ++p;
+	if (strcmp(p, "bcast") == 0) {
+		*index = POLICER_BCAST_BASE + port;
+		return 0;
+	}
+	prio = strtoul(from, &p, 10);
+	if (p == from || *p != 0 || prio >= POLICER_PRIO_COUNT) {
+		goto error;
+	}
+	*index = port * POLICER_PRIO_COUNT + prio;
+	return 0;
+error:
+	loge("Invalid policer %s", arg);
+	return -EINVAL;
+}
+
+/* Applies "<field>=<value>" to @entry */
+static int policer_field_parse(struct sja1105_l2_policing_entry *entry,
+                               char *arg)
+{
+	char *value = strchr(arg, '=');
+	uint64_t tmp;
+	double rate;
+	int rc;
+
+	if (value == NULL) {
+		return -EINVAL;
+	}
+	*value++ = 0;
+	if (strcmp(arg, "rate") == 0) {
+		rc = reliable_double_from_string(&rate, value, NULL);
+		if (rc < 0) {
+			return -EINVAL;
+		}
+		return sja1105_l2_policing_rate_set(entry, rate);
+	}
+	rc = reliable_uint64_from_string(&tmp, value, NULL);
+	if (rc < 0) {
+		return -EINVAL;
+	}
+	if (strcmp(arg, "burst") == 0) {
+		return sja1105_l2_policing_burst_set(entry, tmp);
+	} else if (strcmp(arg, "maxlen") == 0) {
+		if (tmp > 2047) {
+			loge("maxlen %" PRIu64 " out of range (max 2047)", tmp);
+			return -ERANGE;
+		}
+		entry->maxlen = tmp;
+	} else if (strcmp(arg, "sharindx") == 0) {
+		if (tmp >= MAX_L2_POLICING_COUNT) {
+			loge("sharindx %" PRIu64 " out of range", tmp);
+			return -ERANGE;
+		}
+		entry->sharindx = tmp;
+	} else {
+		loge("Unknown policer field %s", arg);
+		return -EINVAL;
+	}
+	return 0;
+}
+
+static void policer_show(struct sja1105_static_config *config)
+{
+	struct sja1105_l2_policing_entry *entry;
+	char name[32];
+	int i;
+
+	printf("%-8s  %5s  %10s  %6s  %6s  %8s\n", "POLICER", "INDEX",
+	       "RATE(Mbps)", "BURST", "MAXLEN", "SHARINDX");
+	for (i = 0; i < config->l2_policing_count; i++) {
+		entry = &config->l2_policing[i];
+		if (i < POLICER_BCAST_BASE) {
+			snprintf(name, sizeof(name), "%d:%d",
+			         i / POLICER_PRIO_COUNT, i % POLICER_PRIO_COUNT);
+		} else {
+			snprintf(name, sizeof(name), "%d:bcast",
+			         i - POLICER_BCAST_BASE);
+		}
+		printf("%-8s  %5d  %10.3f  %6" PRIu64 "  %6" PRIu64
+		       "  %8" PRIu64 "\n", name, i,
+		       sja1105_l2_policing_rate_get(entry), entry->smax,
+		       entry->maxlen, entry->sharindx);
+	}
+}
+
+/* Parses the policers given to "policer set" into @updates, starting
+ * from their entries in @config. Returns how many there are. */
+static int
+policer_updates_parse(struct sja1105_static_config *config,
+                      struct sja1105_l2_policing_update *updates,
+                      int argc, char **argv)
+{
+	struct sja1105_l2_policing_update *update = NULL;
+	int count = 0;
+	int index;
+	int i, rc;
+
+	for (; argc; argc--, argv++) {
+		if (strchr(argv[0], '=') != NULL) {
+			if (update == NULL) {
+				return -EINVAL;
+			}
+			rc = policer_field_parse(&update->entry, argv[0]);
+			if (rc < 0) {
+				return -EINVAL;
+			}
+			continue;
+		}
+		rc = policer_index_from_string(&index, argv[0]);
+		if (rc < 0) {
+			return rc;
+		}
+		if (index >= config->l2_policing_count) {
+			loge("l2-policing-table has no entry %d", index);
+			return -ERANGE;
+		}
+		/* A policer given twice is updated once */
+		for (i = 0; i < count; i++) {
+			if (updates[i].index == index) {
+				break;
+			}
+		}
+		update = &updates[i];
+		if (i == count) {
+			update->index = index;
+			update->entry = config->l2_policing[index];
+			count++;
+		}
+	}
+	return count;
+}
+
+/* Applies a policer command to @config and, for "set", to the running
+ * switch (E/T only), all policers in one SPI transaction. See vlan_run. */
+int policer_run(struct sja1105_spi_setup *spi_setup,
+                struct sja1105_static_config *config,
+                int argc, char **argv)
+{
+	struct sja1105_l2_policing_update updates[MAX_L2_POLICING_COUNT];
+	int running;
+	int count;
+	int i, rc;
+
+	if (argc == 1 && strcmp(argv[0], "show") == 0) {
+		policer_show(config);
+		return SJA1105_ERR_OK;
+	}
+	if (argc < 2 || strcmp(argv[0], "set") != 0) {
+		rc = -EINVAL;
+		goto parse_error;
+	}
+	rc = policer_updates_parse(config, updates, argc - 1, argv + 1);
+	if (rc == -ERANGE) {
+		goto invalid_staging_area_error;
+	} else if (rc < 0) {
+		goto parse_error;
+	}
+	count = rc;
+	if (!IS_ET(spi_setup->device_id)) {
+		/* No dynamic reconfiguration of the policers on these */
+		for (i = 0; i < count; i++) {
+			config->l2_policing[updates[i].index] = updates[i].entry;
+		}
+		sja1105_static_config_mark_dirty(config, BLKID_L2_POLICING_TABLE);
+		loge("warning: SJA1105P/Q/R/S policers can only be changed "
+		     "in the staging area, run config upload to apply them");
+		return SJA1105_ERR_OK;
+	}
+	rc = sja1105_spi_configure(spi_setup);
+	if (rc < 0) {
+		loge("sja1105_spi_configure failed");
+		goto hardware_not_responding_error;
+	}
+	running = staging_area_change_begin(spi_setup, config);
+	for (i = 0; i < count; i++) {
+		config->l2_policing[updates[i].index] = updates[i].entry;
+	}
+	sja1105_static_config_mark_dirty(config, BLKID_L2_POLICING_TABLE);
+	rc = sja1105_l2_policing_set_batch(spi_setup, updates, count);
+	if (rc < 0) {
+		goto hardware_not_responding_staging_area_dirty_error;
+	}
+	logv("updated %d policers of the running switch", count);
+	if (running) {
+		staging_area_change_end(spi_setup, config);
+	}
+	return SJA1105_ERR_OK;
+parse_error:
+	sja1105_err_remap(rc, SJA1105_ERR_CMDLINE_PARSE);
+	print_usage();
+	return rc;
+invalid_staging_area_error:
+	sja1105_err_remap(rc, SJA1105_ERR_STAGING_AREA_INVALID);
+	return rc;
+hardware_not_responding_error:
+	sja1105_err_remap(rc, SJA1105_ERR_HW_NOT_RESPONDING);
+	return rc;
+hardware_not_responding_staging_area_dirty_error:
+	sja1105_err_remap(rc, SJA1105_ERR_HW_NOT_RESPONDING_STAGING_AREA_DIRTY);
+	return rc;
+}
+
+int policer_parse_args(struct sja1105_spi_setup *spi_setup,
+                       int argc, char **argv)
+{
+	if (argc < 1 || matches(argv[0], "help") == 0) {
+		print_usage();
+		return (argc < 1) ? -SJA1105_ERR_CMDLINE_PARSE : SJA1105_ERR_OK;
+	}
+	if (strcmp(argv[0], "show") == 0) {
+		struct sja1105_staging_area staging_area;
+		int rc;
+
+		sja1105_static_config_init(&staging_area.static_config);
+		rc = staging_area_load(spi_setup->staging_area, &staging_area);
+		if (rc == 0) {
+			rc = policer_run(spi_setup, &staging_area.static_config,
+			                 argc, argv);
+		}
+		sja1105_static_config_free(&staging_area.static_config);
+		return rc;
+	}
+	return staging_area_live_run(spi_setup, policer_run, argc, argv);
+}
@@ -0,0 +1,224 @@
+/******************************************************************************
+ * Copyright (c) 2018, NXP Semiconductors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <lib/include/ptp.h>
+#include <common.h>
+#include "internal.h"
+
+static void print_usage()
+{
+	printf("Usage:\n");
+	printf(" * sja1105-tool ptp clock [set|add <[-]sec.nsec>]\n");
+	printf(" * sja1105-tool ptp ts-clock\n");
+	printf(" * sja1105-tool ptp rate <ratio>\n");
+	printf(" * sja1105-tool ptp reset\n");
+	printf(" * sja1105-tool ptp qbv start|stop|status\n");
+}
+
+/* Parses "[-]sec[.nsec]" without going through a double,
+ * so that nanosecond precision is not lost */
+static int ptp_timespec_from_string(struct timespec *ts, char *str)
+{
+	char nsec_str[10] = "000000000";
+	uint64_t sec = 0;
+	uint64_t nsec = 0;
+	char *dot;
+	int negative = 0;
+	int rc;
+
+	if (str[0] == '-') {
+		negative = 1;
+		str++;
+	}
+	dot = strchr(str, '.');
+	if (dot) {
+		if (strlen(dot + 1) == 0 || strlen(dot + 1) > 9) {
+			return -EINVAL;
+		}
+		memcpy(nsec_str, dot + 1, strlen(dot + 1));
+		*dot = '\0';
+	}
+	rc = reliable_uint64_from_string(&sec, str, NULL);
+	if (dot) {
+		*dot = '.';
+	}
+	if (rc < 0) {
+		return rc;
+	}
+	rc = reliable_uint64_from_string(&nsec, nsec_str, NULL);
+	if (rc < 0) {
+		return rc;
+	}
+	ts->tv_sec  = negative ? -sec : sec;
+	ts->tv_nsec = negative ? -nsec : nsec;
+	return 0;
+}
+
+static void ptp_timespec_show(const char *name, struct timespec *ts)
+{
+	printf("%s: %ld.%09ld\n", name, (long) ts->tv_sec, ts->tv_nsec);
+}
+
+static int ptp_clock_parse_args(struct sja1105_spi_setup *spi_setup,
+                                int argc, char **argv)
+{
+	struct timespec ts;
+	int rc;
+
+	if (argc == 0) {
+		rc = sja1105_ptp_clk_get(spi_setup, &ts);
+		if (rc < 0) {
+			return rc;
+		}
+		ptp_timespec_show("PTPCLKVAL", &ts);
+		return 0;
+	}
+	if (argc != 2) {
+		return -EINVAL;
+	}
+	rc = ptp_timespec_from_string(&ts, argv[1]);
+	if (rc < 0) {
+		loge("Invalid time %s", argv[1]);
+		return rc;
+	}
+	if (strcmp(argv[0], "set") == 0) {
+		if (ts.tv_sec < 0 || ts.tv_nsec < 0) {
+			loge("Cannot set the clock to a negative time");
+			return -EINVAL;
+		}
+		return sja1105_ptp_clk_set(spi_setup, &ts);
+	} else if (strcmp(argv[0], "add") == 0) {
+		return sja1105_ptp_clk_add(spi_setup, &ts);
+	}
+	return -EINVAL;
+}
+
+static int ptp_qbv_parse_args(struct sja1105_spi_setup *spi_setup,
+                              int argc, char **argv)
+{
+	int rc;
+
+	if (argc != 1) {
+		return -EINVAL;
+	}
+	if (strcmp(argv[0], "start") == 0) {
+		return sja1105_ptp_qbv_start(spi_setup);
+	} else if (strcmp(argv[0], "stop") == 0) {
+		return sja1105_ptp_qbv_stop(spi_setup);
+	} else if (strcmp(argv[0], "status") == 0) {
+		rc = sja1105_ptp_qbv_running(spi_setup);
+		if (rc < 0) {
+			return rc;
+		}
+		printf("Qbv: %s\n", rc ? "running" : "stopped");
+		return 0;
+	}
+	return -EINVAL;
+}
+
+int ptp_parse_args(struct sja1105_spi_setup *spi_setup, int argc, char **argv)
+{
+	const char *ptp_options[] = {
+		"help",
+		"clock",
+		"ts-clock",
+		"rate",
+		"reset",
+		"qbv",
+	};
+	struct timespec ts;
+	double ratio;
+	char *end;
+	int match;
+	int rc;
+
+	if (argc < 1) {
+		goto out_parse_error_usage;
+	}
+	match = get_match(argv[0], ptp_options, ARRAY_SIZE(ptp_options));
+	if (match < 0) {
+		goto out_parse_error_usage;
+	}
+	argc--; argv++;
+	if (strcmp(ptp_options[match], "help") == 0) {
+		print_usage();
+		rc = 0;
+		goto out_ok;
+	}
+	rc = sja1105_spi_configure(spi_setup);
+	if (rc < 0) {
+		loge("failed to open spi device");
+		goto out_spi_configure_failed;
+	}
+	if (strcmp(ptp_options[match], "clock") == 0) {
+		rc = ptp_clock_parse_args(spi_setup, argc, argv);
+	} else if (strcmp(ptp_options[match], "ts-clock") == 0) {
+		if (argc != 0) {
+			goto out_parse_error_usage;
+		}
+		rc = sja1105_ptp_ts_clk_get(spi_setup, &ts);
+		if (rc == 0) {
+			ptp_timespec_show("PTPTSCLK", &ts);
+		}
+	} else if (strcmp(ptp_options[match], "rate") == 0) {
+		if (argc != 1) {
+			goto out_parse_error_usage;
+		}
+		ratio = strtod(argv[0], &end);
+		if (*end != '\0' || end == argv[0]) {
+			loge("Invalid ratio %s", argv[0]);
+			goto out_parse_error;
+		}
+		rc = sja1105_ptp_clk_rate_set(spi_setup, ratio);
+	} else if (strcmp(ptp_options[match], "reset") == 0) {
+		if (argc != 0) {
+			goto out_parse_error_usage;
+		}
+		rc = sja1105_ptp_reset(spi_setup);
+	} else if (strcmp(ptp_options[match], "qbv") == 0) {
+		rc = ptp_qbv_parse_args(spi_setup, argc, argv);
+	}
+	if (rc == -EINVAL) {
+		goto out_parse_error_usage;
+	}
+	goto out_ok;
+
+out_parse_error_usage:
+	print_usage();
+out_parse_error:
+	rc = -EINVAL;
+out_spi_configure_failed:
+out_ok:
+	return rc;
+}
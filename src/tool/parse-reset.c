@@ -80,6 +80,8 @@ int rgu_parse_args(struct sja1105_spi_setup *spi_setup, int argc, char **argv)
 		loge("failed to open spi device");
 		goto out_spi_configure_failed;
 	}
+	/* The next upload must not be skipped as a no-op */
+	staging_area_upload_forget(spi_setup);
 	rc = sja1105_reset_fn[match](spi_setup);
 	if (rc < 0) {
 		goto out_reset_failed;
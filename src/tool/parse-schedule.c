@@ -0,0 +1,610 @@
+/******************************************************************************
+ * Copyright (c) 2018, NXP Semiconductors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+#include <inttypes.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <lib/include/static-config.h>
+#include <common.h>
+#include "internal.h"
+
+static void print_usage()
+{
+	printf("Usage:\n");
+	printf(" * sja1105-tool schedule compile <cycles.json>|-\n");
+	printf(" * sja1105-tool schedule simulate [streams=<streams.json>]\n"
+	       "                                  [timeline=<file>|-] [format=csv|binary]\n");
+	printf("compile builds the schedule tables of the staging area from a\n"
+	       "JSON description of the cycles, read from stdin for \"-\".\n");
+	printf("simulate expands them into the gate states of each port over\n"
+	       "one hypercycle, and reports the worst-case latency of streams.\n");
+}
+
+/* Milliseconds, from a JSON number or string, to 200 ns ticks rounded to
+ * the nearest. @min_one makes anything above zero at least one tick. */
+static int schedule_ticks_from_json(uint64_t *ticks, struct json_value *value,
+                                    const char *name, int min_one)
+{
+	double ms;
+	int rc;
+
+	if (value == NULL ||
+	    (value->type != JSON_NUMBER && value->type != JSON_STRING)) {
+		loge("missing or invalid \"%s\"", name);
+		return -EINVAL;
+	}
+	rc = reliable_double_from_string(&ms, value->text, NULL);
+	if (rc < 0 || ms < 0) {
+		loge("invalid \"%s\": %s", name, value->text);
+		return -EINVAL;
+	}
+	*ticks = (uint64_t) (ms * 5000 + 0.5);
+	if (*ticks == 0 && ms > 0 && min_one) {
+		logv("%s of %s rounded up to 200 ns", name, value->text);
+		*ticks = 1;
+	}
+	return 0;
+}
+
+/* Bit mask of the numbers in JSON array @value, each below @limit */
+static int schedule_mask_from_json(uint64_t *mask, struct json_value *value,
+                                   const char *name, int limit)
+{
+	uint64_t bit;
+	int i, rc;
+
+	if (value == NULL || value->type != JSON_ARRAY) {
+		loge("missing or invalid \"%s\"", name);
+		return -EINVAL;
+	}
+	*mask = 0;
+	for (i = 0; i < value->count; i++) {
+		rc = reliable_uint64_from_string(&bit, value->items[i].text,
+		                                 NULL);
+		if (rc < 0 || bit >= (uint64_t) limit) {
+			loge("invalid \"%s\" element %s", name,
+			     value->items[i].text ? value->items[i].text : "");
+			return -EINVAL;
+		}
+		*mask |= 1ull << bit;
+	}
+	return 0;
+}
+
+static int schedule_clksrc_from_json(uint64_t *clksrc,
+                                     struct json_value *value)
+{
+	const char *names[] = {"disabled", "standalone", "as6802", "ptp"};
+	uint64_t i;
+
+	if (value == NULL || value->type != JSON_STRING) {
+		loge("missing or invalid \"clksrc\"");
+		return -EINVAL;
+	}
+	for (i = 0; i < ARRAY_SIZE(names); i++) {
+		if (strcmp(value->text, names[i]) == 0) {
+			*clksrc = i;
+			return 0;
+		}
+	}
+	loge("unknown clksrc value %s", value->text);
+	return -EINVAL;
+}
+
+/* Translates the JSON description of the cycles at @root into @desc.
+ * The timeslots are allocated and must be freed by the caller. */
+static int schedule_desc_from_json(struct sja1105_schedule_desc *desc,
+                                   struct json_value *root)
+{
+	struct sja1105_schedule_timeslot *slot;
+	struct sja1105_schedule_cycle *cycle;
+	struct json_value *cycles;
+	struct json_value *timeslots;
+	struct json_value *item;
+	int i, j, rc;
+
+	memset(desc, 0, sizeof(*desc));
+	rc = schedule_clksrc_from_json(&desc->clksrc, json_get(root, "clksrc"));
+	if (rc < 0) {
+		return rc;
+	}
+	cycles = json_get(root, "cycles");
+	if (cycles == NULL || cycles->type != JSON_ARRAY) {
+		loge("missing or invalid \"cycles\"");
+		return -EINVAL;
+	}
+	if (cycles->count > SJA1105_SCHEDULE_MAX_SUBSCHEDULES) {
+		loge("no more than %d cycles are supported, not %d",
+		     SJA1105_SCHEDULE_MAX_SUBSCHEDULES, cycles->count);
+		return -ERANGE;
+	}
+	for (i = 0; i < cycles->count; i++) {
+		item  = &cycles->items[i];
+		cycle = &desc->cycles[i];
+		desc->cycle_count++;
+		rc = schedule_ticks_from_json(&cycle->start_time,
+		                              json_get(item, "start-time-ms"),
+		                              "start-time-ms", 0);
+		if (rc < 0) {
+			return rc;
+		}
+		timeslots = json_get(item, "timeslots");
+		if (timeslots == NULL || timeslots->type != JSON_ARRAY) {
+			loge("cycle %d: missing or invalid \"timeslots\"", i);
+			return -EINVAL;
+		}
+		cycle->timeslots = calloc(timeslots->count + 1,
+		                          sizeof(*cycle->timeslots));
+		if (cycle->timeslots == NULL) {
+			return -ENOMEM;
+		}
+		for (j = 0; j < timeslots->count; j++) {
+			item = &timeslots->items[j];
+			slot = &cycle->timeslots[j];
+			cycle->timeslot_count++;
+			rc = schedule_ticks_from_json(&slot->delta,
+			                              json_get(item, "duration-ms"),
+			                              "duration-ms", 1);
+			if (rc < 0) {
+				return rc;
+			}
+			rc = schedule_mask_from_json(&slot->destports,
+			                             json_get(item, "ports"),
+			                             "ports", 5);
+			if (rc < 0) {
+				return rc;
+			}
+			rc = schedule_mask_from_json(&slot->gates_open,
+			                             json_get(item, "gates-open"),
+			                             "gates-open", 8);
+			if (rc < 0) {
+				return rc;
+			}
+		}
+	}
+	return 0;
+}
+
+static void schedule_desc_free(struct sja1105_schedule_desc *desc)
+{
+	int i;
+
+	for (i = 0; i < desc->cycle_count; i++) {
+		free(desc->cycles[i].timeslots);
+	}
+}
+
+static void schedule_budget_show(struct sja1105_schedule_budget *budget,
+                                 int cycle_count)
+{
+	int i;
+
+	logi("schedule: %d of %d entries for %d timeslots "
+	     "(%d merged, %d added for long windows)", budget->entries,
+	     MAX_SCHEDULE_COUNT, budget->timeslots, budget->merged,
+	     budget->split);
+	for (i = 0; i < cycle_count; i++) {
+		logv("subschedule %d: %d entries", i, budget->cycle_entries[i]);
+	}
+	if (budget->reordered) {
+		logv("cycles put in order of their start time");
+	}
+	if (budget->entries > MAX_SCHEDULE_COUNT) {
+		loge("schedule is %d entries over budget",
+		     budget->entries - MAX_SCHEDULE_COUNT);
+	}
+}
+
+/* Reads the "streams" array of @root. @names point into @root. */
+static int schedule_streams_from_json(struct sja1105_stream *streams,
+                                      const char **names,
+                                      struct json_value *list)
+{
+	struct json_value *item;
+	uint64_t port, tmp;
+	double ms;
+	int i, rc;
+
+	for (i = 0; i < list->count; i++) {
+		item = &list->items[i];
+		memset(&streams[i], 0, sizeof(streams[i]));
+		names[i] = (json_get(item, "name") != NULL) ?
+		           json_get(item, "name")->text : NULL;
+		if (json_get(item, "ingress-port") == NULL ||
+		    reliable_uint64_from_string(&port,
+		        json_get(item, "ingress-port")->text, NULL) < 0 ||
+		    port >= SJA1105_SCHEDULE_PORT_COUNT) {
+			loge("stream %d: missing or invalid \"ingress-port\"", i);
+			return -EINVAL;
+		}
+		streams[i].ingress_port = port;
+		if (json_get(item, "egress-ports") != NULL) {
+			rc = schedule_mask_from_json(&streams[i].egress_ports,
+			                             json_get(item, "egress-ports"),
+			                             "egress-ports",
+			                             SJA1105_SCHEDULE_PORT_COUNT);
+			if (rc < 0) {
+				return rc;
+			}
+		}
+		if (json_get(item, "priority") == NULL ||
+		    reliable_uint64_from_string(&tmp,
+		        json_get(item, "priority")->text, NULL) < 0 ||
+		    tmp > 7) {
+			loge("stream %d: missing or invalid \"priority\"", i);
+			return -EINVAL;
+		}
+		streams[i].prio = tmp;
+		if (json_get(item, "size") == NULL ||
+		    reliable_uint64_from_string(&tmp,
+		        json_get(item, "size")->text, NULL) < 0 ||
+		    tmp == 0) {
+			loge("stream %d: missing or invalid \"size\"", i);
+			return -EINVAL;
+		}
+		streams[i].size = tmp;
+		if (json_get(item, "period-ms") == NULL ||
+		    reliable_double_from_string(&ms,
+		        json_get(item, "period-ms")->text, NULL) < 0 ||
+		    ms < 0) {
+			loge("stream %d: missing or invalid \"period-ms\"", i);
+			return -EINVAL;
+		}
+		streams[i].period = (uint64_t) (ms * 1000000 + 0.5);
+	}
+	return 0;
+}
+
+static void put_le(unsigned char *buf, uint64_t value, int size)
+{
+	int i;
+
+	for (i = 0; i < size; i++) {
+		buf[i] = value >> (8 * i);
+	}
+}
+
+/* Writes the segments of all ports, in order of port then time. The
+ * binary format is the "SJAGATE1" magic, the little-endian 64-bit
+ * hypercycle and offset in ns, the 32-bit segment count, then 24 bytes
+ * per segment: 64-bit start and end, port, gate mask and 6 bytes of
+ * padding. */
+static int schedule_timeline_write(struct sja1105_gate_timeline *timeline,
+                                   const char *filename, int binary)
+{
+	struct sja1105_gate_segment *seg;
+	unsigned char buf[24];
+	FILE *fp = stdout;
+	int count = 0;
+	int port, i, g;
+	int rc = 0;
+
+	if (strcmp(filename, "-") != 0) {
+		fp = fopen(filename, binary ? "wb" : "w");
+		if (fp == NULL) {
+			loge("could not open %s for writing", filename);
+			return -errno;
+		}
+	}
+	for (port = 0; port < SJA1105_SCHEDULE_PORT_COUNT; port++) {
+		count += timeline->count[port];
+	}
+	if (binary) {
+		memcpy(buf, "SJAGATE1", 8);
+		put_le(buf + 8, timeline->length, 8);
+		put_le(buf + 16, timeline->offset, 8);
+		fwrite(buf, 24, 1, fp);
+		put_le(buf, count, 4);
+		fwrite(buf, 4, 1, fp);
+	} else {
+		fprintf(fp, "port,start_ns,end_ns");
+		for (g = 0; g < 8; g++) {
+			fprintf(fp, ",gate%d", g);
+		}
+		fprintf(fp, "\n");
+	}
+	for (port = 0; port < SJA1105_SCHEDULE_PORT_COUNT; port++) {
+		for (i = 0; i < timeline->count[port]; i++) {
+			seg = &timeline->segments[port][i];
+			if (binary) {
+				memset(buf, 0, sizeof(buf));
+				put_le(buf, seg->start, 8);
+				put_le(buf + 8, seg->end, 8);
+				buf[16] = port;
+				buf[17] = seg->gates_open;
+				fwrite(buf, sizeof(buf), 1, fp);
+				continue;
+			}
+			fprintf(fp, "%d,%" PRIu64 ",%" PRIu64, port,
+			        seg->start, seg->end);
+			for (g = 0; g < 8; g++) {
+				fprintf(fp, ",%d", (int) (seg->gates_open >> g) & 1);
+			}
+			fprintf(fp, "\n");
+		}
+	}
+	if (ferror(fp)) {
+		loge("could not write %s", filename);
+		rc = -EIO;
+	}
+	if (fp != stdout) {
+		fclose(fp);
+	}
+	return rc;
+}
+
+/* Percentage of the hypercycle that each gate of each port is open */
+static void schedule_timeline_show(struct sja1105_gate_timeline *timeline)
+{
+	struct sja1105_gate_segment *seg;
+	uint64_t open[8];
+	int port, i, g;
+
+	printf("hypercycle %" PRIu64 " ns, from %" PRIu64 " ns after the "
+	       "schedule start\n", timeline->length, timeline->offset);
+	printf("PORT");
+	for (g = 0; g < 8; g++) {
+		printf("  GATE%d", g);
+	}
+	printf("\n");
+	for (port = 0; port < SJA1105_SCHEDULE_PORT_COUNT; port++) {
+		memset(open, 0, sizeof(open));
+		for (i = 0; i < timeline->count[port]; i++) {
+			seg = &timeline->segments[port][i];
+			for (g = 0; g < 8; g++) {
+				if (seg->gates_open & (1 << g)) {
+					open[g] += seg->end - seg->start;
+				}
+			}
+		}
+		printf("%-4d", port);
+		for (g = 0; g < 8; g++) {
+			printf("  %4" PRIu64 "%%", open[g] * 100 / timeline->length);
+		}
+		printf("\n");
+	}
+}
+
+/* Prints the analysis of the streams in file @filename. Returns
+ * -ERANGE if a stream cannot be sent in its windows. */
+static int schedule_streams_show(struct sja1105_static_config *config,
+                                 struct sja1105_gate_timeline *timeline,
+                                 const char *filename)
+{
+	struct sja1105_stream_report *reports = NULL;
+	struct sja1105_stream *streams = NULL;
+	const char **names = NULL;
+	struct json_value root;
+	struct json_value *list;
+	char name[24];
+	int count;
+	int i, rc;
+
+	rc = json_parse_file(filename, &root);
+	if (rc < 0) {
+		return rc;
+	}
+	list = json_get(&root, "streams");
+	if (list == NULL || list->type != JSON_ARRAY) {
+		loge("missing or invalid \"streams\"");
+		rc = -EINVAL;
+		goto out;
+	}
+	count = list->count;
+	streams = calloc(count + 1, sizeof(*streams));
+	reports = calloc(count + 1, sizeof(*reports));
+	names   = calloc(count + 1, sizeof(*names));
+	if (streams == NULL || reports == NULL || names == NULL) {
+		rc = -ENOMEM;
+		goto out;
+	}
+	rc = schedule_streams_from_json(streams, names, list);
+	if (rc < 0) {
+		goto out;
+	}
+	rc = sja1105_stream_analyze(config, timeline, streams, count, reports);
+	if (rc < 0) {
+		goto out;
+	}
+	printf("%-16s %6s %5s %9s %12s %10s %11s\n", "STREAM", "EGRESS",
+	       "QUEUE", "TX (ns)", "WORST (ns)", "GUARD-BAND", "OVERRUN (ns)");
+	for (i = 0; i < count; i++) {
+		if (names[i] == NULL) {
+			snprintf(name, sizeof(name), "stream%d", i);
+		}
+		printf("%-16.16s %6d %5d %9" PRIu64 " ", names[i] ? names[i] : name,
+		       reports[i].egress_port, reports[i].egress_prio,
+		       reports[i].tx_time);
+		if (reports[i].worst_latency == SJA1105_LATENCY_UNBOUNDED) {
+			printf("%12s", "never");
+			rc = -ERANGE;
+		} else {
+			printf("%12" PRIu64, reports[i].worst_latency);
+		}
+		printf(" %10d %12" PRIu64 "%s\n", reports[i].violations,
+		       reports[i].worst_overrun,
+		       reports[i].overloaded ? "  overloaded" : "");
+		if (reports[i].overloaded) {
+			rc = -ERANGE;
+		}
+	}
+out:
+	free(streams);
+	free(reports);
+	free(names);
+	json_free(&root);
+	return rc;
+}
+
+/* Runs "schedule simulate" on @config */
+static int schedule_simulate(struct sja1105_static_config *config,
+                             int argc, char **argv)
+{
+	struct sja1105_gate_timeline timeline;
+	char *streams = NULL;
+	char *output = NULL;
+	int binary = 0;
+	char *value;
+	int i, rc;
+
+	for (i = 0; i < argc; i++) {
+		value = strchr(argv[i], '=');
+		if (value == NULL) {
+			rc = -EINVAL;
+			goto usage_error;
+		}
+		*value++ = 0;
+		if (strcmp(argv[i], "streams") == 0) {
+			streams = value;
+		} else if (strcmp(argv[i], "timeline") == 0) {
+			output = value;
+		} else if (strcmp(argv[i], "format") == 0 &&
+		           (strcmp(value, "csv") == 0 ||
+		            strcmp(value, "binary") == 0)) {
+			binary = (strcmp(value, "binary") == 0);
+		} else {
+			rc = -EINVAL;
+			goto usage_error;
+		}
+	}
+	rc = sja1105_gate_timeline_build(config, &timeline);
+	if (rc < 0) {
+		goto invalid_schedule_error;
+	}
+	if (output) {
+		rc = schedule_timeline_write(&timeline, output, binary);
+		if (rc < 0) {
+			sja1105_gate_timeline_free(&timeline);
+			goto filesystem_error;
+		}
+	}
+	if (output == NULL || strcmp(output, "-") != 0) {
+		schedule_timeline_show(&timeline);
+	}
+	if (streams) {
+		rc = schedule_streams_show(config, &timeline, streams);
+	}
+	sja1105_gate_timeline_free(&timeline);
+	if (rc == -ERANGE) {
+		goto invalid_schedule_error;
+	} else if (rc < 0) {
+		goto parse_error;
+	}
+	return SJA1105_ERR_OK;
+usage_error:
+	sja1105_err_remap(rc, SJA1105_ERR_CMDLINE_PARSE);
+	print_usage();
+	return rc;
+parse_error:
+	sja1105_err_remap(rc, SJA1105_ERR_CMDLINE_PARSE);
+	return rc;
+invalid_schedule_error:
+	sja1105_err_remap(rc, SJA1105_ERR_STAGING_AREA_INVALID);
+	return rc;
+filesystem_error:
+	sja1105_err_remap(rc, SJA1105_ERR_FILESYSTEM);
+	return rc;
+}
+
+/* Runs a schedule command on @config */
+int schedule_run(struct sja1105_spi_setup __attribute__((unused)) *spi_setup,
+                 struct sja1105_static_config *config,
+                 int argc, char **argv)
+{
+	struct sja1105_schedule_budget budget;
+	struct sja1105_schedule_desc desc;
+	struct json_value root;
+	int rc;
+
+	if (argc >= 1 && strcmp(argv[0], "simulate") == 0) {
+		return schedule_simulate(config, argc - 1, argv + 1);
+	}
+	if (argc != 2 || strcmp(argv[0], "compile") != 0) {
+		rc = -EINVAL;
+		goto usage_error;
+	}
+	rc = json_parse_file(argv[1], &root);
+	if (rc < 0) {
+		goto parse_error;
+	}
+	rc = schedule_desc_from_json(&desc, &root);
+	json_free(&root);
+	if (rc < 0) {
+		schedule_desc_free(&desc);
+		goto parse_error;
+	}
+	rc = sja1105_schedule_optimize(&desc, &budget);
+	if (rc < 0) {
+		schedule_desc_free(&desc);
+		goto invalid_schedule_error;
+	}
+	schedule_budget_show(&budget, desc.cycle_count);
+	rc = sja1105_schedule_compile(config, &desc);
+	schedule_desc_free(&desc);
+	if (rc < 0) {
+		goto invalid_schedule_error;
+	}
+	return SJA1105_ERR_OK;
+usage_error:
+	sja1105_err_remap(rc, SJA1105_ERR_CMDLINE_PARSE);
+	print_usage();
+	return rc;
+parse_error:
+	sja1105_err_remap(rc, SJA1105_ERR_CMDLINE_PARSE);
+	return rc;
+invalid_schedule_error:
+	sja1105_err_remap(rc, SJA1105_ERR_STAGING_AREA_INVALID);
+	return rc;
+}
+
+int schedule_parse_args(struct sja1105_spi_setup *spi_setup,
+                        int argc, char **argv)
+{
+	if (argc < 1 || matches(argv[0], "help") == 0) {
+		print_usage();
+		return (argc < 1) ? -SJA1105_ERR_CMDLINE_PARSE : SJA1105_ERR_OK;
+	}
+	if (strcmp(argv[0], "simulate") == 0) {
+		struct sja1105_staging_area staging_area;
+		int rc;
+
+		sja1105_static_config_init(&staging_area.static_config);
+		rc = staging_area_load(spi_setup->staging_area, &staging_area);
+		if (rc == 0) {
+			rc = schedule_run(spi_setup, &staging_area.static_config,
+			                  argc, argv);
+		}
+		sja1105_static_config_free(&staging_area.static_config);
+		return rc;
+	}
+	return staging_area_live_run(spi_setup, schedule_run, argc, argv);
+}
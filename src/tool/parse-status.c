@@ -31,9 +31,12 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <inttypes.h>
 #include "internal.h"
 #include <lib/include/status.h>
 
+static const char *default_counters_shm = "/dev/shm/sja1105-counters";
+
 static void print_usage()
 {
 	printf("Usage: sja1105-tool status [ type ] [ options ]\n");
@@ -41,11 +44,145 @@ static void print_usage()
 	printf(" * general -> General Status Information Register\n");
 	printf(" * port    -> Port status Information Register\n" \
 	       "              Provide Port No. as argument [0-4]\n");
+	printf(" * poll    -> Sample the port counters periodically and\n"
+	       "              publish them in shared memory. Options:\n"
+	       "              [-i|--interval <ms>] (default 1000)\n"
+	       "              [-n|--count <samples>] (default 0, forever)\n"
+	       "              [-s|--shm <file>] (default %s)\n"
+	       "              [-q|--quiet]\n"
+	       "              [-r|--read] show the newest sample published\n"
+	       "              by another poller, without accessing the switch\n",
+	       default_counters_shm);
+}
+
+static void
+status_counters_show(const struct sja1105_counters_sample *sample, int all)
+{
+	const struct sja1105_port_counters *port;
+	int i, p;
+
+	printf("Sample %" PRIu64 " at %ld.%09ld, interval %" PRIu64 " ns\n",
+	       sample->seq, (long) sample->timestamp.tv_sec,
+	       sample->timestamp.tv_nsec, sample->interval_ns);
+	for (p = 0; p < 5; p++) {
+		port = &sample->port[p];
+		printf("Port %d: rx %.0f frames/s %.0f bytes/s, "
+		       "tx %.0f frames/s %.0f bytes/s, "
+		       "drops %" PRIu64 " (%.0f/s)\n", p,
+		       port->rx_frames_rate, port->rx_bytes_rate,
+		       port->tx_frames_rate, port->tx_bytes_rate,
+		       port->drops, port->drops_rate);
+		if (!all) {
+			continue;
+		}
+		for (i = 0; i < SJA1105_CNT_MAX; i++) {
+			printf("    %-16s %20" PRIu64 " (+%" PRIu64 ")\n",
+			       sja1105_counter_name(i), port->total[i],
+			       port->delta[i]);
+		}
+	}
+}
+
+static int status_poll_cb(const struct sja1105_counters_sample *sample,
+                          void *priv)
+{
+	int quiet = *(int*) priv;
+
+	if (!quiet) {
+		status_counters_show(sample, 0);
+		fflush(stdout);
+	}
+	return 0;
+}
+
+static int status_poll(struct sja1105_spi_setup *spi_setup,
+                       int argc, char **argv)
+{
+	const char *shm = default_counters_shm;
+	struct sja1105_counters_sample sample;
+	struct sja1105_counters_ring *ring;
+	struct sja1105_counters *counters;
+	uint64_t interval_ms = 1000;
+	uint64_t count = 0;
+	int read_only = 0;
+	int quiet = 0;
+	int rc;
+
+	for (; argc; argc--, argv++) {
+		if (matches(argv[0], "-r") == 0 ||
+		    matches(argv[0], "--read") == 0) {
+			read_only = 1;
+		} else if (matches(argv[0], "-q") == 0 ||
+		           matches(argv[0], "--quiet") == 0) {
+			quiet = 1;
+		} else if (argc < 2) {
+			return -EINVAL;
+		} else if (matches(argv[0], "-i") == 0 ||
+		           matches(argv[0], "--interval") == 0) {
+			rc = reliable_uint64_from_string(&interval_ms, argv[1], NULL);
+			if (rc < 0 || interval_ms == 0) {
+				loge("Invalid interval %s", argv[1]);
+				return -EINVAL;
+			}
+			argc--; argv++;
+		} else if (matches(argv[0], "-n") == 0 ||
+		           matches(argv[0], "--count") == 0) {
+			rc = reliable_uint64_from_string(&count, argv[1], NULL);
+			if (rc < 0) {
+				loge("Invalid count %s", argv[1]);
+				return -EINVAL;
+			}
+			argc--; argv++;
+		} else if (matches(argv[0], "-s") == 0 ||
+		           matches(argv[0], "--shm") == 0) {
+			shm = argv[1];
+			argc--; argv++;
+		} else {
+			return -EINVAL;
+		}
+	}
+	if (read_only) {
+		rc = sja1105_counters_ring_open(shm, &ring);
+		if (rc < 0) {
+			return rc;
+		}
+		rc = sja1105_counters_ring_read(ring, 0, &sample);
+		if (rc == -EAGAIN) {
+			loge("No sample was published yet");
+		} else if (rc == 0) {
+			status_counters_show(&sample, 1);
+		}
+		sja1105_counters_ring_close(ring);
+		return rc;
+	}
+	rc = sja1105_spi_configure(spi_setup);
+	if (rc < 0) {
+		loge("sja1105_spi_configure failed");
+		return rc;
+	}
+	counters = malloc(sizeof(*counters));
+	if (!counters) {
+		return -ENOMEM;
+	}
+	sja1105_counters_init(counters);
+	rc = sja1105_counters_ring_create(shm, 64, &ring);
+	if (rc < 0) {
+		loge("cannot create counters ring %s", shm);
+		goto out_free;
+	}
+	rc = sja1105_counters_run(spi_setup, counters, ring,
+	                          interval_ms * 1000000ull, count,
+	                          status_poll_cb, &quiet);
+	sja1105_counters_ring_close(ring);
+out_free:
+	free(counters);
+	return rc;
 }
 
 static int status_ports(struct sja1105_spi_setup *spi_setup,
                         int port_no)
 {
+	struct sja1105_port_status_snapshot snapshot;
 	struct sja1105_port_status status;
 	char *print_buf[5];
 	/* XXX Maybe not quite right? */
@@ -58,13 +195,17 @@ static int status_ports(struct sja1105_spi_setup *spi_setup,
 		for (i = 0; i < 5; i++) {
 			print_buf[i] = (char*) calloc(size, sizeof(char));
 		}
-		for (i = 0; i < 5; i++) {
-			rc = sja1105_port_status_get(spi_setup, &status, i);
-			if (rc < 0) {
-				loge("sja1105_port_status_get failed");
-				goto out;
+		/* Sample the counters of all ports at the same time */
+		rc = sja1105_port_status_snapshot_get(spi_setup, &snapshot);
+		if (rc < 0) {
+			loge("sja1105_port_status_snapshot_get failed");
+			for (i = 0; i < 5; i++) {
+				free(print_buf[i]);
 			}
-			sja1105_port_status_show(&status, i, print_buf[i],
+			goto out;
+		}
+		for (i = 0; i < 5; i++) {
+			sja1105_port_status_show(&snapshot.port[i], i, print_buf[i],
 			                         spi_setup->device_id);
 		}
 		linewise_concat(print_buf, 5);
@@ -95,6 +236,7 @@ int status_parse_args(struct sja1105_spi_setup *spi_setup,
 	const char *options[] = {
 		"general",
 		"ports",
+		"poll",
 	};
 	uint64_t tmp;
 	int clear = 0;
@@ -165,6 +307,14 @@ int status_parse_args(struct sja1105_spi_setup *spi_setup,
 				goto error;
 			}
 		}
+	} else if (matches(options[match], "poll") == 0) {
+		rc = status_poll(spi_setup, argc - 1, argv + 1);
+		if (rc == -EINVAL) {
+			goto parse_error;
+		} else if (rc < 0) {
+			loge("polling the port counters failed");
+			goto error;
+		}
 	} else {
 		rc = -EINVAL;
 		goto parse_error;
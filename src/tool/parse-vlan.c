@@ -0,0 +1,124 @@
+/******************************************************************************
+ * Copyright (c) 2018, NXP Semiconductors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <lib/include/dynamic-config.h>
+#include <lib/include/static-config.h>
+#include <common.h>
+#include "internal.h"
+
+static void print_usage()
+{
+	printf("Usage:\n");
+	printf(" * sja1105-tool vlan add <vid>[-<vid>] <ports> [<tagged>]\n");
+	printf(" * sja1105-tool vlan set <vid>[-<vid>] <ports> [<tagged>]\n");
+	printf(" * sja1105-tool vlan del <vid>[-<vid>] [<ports>]\n");
+	printf("<ports> and <tagged> are port masks (bit 0 is port 0).\n");
+}
+
+/* Applies a vlan command to @config and to the running switch, which
+ * is only told about the VIDs whose entry changed. If the switch ran
+ * @config before, it is recorded as running the new one afterwards.
+ * When the switch could not be updated, @config is changed anyway and
+ * -SJA1105_ERR_HW_NOT_RESPONDING_STAGING_AREA_DIRTY is returned.
+ */
+int vlan_run(struct sja1105_spi_setup *spi_setup,
+             struct sja1105_static_config *config,
+             int argc, char **argv)
+{
+	struct sja1105_vlan_lookup_entry *old_entries;
+	int old_count = config->vlan_lookup_count;
+	int running;
+	int rc;
+
+	old_entries = malloc(old_count * sizeof(*old_entries) + 1);
+	if (!old_entries) {
+		rc = -ENOMEM;
+		goto propagated_error;
+	}
+	memcpy(old_entries, config->vlan_lookup,
+	       old_count * sizeof(*old_entries));
+
+	rc = sja1105_spi_configure(spi_setup);
+	if (rc < 0) {
+		loge("sja1105_spi_configure failed");
+		goto hardware_not_responding_error;
+	}
+	running = staging_area_change_begin(spi_setup, config);
+	rc = config_vlan(config, argc, argv);
+	if (rc < 0) {
+		if (running) {
+			/* Nothing was changed */
+			staging_area_change_end(spi_setup, config);
+		}
+		if (rc == -EINVAL) {
+			goto parse_error;
+		}
+		goto invalid_staging_area_error;
+	}
+	rc = sja1105_vlan_sync(spi_setup, old_entries, old_count,
+	                       config->vlan_lookup, config->vlan_lookup_count);
+	if (rc < 0) {
+		goto hardware_not_responding_staging_area_dirty_error;
+	}
+	logv("updated %d VLANs of the running switch", rc);
+	if (running) {
+		staging_area_change_end(spi_setup, config);
+	}
+	rc = SJA1105_ERR_OK;
+	goto out;
+parse_error:
+	sja1105_err_remap(rc, SJA1105_ERR_CMDLINE_PARSE);
+	print_usage();
+	goto out;
+invalid_staging_area_error:
+	sja1105_err_remap(rc, SJA1105_ERR_STAGING_AREA_INVALID);
+	goto out;
+hardware_not_responding_error:
+	sja1105_err_remap(rc, SJA1105_ERR_HW_NOT_RESPONDING);
+	goto out;
+hardware_not_responding_staging_area_dirty_error:
+	sja1105_err_remap(rc, SJA1105_ERR_HW_NOT_RESPONDING_STAGING_AREA_DIRTY);
+propagated_error:
+out:
+	free(old_entries);
+	return rc;
+}
+
+int vlan_parse_args(struct sja1105_spi_setup *spi_setup, int argc, char **argv)
+{
+	if (argc < 1 || matches(argv[0], "help") == 0) {
+		print_usage();
+		return (argc < 1) ? -SJA1105_ERR_CMDLINE_PARSE : SJA1105_ERR_OK;
+	}
+	return staging_area_live_run(spi_setup, vlan_run, argc, argv);
+}
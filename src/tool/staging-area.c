@@ -30,9 +30,11 @@
  *****************************************************************************/
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
 #include <stdlib.h>
 #include <unistd.h>
 #include <fcntl.h>
+#include <limits.h>
 #include <stdio.h>
 #include <string.h>
 #include <inttypes.h>
@@ -132,18 +134,22 @@ invalid_staging_area_error:
 	return rc;
 }
 
+/* Maps @staging_area_file and indexes its table headers. No table is
+ * decoded yet: use staging_area_map_get for the ones that are needed, or
+ * staging_area_map_get_all. They are decoded into @staging_area, which
+ * must be initialized, and stay valid after staging_area_map_close.
+ */
 int
-staging_area_load(const char *staging_area_file,
-                  struct sja1105_staging_area *staging_area)
+staging_area_map_open(const char *staging_area_file,
+                      struct staging_area_map *map,
+                      struct sja1105_staging_area *staging_area)
 {
-	struct sja1105_static_config *static_config;
 	struct stat stat;
-	unsigned int staging_area_len;
-	char *buf;
 	int fd;
 	int rc;
 
-	static_config = &staging_area->static_config;
+	memset(map, 0, sizeof(*map));
+	map->staging_area = staging_area;
 
 	fd = open(staging_area_file, O_RDONLY);
 	if (fd < 0) {
@@ -156,34 +162,92 @@ staging_area_load(const char *staging_area_file,
 		loge("could not read file size");
 		goto filesystem_error2;
 	}
-	staging_area_len = stat.st_size;
-	buf = (char*) malloc(staging_area_len * sizeof(char));
-	if (!buf) {
-		loge("malloc failed");
-		goto filesystem_error2;
+	if (stat.st_size == 0) {
+		loge("Staging area %s is empty", staging_area_file);
+		rc = -EINVAL;
+		goto invalid_staging_area_error;
 	}
-	rc = reliable_read(fd, buf, staging_area_len);
-	if (rc < 0) {
-		loge("failed to read staging area from file %s",
+	map->len = stat.st_size;
+	map->buf = mmap(NULL, map->len, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (map->buf == MAP_FAILED) {
+		loge("failed to map staging area from file %s",
 		     staging_area_file);
-		goto filesystem_error3;
+		map->buf = NULL;
+		rc = -errno;
+		goto filesystem_error2;
 	}
-	/* Static config */
-	rc = sja1105_static_config_unpack(buf, static_config);
+	/* The mapping holds its own reference to the file */
+	close(fd);
+	rc = sja1105_static_config_index(map->buf, map->len, &map->index);
 	if (rc < 0) {
 		loge("error while interpreting config");
-		goto invalid_staging_area_error;
+		staging_area_map_close(map);
+		sja1105_err_remap(rc, SJA1105_ERR_STAGING_AREA_INVALID);
+		return rc;
 	}
+	sja1105_static_config_free(&staging_area->static_config);
+	staging_area->static_config.device_id = map->index.device_id;
 	return 0;
-filesystem_error3:
-	free(buf);
+invalid_staging_area_error:
+	close(fd);
+	sja1105_err_remap(rc, SJA1105_ERR_STAGING_AREA_INVALID);
+	return rc;
 filesystem_error2:
 	close(fd);
 filesystem_error1:
 	sja1105_err_remap(rc, SJA1105_ERR_FILESYSTEM);
 	return rc;
-invalid_staging_area_error:
-	sja1105_err_remap(rc, SJA1105_ERR_STAGING_AREA_INVALID);
+}
+
+/* Decodes table @blk_id, if it was not decoded already */
+int staging_area_map_get(struct staging_area_map *map, int blk_id)
+{
+	int rc;
+
+	rc = sja1105_static_config_unpack_table(map->buf, &map->index, blk_id,
+	                                        &map->staging_area->static_config);
+	if (rc < 0) {
+		loge("error while interpreting config");
+		sja1105_err_remap(rc, SJA1105_ERR_STAGING_AREA_INVALID);
+	}
+	return rc;
+}
+
+int staging_area_map_get_all(struct staging_area_map *map)
+{
+	int rc;
+
+	rc = sja1105_static_config_unpack_tables(map->buf, &map->index,
+	                                         &map->staging_area->static_config);
+	if (rc < 0) {
+		loge("error while interpreting config");
+		sja1105_err_remap(rc, SJA1105_ERR_STAGING_AREA_INVALID);
+	}
+	return rc;
+}
+
+void staging_area_map_close(struct staging_area_map *map)
+{
+	sja1105_static_config_index_free(&map->index);
+	if (map->buf != NULL) {
+		munmap(map->buf, map->len);
+		map->buf = NULL;
+	}
+}
+
+int
+staging_area_load(const char *staging_area_file,
+                  struct sja1105_staging_area *staging_area)
+{
+	struct staging_area_map map;
+	int rc;
+
+	rc = staging_area_map_open(staging_area_file, &map, staging_area);
+	if (rc < 0) {
+		return rc;
+	}
+	rc = staging_area_map_get_all(&map);
+	staging_area_map_close(&map);
 	return rc;
 }
 
@@ -235,57 +299,328 @@ out_1:
 	return rc;
 }
 
+/* Changes a single entry of the staging area directly in its packed
+ * form. The file is mapped shared, so only the pages holding the table
+ * headers, that entry and the data CRC of its table are read, and only
+ * the latter two are written back. Only that entry is unpacked, passed
+ * to @modify and packed back.
+ * Returns -EAGAIN when the staging area cannot be patched in place
+ * (e.g. missing table, index out of bounds, unreadable file). The caller
+ * should then go through staging_area_load and staging_area_save, which
+ * also take care of reporting the problem.
+ */
+int
+staging_area_patch(const char *staging_area_file, int blk_id, int entry_index,
+                   int (*modify)(struct sja1105_static_config*,
+                                 int, char*, char*),
+                   char *field_name, char *field_val)
+{
+	struct sja1105_static_config static_config;
+	struct sja1105_table_location loc;
+	struct stat stat;
+	size_t staging_area_len;
+	char *buf;
+	int fd;
+	int rc = -EAGAIN;
+
+	fd = open(staging_area_file, O_RDWR);
+	if (fd < 0) {
+		goto out_1;
+	}
+	if (fstat(fd, &stat) < 0 || stat.st_size == 0) {
+		goto out_2;
+	}
+	staging_area_len = stat.st_size;
+	buf = mmap(NULL, staging_area_len, PROT_READ | PROT_WRITE,
+	           MAP_SHARED, fd, 0);
+	if (buf == MAP_FAILED) {
+		goto out_2;
+	}
+	if (sja1105_static_config_locate(buf, staging_area_len,
+	                                 blk_id, &loc) < 0) {
+		goto out_3;
+	}
+	if (entry_index < 0 || entry_index >= loc.entry_count) {
+		goto out_3;
+	}
+	/* Only the table being patched gets allocated */
+	sja1105_static_config_init(&static_config);
+	if (sja1105_static_config_entry_unpack(buf, &loc, entry_index,
+	                                       &static_config) < 0) {
+		goto out_4;
+	}
+	rc = modify(&static_config, entry_index, field_name, field_val);
+	if (rc < 0) {
+		loge("modify failed!");
+		goto out_4;
+	}
+	/* Writes go straight to the page cache of the file */
+	rc = sja1105_static_config_entry_pack(buf, &loc, entry_index,
+	                                      &static_config);
+	if (rc < 0) {
+		rc = -EAGAIN;
+		goto out_4;
+	}
+	logv("patched %d bytes of table 0x%02x in place",
+	     loc.entry_size, blk_id);
+out_4:
+	sja1105_static_config_free(&static_config);
+out_3:
+	munmap(buf, staging_area_len);
+out_2:
+	close(fd);
+out_1:
+	return rc;
+}
+
+/* Packs @config into a newly allocated buffer, ready to be sent to the
+ * switch. Returns the length of the buffer.
+ */
 static int
-static_config_upload(struct sja1105_spi_setup *spi_setup,
-                     struct sja1105_static_config *config)
+static_config_pack_for_upload(struct sja1105_static_config *config,
+                              char **config_buf)
 {
 	struct   sja1105_table_header final_header;
 	char    *final_header_ptr;
-	char  *config_buf;
 	int    config_buf_len;
-	int    crc_len;
 	int    rc;
 
 	config_buf_len = sja1105_static_config_get_length(config);
-	config_buf = (char*) malloc(config_buf_len * sizeof(char));
-	if (!config_buf) {
+	*config_buf = (char*) malloc(config_buf_len * sizeof(char));
+	if (!*config_buf) {
 		loge("malloc failed");
-		rc = -errno;
-		goto out;
+		return -errno;
 	}
 	/* Write Device ID and config tables to config_buf */
-	rc = sja1105_static_config_pack(config_buf, config);
+	rc = sja1105_static_config_pack(*config_buf, config);
 	if (rc < 0) {
 		loge("sja1105_static_config_pack failed");
-		goto out_free;
+		free(*config_buf);
+		return rc;
 	}
-	/* Recalculate CRC of the last header */
-	/* Don't include the CRC field itself */
-	crc_len = config_buf_len - 4;
+	/* Recalculate CRC of the last header.
+	 * The CRC of everything but the CRC field itself was already
+	 * derived while packing, from the cached per-table CRCs. */
 	/* Read the whole table header */
-	final_header_ptr = config_buf + config_buf_len - SIZE_TABLE_HEADER;
+	final_header_ptr = *config_buf + config_buf_len - SIZE_TABLE_HEADER;
 	sja1105_table_header_unpack(final_header_ptr, &final_header);
 	/* Modify */
-	final_header.crc = ether_crc32_le(config_buf, crc_len);
+	final_header.crc = config->packed_crc;
 	/* Rewrite */
 	sja1105_table_header_pack(final_header_ptr, &final_header);
+	return config_buf_len;
+}
 
-	rc = sja1105_spi_send_long_packed_buf(spi_setup,
-	                                      SPI_WRITE,
-	                                      CONFIG_ADDR,
-	                                      config_buf,
-	                                      config_buf_len);
-out_free:
+/* What was last uploaded successfully, as kept in spi_setup->upload_state.
+ * /run is a good place for it: it goes away together with the
+ * configuration of the switch when the board reboots.
+ */
+struct upload_record {
+	uint64_t device_id;
+	uint64_t part_nr;
+	uint64_t len;
+	uint64_t hash; /* 64-bit FNV-1a of the uploaded blob */
+};
+
+static void
+upload_record_get(struct sja1105_spi_setup *spi_setup, char *buf, int len,
+                  struct upload_record *record)
+{
+	uint64_t hash = 0xcbf29ce484222325ull;
+	int i;
+
+	for (i = 0; i < len; i++) {
+		hash ^= (uint8_t) buf[i];
+		hash *= 0x100000001b3ull;
+	}
+	record->device_id = spi_setup->device_id;
+	record->part_nr = spi_setup->part_nr;
+	record->len = len;
+	record->hash = hash;
+}
+
+static int
+upload_record_read(const char *path, struct upload_record *record)
+{
+	FILE *f;
+	int rc;
+
+	f = fopen(path, "r");
+	if (f == NULL) {
+		return -errno;
+	}
+	rc = fscanf(f, "device_id = 0x%" SCNx64 "\n"
+	               "part_nr = 0x%" SCNx64 "\n"
+	               "length = %" SCNu64 "\n"
+	               "hash = 0x%" SCNx64 "\n",
+	            &record->device_id, &record->part_nr,
+	            &record->len, &record->hash);
+	fclose(f);
+	return (rc == 4) ? 0 : -EINVAL;
+}
+
+static void
+upload_record_write(const char *path, struct upload_record *record)
+{
+	char tmp_path[PATH_MAX];
+	FILE *f;
+	int rc;
+
+	/* Written under another name first, so that a crash
+	 * never leaves a partial record behind */
+	snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+	f = fopen(tmp_path, "w");
+	if (f == NULL) {
+		logv("could not write upload record %s", tmp_path);
+		return;
+	}
+	fprintf(f, "device_id = 0x%" PRIx64 "\n"
+	           "part_nr = 0x%" PRIx64 "\n"
+	           "length = %" PRIu64 "\n"
+	           "hash = 0x%016" PRIx64 "\n",
+	        record->device_id, record->part_nr,
+	        record->len, record->hash);
+	rc = fclose(f);
+	if (rc < 0 || rename(tmp_path, path) < 0) {
+		logv("could not write upload record %s", path);
+		unlink(tmp_path);
+	}
+}
+
+/* Drops the record of the last upload. To be called before anything
+ * that may leave the switch without the config that was last uploaded.
+ */
+void staging_area_upload_forget(struct sja1105_spi_setup *spi_setup)
+{
+	if (spi_setup->upload_state != NULL) {
+		unlink(spi_setup->upload_state);
+	}
+}
+
+/* Tells whether the switch still runs the config described by @record,
+ * in which case uploading it again can be skipped.
+ */
+static int
+static_config_is_running(struct sja1105_spi_setup *spi_setup,
+                         struct upload_record *record)
+{
+	struct sja1105_general_status status;
+	struct upload_record last;
+
+	if (spi_setup->force || spi_setup->dry_run ||
+	    spi_setup->upload_state == NULL) {
+		return 0;
+	}
+	if (upload_record_read(spi_setup->upload_state, &last) < 0) {
+		return 0;
+	}
+	if (memcmp(&last, record, sizeof(last)) != 0) {
+		return 0;
+	}
+	/* The switch may have been reset or power cycled behind our back */
+	if (sja1105_general_status_get(spi_setup, &status) < 0) {
+		return 0;
+	}
+	return status.configs == 1 && status.ids == 0;
+}
+
+/* For changes that are applied to the running switch through the
+ * dynamic reconfiguration registers, and to the staging area in step.
+ *
+ * staging_area_change_begin tells whether the switch runs @config as
+ * it was last uploaded, and drops the upload record, since the switch
+ * will be somewhere in between until the change is complete. Once it
+ * is, staging_area_change_end records the changed @config as running,
+ * so that uploading it is skipped as if it had been uploaded.
+ */
+int staging_area_change_begin(struct sja1105_spi_setup *spi_setup,
+                              struct sja1105_static_config *config)
+{
+	struct upload_record record;
+	char *config_buf;
+	int running;
+	int rc;
+
+	rc = static_config_pack_for_upload(config, &config_buf);
+	if (rc < 0) {
+		return 0;
+	}
+	upload_record_get(spi_setup, config_buf, rc, &record);
+	free(config_buf);
+	running = static_config_is_running(spi_setup, &record);
+	staging_area_upload_forget(spi_setup);
+	return running;
+}
+
+void staging_area_change_end(struct sja1105_spi_setup *spi_setup,
+                             struct sja1105_static_config *config)
+{
+	struct upload_record record;
+	char *config_buf;
+	int rc;
+
+	if (spi_setup->upload_state == NULL) {
+		return;
+	}
+	rc = static_config_pack_for_upload(config, &config_buf);
+	if (rc < 0) {
+		return;
+	}
+	upload_record_get(spi_setup, config_buf, rc, &record);
 	free(config_buf);
+	upload_record_write(spi_setup->upload_state, &record);
+}
+
+/* Runs a command that changes the running switch and the staging area
+ * in step (see vlan_run). The staging area is saved even if the switch
+ * could not be updated, since it then holds what the switch should run.
+ */
+int staging_area_live_run(struct sja1105_spi_setup *spi_setup,
+                          int (*run)(struct sja1105_spi_setup*,
+                                     struct sja1105_static_config*,
+                                     int argc, char **argv),
+                          int argc, char **argv)
+{
+	struct sja1105_staging_area staging_area;
+	int rc;
+
+	sja1105_static_config_init(&staging_area.static_config);
+	rc = staging_area_load(spi_setup->staging_area, &staging_area);
+	if (rc < 0) {
+		goto out;
+	}
+	rc = run(spi_setup, &staging_area.static_config, argc, argv);
+	if (rc < 0 &&
+	    rc != -SJA1105_ERR_HW_NOT_RESPONDING_STAGING_AREA_DIRTY) {
+		goto out;
+	}
+	if (staging_area_save(spi_setup->staging_area, &staging_area) < 0) {
+		sja1105_err_remap(rc, SJA1105_ERR_FILESYSTEM);
+	}
 out:
+	sja1105_static_config_free(&staging_area.static_config);
 	return rc;
 }
 
+static int
+static_config_upload(struct sja1105_spi_setup *spi_setup,
+                     char *config_buf, int config_buf_len)
+{
+	return sja1105_spi_send_long_packed_buf(spi_setup,
+	                                        SPI_WRITE,
+	                                        CONFIG_ADDR,
+	                                        config_buf,
+	                                        config_buf_len);
+}
+
 int static_config_flush(struct sja1105_spi_setup *spi_setup,
                         struct sja1105_static_config *config)
 {
 	struct sja1105_general_status status;
 	struct sja1105_egress_port_mask port_mask;
+	struct upload_record record;
+	char *config_buf = NULL;
+	int config_buf_len;
 	int i, rc;
 
 	rc = sja1105_static_config_check_valid(config);
@@ -293,6 +628,19 @@ int static_config_flush(struct sja1105_spi_setup *spi_setup,
 		loge("cannot upload config, because it is not valid");
 		goto staging_area_invalid_error;
 	}
+	rc = static_config_pack_for_upload(config, &config_buf);
+	if (rc < 0) {
+		goto staging_area_invalid_error;
+	}
+	config_buf_len = rc;
+	upload_record_get(spi_setup, config_buf, config_buf_len, &record);
+	if (static_config_is_running(spi_setup, &record)) {
+		logi("switch already runs this config, not uploading it again");
+		rc = SJA1105_ERR_OK;
+		goto out;
+	}
+	/* From here on, the switch no longer runs what was last uploaded */
+	staging_area_upload_forget(spi_setup);
 	/* Workaround for PHY jabbering during switch reset */
 	memset(&port_mask, 0, sizeof(port_mask));
 	for (i = 0; i < SJA1105T_NUM_PORTS; i++) {
@@ -314,7 +662,7 @@ int static_config_flush(struct sja1105_spi_setup *spi_setup,
 		loge("sja1105_reset failed");
 		goto hardware_left_floating_error;
 	}
-	rc = static_config_upload(spi_setup, config);
+	rc = static_config_upload(spi_setup, config_buf, config_buf_len);
 	if (rc < 0) {
 		loge("static_config_upload failed");
 		goto hardware_left_floating_error;
@@ -352,16 +700,22 @@ int static_config_flush(struct sja1105_spi_setup *spi_setup,
 			loge("configuration is invalid");
 			goto hardware_left_floating_error;
 		}
+		if (spi_setup->upload_state != NULL) {
+			upload_record_write(spi_setup->upload_state, &record);
+		}
 	}
-	return SJA1105_ERR_OK;
+	rc = SJA1105_ERR_OK;
+	goto out;
 staging_area_invalid_error:
 	sja1105_err_remap(rc, SJA1105_ERR_STAGING_AREA_INVALID);
-	return rc;
+	goto out;
 hardware_left_floating_error:
 	sja1105_err_remap(rc, SJA1105_ERR_UPLOAD_FAILED_HW_LEFT_FLOATING);
-	return rc;
+	goto out;
 hardware_not_responding_error:
 	sja1105_err_remap(rc, SJA1105_ERR_HW_NOT_RESPONDING);
+out:
+	free(config_buf);
 	return rc;
 }
 
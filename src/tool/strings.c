@@ -182,6 +182,33 @@ out:
 	return rc;
 }
 
+/* Reads a VLAN ID, or a range of them written as "<first>-<last>" */
+int vid_range_from_string(uint16_t *first, uint16_t *last, char *from)
+{
+	uint64_t lo, hi;
+	char *p;
+	int rc;
+
+	rc = reliable_uint64_from_string(&lo, from, &p);
+	if (rc < 0) {
+		return rc;
+	}
+	hi = lo;
+	if (*p == '-') {
+		rc = reliable_uint64_from_string(&hi, p + 1, &p);
+		if (rc < 0) {
+			return rc;
+		}
+	}
+	if (*p != 0 || lo > hi || hi >= MAX_VLAN_LOOKUP_COUNT) {
+		loge("Invalid VLAN ID range \"%s\"", from);
+		return -ERANGE;
+	}
+	*first = lo;
+	*last = hi;
+	return 0;
+}
+
 int read_array(char *array_str, uint64_t *array_val, int max_count)
 {
 	int   count;
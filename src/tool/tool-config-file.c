@@ -40,6 +40,8 @@
 
 const char *default_staging_area = "/etc/sja1105/.staging";
 const char *default_device = "/dev/spidev0.1";
+const char *default_daemon_socket = "/run/sja1105d.sock";
+const char *default_upload_state = "/run/sja1105-tool.upload";
 const uint64_t default_device_id = SJA1105_NO_DEVICE_ID;
 /* default_device_id of SJA1105_NO_DEVICE_ID signals
  * to sja1105_spi_configure that it should attempt to read
@@ -63,10 +65,12 @@ struct fields_set {
 	int cs_change;
 	int dry_run;
 	int flush;
+	int upload_state;
 	int verbose;
 	int debug;
 	int entries_per_line;
 	int screen_width;
+	int daemon_socket;
 };
 
 static void
@@ -90,10 +94,12 @@ config_set_defaults(struct sja1105_spi_setup *spi_setup,
 	SET_DEFAULT_VAL(spi_setup, cs_change, 0, logi, "%d");
 	SET_DEFAULT_VAL(spi_setup, dry_run, 0, logi, "%d");
 	SET_DEFAULT_VAL(spi_setup, flush, 0, logi, "%d");
+	SET_DEFAULT_VAL(spi_setup, upload_state, default_upload_state, logv, "%s");
 	SET_DEFAULT_VAL(general_conf, verbose, 0, logi, "%d");
 	SET_DEFAULT_VAL(general_conf, debug, 0, logi, "%d");
 	SET_DEFAULT_VAL(general_conf, entries_per_line, 1, logi, "%d");
 	SET_DEFAULT_VAL(general_conf, screen_width, 80, logi, "%d");
+	SET_DEFAULT_VAL(general_conf, daemon_socket, default_daemon_socket, logv, "%s");
 }
 
 static int parse_spi_mode(struct sja1105_spi_setup *spi_setup, char *mode)
@@ -195,6 +201,13 @@ parse_spi_setup(struct sja1105_spi_setup *spi_setup, char *key, char *value,
 	} else if (strcmp(key, "staging_area") == 0) {
 		spi_setup->staging_area = strdup(value);
 		fields_set->staging_area = 1;
+	} else if (strcmp(key, "upload_state") == 0) {
+		if (strcmp(value, "none") == 0) {
+			spi_setup->upload_state = NULL;
+		} else {
+			spi_setup->upload_state = strdup(value);
+		}
+		fields_set->upload_state = 1;
 	} else {
 		loge("Invalid key \"%s\"", key);
 		return -1;
@@ -248,6 +261,13 @@ parse_general_config(struct general_config *general_conf,
 		}
 		general_conf->screen_width = tmp;
 		fields_set->screen_width = 1;
+	} else if (strcmp(key, "daemon_socket") == 0) {
+		if (strcmp(value, "none") == 0) {
+			general_conf->daemon_socket = NULL;
+		} else {
+			general_conf->daemon_socket = strdup(value);
+		}
+		fields_set->daemon_socket = 1;
 	} else {
 		loge("Invalid key \"%s\"", key);
 		return -1;
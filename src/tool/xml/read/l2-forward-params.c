@@ -62,7 +62,10 @@ static int parse_entry(xmlNode *node, struct sja1105_static_config *config)
 	}
 	memset(&entry, 0, sizeof(entry));
 	rc = entry_get(node, &entry);
-	config->l2_forwarding_params[config->l2_forwarding_params_count++] = entry;
+	if (rc < 0) {
+		goto out;
+	}
+	rc = sja1105_static_config_append(config, BLKID_L2_FORWARDING_PARAMS_TABLE, &entry);
 out:
 	return rc;
 }
@@ -78,7 +78,11 @@ static int parse_entry(xmlNode *node, struct sja1105_static_config *config)
 	if (rc != 0) {
 		goto error;
 	}
-	config->l2_forwarding[config->l2_forwarding_count++] = entry;
+	rc = sja1105_static_config_append(config, BLKID_L2_FORWARDING_TABLE,
+	                                  &entry);
+	if (rc < 0) {
+		goto error;
+	}
 	return 0;
 error:
 	return -1;
@@ -59,7 +59,10 @@ static int parse_entry(xmlNode *node, struct sja1105_static_config *config)
 	}
 	memset(&entry, 0, sizeof(entry));
 	rc = entry_get(node, &entry);
-	config->l2_lookup_params[config->l2_lookup_params_count++] = entry;
+	if (rc < 0) {
+		goto out;
+	}
+	rc = sja1105_static_config_append(config, BLKID_L2_LOOKUP_PARAMS_TABLE, &entry);
 out:
 	return rc;
 }
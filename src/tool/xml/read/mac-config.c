@@ -86,7 +86,11 @@ static int parse_entry(xmlNode *node, struct sja1105_static_config *config)
 	}
 	memset(&entry, 0, sizeof(entry));
 	rc = entry_get(node, &entry);
-	config->mac_config[config->mac_config_count++] = entry;
+	if (rc < 0) {
+		goto out;
+	}
+	rc = sja1105_static_config_append(config, BLKID_MAC_CONFIG_TABLE,
+	                                  &entry);
 out:
 	return rc;
 }
@@ -56,7 +56,11 @@ static int parse_entry(xmlNode *node, struct sja1105_static_config *config)
 	}
 	memset(&entry, 0, sizeof(entry));
 	rc = entry_get(node, &entry);
-	config->schedule_params[config->schedule_params_count++] = entry;
+	if (rc < 0) {
+		goto out;
+	}
+	rc = sja1105_static_config_append(config, BLKID_SCHEDULE_PARAMS_TABLE,
+	                                  &entry);
 out:
 	return rc;
 }
@@ -67,7 +67,11 @@ static int parse_entry(xmlNode *node, struct sja1105_static_config *config)
 	}
 	memset(&entry, 0, sizeof(entry));
 	rc = entry_get(node, &entry);
-	config->vl_lookup[config->vl_lookup_count++] = entry;
+	if (rc < 0) {
+		goto out;
+	}
+	rc = sja1105_static_config_append(config, BLKID_VL_LOOKUP_TABLE,
+	                                  &entry);
 out:
 	return rc;
 }